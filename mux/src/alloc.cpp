@@ -80,7 +80,8 @@ static const UTF8 *poolnames[] =
     T("Pcaches"),
     T("Lbufrefs"),
     T("Regrefs"),
-    T("Strings")
+    T("Strings"),
+    T("Tasks")
 };
 
 /*! \brief Initialize a buffer pool.
@@ -18,7 +18,8 @@
 #define POOL_LBUFREF 7
 #define POOL_REGREF  8
 #define POOL_STRING  9
-#define NUM_POOLS    10
+#define POOL_TASK    10
+#define NUM_POOLS    11
 
 #ifdef FIRANMUX
 #define LBUF_SIZE   24000   // Large
@@ -59,6 +60,8 @@ extern void pool_reset(void);
 #define free_regref(b)   pool_free(POOL_REGREF,(UTF8 *)(b), (UTF8 *)__FILE__, __LINE__)
 #define alloc_string(s)  (mux_string *)pool_alloc(POOL_STRING, T(s), (UTF8 *)__FILE__, __LINE__)
 #define free_string(b)   pool_free(POOL_STRING,(UTF8 *)(b), (UTF8 *)__FILE__, __LINE__)
+#define alloc_task(s)    (TASK_RECORD *)pool_alloc(POOL_TASK, (UTF8 *)s, (UTF8 *)__FILE__, __LINE__)
+#define free_task(b)     pool_free(POOL_TASK,(UTF8 *)(b), (UTF8 *)__FILE__, __LINE__)
 
 #define safe_copy_chr_ascii(src, buff, bufp, nSizeOfBuffer) \
 { \
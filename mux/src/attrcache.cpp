@@ -7,9 +7,13 @@
  * disk-based mode. It's not used in memory-based builds. The lower-level
  * cache is managed in svdhash.cpp
  *
- * The upper-level cache is organized by a CHashTable and a linked list. The
- * former allows random access while the linked list helps find the
- * least-recently-used attribute.
+ * The upper-level cache is organized by a CHashTable and the lists of an
+ * Adaptive Replacement Cache (ARC).  Values referenced once are kept on T1
+ * and values referenced again on T2.  An evicted value leaves its key on a
+ * ghost list (B1 or B2), and a later miss on a ghost moves the target size
+ * of T1 toward the list which would have kept it.  A sweep over many
+ * attributes, such as @search or lattr(), only churns T1, so the working set
+ * on T2 survives it.  Attributes known to be missing have their own list.
  */
 
 #include "copyright.h"
@@ -17,6 +21,8 @@
 #include "config.h"
 #include "externs.h"
 
+#include "interface.h"
+
 #if !defined(MEMORY_BASED)
 
 static CHashFile hfAttributeFile;
@@ -42,13 +48,176 @@ typedef struct tagCacheEntryHeader
 {
     struct tagCacheEntryHeader *pPrevEntry;
     struct tagCacheEntryHeader *pNextEntry;
-    Aname attrKey;
-    size_t nSize;
+    struct tagCacheEntryHeader *pPrevDirty;
+    struct tagCacheEntryHeader *pNextDirty;
+    Aname  attrKey;
+    PATTR_RECORD pRecord;   // NULL for ghosts and missing attributes.
+    size_t nValue;
+    size_t nSize;       // Bytes charged against the list.
+    INT64  iLookup;     // Lookup count when the value was added.
+    INT64  iDirty;      // When the entry was first left dirty, in 100ns.
+    UINT32 nHash;
+    int    iList;
+    int    iClass;      // Slab class of pRecord.
+    bool   bDirty;      // Not yet written to the database.
 } CENT_HDR, *PCENT_HDR;
 
-static PCENT_HDR pCacheHead = 0;
-static PCENT_HDR pCacheTail = 0;
-static size_t CacheSize = 0;
+// The cache lists.  Each is circular through its anchor.  The anchor's
+// pNextEntry is the most-recently-used end, and its pPrevEntry is the
+// least-recently-used end.
+//
+#define ACL_T1      0   // Values referenced once.
+#define ACL_T2      1   // Values referenced more than once.
+#define ACL_B1      2   // Ghosts of values evicted from T1.
+#define ACL_B2      3   // Ghosts of values evicted from T2.
+#define ACL_MISSING 4   // Attributes known not to exist.
+#define ACL_COUNT   5
+
+typedef struct
+{
+    CENT_HDR anchor;
+    size_t   nSize;
+    size_t   nEntries;
+    INT64    nHits;
+    INT64    nEvictions;
+} CACHE_LIST;
+
+static CACHE_LIST aCacheLists[ACL_COUNT];
+static bool cache_lists_initted = false;
+
+// ARC's target size for T1 in bytes.  It grows with hits on B1 and
+// shrinks with hits on B2.
+//
+static size_t nTargetT1 = 0;
+static INT64  nCacheLookups = 0;
+static INT64  nCacheMisses = 0;
+
+// A value referenced again within this many lookups stays on T1.  A single
+// command or function often fetches the same attribute more than once, and
+// a sweep should not promote everything it touches that way.
+//
+#define CACHE_CORRELATED 64
+
+// Writes and deletes are kept in the cache and written to the database in
+// batches by cache_tick(), cache_sync(), and cache_close(), or when the
+// entry is evicted.  Entries waiting to be written are also on the dirty
+// list.
+//
+static CENT_HDR DirtyAnchor;
+static size_t nDirty = 0;
+static INT64  nCacheWrites = 0;
+static INT64  nCoalescedWrites = 0;
+static INT64  nFlushWrites = 0;
+static INT64  nEvictionWrites = 0;
+static INT64  nFlushes = 0;
+static INT64  tFlushLatency = 0;
+static INT64  tMaxFlushLatency = 0;
+
+// Entry headers and values are carved from slabs.  Class 0 holds entry
+// headers.  The other classes step by halves of powers of two up to the
+// largest attribute value.
+//
+#define SLAB_SIZE       65536
+#define MAX_SLAB_CLASSES 40
+
+static size_t aSlabClassSize[MAX_SLAB_CLASSES];
+static void  *aSlabFree[MAX_SLAB_CLASSES];
+static int    nSlabClasses = 0;
+static size_t nSlabBytes = 0;
+static size_t nSlabInUse = 0;
+
+static void cache_lists_init(void)
+{
+    for (int i = 0; i < ACL_COUNT; i++)
+    {
+        CACHE_LIST *pList = &aCacheLists[i];
+        pList->anchor.pNextEntry = &pList->anchor;
+        pList->anchor.pPrevEntry = &pList->anchor;
+        pList->nSize = 0;
+        pList->nEntries = 0;
+        pList->nHits = 0;
+        pList->nEvictions = 0;
+    }
+
+    DirtyAnchor.pNextDirty = &DirtyAnchor;
+    DirtyAnchor.pPrevDirty = &DirtyAnchor;
+
+    aSlabClassSize[0] = (sizeof(CENT_HDR) + 15) & ~15;
+    aSlabFree[0] = NULL;
+    nSlabClasses = 1;
+
+    size_t nStep = 32;
+    while (nSlabClasses + 2 <= MAX_SLAB_CLASSES)
+    {
+        aSlabClassSize[nSlabClasses] = nStep;
+        aSlabFree[nSlabClasses++] = NULL;
+        if (LBUF_SIZE <= nStep)
+        {
+            break;
+        }
+        aSlabClassSize[nSlabClasses] = nStep + nStep/2;
+        aSlabFree[nSlabClasses++] = NULL;
+        if (LBUF_SIZE <= nStep + nStep/2)
+        {
+            break;
+        }
+        nStep *= 2;
+    }
+    cache_lists_initted = true;
+}
+
+static int slab_class(size_t nValue)
+{
+    for (int i = 1; i < nSlabClasses; i++)
+    {
+        if (nValue <= aSlabClassSize[i])
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void *slab_alloc(int iClass)
+{
+    void *p = aSlabFree[iClass];
+    if (NULL == p)
+    {
+        size_t nChunk = aSlabClassSize[iClass];
+        size_t nChunks = SLAB_SIZE / nChunk;
+        if (0 == nChunks)
+        {
+            nChunks = 1;
+        }
+        UTF8 *pSlab = (UTF8 *)MEMALLOC(nChunks * nChunk);
+        if (NULL == pSlab)
+        {
+            return NULL;
+        }
+        nSlabBytes += nChunks * nChunk;
+
+        // Slabs are never returned.  Their chunks go on the free list for
+        // their class.
+        //
+        for (size_t i = nChunks; 0 < i; i--)
+        {
+            void *pChunk = pSlab + (i-1) * nChunk;
+            *(void **)pChunk = aSlabFree[iClass];
+            aSlabFree[iClass] = pChunk;
+        }
+        p = aSlabFree[iClass];
+    }
+    aSlabFree[iClass] = *(void **)p;
+    nSlabInUse += aSlabClassSize[iClass];
+    return p;
+}
+
+static void slab_free(int iClass, void *p)
+{
+    *(void **)p = aSlabFree[iClass];
+    aSlabFree[iClass] = p;
+    nSlabInUse -= aSlabClassSize[iClass];
+}
 
 int cache_init(const UTF8 *game_dir_file, const UTF8 *game_pag_file,
     int nCachePages)
@@ -58,11 +227,16 @@ int cache_init(const UTF8 *game_dir_file, const UTF8 *game_pag_file,
         return HF_OPEN_STATUS_ERROR;
     }
 
-    int cc = hfAttributeFile.Open(game_dir_file, game_pag_file, nCachePages);
+    int cc = hfAttributeFile.Open(game_dir_file, game_pag_file, nCachePages,
+        mudconf.cache_mmap);
     if (cc != HF_OPEN_STATUS_ERROR)
     {
         // Mark caching system live
         //
+        if (!cache_lists_initted)
+        {
+            cache_lists_init();
+        }
         cache_initted = true;
         cs_ltime.GetUTC();
     }
@@ -131,110 +305,453 @@ void cache_cleanup(void)
     }
 }
 
-void cache_close(void)
+static void REMOVE_ENTRY(PCENT_HDR pEntry)
 {
-    hfAttributeFile.CloseAll();
-    cache_initted = false;
+    CACHE_LIST *pList = &aCacheLists[pEntry->iList];
+    pEntry->pPrevEntry->pNextEntry = pEntry->pNextEntry;
+    pEntry->pNextEntry->pPrevEntry = pEntry->pPrevEntry;
+    pEntry->pNextEntry = NULL;
+    pEntry->pPrevEntry = NULL;
+    pList->nSize -= pEntry->nSize;
+    pList->nEntries--;
 }
 
-void cache_tick(void)
+static void ADD_ENTRY(PCENT_HDR pEntry, int iList)
 {
-    hfAttributeFile.Tick();
+    CACHE_LIST *pList = &aCacheLists[iList];
+    pEntry->iList = iList;
+    pEntry->pPrevEntry = &pList->anchor;
+    pEntry->pNextEntry = pList->anchor.pNextEntry;
+    pList->anchor.pNextEntry->pPrevEntry = pEntry;
+    pList->anchor.pNextEntry = pEntry;
+    pList->nSize += pEntry->nSize;
+    pList->nEntries++;
 }
 
-static void REMOVE_ENTRY(PCENT_HDR pEntry)
+static PCENT_HDR LRU_ENTRY(int iList)
 {
-    // How is X positioned?
-    //
-    if (pEntry == pCacheHead)
+    CACHE_LIST *pList = &aCacheLists[iList];
+    if (0 == pList->nEntries)
+    {
+        return NULL;
+    }
+    return pList->anchor.pPrevEntry;
+}
+
+// Replace whatever the database holds for an attribute with pRecord, or
+// remove it if pRecord is NULL.
+//
+static void cache_write(const Aname *nam, UINT32 nHash,
+    const ATTR_RECORD *pRecord, size_t nValue)
+{
+    UINT32 iDir = hfAttributeFile.FindFirstKey(nHash);
+    while (iDir != HF_FIND_END)
     {
-        if (pEntry == pCacheTail)
+        HP_HEAPLENGTH nRecord;
+        const ATTR_RECORD *pOld =
+            (const ATTR_RECORD *)hfAttributeFile.Peek(iDir, &nRecord);
+
+        if (  NULL != pOld
+           && pOld->attrKey.attrnum == nam->attrnum
+           && pOld->attrKey.object  == nam->object)
         {
-            // HEAD --> X --> 0
-            //    0 <--  <-- TAIL
-            //
-            // ASSERT: pEntry->pNextEntry == 0;
-            // ASSERT: pEntry->pPrevEntry == 0;
-            //
-            pCacheHead = pCacheTail = 0;
+            hfAttributeFile.Remove(iDir);
         }
-        else
+        iDir = hfAttributeFile.FindNextKey(iDir, nHash);
+    }
+
+    if (  NULL != pRecord
+       && !hfAttributeFile.Insert((HP_HEAPLENGTH)(nValue+sizeof(Aname)),
+              nHash, (void *)pRecord))
+    {
+        Log.tinyprintf(T("cache_put((%d,%d), \xE2\x80\x98%s\xE2\x80\x99, %u) failed" ENDLINE),
+            nam->object, nam->attrnum, pRecord->attrText, nValue);
+    }
+}
+
+static void cache_mark_dirty(PCENT_HDR pEntry)
+{
+    CLinearTimeAbsolute ltaNow;
+    ltaNow.GetUTC();
+    pEntry->bDirty = true;
+    pEntry->iDirty = ltaNow.Return100ns();
+    pEntry->pPrevDirty = &DirtyAnchor;
+    pEntry->pNextDirty = DirtyAnchor.pNextDirty;
+    DirtyAnchor.pNextDirty->pPrevDirty = pEntry;
+    DirtyAnchor.pNextDirty = pEntry;
+    nDirty++;
+}
+
+static void cache_unmark_dirty(PCENT_HDR pEntry)
+{
+    pEntry->pPrevDirty->pNextDirty = pEntry->pNextDirty;
+    pEntry->pNextDirty->pPrevDirty = pEntry->pPrevDirty;
+    pEntry->pNextDirty = NULL;
+    pEntry->pPrevDirty = NULL;
+    pEntry->bDirty = false;
+    nDirty--;
+}
+
+// Write a dirty entry to the database.
+//
+static void cache_clean(PCENT_HDR pEntry, INT64 tNow)
+{
+    cache_write(&pEntry->attrKey, pEntry->nHash, pEntry->pRecord,
+        pEntry->nValue);
+    cache_unmark_dirty(pEntry);
+
+    INT64 tLatency = tNow - pEntry->iDirty;
+    tFlushLatency += tLatency;
+    if (tMaxFlushLatency < tLatency)
+    {
+        tMaxFlushLatency = tLatency;
+    }
+}
+
+static INT64 cache_now(void)
+{
+    CLinearTimeAbsolute ltaNow;
+    ltaNow.GetUTC();
+    return ltaNow.Return100ns();
+}
+
+static void cache_discard(PCENT_HDR pEntry)
+{
+    if (pEntry->bDirty)
+    {
+        // A newer write or delete supersedes this one.
+        //
+        cache_unmark_dirty(pEntry);
+        nCoalescedWrites++;
+    }
+    REMOVE_ENTRY(pEntry);
+    hashdeleteLEN(&pEntry->attrKey, sizeof(Aname), &mudstate.acache_htab);
+    if (NULL != pEntry->pRecord)
+    {
+        slab_free(pEntry->iClass, pEntry->pRecord);
+    }
+    slab_free(0, pEntry);
+}
+
+// Evict a value but remember its key and size on a ghost list.
+//
+static void cache_ghost(PCENT_HDR pEntry, int iGhost)
+{
+    if (pEntry->bDirty)
+    {
+        cache_clean(pEntry, cache_now());
+        nEvictionWrites++;
+    }
+    aCacheLists[pEntry->iList].nEvictions++;
+    REMOVE_ENTRY(pEntry);
+    slab_free(pEntry->iClass, pEntry->pRecord);
+    pEntry->pRecord = NULL;
+    pEntry->nValue = 0;
+    ADD_ENTRY(pEntry, iGhost);
+}
+
+static void cache_drop_lru(int iList)
+{
+    PCENT_HDR pEntry = LRU_ENTRY(iList);
+    if (NULL != pEntry)
+    {
+        if (pEntry->bDirty)
         {
-            // HEAD  --> X --> Y --> 0
-            //    0 <--   <--   <--  TAIL
-            //
-            // ASSERT: pEntry->pNextEntry != 0;
-            // ASSERT: pEntry->pPrevEntry == 0;
-            //
-            pCacheHead = pEntry->pNextEntry;
-            pCacheHead->pPrevEntry = 0;
-            pEntry->pNextEntry = 0;
+            cache_clean(pEntry, cache_now());
+            nEvictionWrites++;
         }
+        aCacheLists[iList].nEvictions++;
+        cache_discard(pEntry);
+    }
+}
+
+static int DCL_CDECL cache_page_order(const void *p, const void *q)
+{
+    const CENT_HDR *pa = *(const CENT_HDR * const *)p;
+    const CENT_HDR *pb = *(const CENT_HDR * const *)q;
+    if (pa->nHash != pb->nHash)
+    {
+        return (pa->nHash < pb->nHash) ? -1 : 1;
     }
-    else if (pEntry == pCacheTail)
+    if (pa->attrKey.object != pb->attrKey.object)
     {
-        // HEAD  --> Y --> X --> 0
-        //    0 <--   <--   <-- TAIL
-        //
-        // ASSERT: pEntry->pNextEntry == 0;
-        // ASSERT: pEntry->pPrevEntry != 0;
-        //
-        pCacheTail = pEntry->pPrevEntry;
-        pCacheTail->pNextEntry = 0;
-        pEntry->pPrevEntry = 0;
+        return (pa->attrKey.object < pb->attrKey.object) ? -1 : 1;
+    }
+    if (pa->attrKey.attrnum != pb->attrKey.attrnum)
+    {
+        return (pa->attrKey.attrnum < pb->attrKey.attrnum) ? -1 : 1;
+    }
+    return 0;
+}
+
+// Write every dirty entry to the database.  CHashFile picks a page from
+// the leading bits of the hash, so writing in hash order visits each page
+// once.
+//
+static void cache_flush(void)
+{
+    if (0 == nDirty)
+    {
+        return;
+    }
+#if defined(HAVE_WORKING_FORK)
+    if (mudstate.write_protect)
+    {
+        return;
+    }
+#endif // HAVE_WORKING_FORK
+
+    INT64 tNow = cache_now();
+    size_t nBatch = nDirty;
+    PCENT_HDR *aBatch = (PCENT_HDR *)MEMALLOC(nBatch * sizeof(PCENT_HDR));
+    if (NULL != aBatch)
+    {
+        size_t i = 0;
+        for (PCENT_HDR p = DirtyAnchor.pNextDirty; p != &DirtyAnchor; p = p->pNextDirty)
+        {
+            aBatch[i++] = p;
+        }
+        qsort(aBatch, nBatch, sizeof(PCENT_HDR), cache_page_order);
+        for (i = 0; i < nBatch; i++)
+        {
+            cache_clean(aBatch[i], tNow);
+        }
+        MEMFREE(aBatch);
+        aBatch = NULL;
     }
     else
     {
-        // HEAD  --> Y --> X --> Z --> 0
-        //    0 <--   <--   <--   <-- TAIL
-        //
-        // ASSERT: pEntry->pNextEntry != 0;
-        // ASSERT: pEntry->pNextEntry != 0;
-        //
-        pEntry->pNextEntry->pPrevEntry = pEntry->pPrevEntry;
-        pEntry->pPrevEntry->pNextEntry = pEntry->pNextEntry;
-        pEntry->pNextEntry = 0;
-        pEntry->pPrevEntry = 0;
+        while (DirtyAnchor.pNextDirty != &DirtyAnchor)
+        {
+            cache_clean(DirtyAnchor.pNextDirty, tNow);
+        }
     }
+    nFlushWrites += nBatch;
+    nFlushes++;
 }
 
-static void ADD_ENTRY(PCENT_HDR pEntry)
+// Make room for nIncoming bytes in T1 and T2.  T1 gives up entries while
+// it is over its target.
+//
+static void cache_replace(size_t nIncoming, bool bFromB2)
 {
-    if (pCacheHead)
+    size_t nMax = mudconf.max_cache_size;
+    CACHE_LIST *pT1 = &aCacheLists[ACL_T1];
+    CACHE_LIST *pT2 = &aCacheLists[ACL_T2];
+    while (nMax < pT1->nSize + pT2->nSize + nIncoming)
     {
-        pCacheHead->pPrevEntry = pEntry;
+        if (  0 < pT1->nEntries
+           && (  nTargetT1 < pT1->nSize
+              || (  bFromB2
+                 && nTargetT1 == pT1->nSize)
+              || 0 == pT2->nEntries))
+        {
+            cache_ghost(LRU_ENTRY(ACL_T1), ACL_B1);
+        }
+        else if (0 < pT2->nEntries)
+        {
+            cache_ghost(LRU_ENTRY(ACL_T2), ACL_B2);
+        }
+        else
+        {
+            break;
+        }
     }
-    pEntry->pNextEntry = pCacheHead;
-    pEntry->pPrevEntry = 0;
-    pCacheHead = pEntry;
-    if (!pCacheTail)
+}
+
+// T1 and B1 together cover at most max_cache_size bytes, and all four
+// lists twice that.  Ghosts also never outnumber the values.
+//
+static void cache_trim_ghosts(void)
+{
+    size_t nMax = mudconf.max_cache_size;
+    CACHE_LIST *pT1 = &aCacheLists[ACL_T1];
+    CACHE_LIST *pT2 = &aCacheLists[ACL_T2];
+    CACHE_LIST *pB1 = &aCacheLists[ACL_B1];
+    CACHE_LIST *pB2 = &aCacheLists[ACL_B2];
+
+    while (  0 < pB1->nEntries
+          && nMax < pT1->nSize + pB1->nSize)
+    {
+        cache_drop_lru(ACL_B1);
+    }
+
+    while (  0 < pB2->nEntries
+          && 2*nMax < pT1->nSize + pT2->nSize + pB1->nSize + pB2->nSize)
     {
-        pCacheTail = pCacheHead;
+        cache_drop_lru(ACL_B2);
+    }
+
+    while (pT1->nEntries + pT2->nEntries < pB1->nEntries + pB2->nEntries)
+    {
+        cache_drop_lru(pB2->nEntries < pB1->nEntries ? ACL_B1 : ACL_B2);
     }
 }
 
-static void TrimCache(void)
+// Record a value read from or written to the database.  A written value
+// is left dirty until the next flush.  Returns NULL if the value could not
+// be cached.
+//
+static PCENT_HDR cache_add_value(Aname *nam, UINT32 nHash,
+    const UTF8 *pValue, size_t nValue, bool bDirty)
 {
-    // Check to see if the cache needs to be trimmed.
+    // The value may point into a page of the file or into the entry it
+    // replaces, so copy it out first.
     //
-    while (CacheSize > mudconf.max_cache_size)
+    PCENT_HDR pEntry = NULL;
+    PATTR_RECORD pRecord = NULL;
+    int iClass = slab_class(nValue + sizeof(Aname));
+    size_t nSize = 0;
+    if (0 <= iClass)
     {
-        // Blow something away.
-        //
-        PCENT_HDR pCacheEntry = pCacheTail;
-        if (!pCacheEntry)
+        nSize = aSlabClassSize[0] + aSlabClassSize[iClass];
+        if (nSize <= mudconf.max_cache_size)
         {
-            CacheSize = 0;
+            pRecord = (PATTR_RECORD)slab_alloc(iClass);
+            if (NULL != pRecord)
+            {
+                pEntry = (PCENT_HDR)slab_alloc(0);
+                if (NULL == pEntry)
+                {
+                    slab_free(iClass, pRecord);
+                    pRecord = NULL;
+                }
+            }
+        }
+    }
+
+    if (NULL != pRecord)
+    {
+        pRecord->attrKey = *nam;
+        memcpy(pRecord->attrText, pValue, nValue);
+        if (0 < nValue)
+        {
+            pRecord->attrText[nValue-1] = '\0';
+        }
+    }
+
+    int  iList = ACL_T1;
+    bool bFromB2 = false;
+
+    PCENT_HDR pOld = (PCENT_HDR)hashfindLEN(nam, sizeof(Aname),
+        &mudstate.acache_htab);
+    if (NULL != pOld)
+    {
+        size_t nMax = mudconf.max_cache_size;
+        size_t nDelta = pOld->nSize;
+        CACHE_LIST *pB1 = &aCacheLists[ACL_B1];
+        CACHE_LIST *pB2 = &aCacheLists[ACL_B2];
+
+        switch (pOld->iList)
+        {
+        case ACL_T2:
+            iList = ACL_T2;
+            break;
+
+        case ACL_B1:
+            // T1 was too small to keep this value.
+            //
+            pB1->nHits++;
+            if (pB1->nSize < pB2->nSize)
+            {
+                nDelta = (size_t)(((UINT64)nDelta * pB2->nSize) / pB1->nSize);
+            }
+            nTargetT1 += nDelta;
+            if (nMax < nTargetT1)
+            {
+                nTargetT1 = nMax;
+            }
+            iList = ACL_T2;
+            break;
+
+        case ACL_B2:
+            // T2 was too small to keep this value.
+            //
+            pB2->nHits++;
+            if (pB2->nSize < pB1->nSize)
+            {
+                nDelta = (size_t)(((UINT64)nDelta * pB1->nSize) / pB2->nSize);
+            }
+            nTargetT1 = (nDelta < nTargetT1) ? nTargetT1 - nDelta : 0;
+            iList = ACL_T2;
+            bFromB2 = true;
             break;
         }
+        cache_discard(pOld);
+    }
 
-        REMOVE_ENTRY(pCacheEntry);
-        CacheSize -= pCacheEntry->nSize;
-        hashdeleteLEN(&(pCacheEntry->attrKey), sizeof(Aname),
-            &mudstate.acache_htab);
-        MEMFREE(pCacheEntry);
-        pCacheEntry = NULL;
+    if (NULL == pEntry)
+    {
+        return NULL;
+    }
+    cache_replace(nSize, bFromB2);
+
+    pEntry->attrKey = *nam;
+    pEntry->pRecord = pRecord;
+    pEntry->iClass = iClass;
+    pEntry->nValue = nValue;
+    pEntry->nSize = nSize;
+    pEntry->nHash = nHash;
+    pEntry->iLookup = nCacheLookups;
+    pEntry->bDirty = false;
+    ADD_ENTRY(pEntry, iList);
+    hashaddLEN(nam, sizeof(Aname), pEntry, &mudstate.acache_htab);
+    if (bDirty)
+    {
+        cache_mark_dirty(pEntry);
     }
+
+    cache_trim_ghosts();
+    return pEntry;
+}
+
+// Record that an attribute does not exist.  These entries have their own
+// LRU list and an eighth of max_cache_size, so lookups of missing
+// attributes do not push values out.  A delete is left dirty until the
+// next flush.  Returns false if the entry could not be cached.
+//
+static bool cache_add_missing(Aname *nam, UINT32 nHash, bool bDirty)
+{
+    PCENT_HDR pEntry = (PCENT_HDR)hashfindLEN(nam, sizeof(Aname),
+        &mudstate.acache_htab);
+    if (NULL != pEntry)
+    {
+        cache_discard(pEntry);
+    }
+
+    size_t nSize = aSlabClassSize[0];
+    CACHE_LIST *pMissing = &aCacheLists[ACL_MISSING];
+    while (  0 < pMissing->nEntries
+          && mudconf.max_cache_size/8 < pMissing->nSize + nSize)
+    {
+        cache_drop_lru(ACL_MISSING);
+    }
+    if (mudconf.max_cache_size/8 < nSize)
+    {
+        return false;
+    }
+
+    pEntry = (PCENT_HDR)slab_alloc(0);
+    if (NULL == pEntry)
+    {
+        return false;
+    }
+    pEntry->attrKey = *nam;
+    pEntry->pRecord = NULL;
+    pEntry->nValue = 0;
+    pEntry->iClass = 0;
+    pEntry->nSize = nSize;
+    pEntry->nHash = nHash;
+    pEntry->bDirty = false;
+    ADD_ENTRY(pEntry, ACL_MISSING);
+    hashaddLEN(nam, sizeof(Aname), pEntry, &mudstate.acache_htab);
+    if (bDirty)
+    {
+        cache_mark_dirty(pEntry);
+    }
+
+    cache_trim_ghosts();
+    return true;
 }
 
 const UTF8 *cache_get(Aname *nam, size_t *pLen)
@@ -246,31 +763,50 @@ const UTF8 *cache_get(Aname *nam, size_t *pLen)
         return NULL;
     }
 
-    PCENT_HDR pCacheEntry = NULL;
     if (!mudstate.bStandAlone)
     {
-        // Check the cache, first.
+        // Check the cache, first.  Attributes with unwritten changes are
+        // always found here.
         //
-        pCacheEntry = (PCENT_HDR)hashfindLEN(nam, sizeof(Aname),
+        PCENT_HDR pCacheEntry = (PCENT_HDR)hashfindLEN(nam, sizeof(Aname),
             &mudstate.acache_htab);
         if (pCacheEntry)
         {
-            // It was in the cache, so move this entry to the head of the queue.
-            // and return a pointer to it.
-            //
-            REMOVE_ENTRY(pCacheEntry);
-            ADD_ENTRY(pCacheEntry);
-            if (sizeof(CENT_HDR) < pCacheEntry->nSize)
-            {
-                *pLen = pCacheEntry->nSize - sizeof(CENT_HDR);
-                return (UTF8 *)(pCacheEntry+1);
-            }
-            else
+            switch (pCacheEntry->iList)
             {
+            case ACL_T1:
+            case ACL_T2:
+                // A later reference promotes a value to T2.
+                //
+                aCacheLists[pCacheEntry->iList].nHits++;
+                REMOVE_ENTRY(pCacheEntry);
+                if (  ACL_T1 == pCacheEntry->iList
+                   && nCacheLookups - pCacheEntry->iLookup < CACHE_CORRELATED)
+                {
+                    ADD_ENTRY(pCacheEntry, ACL_T1);
+                }
+                else
+                {
+                    ADD_ENTRY(pCacheEntry, ACL_T2);
+                }
+                nCacheLookups++;
+                *pLen = pCacheEntry->nValue;
+                return pCacheEntry->pRecord->attrText;
+
+            case ACL_MISSING:
+                aCacheLists[ACL_MISSING].nHits++;
+                REMOVE_ENTRY(pCacheEntry);
+                ADD_ENTRY(pCacheEntry, ACL_MISSING);
+                nCacheLookups++;
                 *pLen = 0;
                 return NULL;
             }
+
+            // Ghosts fall through to the database.
+            //
         }
+        nCacheLookups++;
+        nCacheMisses++;
     }
 
     UINT32 nHash = CRC32_ProcessInteger2(nam->object, nam->attrnum);
@@ -278,33 +814,39 @@ const UTF8 *cache_get(Aname *nam, size_t *pLen)
 
     while (iDir != HF_FIND_END)
     {
+        // The record is used where it sits in the page instead of being
+        // copied out.
+        //
         HP_HEAPLENGTH nRecord;
-        hfAttributeFile.Copy(iDir, &nRecord, &TempRecord);
+        const ATTR_RECORD *pRecord =
+            (const ATTR_RECORD *)hfAttributeFile.Peek(iDir, &nRecord);
 
-        if (  TempRecord.attrKey.attrnum == nam->attrnum
-           && TempRecord.attrKey.object == nam->object)
+        if (  NULL != pRecord
+           && pRecord->attrKey.attrnum == nam->attrnum
+           && pRecord->attrKey.object == nam->object)
         {
             int nLength = nRecord - sizeof(Aname);
             *pLen = nLength;
-            if (!mudstate.bStandAlone)
+
+            // A page read in place from the mapped page file is already held
+            // by the operating system's page cache, so there is no reason to
+            // hold a second copy here.
+            //
+            if (  !mudstate.bStandAlone
+               && !hfAttributeFile.IsMapped())
             {
-                // Add this information to the cache.
+                // Add this information to the cache.  Making room may
+                // write other entries and move the page, so return the
+                // cached copy.
                 //
-                pCacheEntry = (PCENT_HDR)MEMALLOC(sizeof(CENT_HDR)+nLength);
-                if (pCacheEntry)
+                PCENT_HDR pCacheEntry = cache_add_value(nam, nHash,
+                    pRecord->attrText, nLength, false);
+                if (NULL != pCacheEntry)
                 {
-                    pCacheEntry->attrKey = *nam;
-                    pCacheEntry->nSize = nLength + sizeof(CENT_HDR);
-                    CacheSize += pCacheEntry->nSize;
-                    memcpy((char *)(pCacheEntry+1), TempRecord.attrText, nLength);
-                    ADD_ENTRY(pCacheEntry);
-                    hashaddLEN(nam, sizeof(Aname), pCacheEntry,
-                        &mudstate.acache_htab);
-
-                    TrimCache();
+                    return pCacheEntry->pRecord->attrText;
                 }
             }
-            return TempRecord.attrText;
+            return pRecord->attrText;
         }
         iDir = hfAttributeFile.FindNextKey(iDir, nHash);
     }
@@ -315,18 +857,7 @@ const UTF8 *cache_get(Aname *nam, size_t *pLen)
     {
         // Add this information to the cache.
         //
-        pCacheEntry = (PCENT_HDR)MEMALLOC(sizeof(CENT_HDR));
-        if (pCacheEntry)
-        {
-            pCacheEntry->attrKey = *nam;
-            pCacheEntry->nSize = sizeof(CENT_HDR);
-            CacheSize += pCacheEntry->nSize;
-            ADD_ENTRY(pCacheEntry);
-            hashaddLEN(nam, sizeof(Aname), pCacheEntry,
-                &mudstate.acache_htab);
-
-            TrimCache();
-        }
+        cache_add_missing(nam, nHash, false);
     }
 
     *pLen = 0;
@@ -359,8 +890,6 @@ bool cache_put(Aname *nam, const UTF8 *value, size_t len)
         len = sizeof(TempRecord.attrText);
     }
 
-    // Removal from DB.
-    //
     UINT32 nHash = CRC32_ProcessInteger2(nam->object, nam->attrnum);
 
     if (cache_redirected)
@@ -376,75 +905,58 @@ bool cache_put(Aname *nam, const UTF8 *value, size_t len)
         return true;
     }
 
-    UINT32 iDir = hfAttributeFile.FindFirstKey(nHash);
-    while (iDir != HF_FIND_END)
+    if (!mudstate.bStandAlone)
     {
-        HP_HEAPLENGTH nRecord;
-        hfAttributeFile.Copy(iDir, &nRecord, &TempRecord);
-
-        if (  TempRecord.attrKey.attrnum == nam->attrnum
-           && TempRecord.attrKey.object  == nam->object)
+        // Leave the write in the cache until the next flush.
+        //
+        nCacheWrites++;
+        if (NULL != cache_add_value(nam, nHash, value, len, true))
         {
-            hfAttributeFile.Remove(iDir);
+            return true;
         }
-        iDir = hfAttributeFile.FindNextKey(iDir, nHash);
     }
 
+    // The value may point into a page of the file (see cache_get), so take
+    // a copy before the page is changed.
+    //
     TempRecord.attrKey = *nam;
     memcpy(TempRecord.attrText, value, len);
     TempRecord.attrText[len-1] = '\0';
-
-    // Insertion into DB.
-    //
-    if (!hfAttributeFile.Insert((HP_HEAPLENGTH)(len+sizeof(Aname)), nHash, &TempRecord))
-    {
-        Log.tinyprintf(T("cache_put((%d,%d), \xE2\x80\x98%s\xE2\x80\x99, %u) failed" ENDLINE),
-            nam->object, nam->attrnum, value, len);
-    }
-
-    if (!mudstate.bStandAlone)
-    {
-        // Update cache.
-        //
-        PCENT_HDR pCacheEntry = (PCENT_HDR)hashfindLEN(nam, sizeof(Aname),
-            &mudstate.acache_htab);
-        if (pCacheEntry)
-        {
-            // It was in the cache, so delete it.
-            //
-            REMOVE_ENTRY(pCacheEntry);
-            CacheSize -= pCacheEntry->nSize;
-            hashdeleteLEN((char *)nam, sizeof(Aname), &mudstate.acache_htab);
-            MEMFREE(pCacheEntry);
-            pCacheEntry = NULL;
-        }
-
-        // Add information about the new entry back into the cache.
-        //
-        size_t nSizeOfEntry = sizeof(CENT_HDR) + len;
-        pCacheEntry = (PCENT_HDR)MEMALLOC(nSizeOfEntry);
-        if (pCacheEntry)
-        {
-            pCacheEntry->attrKey = *nam;
-            pCacheEntry->nSize = nSizeOfEntry;
-            CacheSize += pCacheEntry->nSize;
-            memcpy((char *)(pCacheEntry+1), TempRecord.attrText, len);
-            ADD_ENTRY(pCacheEntry);
-            hashaddLEN(nam, sizeof(Aname), pCacheEntry,
-                &mudstate.acache_htab);
-
-            TrimCache();
-        }
-    }
+    cache_write(nam, nHash, &TempRecord, len);
     return true;
 }
 
 bool cache_sync(void)
 {
+    cache_flush();
     hfAttributeFile.Sync();
     return true;
 }
 
+void cache_close(void)
+{
+    cache_flush();
+    hfAttributeFile.CloseAll();
+    cache_initted = false;
+}
+
+void cache_tick(void)
+{
+#if defined(HAVE_WORKING_FORK)
+    // While a forked dump is reading the page file, leave changes in the
+    // cache rather than wait on it to split a page.
+    //
+    if (  !mudstate.dumping
+       || 0 == mudstate.dumper)
+    {
+        cache_flush();
+    }
+#else // HAVE_WORKING_FORK
+    cache_flush();
+#endif // HAVE_WORKING_FORK
+    hfAttributeFile.Tick();
+}
+
 // Delete this attribute from the database.
 //
 void cache_del(Aname *nam)
@@ -465,38 +977,83 @@ void cache_del(Aname *nam)
 #endif // HAVE_WORKING_FORK
 
     UINT32 nHash = CRC32_ProcessInteger2(nam->object, nam->attrnum);
-    UINT32 iDir = hfAttributeFile.FindFirstKey(nHash);
-
-    while (iDir != HF_FIND_END)
+    if (!mudstate.bStandAlone)
     {
-        HP_HEAPLENGTH nRecord;
-        hfAttributeFile.Copy(iDir, &nRecord, &TempRecord);
-
-        if (  TempRecord.attrKey.attrnum == nam->attrnum
-           && TempRecord.attrKey.object == nam->object)
+        // Leave the delete in the cache until the next flush.
+        //
+        nCacheWrites++;
+        if (cache_add_missing(nam, nHash, true))
         {
-            hfAttributeFile.Remove(iDir);
+            return;
         }
-        iDir = hfAttributeFile.FindNextKey(iDir, nHash);
     }
+    cache_write(nam, nHash, NULL, 0);
+}
 
-    if (!mudstate.bStandAlone)
+
+static int cache_permille(INT64 nPart, INT64 nWhole)
+{
+    if (nWhole <= 0)
     {
-        // Update cache.
-        //
-        PCENT_HDR pCacheEntry = (PCENT_HDR)hashfindLEN(nam, sizeof(Aname),
-            &mudstate.acache_htab);
-        if (pCacheEntry)
+        return 0;
+    }
+    return (int)((1000 * nPart) / nWhole);
+}
+
+// ---------------------------------------------------------------------------
+// cache_stats: Report on the attribute cache for @list cache.
+//
+void cache_stats(dbref player)
+{
+    if (!cache_lists_initted)
+    {
+        raw_notify(player, T("The attribute cache is not in use."));
+        return;
+    }
+
+    static const UTF8 *aListNames[ACL_COUNT] =
+    {
+        T("Recent (T1)"),
+        T("Frequent (T2)"),
+        T("Ghosts (B1)"),
+        T("Ghosts (B2)"),
+        T("Missing")
+    };
+
+    raw_notify(player, T("List              Entries        Bytes         Hits      Evicted"));
+    INT64 nHits = 0;
+    for (int i = 0; i < ACL_COUNT; i++)
+    {
+        CACHE_LIST *pList = &aCacheLists[i];
+        raw_notify(player, tprintf(T("%-15s %9lld %12lld %12lld %12lld"),
+            aListNames[i], (INT64)pList->nEntries, (INT64)pList->nSize,
+            pList->nHits, pList->nEvictions));
+        if (  ACL_B1 != i
+           && ACL_B2 != i)
         {
-            // It was in the cache, so delete it.
-            //
-            REMOVE_ENTRY(pCacheEntry);
-            CacheSize -= pCacheEntry->nSize;;
-            hashdeleteLEN((char *)nam, sizeof(Aname), &mudstate.acache_htab);
-            MEMFREE(pCacheEntry);
-            pCacheEntry = NULL;
+            nHits += pList->nHits;
         }
     }
+
+    INT64 nLookups = nCacheLookups;
+    int iHits = cache_permille(nHits, nLookups);
+    int iGhostHits = cache_permille(aCacheLists[ACL_B1].nHits
+        + aCacheLists[ACL_B2].nHits, nCacheMisses);
+    raw_notify(player, tprintf(T("Lookups: %lld  Hit ratio: %d.%d%%  Ghost hits: %d.%d%% of misses"),
+        nLookups, iHits / 10, iHits % 10, iGhostHits / 10, iGhostHits % 10));
+    INT64 nWritten = nFlushWrites + nEvictionWrites;
+    int iCoalesced = cache_permille(nCoalescedWrites, nCacheWrites);
+    raw_notify(player, tprintf(T("Writes: %lld  Coalesced: %d.%d%%  Waiting: %lld"),
+        nCacheWrites, iCoalesced / 10, iCoalesced % 10, (INT64)nDirty));
+    raw_notify(player, tprintf(T("Written: %lld in %lld flushes, %lld on eviction"),
+        nWritten, nFlushes, nEvictionWrites));
+    INT64 tAverage = (0 < nWritten) ? tFlushLatency / nWritten : 0;
+    raw_notify(player, tprintf(T("Write delay: average %lld ms, longest %lld ms"),
+        tAverage / 10000, tMaxFlushLatency / 10000));
+    raw_notify(player, tprintf(T("Target size of T1: %lld of %u bytes"),
+        (INT64)nTargetT1, mudconf.max_cache_size));
+    raw_notify(player, tprintf(T("Slabs: %lld bytes, %lld in use"),
+        (INT64)nSlabBytes, (INT64)nSlabInUse));
 }
 
 #endif // MEMORY_BASED
@@ -22,5 +22,6 @@ extern void cache_close(void);
 extern void cache_tick(void);
 extern bool cache_sync(void);
 extern void cache_del(Aname *nam);
+extern void cache_stats(dbref player);
 
 #endif // !_ATTRCACHE_H
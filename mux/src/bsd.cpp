@@ -356,6 +356,10 @@ static int get_slave_result(void)
 int maxd = 0;
 #endif // UNIX_NETWORKING_SELECT
 
+#if defined(UNIX_NETWORKING_EPOLL)
+static void epoll_forget(SOCKET s);
+#endif // UNIX_NETWORKING_EPOLL
+
 #if defined(HAVE_WORKING_FORK)
 
 pid_t slave_pid = 0;
@@ -369,6 +373,9 @@ void CleanUpSlaveSocket(void)
 {
     if (!IS_INVALID_SOCKET(slave_socket))
     {
+#if defined(UNIX_NETWORKING_EPOLL)
+        epoll_forget(slave_socket);
+#endif // UNIX_NETWORKING_EPOLL
         shutdown(slave_socket, SD_BOTH);
         if (0 == SOCKET_CLOSE(slave_socket))
         {
@@ -393,6 +400,9 @@ void CleanUpStubSlaveSocket(void)
 {
     if (!IS_INVALID_SOCKET(stubslave_socket))
     {
+#if defined(UNIX_NETWORKING_EPOLL)
+        epoll_forget(stubslave_socket);
+#endif // UNIX_NETWORKING_EPOLL
         shutdown(stubslave_socket, SD_BOTH);
         if (0 == SOCKET_CLOSE(stubslave_socket))
         {
@@ -751,12 +761,89 @@ failure:
     ENDLOG;
 }
 
-// Get a result from the slave
+// Statistics for @list resolver.
 //
-static int get_slave_result(void)
+static INT64 nSlaveRequests = 0;
+static INT64 nSlaveDatagrams = 0;
+static INT64 nSlaveResults[4] = { 0, 0, 0, 0 };
+static INT64 nSlaveLatency = 0;
+static INT64 tSlaveLatency = 0;
+static INT64 tMaxSlaveLatency = 0;
+
+static void slave_result(const UTF8 *host_address, const UTF8 *host_name, int chStatus)
 {
+    switch (chStatus)
+    {
+    case SLAVE_RESOLVED:
+        nSlaveResults[0]++;
+        break;
+
+    case SLAVE_FAILED:
+        nSlaveResults[1]++;
+        break;
+
+    case SLAVE_CACHED:
+        nSlaveResults[2]++;
+        break;
+
+    case SLAVE_NEGATIVE:
+        nSlaveResults[3]++;
+        break;
+    }
+
+    if (!mudconf.use_hostname)
+    {
+        return;
+    }
+
+    CLinearTimeAbsolute ltaNow;
+    ltaNow.GetUTC();
+
     DESC *d;
+    for (d = descriptor_list; d; d = d->next)
+    {
+        if (strcmp((char *)d->addr, (char *)host_address) != 0)
+        {
+            continue;
+        }
+
+        // Measure from the connection to the arrival of its hostname.
+        //
+        if (d->bHostnamePending)
+        {
+            d->bHostnamePending = false;
+            INT64 tLatency = (ltaNow - d->connected_at).Return100ns();
+            nSlaveLatency++;
+            tSlaveLatency += tLatency;
+            if (tMaxSlaveLatency < tLatency)
+            {
+                tMaxSlaveLatency = tLatency;
+            }
+        }
+
+        strncpy((char *)d->addr, (char *)host_name, 50);
+        d->addr[50] = '\0';
+        if (d->player != 0)
+        {
+            if (d->username[0])
+            {
+                atr_add_raw(d->player, A_LASTSITE, tprintf(T("%s@%s"),
+                    d->username, d->addr));
+            }
+            else
+            {
+                atr_add_raw(d->player, A_LASTSITE, d->addr);
+            }
+            atr_add_raw(d->player, A_LASTIP, host_address);
+        }
+    }
+}
 
+// Get a batch of results from the slave.  Each datagram holds one or more
+// lines of the form '<address> <hostname> <status>'.
+//
+static int get_slave_result(void)
+{
     UTF8 *buf = alloc_lbuf("slave_buf");
 
     int len = mux_read(slave_socket, buf, LBUF_SIZE-1);
@@ -785,48 +872,23 @@ static int get_slave_result(void)
         return -1;
     }
     buf[len] = '\0';
+    nSlaveDatagrams++;
 
     UTF8 *host_name = alloc_lbuf("slave_host_name");
     UTF8 *host_address = alloc_lbuf("slave_host_address");
-    UTF8 *p;
-    if (sscanf((char *)buf, "%s %s", host_address, host_name) != 2)
+    UTF8 *p = buf;
+    UTF8 *q;
+    while (NULL != (q = (UTF8 *)strchr((char *)p, '\n')))
     {
-        goto Done;
-    }
-    p = (UTF8 *)strchr((char *)buf, '\n');
-    if (!p)
-    {
-        goto Done;
-    }
-    *p = '\0';
-    if (mudconf.use_hostname)
-    {
-        for (d = descriptor_list; d; d = d->next)
+        *q = '\0';
+        char chStatus = SLAVE_RESOLVED;
+        if (2 <= sscanf((char *)p, "%s %s %c", host_address, host_name, &chStatus))
         {
-            if (strcmp((char *)d->addr, (char *)host_address) != 0)
-            {
-                continue;
-            }
-
-            strncpy((char *)d->addr, (char *)host_name, 50);
-            d->addr[50] = '\0';
-            if (d->player != 0)
-            {
-                if (d->username[0])
-                {
-                    atr_add_raw(d->player, A_LASTSITE, tprintf(T("%s@%s"),
-                        d->username, d->addr));
-                }
-                else
-                {
-                    atr_add_raw(d->player, A_LASTSITE, d->addr);
-                }
-                atr_add_raw(d->player, A_LASTIP, host_address);
-            }
+            slave_result(host_address, host_name, chStatus);
         }
+        p = q + 1;
     }
 
-Done:
     free_lbuf(buf);
     free_lbuf(host_name);
     free_lbuf(host_address);
@@ -1412,12 +1474,63 @@ void shovechars(int nPorts, PortInfo aPorts[])
 
 #elif defined(UNIX_NETWORKING)
 
+#if defined(UNIX_NETWORKING)
+
+NETLOOP_STATS NetLoopStats;
+
+/*! \brief Account for one pass through the main network loop.
+ *
+ * Iterations and ready sockets are accumulated over a fixed interval. When
+ * the interval completes, the rates are published for @list process, and a
+ * new interval is begun.
+ *
+ * \param ltaCurrent  Time at the top of this pass.
+ * \param nReady      Number of ready sockets found by this pass.
+ * \return            None.
+ */
+
+static void NetLoopStatsUpdate(const CLinearTimeAbsolute &ltaCurrent, int nReady)
+{
+    NetLoopStats.nIterations++;
+    if (0 < nReady)
+    {
+        NetLoopStats.nReady += nReady;
+    }
+
+    CLinearTimeDelta ltdInterval = ltaCurrent - NetLoopStats.ltaIntervalStart;
+    if (time_15s <= ltdInterval)
+    {
+        double dSeconds = static_cast<double>(ltdInterval.Return100ns())
+                        / static_cast<double>(FACTOR_100NS_PER_SECOND);
+        NetLoopStats.dIterationsPerSecond =
+            static_cast<double>(NetLoopStats.nIterations) / dSeconds;
+        NetLoopStats.dAverageReady =
+            static_cast<double>(NetLoopStats.nReady)
+            / static_cast<double>(NetLoopStats.nIterations);
+        NetLoopStats.nIterations = 0;
+        NetLoopStats.nReady = 0;
+        NetLoopStats.ltaIntervalStart = ltaCurrent;
+    }
+}
+
+static void NetLoopStatsStart(const UTF8 *pBackend)
+{
+    NetLoopStats.pBackend = pBackend;
+    NetLoopStats.ltaIntervalStart.GetUTC();
+    NetLoopStats.nIterations = 0;
+    NetLoopStats.nReady = 0;
+    NetLoopStats.dIterationsPerSecond = 0.0;
+    NetLoopStats.dAverageReady = 0.0;
+}
+
+#endif // UNIX_NETWORKING
+
 #if defined(UNIX_NETWORKING_SELECT)
 
 #define CheckInput(x)     FD_ISSET(x, &input_set)
 #define CheckOutput(x)    FD_ISSET(x, &output_set)
 
-void shovechars(int nPorts, PortInfo aPorts[])
+static void shovechars_select(int nPorts, PortInfo aPorts[])
 {
     fd_set input_set, output_set;
     int found;
@@ -1430,6 +1543,7 @@ void shovechars(int nPorts, PortInfo aPorts[])
 
     CLinearTimeAbsolute ltaLastSlice;
     ltaLastSlice.GetUTC();
+    NetLoopStatsStart(T("select"));
 
 #ifdef HAVE_GETDTABLESIZE
     maxfds = getdtablesize();
@@ -1523,6 +1637,7 @@ void shovechars(int nPorts, PortInfo aPorts[])
         ltdTimeout.ReturnTimeValueStruct(&timeout);
         found = select(maxd, &input_set, &output_set, (fd_set *) NULL,
                    &timeout);
+        NetLoopStatsUpdate(ltaCurrent, found);
 
         if (IS_SOCKET_ERROR(found))
         {
@@ -1586,59 +1701,492 @@ void shovechars(int nPorts, PortInfo aPorts[])
                     }
                 }
             }
-            else if (iSocketError != SOCKET_EINTR)
+            else if (iSocketError != SOCKET_EINTR)
+            {
+                log_perror(T("NET"), T("FAIL"), T("checking for activity"), T("select"));
+            }
+            continue;
+        }
+
+#if defined(HAVE_WORKING_FORK)
+        // Get usernames and hostnames.
+        //
+        if (  !IS_INVALID_SOCKET(slave_socket)
+           && CheckInput(slave_socket))
+        {
+            while (0 == get_slave_result())
+            {
+                ; // Nothing.
+            }
+        }
+
+#if defined(STUB_SLAVE)
+        // Get data from stubslave.
+        //
+        if (!IS_INVALID_SOCKET(stubslave_socket))
+        {
+            if (CheckInput(stubslave_socket))
+            {
+                while (0 == StubSlaveRead())
+                {
+                    ; // Nothing.
+                }
+            }
+
+            Pipe_DecodeFrames(CHANNEL_INVALID, &Queue_Out);
+
+            if (!IS_INVALID_SOCKET(stubslave_socket))
+            {
+                if (CheckOutput(stubslave_socket))
+                {
+                    StubSlaveWrite();
+                }
+            }
+        }
+#endif // STUB_SLAVE
+#endif // HAVE_WORKING_FORK
+
+        // Check for new connection requests.
+        //
+        for (i = 0; i < nPorts; i++)
+        {
+            if (CheckInput(aPorts[i].socket))
+            {
+                int iSocketError;
+                newd = new_connection(aPorts+i, &iSocketError);
+                if (!newd)
+                {
+                    if (  iSocketError
+                       && iSocketError != SOCKET_EINTR)
+                    {
+                        log_perror(T("NET"), T("FAIL"), NULL, T("new_connection"));
+                    }
+                }
+                else if (  !IS_INVALID_SOCKET(newd->descriptor)
+                        && maxd <= newd->descriptor)
+                {
+                    maxd = newd->descriptor + 1;
+                }
+            }
+        }
+
+        // Check for activity on user sockets.
+        //
+        DESC_SAFEITER_ALL(d, dnext)
+        {
+            // Process input from sockets with pending input.
+            //
+            if (CheckInput(d->descriptor))
+            {
+                // Undo autodark
+                //
+                if (d->flags & DS_AUTODARK)
+                {
+                    // Clear the DS_AUTODARK on every related session.
+                    //
+                    DESC *d1;
+                    DESC_ITER_PLAYER(d->player, d1)
+                    {
+                        d1->flags &= ~DS_AUTODARK;
+                    }
+                    s_Dirty(d->player);
+                    db[d->player].fs.word[FLAG_WORD1] &= ~DARK;
+                }
+
+                // Process received data.
+                //
+                if (!process_input(d))
+                {
+                    shutdownsock(d, R_SOCKDIED);
+                    continue;
+                }
+            }
+
+            // Process output for sockets with pending output.
+            //
+            if (CheckOutput(d->descriptor))
+            {
+                process_output(d, true);
+            }
+        }
+    }
+}
+
+#endif // UNIX_NETWORKING_SELECT
+
+#if defined(UNIX_NETWORKING_EPOLL)
+
+// The epoll backend registers interest in a socket once and only changes it
+// when the state of the socket's queues changes.  A socket with no interest
+// at all is removed from the epoll set so that hang-ups on a socket whose
+// input we are not yet ready to read do not wake us repeatedly.
+//
+#define EPOLL_MAX_EVENTS  256
+
+static int epoll_fd = -1;
+static struct epoll_event *epoll_ready = NULL;
+static int epoll_nready = 0;
+static bool epoll_ports_listening = false;
+#if defined(HAVE_WORKING_FORK)
+static SOCKET epoll_slave_socket = INVALID_SOCKET;
+#if defined(STUB_SLAVE)
+static SOCKET epoll_stubslave_socket = INVALID_SOCKET;
+static unsigned int epoll_stubslave_events = 0;
+#endif // STUB_SLAVE
+#endif // HAVE_WORKING_FORK
+
+/*! \brief Move a socket from one set of registered events to another.
+ *
+ * \param s          Socket.
+ * \param evOld      Events currently registered (0 if not registered).
+ * \param evNew      Events desired (0 to remove the registration).
+ * \param p          Cookie returned with each ready event.
+ * \return           None.
+ */
+
+static void epoll_interest(SOCKET s, unsigned int evOld, unsigned int evNew, void *p)
+{
+    int op;
+    if (0 == evNew)
+    {
+        op = EPOLL_CTL_DEL;
+    }
+    else if (0 == evOld)
+    {
+        op = EPOLL_CTL_ADD;
+    }
+    else
+    {
+        op = EPOLL_CTL_MOD;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = evNew;
+    ev.data.ptr = p;
+    if (epoll_ctl(epoll_fd, op, s, &ev) < 0)
+    {
+        log_perror(T("NET"), T("FAIL"), T("registering interest"), T("epoll_ctl"));
+    }
+}
+
+/*! \brief Bring the registered epoll interest for a descriptor up to date.
+ *
+ * We want to read from a descriptor only when its input queue is empty, and
+ * we want to write to it only when its output queue is not. Callers invoke
+ * this (through DESC_INTEREST_CHANGED) whenever input_head or output_head
+ * may have changed between empty and non-empty. It is cheap when nothing
+ * changed.
+ *
+ * \param d        Network descriptor state.
+ * \return         None.
+ */
+
+void UpdateDescriptorInterest(DESC *d)
+{
+    if (  epoll_fd < 0
+       || IS_INVALID_SOCKET(d->descriptor))
+    {
+        return;
+    }
+
+    unsigned int events = 0;
+    if (NULL == d->input_head)
+    {
+        events |= EPOLLIN;
+    }
+    if (NULL != d->output_head)
+    {
+        events |= EPOLLOUT;
+    }
+
+    if (events != d->epoll_events)
+    {
+        epoll_interest(d->descriptor, d->epoll_events, events, d);
+        d->epoll_events = events;
+    }
+}
+
+/*! \brief Forget a descriptor which is about to be closed.
+ *
+ * The registration is removed explicitly because a forked child (a dump,
+ * for example) may still hold the socket open, and any events for it which
+ * have already been collected but not yet processed are discarded.
+ *
+ * \param d        Network descriptor state.
+ * \return         None.
+ */
+
+static void epoll_forget_desc(DESC *d)
+{
+    if (epoll_fd < 0)
+    {
+        return;
+    }
+
+    if (0 != d->epoll_events)
+    {
+        epoll_interest(d->descriptor, d->epoll_events, 0, d);
+        d->epoll_events = 0;
+    }
+
+    for (int i = 0; i < epoll_nready; i++)
+    {
+        if (epoll_ready[i].data.ptr == d)
+        {
+            epoll_ready[i].data.ptr = NULL;
+        }
+    }
+}
+
+/*! \brief Forget a slave socket which is about to be closed.
+ *
+ * \param s        Socket.
+ * \return         None.
+ */
+
+static void epoll_forget(SOCKET s)
+{
+    if (epoll_fd < 0)
+    {
+        return;
+    }
+
+#if defined(HAVE_WORKING_FORK)
+    if (s == epoll_slave_socket)
+    {
+        epoll_interest(s, EPOLLIN, 0, NULL);
+        epoll_slave_socket = INVALID_SOCKET;
+    }
+#if defined(STUB_SLAVE)
+    if (s == epoll_stubslave_socket)
+    {
+        epoll_interest(s, epoll_stubslave_events, 0, NULL);
+        epoll_stubslave_socket = INVALID_SOCKET;
+        epoll_stubslave_events = 0;
+    }
+#endif // STUB_SLAVE
+#endif // HAVE_WORKING_FORK
+}
+
+/*! \brief Main network loop using epoll().
+ *
+ * \param nPorts   Number of listening ports.
+ * \param aPorts   Listening ports.
+ * \return         false if epoll() is not usable and the caller should fall
+ *                 back to select().
+ */
+
+static bool shovechars_epoll(int nPorts, PortInfo aPorts[])
+{
+    DESC *d, *newd;
+    unsigned int avail_descriptors;
+    int maxfds;
+    int i;
+
+    mudstate.debug_cmd = T("< shovechars_epoll >");
+
+    epoll_fd = epoll_create(EPOLL_MAX_EVENTS);
+    if (epoll_fd < 0)
+    {
+        log_perror(T("NET"), T("FAIL"), T("falling back to select"), T("epoll_create"));
+        return false;
+    }
+
+    // The epoll descriptor must not survive @restart's exec().
+    //
+    fcntl(epoll_fd, F_SETFD, FD_CLOEXEC);
+
+    CLinearTimeAbsolute ltaLastSlice;
+    ltaLastSlice.GetUTC();
+    NetLoopStatsStart(T("epoll"));
+
+#ifdef HAVE_GETDTABLESIZE
+    maxfds = getdtablesize();
+#else // HAVE_GETDTABLESIZE
+    maxfds = sysconf(_SC_OPEN_MAX);
+#endif // HAVE_GETDTABLESIZE
+
+    avail_descriptors = maxfds - 7;
+
+    // Descriptors may already exist (for example, after @restart).
+    //
+    DESC_ITER_ALL(d)
+    {
+        d->epoll_events = 0;
+        UpdateDescriptorInterest(d);
+    }
+
+    struct epoll_event aEvents[EPOLL_MAX_EVENTS];
+
+    while (!mudstate.shutdown_flag)
+    {
+        CLinearTimeAbsolute ltaCurrent;
+        ltaCurrent.GetUTC();
+        update_quotas(ltaLastSlice, ltaCurrent);
+
+        // Check the scheduler.
+        //
+        scheduler.RunTasks(ltaCurrent);
+        CLinearTimeAbsolute ltaWakeUp;
+        if (scheduler.WhenNext(&ltaWakeUp))
+        {
+            if (ltaWakeUp < ltaCurrent)
+            {
+                ltaWakeUp = ltaCurrent;
+            }
+        }
+        else
+        {
+            CLinearTimeDelta ltd = time_30m;
+            ltaWakeUp = ltaCurrent + ltd;
+        }
+
+        if (mudstate.shutdown_flag)
+        {
+            break;
+        }
+
+#if defined(HAVE_WORKING_FORK) && defined(STUB_SLAVE)
+        // Listen for replies from the stubslave socket.
+        //
+        unsigned int evStubSlave = 0;
+        if (!IS_INVALID_SOCKET(stubslave_socket))
+        {
+            evStubSlave = EPOLLIN;
+            if (0 < Pipe_QueueLength(&Queue_Out))
+            {
+                evStubSlave |= EPOLLOUT;
+            }
+        }
+        if (stubslave_socket != epoll_stubslave_socket)
+        {
+            if (!IS_INVALID_SOCKET(stubslave_socket))
             {
-                log_perror(T("NET"), T("FAIL"), T("checking for activity"), T("select"));
+                epoll_interest(stubslave_socket, 0, evStubSlave, &stubslave_socket);
             }
-            continue;
+            epoll_stubslave_socket = stubslave_socket;
+            epoll_stubslave_events = evStubSlave;
+        }
+        else if (evStubSlave != epoll_stubslave_events)
+        {
+            epoll_interest(stubslave_socket, epoll_stubslave_events, evStubSlave, &stubslave_socket);
+            epoll_stubslave_events = evStubSlave;
+        }
+#endif // HAVE_WORKING_FORK && STUB_SLAVE
+
+        // Listen for new connections if there are free descriptors.
+        //
+        bool fListen = (ndescriptors < avail_descriptors);
+        if (fListen != epoll_ports_listening)
+        {
+            for (i = 0; i < nPorts; i++)
+            {
+                epoll_interest(aPorts[i].socket, fListen ? 0 : EPOLLIN,
+                    fListen ? EPOLLIN : 0, aPorts + i);
+            }
+            epoll_ports_listening = fListen;
         }
 
 #if defined(HAVE_WORKING_FORK)
-        // Get usernames and hostnames.
+        // Listen for replies from the slave socket.
         //
-        if (  !IS_INVALID_SOCKET(slave_socket)
-           && CheckInput(slave_socket))
+        if (slave_socket != epoll_slave_socket)
         {
-            while (0 == get_slave_result())
+            if (!IS_INVALID_SOCKET(slave_socket))
             {
-                ; // Nothing.
+                epoll_interest(slave_socket, 0, EPOLLIN, &slave_socket);
             }
+            epoll_slave_socket = slave_socket;
         }
+#endif // HAVE_WORKING_FORK
 
-#if defined(STUB_SLAVE)
-        // Get data from stubslave.
+        // Wait for something to happen.  Round a partial millisecond up so
+        // that we do not spin until the next task is due.
         //
-        if (!IS_INVALID_SOCKET(stubslave_socket))
+        CLinearTimeDelta ltdTimeout = ltaWakeUp - ltaCurrent;
+        long msTimeout = ltdTimeout.ReturnMilliseconds();
+        if (  0 == msTimeout
+           && ltaCurrent < ltaWakeUp)
         {
-            if (CheckInput(stubslave_socket))
+            msTimeout = 1;
+        }
+        int found = epoll_wait(epoll_fd, aEvents, EPOLL_MAX_EVENTS, msTimeout);
+        NetLoopStatsUpdate(ltaCurrent, found);
+
+        if (found < 0)
+        {
+            if (EINTR != errno)
             {
-                while (0 == StubSlaveRead())
+                log_perror(T("NET"), T("FAIL"), T("checking for activity"), T("epoll_wait"));
+            }
+            continue;
+        }
+
+        epoll_ready = aEvents;
+        epoll_nready = found;
+
+        for (int iEvent = 0; iEvent < found; iEvent++)
+        {
+            void *p = aEvents[iEvent].data.ptr;
+            if (NULL == p)
+            {
+                // The socket was closed after this event was collected.
+                //
+                continue;
+            }
+            unsigned int events = aEvents[iEvent].events;
+
+#if defined(HAVE_WORKING_FORK)
+            if (p == &slave_socket)
+            {
+                // Get usernames and hostnames.
+                //
+                if (!IS_INVALID_SOCKET(slave_socket))
                 {
-                    ; // Nothing.
+                    while (0 == get_slave_result())
+                    {
+                        ; // Nothing.
+                    }
                 }
+                continue;
             }
 
-            Pipe_DecodeFrames(CHANNEL_INVALID, &Queue_Out);
-
-            if (!IS_INVALID_SOCKET(stubslave_socket))
+#if defined(STUB_SLAVE)
+            if (p == &stubslave_socket)
             {
-                if (CheckOutput(stubslave_socket))
+                // Get data from stubslave.
+                //
+                if (!IS_INVALID_SOCKET(stubslave_socket))
                 {
-                    StubSlaveWrite();
+                    if (events & (EPOLLIN|EPOLLHUP|EPOLLERR))
+                    {
+                        while (0 == StubSlaveRead())
+                        {
+                            ; // Nothing.
+                        }
+                    }
+
+                    Pipe_DecodeFrames(CHANNEL_INVALID, &Queue_Out);
+
+                    if (  !IS_INVALID_SOCKET(stubslave_socket)
+                       && (events & EPOLLOUT))
+                    {
+                        StubSlaveWrite();
+                    }
                 }
+                continue;
             }
-        }
 #endif // STUB_SLAVE
 #endif // HAVE_WORKING_FORK
 
-        // Check for new connection requests.
-        //
-        for (i = 0; i < nPorts; i++)
-        {
-            if (CheckInput(aPorts[i].socket))
+            // Check for new connection requests.
+            //
+            if (  aPorts <= p
+               && p < aPorts + nPorts)
             {
                 int iSocketError;
-                newd = new_connection(aPorts+i, &iSocketError);
+                newd = new_connection(static_cast<PortInfo *>(p), &iSocketError);
                 if (!newd)
                 {
                     if (  iSocketError
@@ -1647,21 +2195,29 @@ void shovechars(int nPorts, PortInfo aPorts[])
                         log_perror(T("NET"), T("FAIL"), NULL, T("new_connection"));
                     }
                 }
-                else if (  !IS_INVALID_SOCKET(newd->descriptor)
-                        && maxd <= newd->descriptor)
+                else if (!IS_INVALID_SOCKET(newd->descriptor))
                 {
-                    maxd = newd->descriptor + 1;
+                    if (maxd <= newd->descriptor)
+                    {
+                        maxd = newd->descriptor + 1;
+                    }
+                    UpdateDescriptorInterest(newd);
                 }
+                continue;
+            }
+
+            // Activity on a user socket.  A hang-up or error is reported for
+            // whichever direction we were waiting on.
+            //
+            d = static_cast<DESC *>(p);
+            if (events & (EPOLLHUP|EPOLLERR))
+            {
+                events |= d->epoll_events;
             }
-        }
 
-        // Check for activity on user sockets.
-        //
-        DESC_SAFEITER_ALL(d, dnext)
-        {
             // Process input from sockets with pending input.
             //
-            if (CheckInput(d->descriptor))
+            if (events & EPOLLIN)
             {
                 // Undo autodark
                 //
@@ -1674,6 +2230,7 @@ void shovechars(int nPorts, PortInfo aPorts[])
                     {
                         d1->flags &= ~DS_AUTODARK;
                     }
+                    s_Dirty(d->player);
                     db[d->player].fs.word[FLAG_WORD1] &= ~DARK;
                 }
 
@@ -1688,15 +2245,47 @@ void shovechars(int nPorts, PortInfo aPorts[])
 
             // Process output for sockets with pending output.
             //
-            if (CheckOutput(d->descriptor))
+            if (events & EPOLLOUT)
             {
                 process_output(d, true);
             }
         }
+
+        epoll_ready = NULL;
+        epoll_nready = 0;
     }
+
+    mux_close(epoll_fd);
+    epoll_fd = -1;
+    return true;
 }
 
-#endif // UNIX_NETWORKING_SELECT
+#endif // UNIX_NETWORKING_EPOLL
+
+#if defined(UNIX_NETWORKING)
+
+/*! \brief Main network loop.
+ *
+ * epoll() is used where it is available and working. Otherwise, we fall back
+ * to select().
+ *
+ * \param nPorts   Number of listening ports.
+ * \param aPorts   Listening ports.
+ * \return         None.
+ */
+
+void shovechars(int nPorts, PortInfo aPorts[])
+{
+#if defined(UNIX_NETWORKING_EPOLL)
+    if (shovechars_epoll(nPorts, aPorts))
+    {
+        return;
+    }
+#endif // UNIX_NETWORKING_EPOLL
+    shovechars_select(nPorts, aPorts);
+}
+
+#endif // UNIX_NETWORKING
 
 #if defined(HAVE_WORKING_FORK) && defined(STUB_SLAVE)
 extern "C" MUX_RESULT DCL_API pipepump(void)
@@ -1831,12 +2420,15 @@ DESC *new_connection(PortInfo *Port, int *piSocketError)
 #if defined(HAVE_WORKING_FORK)
         // Make slave request
         //
+        bool bHostnamePending = false;
         if (  !IS_INVALID_SOCKET(slave_socket)
            && mudconf.use_hostname)
         {
             UTF8 *pBuffL1 = alloc_lbuf("new_connection.write");
             mux_sprintf(pBuffL1, LBUF_SIZE, T("%s\n"), pBuffM2);
             len = strlen((char *)pBuffL1);
+            nSlaveRequests++;
+            bHostnamePending = true;
             if (mux_write(slave_socket, pBuffL1, len) < 0)
             {
                 CleanUpSlaveSocket();
@@ -1890,6 +2482,9 @@ DESC *new_connection(PortInfo *Port, int *piSocketError)
 #endif
 
         d = initializesock(newsock, &addr);
+#if defined(HAVE_WORKING_FORK)
+        d->bHostnamePending = bHostnamePending;
+#endif // HAVE_WORKING_FORK
 
 #ifdef UNIX_SSL
         d->ssl_session = ssl_session;
@@ -2139,6 +2734,12 @@ void shutdownsock(DESC *d, int reason)
         // Cancel any scheduled processing on this descriptor.
         //
         scheduler.CancelTask(Task_ProcessCommand, d, 0);
+        cancel_pass_checks(d);
+        if (NULL != d->auth_user)
+        {
+            MEMFREE(d->auth_user);
+            d->auth_user = NULL;
+        }
 
 #if defined(WINDOWS_NETWORKING)
         // Don't close down the socket twice.
@@ -2183,6 +2784,10 @@ void shutdownsock(DESC *d, int reason)
         }
 #endif
 
+#if defined(UNIX_NETWORKING_EPOLL)
+        epoll_forget_desc(d);
+#endif // UNIX_NETWORKING_EPOLL
+
         shutdown(d->descriptor, SD_BOTH);
         if (0 == SOCKET_CLOSE(d->descriptor))
         {
@@ -2360,6 +2965,9 @@ DESC *initializesock(SOCKET s, MUX_SOCKADDR *msa)
 #ifdef UNIX_SSL
     d->ssl_session = NULL;
 #endif
+#if defined(UNIX_NETWORKING_EPOLL)
+    d->epoll_events = 0;
+#endif // UNIX_NETWORKING_EPOLL
 
     // Be sure #0 isn't wizard. Shouldn't be.
     //
@@ -2368,6 +2976,7 @@ DESC *initializesock(SOCKET s, MUX_SOCKADDR *msa)
     d->addr[0] = '\0';
     d->doing[0] = '\0';
     d->username[0] = '\0';
+    d->bHostnamePending = false;
     config_socket(s);
     d->output_prefix = NULL;
     d->output_suffix = NULL;
@@ -2396,6 +3005,7 @@ DESC *initializesock(SOCKET s, MUX_SOCKADDR *msa)
         d->nvt_us_state[i] = OPTION_NO;
     }
     d->ttype = NULL;
+    d->auth_user = NULL;
     d->encoding = mudconf.default_charset;
     d->negotiated_encoding = mudconf.default_charset;
     d->height = 24;
@@ -2491,7 +3101,7 @@ void process_output(void *dvoid, int bHandleShutdown)
     {
         TBLOCK *save = tb;
         tb = tb->hdr.nxt;
-        MEMFREE(save);
+        tblock_free(save);
         save = NULL;
         d->output_head = tb;
         if (NULL == tb)
@@ -2570,6 +3180,81 @@ void process_output(void *dvoid, int bHandleShutdown)
 
 #elif defined(UNIX_NETWORKING)
 
+// Handle an error from writing the output queue.  A write which would have
+// blocked leaves the blocks involved marked read-only so that exactly the
+// same request can be tried again later.
+//
+static void process_output_error(DESC *d, int iSocketError, int nLocked, int bHandleShutdown)
+{
+    if (  SOCKET_EWOULDBLOCK   == iSocketError
+#ifdef SOCKET_EAGAIN
+       || SOCKET_EAGAIN        == iSocketError
+#endif
+#ifdef UNIX_SSL
+       || SSL_ERROR_WANT_WRITE == iSocketError
+       || SSL_ERROR_WANT_READ  == iSocketError
+#endif
+    )
+    {
+        TBLOCK *tb = d->output_head;
+        for (int i = 0; i < nLocked && NULL != tb; tb = tb->hdr.nxt)
+        {
+            if (0 < tb->hdr.nchars)
+            {
+                tb->hdr.flags |= TBLK_FLAG_LOCKED;
+                i++;
+            }
+        }
+    }
+    else if (bHandleShutdown)
+    {
+        shutdownsock(d, R_SOCKDIED);
+    }
+}
+
+// Account for cnt bytes accepted by the network, releasing blocks from the
+// head of the output queue as they are completely sent.
+//
+static void process_output_consume(DESC *d, size_t cnt)
+{
+    OutputStats.nBytes += cnt;
+    d->output_size -= cnt;
+
+    TBLOCK *tb = d->output_head;
+    while (NULL != tb)
+    {
+        if (cnt < tb->hdr.nchars)
+        {
+            tb->hdr.nchars -= cnt;
+            tb->hdr.start += cnt;
+            break;
+        }
+        cnt -= tb->hdr.nchars;
+
+        TBLOCK *save = tb;
+        tb = tb->hdr.nxt;
+        tblock_free(save);
+        save = NULL;
+        OutputStats.nBlocks++;
+        d->output_head = tb;
+        if (NULL == tb)
+        {
+            d->output_tail = NULL;
+        }
+    }
+}
+
+#if defined(TCP_CORK)
+static void SetCork(DESC *d, int iCork)
+{
+    setsockopt(d->descriptor, IPPROTO_TCP, TCP_CORK, (char *)&iCork, sizeof(iCork));
+}
+#endif // TCP_CORK
+
+// The most output blocks gathered into a single writev() call.
+//
+#define OUTPUT_IOV_MAX 64
+
 /*! \brief Service network request for more output to a specific descriptor.
  *
  * This function is called when the network wants to consume more data, but it
@@ -2578,6 +3263,12 @@ void process_output(void *dvoid, int bHandleShutdown)
  * not being called by the task queue, but it is in a form that is callable by
  * the task queue.
  *
+ * Where writev() is available, the whole output queue is handed to the
+ * network in one system call instead of one call per block.  If the
+ * output_cork option is set and at least that many bytes are queued, the
+ * socket is corked while the queue is written so that the burst leaves in
+ * full-sized segments.
+ *
  * \param dvoid             Network descriptor state.
  * \param bHandleShutdown   Whether the shutdownsock() call is being handled..
  * \return                  None.
@@ -2590,12 +3281,85 @@ void process_output(void *dvoid, int bHandleShutdown)
     const UTF8 *cmdsave = mudstate.debug_cmd;
     mudstate.debug_cmd = T("< process_output >");
 
+    if (NULL != d->output_head)
+    {
+        OutputStats.nFlushes++;
+    }
+
+#if defined(UNIX_NETWORKING_WRITEV)
+#ifdef UNIX_SSL
+    if (!d->ssl_session)
+#endif
+    {
+#if defined(TCP_CORK)
+        bool bCorked = false;
+        if (  0 < mudconf.output_cork
+           && static_cast<size_t>(mudconf.output_cork) <= d->output_size)
+        {
+            SetCork(d, 1);
+            bCorked = true;
+        }
+#endif // TCP_CORK
+
+        struct iovec aiov[OUTPUT_IOV_MAX];
+        while (NULL != d->output_head)
+        {
+            int niov = 0;
+            for (TBLOCK *tb = d->output_head; NULL != tb && niov < OUTPUT_IOV_MAX; tb = tb->hdr.nxt)
+            {
+                if (0 < tb->hdr.nchars)
+                {
+                    aiov[niov].iov_base = tb->hdr.start;
+                    aiov[niov].iov_len  = tb->hdr.nchars;
+                    niov++;
+                }
+            }
+
+            if (0 == niov)
+            {
+                // Only empty blocks remain.
+                //
+                process_output_consume(d, 0);
+                break;
+            }
+
+            ssize_t cnt = writev(d->descriptor, aiov, niov);
+            OutputStats.nCalls++;
+            if (cnt < 0)
+            {
+                int iSocketError = SOCKET_LAST_ERROR;
+#if defined(TCP_CORK)
+                if (bCorked)
+                {
+                    SetCork(d, 0);
+                }
+#endif // TCP_CORK
+                mudstate.debug_cmd = cmdsave;
+                process_output_error(d, iSocketError, niov, bHandleShutdown);
+                return;
+            }
+            process_output_consume(d, static_cast<size_t>(cnt));
+        }
+
+#if defined(TCP_CORK)
+        if (bCorked)
+        {
+            SetCork(d, 0);
+        }
+#endif // TCP_CORK
+        DESC_INTEREST_CHANGED(d);
+        mudstate.debug_cmd = cmdsave;
+        return;
+    }
+#endif // UNIX_NETWORKING_WRITEV
+
     TBLOCK *tb = d->output_head;
     while (NULL != tb)
     {
-        while (0 < tb->hdr.nchars)
+        if (0 < tb->hdr.nchars)
         {
             int cnt = mux_socket_write(d, (char *)tb->hdr.start, tb->hdr.nchars, 0);
+            OutputStats.nCalls++;
             if (IS_SOCKET_ERROR(cnt))
             {
 #ifdef UNIX_SSL
@@ -2612,43 +3376,18 @@ void process_output(void *dvoid, int bHandleShutdown)
                 int iSocketError = SOCKET_LAST_ERROR;
 #endif
                 mudstate.debug_cmd = cmdsave;
-
-                if (  SOCKET_EWOULDBLOCK   == iSocketError
-#ifdef SOCKET_EAGAIN
-                   || SOCKET_EAGAIN        == iSocketError
-#endif
-#ifdef UNIX_SSL
-                   || SSL_ERROR_WANT_WRITE == iSocketError
-                   || SSL_ERROR_WANT_READ  == iSocketError
-#endif
-                )
-                {
-                    // The call would have blocked, so we need to mark the
-                    // buffer we used as read-only and try again later with
-                    // the exactly same buffer.
-                    //
-                    tb->hdr.flags |= TBLK_FLAG_LOCKED;
-                }
-                else if (bHandleShutdown)
-                {
-                    shutdownsock(d, R_SOCKDIED);
-                }
+                process_output_error(d, iSocketError, 1, bHandleShutdown);
                 return;
             }
-            d->output_size -= cnt;
-            tb->hdr.nchars -= cnt;
-            tb->hdr.start += cnt;
+            process_output_consume(d, cnt);
         }
-        TBLOCK *save = tb;
-        tb = tb->hdr.nxt;
-        MEMFREE(save);
-        save = NULL;
-        d->output_head = tb;
-        if (tb == NULL)
+        else
         {
-            d->output_tail = NULL;
+            process_output_consume(d, 0);
         }
+        tb = d->output_head;
     }
+    DESC_INTEREST_CHANGED(d);
 
     mudstate.debug_cmd = cmdsave;
 }
@@ -4176,6 +4915,7 @@ void close_sockets(bool emergency, const UTF8 *message)
 void emergency_shutdown(void)
 {
     close_sockets(true, T("Going down - Bye"));
+    Log.Flush();
 }
 
 
@@ -4635,6 +5375,10 @@ static void DCL_CDECL sighandler(int sig)
                         //
                     }
                     mudstate.dumping = false;
+#if defined(UNIX_DUMP_JOURNAL)
+                    dump_journal_finish(  WIFEXITED(stat_buf)
+                                       && 0 == WEXITSTATUS(stat_buf));
+#endif // UNIX_DUMP_JOURNAL
                     local_dump_complete_signal();
 #if defined(TINYMUX_MODULES)
                     ServerEventsSinkNode *p = g_pServerEventsSinkListHead;
@@ -4807,6 +5551,7 @@ static void DCL_CDECL sighandler(int sig)
             dump_restart_db();
 #endif // HAVE_WORKING_FORK
 
+            Log.StopLogging();
 #ifdef GAME_DOOFERMUX
             execl("bin/netmux", mudconf.mud_name, "-c", mudconf.config_file, "-p", mudconf.pid_file, "-e", mudconf.log_dir, (char *)NULL);
 #else // GAME_DOOFERMUX
@@ -4944,6 +5689,49 @@ void list_system_resources(dbref player)
 #endif // WINDOWS_NETWORKING
 }
 
+// list_resolver: Report how the reverse-DNS slave is keeping up.
+//
+void list_resolver(dbref player)
+{
+#if defined(HAVE_WORKING_FORK)
+    UTF8 buffer[200];
+
+    if (IS_INVALID_SOCKET(slave_socket))
+    {
+        notify(player, T("Resolver: slave is not running."));
+    }
+    else
+    {
+        mux_sprintf(buffer, sizeof(buffer), T("Resolver: slave running as process %d."),
+            slave_pid);
+        notify(player, buffer);
+    }
+
+    INT64 nResults = nSlaveResults[0] + nSlaveResults[1] + nSlaveResults[2]
+                   + nSlaveResults[3];
+    mux_sprintf(buffer, sizeof(buffer), T("Requests: %lld  Answers: %lld in %lld batches"),
+        nSlaveRequests, nResults, nSlaveDatagrams);
+    notify(player, buffer);
+
+    mux_sprintf(buffer, sizeof(buffer), T("Looked up: %lld resolved, %lld failed"),
+        nSlaveResults[0], nSlaveResults[1]);
+    notify(player, buffer);
+
+    INT64 nHits = nSlaveResults[2] + nSlaveResults[3];
+    int iRatio = (0 < nResults) ? (int)((1000 * nHits) / nResults) : 0;
+    mux_sprintf(buffer, sizeof(buffer), T("Cached: %lld hostnames, %lld failures  Hit ratio: %d.%d%%"),
+        nSlaveResults[2], nSlaveResults[3], iRatio / 10, iRatio % 10);
+    notify(player, buffer);
+
+    INT64 tAverage = (0 < nSlaveLatency) ? tSlaveLatency / nSlaveLatency : 0;
+    mux_sprintf(buffer, sizeof(buffer), T("Connect to hostname: average %lld ms, longest %lld ms over %lld connections"),
+        tAverage / 10000, tMaxSlaveLatency / 10000, nSlaveLatency);
+    notify(player, buffer);
+#else // HAVE_WORKING_FORK
+    notify(player, T("Resolver statistics are not available."));
+#endif // HAVE_WORKING_FORK
+}
+
 #if defined(WINDOWS_NETWORKING)
 
 // ---------------------------------------------------------------------------
@@ -5206,7 +5994,7 @@ void ProcessWindowsTCP(DWORD dwTimeout)
 
                 TBLOCK *save = tb;
                 tb = tb->hdr.nxt;
-                MEMFREE(save);
+                tblock_free(save);
                 save = NULL;
                 d->output_head = tb;
                 if (NULL == tb)
@@ -5262,6 +6050,7 @@ void ProcessWindowsTCP(DWORD dwTimeout)
                 {
                     d1->flags &= ~DS_AUTODARK;
                 }
+                s_Dirty(d->player);
                 db[d->player].fs.word[FLAG_WORD1] &= ~DARK;
             }
 
@@ -6746,6 +7535,13 @@ bool mux_in_addr::clearOutsideMask(const mux_addr &it)
     return true;
 }
 
+// The key is the address in network order, most significant bit first.
+//
+void mux_in_addr::getKey(unsigned char *pKey) const
+{
+    memcpy(pKey, &m_ia.s_addr, sizeof(m_ia.s_addr));
+}
+
 mux_addr *mux_in_addr::calculateEnd(const mux_addr &it) const
 {
     if (AF_INET == it.getFamily())
@@ -6819,6 +7615,11 @@ bool mux_in6_addr::clearOutsideMask(const mux_addr &it)
     return true;
 }
 
+void mux_in6_addr::getKey(unsigned char *pKey) const
+{
+    memcpy(pKey, m_ia6.s6_addr, sizeof(m_ia6.s6_addr));
+}
+
 mux_addr *mux_in6_addr::calculateEnd(const mux_addr &it) const
 {
     if (AF_INET6 == it.getFamily())
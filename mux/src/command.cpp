@@ -455,6 +455,16 @@ static NAMETAB pose_sw[] =
     {(UTF8 *) NULL,        0,          0,  0}
 };
 
+static NAMETAB profile_sw[] =
+{
+    {T("export"),          1,  CA_WIZARD,  PROFILE_EXPORT},
+    {T("off"),             2,  CA_WIZARD,  PROFILE_OFF},
+    {T("on"),              2,  CA_WIZARD,  PROFILE_ON},
+    {T("report"),          3,  CA_WIZARD,  PROFILE_REPORT},
+    {T("reset"),           3,  CA_WIZARD,  PROFILE_RESET},
+    {(UTF8 *) NULL,        0,          0,  0}
+};
+
 static NAMETAB ps_sw[] =
 {
     {T("all"),             1,  CA_PUBLIC,  PS_ALL|SW_MULTIPLE},
@@ -598,6 +608,7 @@ static CMDENT_NO_ARG command_table_no_arg[] =
     {T("@dbclean"),    NULL,       CA_GOD,      0,          CS_NO_ARGS, 0, do_dbclean},
     {T("@dump"),       dump_sw,    CA_WIZARD,   0,          CS_NO_ARGS, 0, do_dump},
     {T("@mark_all"),   markall_sw, CA_WIZARD,   MARK_SET,   CS_NO_ARGS, 0, do_markall},
+    {T("@profile"),    profile_sw, CA_WIZARD,   0,          CS_NO_ARGS, 0, do_profile},
     {T("@readcache"),  NULL,       CA_WIZARD,   0,          CS_NO_ARGS, 0, do_readcache},
     {T("@restart"),    NULL,       CA_NO_GUEST|CA_NO_SLAVE, 0, CS_NO_ARGS, 0, do_restart},
 #if defined(HAVE_WORKING_FORK)
@@ -3618,6 +3629,12 @@ static void list_vattrs(dbref player, UTF8 *s_mask)
         wild_mtch ? "(wildmatched) " : "");
     raw_notify(player, p);
 
+    CWildcard wc;
+    if (wild_mtch)
+    {
+        wc.Compile(s_mask);
+    }
+
     ATTR *va;
     int na;
     int wna = 0;
@@ -3630,8 +3647,7 @@ static void list_vattrs(dbref player, UTF8 *s_mask)
             //
             if (wild_mtch)
             {
-                mudstate.wild_invk_ctr = 0;
-                if (!quick_wild(s_mask, va->name))
+                if (!wc.Match(va->name))
                 {
                     continue;
                 }
@@ -3726,7 +3742,15 @@ static void list_hashstats(dbref player)
     list_hashstat(player, T("Vattr Names"), &mudstate.vattr_name_htab);
     list_hashstat(player, T("Player Names"), &mudstate.player_htab);
     list_hashstat(player, T("Net Descr."), &mudstate.desc_htab);
+    list_hashstat(player, T("Exec. Cache"), &mudstate.exec_htab);
+    list_hashstat(player, T("Regexps"), &mudstate.regexp_htab);
+    list_hashstat(player, T("Semaphores"), &mudstate.sem_htab);
+    list_hashstat(player, T("Queue Index"), &mudstate.queue_htab);
+    list_hashstat(player, T("Profile"), &mudstate.profile_htab);
     list_hashstat(player, T("Fwd. lists"), &mudstate.fwdlist_htab);
+    list_hashstat(player, T("Hearers"), &mudstate.hearer_htab);
+    list_hashstat(player, T("Name Index"), &mudstate.name_index_htab);
+    list_hashstat(player, T("$-cmd Index"), &mudstate.cmd_index_htab);
     list_hashstat(player, T("Excl. $-cmds"), &mudstate.parent_htab);
     list_hashstat(player, T("Mail Messages"), &mudstate.mail_htab);
     list_hashstat(player, T("Channel Names"), &mudstate.channel_htab);
@@ -3758,6 +3782,7 @@ static void list_db_stats(dbref player)
     raw_notify(player, tprintf(T("Syncs      %12d"), cs_syncs));
     raw_notify(player, tprintf(T("I/O        %12d%12d"), cs_dbwrites, cs_dbreads));
     raw_notify(player, tprintf(T("Cache Hits %12d%12d"), cs_whits, cs_rhits));
+    raw_notify(player, tprintf(T("Mapped                 %12d"), cs_dbmaps));
 #endif // MEMORY_BASED
 }
 
@@ -3834,6 +3859,40 @@ static void list_process(dbref player)
     raw_notify(player,
            tprintf(T("Descs avail: %10d"), maxfds));
 #endif // HAVE_GETRUSAGE
+
+#if defined(UNIX_NETWORKING)
+    if (NULL != NetLoopStats.pBackend)
+    {
+        int iIterations = static_cast<int>(NetLoopStats.dIterationsPerSecond * 100.0 + 0.5);
+        int iAverageReady = static_cast<int>(NetLoopStats.dAverageReady * 100.0 + 0.5);
+        raw_notify(player,
+               tprintf(T("Main loop:   %7d.%02d iter/s %7d.%02d ready  (%s)"),
+                   iIterations / 100, iIterations % 100,
+                   iAverageReady / 100, iAverageReady % 100,
+                   NetLoopStats.pBackend));
+    }
+
+    if (0 < OutputStats.nFlushes)
+    {
+        double dFlushes = static_cast<double>(OutputStats.nFlushes);
+        int iBytes  = static_cast<int>(static_cast<double>(OutputStats.nBytes) / dFlushes + 0.5);
+        int iCalls  = static_cast<int>(static_cast<double>(OutputStats.nCalls) * 100.0 / dFlushes + 0.5);
+        int iBlocks = static_cast<int>(static_cast<double>(OutputStats.nBlocks) * 100.0 / dFlushes + 0.5);
+        raw_notify(player,
+               tprintf(T("Output:      %10d bytes  %4d.%02d calls  %4d.%02d blocks per flush"),
+                   iBytes, iCalls / 100, iCalls % 100, iBlocks / 100, iBlocks % 100));
+        raw_notify(player,
+               tprintf(T("Output:      %10d free blocks"), OutputStats.nFreeBlocks));
+    }
+
+    if (0 < OutputStats.nBroadcastRenders)
+    {
+        raw_notify(player,
+               tprintf(T("Broadcasts:  %10u renders  %10u reused"),
+                   static_cast<unsigned int>(OutputStats.nBroadcastRenders),
+                   static_cast<unsigned int>(OutputStats.nBroadcastShared)));
+    }
+#endif // UNIX_NETWORKING
 }
 
 //----------------------------------------------------------------------------
@@ -3927,6 +3986,9 @@ static void list_rlevels(dbref player)
 #define LIST_RESOURCES  23
 #define LIST_GUESTS     24
 #define LIST_MODULES    25
+#define LIST_SCHEDULER  27
+#define LIST_CACHE      28
+#define LIST_RESOLVER   29
 #ifdef REALITY_LVLS
 #define LIST_RLEVELS    26
 #endif
@@ -3938,6 +4000,7 @@ NAMETAB list_names[] =
     {T("attributes"),         2,  CA_PUBLIC,  LIST_ATTRIBUTES},
     {T("bad_names"),          2,  CA_WIZARD,  LIST_BADNAMES},
     {T("buffers"),            2,  CA_WIZARD,  LIST_BUFTRACE},
+    {T("cache"),              2,  CA_WIZARD,  LIST_CACHE},
     {T("commands"),           3,  CA_PUBLIC,  LIST_COMMANDS},
     {T("config_permissions"), 3,  CA_GOD,     LIST_CONF_PERMS},
     {T("costs"),              3,  CA_PUBLIC,  LIST_COSTS},
@@ -3953,7 +4016,9 @@ NAMETAB list_names[] =
     {T("permissions"),        2,  CA_WIZARD,  LIST_PERMS},
     {T("powers"),             2,  CA_WIZARD,  LIST_POWERS},
     {T("process"),            2,  CA_WIZARD,  LIST_PROCESS},
+    {T("resolver"),           4,  CA_WIZARD,  LIST_RESOLVER},
     {T("resources"),          1,  CA_WIZARD,  LIST_RESOURCES},
+    {T("scheduler"),          2,  CA_WIZARD,  LIST_SCHEDULER},
     {T("site_information"),   2,  CA_WIZARD,  LIST_SITEINFO},
     {T("switches"),           2,  CA_PUBLIC,  LIST_SWITCHES},
     {T("user_attributes"),    1,  CA_WIZARD,  LIST_VATTRS},
@@ -4020,7 +4085,8 @@ void do_list(dbref executor, dbref caller, dbref enactor, int eval, int key,
         list_hashstats(executor);
         break;
     case LIST_SITEINFO:
-        list_siteinfo(executor);
+        s_option = mux_strtok_parse(&tts);
+        list_siteinfo(executor, s_option);
         break;
     case LIST_FLAGS:
         display_flagtab(executor);
@@ -4060,6 +4126,13 @@ void do_list(dbref executor, dbref caller, dbref enactor, int eval, int key,
     case LIST_DB_STATS:
         list_db_stats(executor);
         break;
+    case LIST_CACHE:
+#ifdef MEMORY_BASED
+        raw_notify(executor, T("Database is memory based."));
+#else // MEMORY_BASED
+        cache_stats(executor);
+#endif // MEMORY_BASED
+        break;
     case LIST_PROCESS:
         list_process(executor);
         break;
@@ -4069,12 +4142,19 @@ void do_list(dbref executor, dbref caller, dbref enactor, int eval, int key,
     case LIST_RESOURCES:
         list_system_resources(executor);
         break;
+    case LIST_RESOLVER:
+        list_resolver(executor);
+        break;
     case LIST_GUESTS:
         Guest.ListAll(executor);
         break;
     case LIST_MODULES:
         list_modules(executor);
         break;
+    case LIST_SCHEDULER:
+        s_option = mux_strtok_parse(&tts);
+        list_scheduler(executor, s_option);
+        break;
 #ifdef REALITY_LVLS
     case LIST_RLEVELS:
         list_rlevels(executor);
@@ -64,6 +64,239 @@ static void do_setnewtitle(dbref player, struct channel *ch, UTF8 *pValidatedTit
     }
 }
 
+// Channel history is kept in memory in a ring buffer of max_log entries.
+// Message number n (counting from 1) lives in history[n mod max_log].  The
+// MAX_LOG and LOG_TIMESTAMPS attributes on the channel object still hold
+// the settings, but they are only read when the settings change.
+//
+static void channel_history_resize(struct channel *ch, int max_log)
+{
+    if (max_log < 0)
+    {
+        max_log = 0;
+    }
+    if (max_log == ch->max_log)
+    {
+        return;
+    }
+
+    UTF8 **history = NULL;
+    if (0 < max_log)
+    {
+        history = (UTF8 **)MEMALLOC(max_log * sizeof(UTF8 *));
+        ISOUTOFMEMORY(history);
+        for (int i = 0; i < max_log; i++)
+        {
+            history[i] = NULL;
+        }
+    }
+
+    // Keep the most recent messages which still fit.
+    //
+    int nKeep = (max_log < ch->max_log) ? max_log : ch->max_log;
+    for (int i = 0; i < ch->max_log; i++)
+    {
+        int n = ch->num_messages - i;
+        UTF8 **pp = &ch->history[iMod(n, ch->max_log)];
+        if (i < nKeep)
+        {
+            history[iMod(n, max_log)] = *pp;
+        }
+        else if (NULL != *pp)
+        {
+            MEMFREE(*pp);
+        }
+        *pp = NULL;
+    }
+
+    if (NULL != ch->history)
+    {
+        MEMFREE(ch->history);
+    }
+    ch->history = history;
+    ch->max_log = max_log;
+}
+
+static void channel_history_add(struct channel *ch, const UTF8 *pMessage)
+{
+    UTF8 **pp = &ch->history[iMod(ch->num_messages, ch->max_log)];
+    if (NULL != *pp)
+    {
+        MEMFREE(*pp);
+    }
+    *pp = StringClone(pMessage);
+}
+
+// Read the logging settings from the channel object.
+//
+static void channel_log_refresh(struct channel *ch)
+{
+    int  logmax = DFLT_MAX_LOG;
+    bool bTimestamps = false;
+
+    dbref obj = ch->chan_obj;
+    if (Good_obj(obj))
+    {
+        dbref aowner;
+        int   aflags;
+        ATTR *pattr = atr_str(T("MAX_LOG"));
+        if (  pattr
+           && pattr->number)
+        {
+            UTF8 *maxbuf = atr_get("channel_log_refresh.1", obj, pattr->number, &aowner, &aflags);
+            logmax = mux_atol(maxbuf);
+            free_lbuf(maxbuf);
+        }
+        if (logmax > MAX_RECALL_REQUEST)
+        {
+            logmax = MAX_RECALL_REQUEST;
+        }
+
+        pattr = atr_str(T("LOG_TIMESTAMPS"));
+        bTimestamps = (  pattr
+                      && atr_get_info(obj, pattr->number, &aowner, &aflags));
+    }
+    channel_history_resize(ch, logmax);
+    ch->log_timestamps = bTimestamps;
+}
+
+// Earlier versions kept the history in HISTORY_<n> attributes on the channel
+// object.  Move it into the ring buffer.
+//
+static void channel_history_import(struct channel *ch)
+{
+    dbref obj = ch->chan_obj;
+    if (  !Good_obj(obj)
+       || ch->max_log <= 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < ch->max_log; i++)
+    {
+        ATTR *pattr = atr_str(tprintf(T("HISTORY_%d"), i));
+        if (NULL == pattr)
+        {
+            continue;
+        }
+
+        dbref aowner;
+        int   aflags;
+        UTF8 *message = atr_get("channel_history_import.1", obj, pattr->number,
+            &aowner, &aflags);
+        if (  '\0' != message[0]
+           && NULL == ch->history[i])
+        {
+            ch->history[i] = StringClone(message);
+        }
+        free_lbuf(message);
+        atr_clr(obj, pattr->number);
+    }
+}
+
+static void channel_history_free(struct channel *ch)
+{
+    channel_history_resize(ch, 0);
+}
+
+static void save_channel_history(FILE *fp)
+{
+    struct channel *ch;
+    int nChannels = 0;
+    for (ch = (struct channel *)hash_firstentry(&mudstate.channel_htab);
+         ch;
+         ch = (struct channel *)hash_nextentry(&mudstate.channel_htab))
+    {
+        if (0 < ch->max_log)
+        {
+            nChannels++;
+        }
+    }
+
+    mux_fprintf(fp, T("%d\n"), nChannels);
+    for (ch = (struct channel *)hash_firstentry(&mudstate.channel_htab);
+         ch;
+         ch = (struct channel *)hash_nextentry(&mudstate.channel_htab))
+    {
+        if (ch->max_log <= 0)
+        {
+            continue;
+        }
+
+        // Channel name and number of messages, followed by the messages from
+        // oldest to newest.
+        //
+        int nMessages = 0;
+        for (int i = 0; i < ch->max_log; i++)
+        {
+            if (NULL != ch->history[i])
+            {
+                nMessages++;
+            }
+        }
+        mux_fprintf(fp, T("%s\n%d\n"), ch->name, nMessages);
+
+        for (int i = ch->max_log - 1; 0 <= i; i--)
+        {
+            UTF8 *p = ch->history[iMod(ch->num_messages - i, ch->max_log)];
+            if (NULL != p)
+            {
+                putstring(fp, p);
+            }
+        }
+    }
+}
+
+static void load_channel_history(FILE *fp)
+{
+    UTF8 temp[LBUF_SIZE];
+    if (NULL == fgets((char *)temp, sizeof(temp), fp))
+    {
+        return;
+    }
+    int nChannels = mux_atol(temp);
+
+    for (int i = 0; i < nChannels; i++)
+    {
+        size_t nChannel = GetLineTrunc(temp, sizeof(temp), fp);
+        if (  0 < nChannel
+           && temp[nChannel-1] == '\n')
+        {
+            nChannel--;
+        }
+        temp[nChannel] = '\0';
+        struct channel *ch = select_channel(temp);
+
+        if (NULL == fgets((char *)temp, sizeof(temp), fp))
+        {
+            return;
+        }
+        int nMessages = mux_atol(temp);
+
+        if (NULL != ch)
+        {
+            channel_log_refresh(ch);
+        }
+
+        for (int j = 0; j < nMessages; j++)
+        {
+            size_t nBuffer;
+            UTF8 *pMessage = (UTF8 *)getstring_noalloc(fp, true, &nBuffer);
+            if (  NULL != ch
+               && nMessages - j <= ch->max_log)
+            {
+                int n = ch->num_messages - (nMessages - 1 - j);
+                UTF8 **pp = &ch->history[iMod(n, ch->max_log)];
+                if (NULL != *pp)
+                {
+                    MEMFREE(*pp);
+                }
+                *pp = StringClone(pMessage);
+            }
+        }
+    }
+}
+
 // Save communication system data to disk.
 //
 void save_comsys(UTF8 *filename)
@@ -79,6 +312,18 @@ void save_comsys(UTF8 *filename)
     }
     DebugTotalFiles++;
 
+    save_comsys_stream(fp);
+
+    if (fclose(fp) == 0)
+    {
+        DebugTotalFiles--;
+    }
+
+    ReplaceFile(buffer, filename);
+}
+
+void save_comsys_stream(FILE *fp)
+{
     mux_fprintf(fp, T("+V4\n"));
     mux_fprintf(fp, T("*** Begin CHANNELS ***\n"));
 
@@ -87,12 +332,8 @@ void save_comsys(UTF8 *filename)
     mux_fprintf(fp, T("*** Begin COMSYS ***\n"));
     save_comsystem(fp);
 
-    if (fclose(fp) == 0)
-    {
-        DebugTotalFiles--;
-    }
-
-    ReplaceFile(buffer, filename);
+    mux_fprintf(fp, T("*** Begin HISTORY ***\n"));
+    save_channel_history(fp);
 }
 
 // Aliases must be between 1 and ALIAS_SIZE characters. No spaces. No ANSI.
@@ -548,6 +789,9 @@ void load_comsystem_V4(FILE *fp)
         ch->amount_col   = 0;
         ch->num_messages = 0;
         ch->chan_obj     = NOTHING;
+        ch->history      = NULL;
+        ch->max_log      = 0;
+        ch->log_timestamps = false;
 
         mux_assert(ReadListOfNumbers(fp, 8, anum));
         ch->type         = anum[0];
@@ -753,6 +997,9 @@ void load_comsystem_V0123(FILE *fp)
         ch->amount_col   = 0;
         ch->num_messages = 0;
         ch->chan_obj     = NOTHING;
+        ch->history      = NULL;
+        ch->max_log      = 0;
+        ch->log_timestamps = false;
 
         if (ver >= 1)
         {
@@ -1039,6 +1286,8 @@ void load_channels_V0123(FILE *fp)
     }
 }
 
+static bool s_bHistoryLoaded;
+
 void load_comsys_V4(FILE *fp)
 {
     char buffer[200];
@@ -1063,6 +1312,15 @@ void load_comsys_V4(FILE *fp)
         Log.tinyprintf(T("Error: Couldn\xE2\x80\x99t find Begin COMSYS." ENDLINE));
         return;
     }
+
+    // Channel history was added later without changing the version.
+    //
+    if (  fgets(buffer, sizeof(buffer), fp)
+       && strcmp(buffer, "*** Begin HISTORY ***\n") == 0)
+    {
+        load_channel_history(fp);
+        s_bHistoryLoaded = true;
+    }
 }
 
 void load_comsys_V0123(FILE *fp)
@@ -1151,6 +1409,17 @@ void load_comsys(UTF8 *filename)
 
         Log.tinyprintf(T("LOADING: %s (done)" ENDLINE), filename);
     }
+
+    for (struct channel *ch = (struct channel *)hash_firstentry(&mudstate.channel_htab);
+         ch;
+         ch = (struct channel *)hash_nextentry(&mudstate.channel_htab))
+    {
+        channel_log_refresh(ch);
+        if (!s_bHistoryLoaded)
+        {
+            channel_history_import(ch);
+        }
+    }
 }
 
 // Save channel data and some user state info on a per-channel basis.
@@ -1521,6 +1790,19 @@ void SendChannelMessage
     bool bSpoof = ((ch->type & CHANNEL_SPOOF) != 0);
     ch->num_messages++;
 
+    // Parse each form of the message once, and let the network layer render
+    // it once per kind of client.
+    //
+    mux_string *sMsgNormal = new mux_string(msgNormal);
+    mux_string *sMsgNoComtitle = NULL;
+    broadcast_begin();
+    broadcast_message(*sMsgNormal);
+    if (NULL != msgNoComtitle)
+    {
+        sMsgNoComtitle = new mux_string(msgNoComtitle);
+        broadcast_message(*sMsgNoComtitle);
+    }
+
     struct comuser *user;
     for (user = ch->on_users; user; user = user->on_next)
     {
@@ -1529,74 +1811,51 @@ void SendChannelMessage
         {
             if (  user->ComTitleStatus
                || bSpoof
-               || msgNoComtitle == NULL)
+               || NULL == sMsgNoComtitle)
             {
-                notify_comsys(user->who, executor, msgNormal);
+                notify_comsys(user->who, executor, *sMsgNormal);
             }
             else
             {
-                notify_comsys(user->who, executor, msgNoComtitle);
+                notify_comsys(user->who, executor, *sMsgNoComtitle);
             }
         }
     }
 
+    broadcast_end();
+    delete sMsgNormal;
+    delete sMsgNoComtitle;
+
     // Handle logging.
     //
     dbref obj = ch->chan_obj;
     if (Good_obj(obj))
     {
-        dbref aowner;
-        int   aflags;
-        int   logmax = DFLT_MAX_LOG;
-        UTF8 *maxbuf;
-        ATTR *pattr = atr_str(T("MAX_LOG"));
-        if (  pattr
-           && pattr->number)
+        if (0 < ch->max_log)
         {
-            maxbuf = atr_get("SendChannelMessage.1141", obj, pattr->number, &aowner, &aflags);
-            logmax = mux_atol(maxbuf);
-            free_lbuf(maxbuf);
-        }
-
-        if (0 < logmax)
-        {
-            if (logmax > MAX_RECALL_REQUEST)
+            if (ch->log_timestamps)
             {
-                logmax = MAX_RECALL_REQUEST;
-                atr_add(ch->chan_obj, pattr->number, mux_ltoa_t(logmax), GOD,
-                    AF_CONST|AF_NOPROG|AF_NOPARSE);
+                CLinearTimeAbsolute ltaNow;
+                ltaNow.GetLocal();
+
+                // Save message in history with timestamp.
+                //
+                UTF8 temp[LBUF_SIZE];
+                mux_sprintf(temp, sizeof(temp), T("[%s] %s"), ltaNow.ReturnDateString(0), msgNormal);
+                channel_history_add(ch, temp);
             }
-            UTF8 *p = tprintf(T("HISTORY_%d"), iMod(ch->num_messages, logmax));
-            int atr = mkattr(GOD, p);
-            if (0 < atr)
+            else
             {
-                pattr = atr_str(T("LOG_TIMESTAMPS"));
-                if (  pattr
-                   && atr_get_info(obj, pattr->number, &aowner, &aflags))
-                {
-                    CLinearTimeAbsolute ltaNow;
-                    ltaNow.GetLocal();
-
-                    // Save message in history with timestamp.
-                    //
-                    UTF8 temp[LBUF_SIZE];
-                    mux_sprintf(temp, sizeof(temp), T("[%s] %s"), ltaNow.ReturnDateString(0), msgNormal);
-                    atr_add(ch->chan_obj, atr, temp, GOD, AF_CONST|AF_NOPROG|AF_NOPARSE);
-                }
-                else
-                {
-                    // Save message in history without timestamp.
-                    //
-                    atr_add(ch->chan_obj, atr, msgNormal, GOD,
-                            AF_CONST|AF_NOPROG|AF_NOPARSE);
-                }
-
+                // Save message in history without timestamp.
+                //
+                channel_history_add(ch, msgNormal);
             }
         }
     }
     else if (ch->chan_obj != NOTHING)
     {
         ch->chan_obj = NOTHING;
+        channel_log_refresh(ch);
     }
 
     // Since msgNormal and msgNoComTitle are no longer needed, free them here.
@@ -1848,22 +2107,7 @@ void do_comlast(dbref player, struct channel *ch, int arg)
         return;
     }
 
-    dbref aowner;
-    int aflags;
-    dbref obj = ch->chan_obj;
-    int logmax = MAX_RECALL_REQUEST;
-
-    // Lookup depth of logging.
-    //
-    ATTR *pattr = atr_str(T("MAX_LOG"));
-    if (  pattr
-       && (atr_get_info(obj, pattr->number, &aowner, &aflags)))
-    {
-        UTF8 *maxbuf = atr_get("do_comlast.1408", obj, pattr->number, &aowner, &aflags);
-        logmax = mux_atol(maxbuf);
-        free_lbuf(maxbuf);
-    }
-
+    int logmax = ch->max_log;
     if (logmax < 1)
     {
         raw_notify(player, T("Channel does not log."));
@@ -1880,7 +2124,6 @@ void do_comlast(dbref player, struct channel *ch, int arg)
         arg = logmax;
     }
 
-    UTF8 *message;
     int histnum = ch->num_messages - arg;
 
     raw_notify(player, tprintf(T("%s -- Begin Comsys Recall --"), ch->header));
@@ -1888,13 +2131,10 @@ void do_comlast(dbref player, struct channel *ch, int arg)
     for (int count = 0; count < arg; count++)
     {
         histnum++;
-        pattr = atr_str(tprintf(T("HISTORY_%d"), iMod(histnum, logmax)));
-        if (pattr)
+        UTF8 *message = ch->history[iMod(histnum, logmax)];
+        if (NULL != message)
         {
-            message = atr_get("do_comlast.1436", obj, pattr->number,
-                    &aowner, &aflags);
             raw_notify(player, message);
-            free_lbuf(message);
         }
     }
 
@@ -1954,6 +2194,7 @@ static bool do_chanlog_timestamps(dbref player, UTF8 *channel, UTF8 *arg)
     {
         atr_clr(ch->chan_obj, atr);
     }
+    ch->log_timestamps = (0 != value);
 
     return true;
 }
@@ -1991,24 +2232,9 @@ static bool do_chanlog(dbref player, UTF8 *channel, UTF8 *arg)
         return false;
     }
 
-    dbref aowner;
-    int aflags;
-    UTF8 *oldvalue = atr_get("do_chanlog.1477", ch->chan_obj, atr, &aowner, &aflags);
-    int oldnum = mux_atol(oldvalue);
-    if (value < oldnum)
-    {
-        for (int count = 0; count <= oldnum; count++)
-        {
-            ATTR *hist = atr_str(tprintf(T("HISTORY_%d"), count));
-            if (hist)
-            {
-                atr_clr(ch->chan_obj, hist->number);
-            }
-        }
-    }
-    free_lbuf(oldvalue);
     atr_add(ch->chan_obj, atr, mux_ltoa_t(value), GOD,
         AF_CONST|AF_NOPROG|AF_NOPARSE);
+    channel_history_resize(ch, value);
     return true;
 }
 
@@ -2405,6 +2631,9 @@ void do_createchannel(dbref executor, dbref caller, dbref enactor, int eval, int
     newchannel->on_users = NULL;
     newchannel->chan_obj = NOTHING;
     newchannel->num_messages = 0;
+    newchannel->history = NULL;
+    newchannel->max_log = 0;
+    newchannel->log_timestamps = false;
 
     num_channels++;
 
@@ -2455,6 +2684,7 @@ void do_destroychannel(dbref executor, dbref caller, dbref enactor, int eval, in
     }
     MEMFREE(ch->users);
     ch->users = NULL;
+    channel_history_free(ch);
     MEMFREE(ch);
     ch = NULL;
     raw_notify(executor, tprintf(T("Channel %s destroyed."), channel));
@@ -2686,6 +2916,7 @@ void do_channelnuke(dbref player)
                 MEMFREE(ch->users);
                 ch->users = NULL;
             }
+            channel_history_free(ch);
             MEMFREE(ch);
             ch = NULL;
         }
@@ -3418,11 +3649,13 @@ void do_chopen
         if (thing == NOTHING)
         {
             ch->chan_obj = thing;
+            channel_log_refresh(ch);
             msg = tprintf(T("Channel %s is now disassociated from any channel object."), ch->name);
         }
         else if (Good_obj(thing))
         {
             ch->chan_obj = thing;
+            channel_log_refresh(ch);
             buff = unparse_object(executor, thing, false);
             msg = tprintf(T("Channel %s is now using %s as channel object."), ch->name, buff);
             free_lbuf(buff);
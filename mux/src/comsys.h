@@ -83,6 +83,12 @@ struct channel
     struct comuser *on_users;
     //! Number of messages sent on the channel
     int num_messages;
+    //! Recall ring buffer holding the last max_log messages
+    UTF8 **history;
+    //! Size of the recall ring buffer (MAX_LOG on the channel object)
+    int max_log;
+    //! Whether recalled messages are timestamped (LOG_TIMESTAMPS)
+    bool log_timestamps;
 };
 
 //! \struct tagComsys
@@ -106,6 +112,10 @@ typedef struct tagComsys
 //! \param filename - file to use for for writing data
 void save_comsys(UTF8 *filename);
 
+//! \brief Write communication system data in the comsys database format
+//! \param fp - FILE pointer used for writing data
+void save_comsys_stream(FILE *fp);
+
 //! \brief Save user aliases on a per-channel basis
 //! \param fp - FILE pointer used for writing data
 void save_channels(FILE *fp);
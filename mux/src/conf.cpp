@@ -56,10 +56,12 @@ void cf_init(void)
     mudconf.comsys_db = StringClone(T("comsys.db"));
 
     mudconf.compress_db = false;
+    mudconf.binary_database = false;
     mudconf.compress = StringClone(T("gzip"));
     mudconf.uncompress = StringClone(T("gzip -d"));
     mudconf.status_file = StringClone(T("shutdown.status"));
     mudconf.max_cache_size = 1*1024*1024;
+    mudconf.exec_cache_size = 1*1024*1024;
 
     mudconf.ip_address = NULL;
     mudconf.ports.n = 1;
@@ -138,6 +140,11 @@ void cf_init(void)
     mudstate.dumped   = 0;
     mudstate.write_protect = false;
 #endif // HAVE_WORKING_FORK
+#if defined(UNIX_THREADS)
+    mudconf.log_async = true;
+#else // UNIX_THREADS
+    mudconf.log_async = false;
+#endif // UNIX_THREADS
     mudconf.restrict_home = false;
     mudconf.have_comsys = true;
     mudconf.have_mailer = true;
@@ -146,6 +153,7 @@ void cf_init(void)
     mudconf.sig_action = SA_DFLT;
     mudconf.max_players = -1;
     mudconf.dump_interval = 3600;
+    mudconf.dump_incremental = 0;
     mudconf.check_interval = 600;
     mudconf.events_daily_hour = 7;
     mudconf.dump_offset = 0;
@@ -154,6 +162,7 @@ void cf_init(void)
     mudconf.conn_timeout = 120;
     mudconf.idle_interval = 60;
     mudconf.retry_limit = 3;
+    mudconf.output_cork = 0;
     mudconf.output_limit = 16384;
     mudconf.paycheck = 0;
     mudconf.paystart = 0;
@@ -193,6 +202,8 @@ void cf_init(void)
     mudconf.queuemax = 100;
     mudconf.queue_chunk = 10;
     mudconf.active_q_chunk  = 10;
+    mudconf.queue_fair_share = false;
+    mudconf.queue_fair_quantum = 1000;
     mudconf.sacfactor       = 5;
     mudconf.sacadjust       = -1;
     mudconf.trace_limit     = 200;
@@ -283,9 +294,9 @@ void cf_init(void)
     mudconf.markdata[7] = 0x80;
     mudconf.func_nest_lim = 500;
     mudconf.func_invk_lim = 25000;
-    mudconf.wild_invk_lim = 100000;
     mudconf.ntfy_nest_lim = 20;
     mudconf.lock_nest_lim = 20;
+    mudconf.match_index_min = 100;
     mudconf.parent_nest_lim = 10;
     mudconf.zone_nest_lim = 20;
     mudconf.stack_limit = 50;
@@ -300,6 +311,7 @@ void cf_init(void)
     mudconf.help_executor = NOTHING;
     mudconf.global_error_obj = NOTHING;
     mudconf.cache_pages = 40;
+    mudconf.cache_mmap = false;
     mudconf.mail_per_hour = 50;
     mudconf.vattr_per_hour = 5000;
     mudconf.references_per_hour = 500;
@@ -311,15 +323,19 @@ void cf_init(void)
     mudconf.room_name_charset = 0;
     mudconf.thing_name_charset = 0;
     mudconf.password_methods = CRYPT_DEFAULT;
+    mudconf.password_threads = 2;
     mudconf.default_charset = CHARSET_LATIN1;
 
     mudstate.events_flag = 0;
     mudstate.bReadingConfiguration = false;
     mudstate.bCanRestart = false;
+    mudstate.bProfiling = false;
     mudstate.panicking = false;
     mudstate.asserting = 0;
     mudstate.logging = 0;
     mudstate.epoch = 0;
+    mudstate.nIncrementalDumps = -1;
+    mudstate.bDirtyAttrNames = false;
     mudstate.generation = 0;
     mudstate.curr_executor = NOTHING;
     mudstate.curr_enactor = NOTHING;
@@ -355,7 +371,7 @@ void cf_init(void)
     mudstate.markbits = NULL;
     mudstate.func_nest_lev = 0;
     mudstate.func_invk_ctr = 0;
-    mudstate.wild_invk_ctr = 0;
+    mudstate.func_generation = 0;
     mudstate.ntfy_nest_lev = 0;
     mudstate.train_nest_lev = 0;
     mudstate.lock_nest_lev = 0;
@@ -1309,6 +1325,146 @@ static CF_HAND(cf_site)
     return 0;
 }
 
+// ---------------------------------------------------------------------------
+// cf_site_file: Load many subnets from a file.  Only valid during startup.
+//
+// Each line is a subnet optionally preceded by one of the keywords below.
+// Subnets without a keyword are forbidden, so blocklists can be used as
+// they are.  Anything after a '#' or ';' is a comment.
+//
+static NAMETAB site_file_nametab[] =
+{
+    {T("forbid"),      1,  0,  HC_FORBID},
+    {T("guest"),       1,  0,  HC_GUEST},
+    {T("noguest"),     3,  0,  HC_NOGUEST},
+    {T("nositemon"),   3,  0,  HC_NOSITEMON},
+    {T("permit"),      1,  0,  HC_PERMIT},
+    {T("register"),    3,  0,  HC_REGISTER},
+    {T("reset"),       3,  0,  HC_RESET},
+    {T("sitemon"),     2,  0,  HC_SITEMON},
+    {T("suspect"),     2,  0,  HC_SUSPECT},
+    {T("trust"),       1,  0,  HC_TRUST},
+    {(UTF8 *) NULL,    0,  0,  0}
+};
+
+static CF_HAND(cf_site_file)
+{
+    UNUSED_PARAMETER(nExtra);
+
+    if (!mudstate.bReadingConfiguration)
+    {
+        return -1;
+    }
+
+    FILE *fp;
+    if (!mux_fopen(&fp, str, T("rb")))
+    {
+        cf_log_notfound(player, cmd, T("Site file"), str);
+        return -1;
+    }
+    DebugTotalFiles++;
+
+    int nLoaded = 0;
+    int nFailed = 0;
+    UTF8 *buf = alloc_lbuf("cf_site_file");
+    while (NULL != fgets((char *)buf, LBUF_SIZE, fp))
+    {
+        UTF8 *zp = buf;
+        while (  '\0' != *zp
+              && '#' != *zp
+              && ';' != *zp)
+        {
+            zp++;
+        }
+        *zp = '\0';
+
+        UTF8 *cp = buf;
+        while (mux_isspace(*cp))
+        {
+            cp++;
+        }
+        if ('\0' == *cp)
+        {
+            continue;
+        }
+
+        // A keyword is all letters.  An address never is.
+        //
+        UINT32 ulControl = HC_FORBID;
+        UTF8 *ap;
+        for (ap = cp; mux_isalpha(*ap); ap++)
+        {
+            ; // Nothing.
+        }
+        if (  cp < ap
+           && (  '\0' == *ap
+              || mux_isspace(*ap)))
+        {
+            if (*ap)
+            {
+                *ap++ = '\0';
+            }
+
+            int iControl;
+            if (!search_nametab(GOD, site_file_nametab, cp, &iControl))
+            {
+                cf_log_syntax(player, cmd, T("Unknown site keyword: %s"), cp);
+                nFailed++;
+                continue;
+            }
+            ulControl = iControl;
+
+            cp = ap;
+            while (mux_isspace(*cp))
+            {
+                cp++;
+            }
+        }
+
+        // A bare address is a subnet of one host.
+        //
+        UTF8 *ep = cp + strlen((char *)cp);
+        while (  cp < ep
+              && mux_isspace(ep[-1]))
+        {
+            ep--;
+        }
+        *ep = '\0';
+
+        UTF8 aSingle[SBUF_SIZE];
+        if (  NULL == strpbrk((char *)cp, "/ \t=,")
+           && ep - cp < SBUF_SIZE - 5)
+        {
+            mux_sprintf(aSingle, sizeof(aSingle), T("%s/%d"), cp,
+                (NULL == strchr((char *)cp, ':')) ? 32 : 128);
+            cp = aSingle;
+        }
+
+        if (0 == cf_site(vp, cp, pExtra, ulControl, player, cmd))
+        {
+            nLoaded++;
+        }
+        else
+        {
+            nFailed++;
+        }
+    }
+    free_lbuf(buf);
+    if (fclose(fp) == 0)
+    {
+        DebugTotalFiles--;
+    }
+
+    STARTLOG(LOG_STARTUP, "CNF", "SITE");
+    log_printf(T("Loaded %d subnets from %s"), nLoaded, str);
+    if (0 < nFailed)
+    {
+        log_printf(T(", %d lines failed"), nFailed);
+    }
+    ENDLOG;
+    return (0 == nFailed) ? 0 : 1;
+}
+
 // ---------------------------------------------------------------------------
 // cf_helpfile, cf_raw_helpfile: Add help files and their corresponding
 // command.
@@ -1773,6 +1929,8 @@ static CONFPARM conftable[] =
     {T("autozone"),                  cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.autozone,        NULL,               0},
     {T("bad_name"),                  cf_badname,     CA_GOD,    CA_DISABLED, NULL,                            NULL,               0},
     {T("badsite_file"),              cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.site_file,       NULL, SIZEOF_PATHNAME},
+    {T("binary_database"),           cf_bool,        CA_GOD,    CA_WIZARD,   (int *)&mudconf.binary_database, NULL,               0},
+    {T("cache_mmap"),                cf_bool,        CA_STATIC, CA_WIZARD,   (int *)&mudconf.cache_mmap,      NULL,               0},
     {T("cache_names"),               cf_bool,        CA_STATIC, CA_GOD,      (int *)&mudconf.cache_names,     NULL,               0},
     {T("cache_pages"),               cf_int,         CA_STATIC, CA_WIZARD,   &mudconf.cache_pages,            NULL,               0},
     {T("cache_tick_period"),         cf_seconds,     CA_GOD,    CA_WIZARD,   (int *)&mudconf.cache_tick_period, NULL,             0},
@@ -1800,6 +1958,7 @@ static CONFPARM conftable[] =
     {T("dig_cost"),                  cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.digcost,                NULL,               0},
     {T("down_file"),                 cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.down_file,       NULL, SIZEOF_PATHNAME},
     {T("down_motd_message"),         cf_string,      CA_GOD,    CA_WIZARD,   (int *)mudconf.downmotd_msg,     NULL,       GBUF_SIZE},
+    {T("dump_incremental"),          cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.dump_incremental,       NULL,               0},
     {T("dump_interval"),             cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.dump_interval,          NULL,               0},
     {T("dump_message"),              cf_string,      CA_GOD,    CA_WIZARD,   (int *)mudconf.dump_msg,         NULL,             256},
     {T("dump_offset"),               cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.dump_offset,            NULL,               0},
@@ -1808,6 +1967,7 @@ static CONFPARM conftable[] =
     {T("events_daily_hour"),         cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.events_daily_hour,      NULL,               0},
     {T("examine_flags"),             cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.ex_flags,        NULL,               0},
     {T("examine_public_attrs"),      cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.exam_public,     NULL,               0},
+    {T("exec_cache_size"),           cf_int,         CA_GOD,    CA_GOD,      (int *)&mudconf.exec_cache_size, NULL,               0},
     {T("exit_flags"),                cf_set_flags,   CA_GOD,    CA_DISABLED, (int *)&mudconf.exit_flags,      NULL,               0},
     {T("exit_name_charset"),         cf_modify_bits, CA_GOD,    CA_PUBLIC,   &mudconf.exit_name_charset,      allow_charset_nametab, 0},
     {T("exit_quota"),                cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.exit_quota,             NULL,               0},
@@ -1867,6 +2027,7 @@ static CONFPARM conftable[] =
     {T("list_access"),               cf_ntab_access, CA_GOD,    CA_DISABLED, (int *)list_names,               access_nametab,     0},
     {T("lock_recursion_limit"),      cf_int,         CA_WIZARD, CA_PUBLIC,   &mudconf.lock_nest_lim,          NULL,               0},
     {T("log"),                       cf_modify_bits, CA_GOD,    CA_DISABLED, &mudconf.log_options,            logoptions_nametab, 0},
+    {T("log_async"),                 cf_bool,        CA_STATIC, CA_GOD,      (int *)&mudconf.log_async,       NULL,               0},
     {T("log_options"),               cf_modify_bits, CA_GOD,    CA_DISABLED, &mudconf.log_info,               logdata_nametab,    0},
     {T("logout_cmd_access"),         cf_ntab_access, CA_GOD,    CA_DISABLED, (int *)logout_cmdtable,          access_nametab,     0},
     {T("logout_cmd_alias"),          cf_alias,       CA_GOD,    CA_DISABLED, (int *)&mudstate.logout_cmd_htab,NULL,               0},
@@ -1876,6 +2037,7 @@ static CONFPARM conftable[] =
     {T("mail_expiration"),           cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.mail_expiration,        NULL,               0},
     {T("mail_per_hour"),             cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.mail_per_hour,          NULL,               0},
     {T("master_room"),               cf_dbref,       CA_GOD,    CA_WIZARD,   &mudconf.master_room,            NULL,               0},
+    {T("match_index_min"),           cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.match_index_min,        NULL,               0},
     {T("match_own_commands"),        cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.match_mine,      NULL,               0},
     {T("max_cache_size"),            cf_int,         CA_GOD,    CA_GOD,      (int *)&mudconf.max_cache_size,  NULL,               0},
     {T("max_players"),               cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.max_players,            NULL,               0},
@@ -1894,12 +2056,14 @@ static CONFPARM conftable[] =
     {T("notify_recursion_limit"),    cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.ntfy_nest_lim,          NULL,               0},
     {T("number_guests"),             cf_int,         CA_STATIC, CA_WIZARD,   &mudconf.number_guests,          NULL,               0},
     {T("open_cost"),                 cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.opencost,               NULL,               0},
+    {T("output_cork"),               cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.output_cork,            NULL,               0},
     {T("output_database"),           cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.outdb,           NULL, SIZEOF_PATHNAME},
     {T("output_limit"),              cf_int,         CA_GOD,    CA_WIZARD,   (int *)&mudconf.output_limit,    NULL,               0},
     {T("page_cost"),                 cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.pagecost,               NULL,               0},
     {T("paranoid_allocate"),         cf_bool,        CA_GOD,    CA_WIZARD,   (int *)&mudconf.paranoid_alloc,  NULL,               0},
     {T("parent_recursion_limit"),    cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.parent_nest_lim,        NULL,               0},
     {T("password_methods"),          cf_modify_bits, CA_GOD,    CA_PUBLIC,   &mudconf.password_methods,       method_nametab,     0},
+    {T("password_threads"),          cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.password_threads,       NULL,               0},
     {T("paycheck"),                  cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.paycheck,               NULL,               0},
     {T("pemit_any_object"),          cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.pemit_any,       NULL,               0},
     {T("pemit_far_players"),         cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.pemit_players,   NULL,               0},
@@ -1926,6 +2090,8 @@ static CONFPARM conftable[] =
     {T("public_flags"),              cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.pub_flags,       NULL,               0},
     {T("pueblo_message"),            cf_string,      CA_GOD,    CA_WIZARD,   (int *)mudconf.pueblo_msg,       NULL,       GBUF_SIZE},
     {T("queue_active_chunk"),        cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.active_q_chunk,         NULL,               0},
+    {T("queue_fair_quantum"),        cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.queue_fair_quantum,     NULL,               0},
+    {T("queue_fair_share"),          cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.queue_fair_share, NULL,              0},
     {T("queue_idle_chunk"),          cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.queue_chunk,            NULL,               0},
     {T("quiet_look"),                cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.quiet_look,      NULL,               0},
     {T("quiet_whisper"),             cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.quiet_whisper,   NULL,               0},
@@ -1957,6 +2123,7 @@ static CONFPARM conftable[] =
     {T("see_owned_dark"),            cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.see_own_dark,    NULL,               0},
     {T("signal_action"),             cf_option,      CA_STATIC, CA_GOD,      &mudconf.sig_action,             sigactions_nametab, 0},
     {T("site_chars"),                cf_int,         CA_GOD,    CA_WIZARD,   (int *)&mudconf.site_chars,      NULL,               0},
+    {T("site_file"),                 cf_site_file,   CA_STATIC, CA_DISABLED, (int *)&mudstate.access_list,    NULL,               0},
     {T("sitemon_site"),              cf_site,        CA_GOD,    CA_DISABLED, (int *)&mudstate.access_list,    NULL,      HC_SITEMON},
     {T("space_compress"),            cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.space_compress,  NULL,               0},
 #ifdef UNIX_SSL
@@ -72,6 +72,51 @@
 #define UNIX_DIGEST
 #endif // SSL_ENABLED
 
+// Network readiness backends.  select() is always required as a fallback.
+// epoll() is preferred where available.
+//
+#if defined(HAVE_SYS_SELECT_H) && defined(HAVE_SELECT)
+#define UNIX_NETWORKING_SELECT
+#else
+#error Platform does not provide select().
+#endif
+#if  defined(HAVE_SYS_EPOLL_H) \
+  && defined(HAVE_EPOLL_CREATE) \
+  && defined(HAVE_EPOLL_CTL) \
+  && defined(HAVE_EPOLL_WAIT)
+#define UNIX_NETWORKING_EPOLL
+#endif
+
+// Output queues are written with one writev() per flush where available.
+//
+#if defined(HAVE_SYS_UIO_H) && defined(HAVE_WRITEV)
+#define UNIX_NETWORKING_WRITEV
+#endif // HAVE_SYS_UIO_H && HAVE_WRITEV
+
+// The attribute page file can be mapped into memory and read in place.
+//
+#if  defined(HAVE_SYS_MMAN_H) \
+  && defined(HAVE_MMAP) \
+  && defined(HAVE_MUNMAP)
+#define UNIX_FILES_MMAP
+#endif // HAVE_SYS_MMAN_H && HAVE_MMAP && HAVE_MUNMAP
+
+// Background threads are used for work which should not stall the main
+// loop (e.g., writing logs).
+//
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD_CREATE)
+#define UNIX_THREADS
+#endif // HAVE_PTHREAD_H && HAVE_PTHREAD_CREATE
+
+// Incremental checkpoints are serialized into memory and written to the
+// checkpoint journal by a background thread.
+//
+#if  defined(UNIX_THREADS) \
+  && defined(HAVE_OPEN_MEMSTREAM) \
+  && defined(HAVE_FSYNC)
+#define UNIX_DUMP_JOURNAL
+#endif // UNIX_THREADS && HAVE_OPEN_MEMSTREAM && HAVE_FSYNC
+
 #endif // WIN32
 
 #ifndef __specstrings
@@ -168,6 +213,9 @@ extern int getdtablesize(void);
 #ifdef HAVE_NETINET_IN_H
 #include <netinet/in.h>
 #endif // HAVE_NETINET_IN_H
+#ifdef HAVE_NETINET_TCP_H
+#include <netinet/tcp.h>
+#endif // HAVE_NETINET_TCP_H
 #ifdef HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif // HAVE_ARPA_INET_H
@@ -183,6 +231,18 @@ extern int getdtablesize(void);
 #include <sys/select.h>
 #endif // UNIX_NETWORKING_SELECT && HAVE_SYS_SELECT_H
 
+#if defined(UNIX_NETWORKING_WRITEV)
+#include <sys/uio.h>
+#endif // UNIX_NETWORKING_WRITEV
+
+#if defined(UNIX_FILES_MMAP)
+#include <sys/mman.h>
+#endif // UNIX_FILES_MMAP
+
+#if defined(UNIX_THREADS)
+#include <pthread.h>
+#endif // UNIX_THREADS
+
 #ifdef UNIX_SSL
 #include <openssl/ssl.h>
 #endif
@@ -439,12 +499,6 @@ typedef unsigned __int64 UINT64;
 
 #else // WIN32
 
-#if defined(HAVE_SYS_SELECT_H) && defined(HAVE_SELECT)
-#define UNIX_NETWORKING_SELECT
-#else
-#error Platform does not provide select().
-#endif
-
 #define DCL_CDECL
 #define DCL_EXPORT
 #define DCL_API
@@ -744,6 +798,7 @@ public:
     virtual void makeMask(int nLeadingBits) = 0;
     virtual bool clearOutsideMask(const mux_addr &itMask) = 0;
     virtual mux_addr *calculateEnd(const mux_addr &itMask) const = 0;
+    virtual void getKey(unsigned char *pKey) const = 0;
     virtual bool operator<(const mux_addr &it) const = 0;
     virtual bool operator==(const mux_addr &it) const = 0;
 };
@@ -766,6 +821,8 @@ public:
     Comparison CompareTo(mux_subnet *msn) const;
     Comparison CompareTo(MUX_SOCKADDR *msa) const;
     bool listinfo(UTF8 *sAddress, int *pnLeadingBits) const;
+    void getKey(unsigned char *pKey) const { m_iaBase->getKey(pKey); }
+    int getLeadingBits() const { return m_iLeadingBits; }
 
 protected:
     mux_addr *m_iaBase;
@@ -794,6 +851,7 @@ public:
     void makeMask(int nLeadingBits);
     bool clearOutsideMask(const mux_addr &itMask);
     mux_addr *calculateEnd(const mux_addr &itMask) const;
+    void getKey(unsigned char *pKey) const;
     bool operator<(const mux_addr &it) const;
     bool operator==(const mux_addr &it) const;
 
@@ -819,6 +877,7 @@ public:
     void makeMask(int nLeadingBits);
     bool clearOutsideMask(const mux_addr &itMask);
     mux_addr *calculateEnd(const mux_addr &itMask) const;
+    void getKey(unsigned char *pKey) const;
     bool operator<(const mux_addr &it) const;
     bool operator==(const mux_addr &it) const;
 
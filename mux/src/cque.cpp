@@ -22,7 +22,7 @@
 
 bool break_called = false;
 
-static CLinearTimeDelta GetProcessorUsage(void)
+CLinearTimeDelta GetProcessorUsage(void)
 {
     CLinearTimeDelta ltd;
 #if defined(WINDOWS_PROCESSES)
@@ -77,23 +77,211 @@ static int add_to(dbref executor, int am, int attrnum)
     return num;
 }
 
-// This Task assumes that pEntry is already unlinked from any lists it may
-// have been related to.
+// ---------------------------------------------------------------------------
+// Queue index.
+//
+// Every queue entry is linked into a list for the object that will run it and
+// a list for the player who owned that object when the entry was queued.  The
+// player was charged for the entry at that time, so the entry is counted and
+// refunded against the same player.  Both lists for a dbref hang off of one
+// QUE_LIST in queue_htab, and the per-owner counts let @ps/summary report
+// without visiting any entries.
+//
+#define QUE_NONE      (-1)
+#define QUE_WAIT      0
+#define QUE_SEMAPHORE 1
+#define QUE_SQL       2
+#define QUE_KINDS     3
+
+typedef struct que_list QUE_LIST;
+struct que_list
+{
+    dbref thing;
+    BQUE *pExecHead;            // Entries run by this object.
+    BQUE *pOwnerHead;           // Entries owned by this player.
+    int   nExec;
+    int   aOwned[QUE_KINDS];
+};
+
+static int s_aQueued[QUE_KINDS];
+
+static QUE_LIST *que_list(dbref thing, bool bCreate)
+{
+    QUE_LIST *pql = (QUE_LIST *)hashfindLEN(&thing, sizeof(thing), &mudstate.queue_htab);
+    if (  NULL == pql
+       && bCreate)
+    {
+        pql = (QUE_LIST *)MEMALLOC(sizeof(QUE_LIST));
+        ISOUTOFMEMORY(pql);
+        pql->thing      = thing;
+        pql->pExecHead  = NULL;
+        pql->pOwnerHead = NULL;
+        pql->nExec      = 0;
+        for (int i = 0; i < QUE_KINDS; i++)
+        {
+            pql->aOwned[i] = 0;
+        }
+        hashaddLEN(&thing, sizeof(thing), pql, &mudstate.queue_htab);
+    }
+    return pql;
+}
+
+static void que_list_release(QUE_LIST *pql)
+{
+    if (  NULL == pql->pExecHead
+       && NULL == pql->pOwnerHead)
+    {
+        hashdeleteLEN(&pql->thing, sizeof(pql->thing), &mudstate.queue_htab);
+        MEMFREE(pql);
+    }
+}
+
+static void que_link(BQUE *point, int iQueue)
+{
+    point->owner = Owner(point->executor);
+    point->iQueue = iQueue;
+
+    // The scheduler charges the entry's CPU time and latency to its owner.
+    //
+    point->pTask->m_iShare = point->owner;
+
+    QUE_LIST *pql = que_list(point->executor, true);
+    point->pExecPrev = NULL;
+    point->pExecNext = pql->pExecHead;
+    if (NULL != pql->pExecHead)
+    {
+        pql->pExecHead->pExecPrev = point;
+    }
+    pql->pExecHead = point;
+    pql->nExec++;
+
+    pql = que_list(point->owner, true);
+    point->pOwnerPrev = NULL;
+    point->pOwnerNext = pql->pOwnerHead;
+    if (NULL != pql->pOwnerHead)
+    {
+        pql->pOwnerHead->pOwnerPrev = point;
+    }
+    pql->pOwnerHead = point;
+    pql->aOwned[iQueue]++;
+    s_aQueued[iQueue]++;
+}
+
+static void que_unlink(BQUE *point)
+{
+    if (QUE_NONE == point->iQueue)
+    {
+        return;
+    }
+
+    QUE_LIST *pql = que_list(point->executor, false);
+    if (NULL != pql)
+    {
+        if (NULL == point->pExecPrev)
+        {
+            pql->pExecHead = point->pExecNext;
+        }
+        else
+        {
+            point->pExecPrev->pExecNext = point->pExecNext;
+        }
+        if (NULL != point->pExecNext)
+        {
+            point->pExecNext->pExecPrev = point->pExecPrev;
+        }
+        pql->nExec--;
+        que_list_release(pql);
+    }
+
+    pql = que_list(point->owner, false);
+    if (NULL != pql)
+    {
+        if (NULL == point->pOwnerPrev)
+        {
+            pql->pOwnerHead = point->pOwnerNext;
+        }
+        else
+        {
+            point->pOwnerPrev->pOwnerNext = point->pOwnerNext;
+        }
+        if (NULL != point->pOwnerNext)
+        {
+            point->pOwnerNext->pOwnerPrev = point->pOwnerPrev;
+        }
+        pql->aOwned[point->iQueue]--;
+        que_list_release(pql);
+    }
+    s_aQueued[point->iQueue]--;
+
+    point->iQueue = QUE_NONE;
+    point->pExecNext  = NULL;
+    point->pExecPrev  = NULL;
+    point->pOwnerNext = NULL;
+    point->pOwnerPrev = NULL;
+}
+
+// Moves an entry from one queue to another (e.g., when a semaphore is
+// notified or a query completes).
+//
+static void que_requeue(BQUE *point, int iQueue)
+{
+    if (  QUE_NONE == point->iQueue
+       || iQueue == point->iQueue)
+    {
+        return;
+    }
+
+    QUE_LIST *pql = que_list(point->owner, false);
+    if (NULL != pql)
+    {
+        pql->aOwned[point->iQueue]--;
+        pql->aOwned[iQueue]++;
+    }
+    s_aQueued[point->iQueue]--;
+    s_aQueued[iQueue]++;
+    point->iQueue = iQueue;
+}
+
+// Releases an entry which will not be run.
+//
+static void que_free(BQUE *point)
+{
+    for (int i = 0; i < MAX_GLOBAL_REGS; i++)
+    {
+        if (point->scr[i])
+        {
+            RegRelease(point->scr[i]);
+            point->scr[i] = NULL;
+        }
+    }
+
+    MEMFREE(point->text);
+    point->text = NULL;
+    free_qentry(point);
+}
+
+// This Task removes pEntry from the queue index, but it assumes that pEntry
+// is already unlinked from any semaphore list.
 //
 static void Task_RunQueueEntry(void *pEntry, int iUnused)
 {
     UNUSED_PARAMETER(iUnused);
 
     BQUE *point = (BQUE *)pEntry;
+    que_unlink(point);
+    point->pTask = NULL;
     dbref executor = point->executor;
 
     if (  Good_obj(executor)
        && !Going(executor))
     {
-        giveto(executor, mudconf.waitcost);
+        // Refund the owner who was charged when the entry was queued, even
+        // if the executor has been @chown'ed since.
+        //
+        giveto(point->owner, mudconf.waitcost);
         mudstate.curr_enactor = point->enactor;
         mudstate.curr_executor = executor;
-        a_Queue(Owner(executor), -1);
+        a_Queue(point->owner, -1);
         point->executor = NOTHING;
         if (!Halted(executor))
         {
@@ -264,7 +452,7 @@ static void Task_RunQueueEntry(void *pEntry, int iUnused)
 static bool que_want(BQUE *entry, dbref ptarg, dbref otarg)
 {
     if (  ptarg != NOTHING
-       && ptarg != Owner(entry->executor))
+       && ptarg != entry->owner)
     {
         return false;
     }
@@ -272,6 +460,127 @@ static bool que_want(BQUE *entry, dbref ptarg, dbref otarg)
            || otarg == entry->executor);
 }
 
+// ---------------------------------------------------------------------------
+// Semaphore wait lists.
+//
+// Every queue entry waiting on a semaphore is also linked into a list for its
+// (object, attribute) pair in the order the waits were made. The lists for
+// an object hang off of sem_htab keyed by the object's dbref. This lets
+// @notify and @drain visit only the waiters they affect instead of
+// traversing every task in the scheduler.
+//
+typedef struct sem_list SEM_LIST;
+struct sem_list
+{
+    int       attr;
+    BQUE     *pHead;
+    BQUE     *pTail;
+    SEM_LIST *pNext;
+};
+
+static void sem_link(BQUE *point)
+{
+    dbref sem = point->u.s.sem;
+    SEM_LIST *pHead = (SEM_LIST *)hashfindLEN(&sem, sizeof(sem), &mudstate.sem_htab);
+    SEM_LIST *psl = pHead;
+    while (  NULL != psl
+          && psl->attr != point->u.s.attr)
+    {
+        psl = psl->pNext;
+    }
+
+    if (NULL == psl)
+    {
+        psl = (SEM_LIST *)MEMALLOC(sizeof(SEM_LIST));
+        ISOUTOFMEMORY(psl);
+        psl->attr  = point->u.s.attr;
+        psl->pHead = NULL;
+        psl->pTail = NULL;
+        psl->pNext = pHead;
+        if (NULL == pHead)
+        {
+            hashaddLEN(&sem, sizeof(sem), psl, &mudstate.sem_htab);
+        }
+        else
+        {
+            hashreplLEN(&sem, sizeof(sem), psl, &mudstate.sem_htab);
+        }
+    }
+
+    point->pSemNext = NULL;
+    point->pSemPrev = psl->pTail;
+    if (NULL == psl->pTail)
+    {
+        psl->pHead = point;
+    }
+    else
+    {
+        psl->pTail->pSemNext = point;
+    }
+    psl->pTail = point;
+}
+
+static void sem_unlink(BQUE *point)
+{
+    if (QUE_SEMAPHORE != point->iQueue)
+    {
+        return;
+    }
+
+    dbref sem = point->u.s.sem;
+    SEM_LIST *pHead = (SEM_LIST *)hashfindLEN(&sem, sizeof(sem), &mudstate.sem_htab);
+    SEM_LIST *pPrev = NULL;
+    SEM_LIST *psl = pHead;
+    while (  NULL != psl
+          && psl->attr != point->u.s.attr)
+    {
+        pPrev = psl;
+        psl = psl->pNext;
+    }
+    if (NULL == psl)
+    {
+        return;
+    }
+
+    if (NULL == point->pSemPrev)
+    {
+        psl->pHead = point->pSemNext;
+    }
+    else
+    {
+        point->pSemPrev->pSemNext = point->pSemNext;
+    }
+    if (NULL == point->pSemNext)
+    {
+        psl->pTail = point->pSemPrev;
+    }
+    else
+    {
+        point->pSemNext->pSemPrev = point->pSemPrev;
+    }
+    point->pSemNext = NULL;
+    point->pSemPrev = NULL;
+
+    if (NULL == psl->pHead)
+    {
+        // This was the last waiter for this attribute.
+        //
+        if (NULL != pPrev)
+        {
+            pPrev->pNext = psl->pNext;
+        }
+        else if (NULL != psl->pNext)
+        {
+            hashreplLEN(&sem, sizeof(sem), psl->pNext, &mudstate.sem_htab);
+        }
+        else
+        {
+            hashdeleteLEN(&sem, sizeof(sem), &mudstate.sem_htab);
+        }
+        MEMFREE(psl);
+    }
+}
+
 static void Task_SemaphoreTimeout(void *pExpired, int iUnused)
 {
     UNUSED_PARAMETER(iUnused);
@@ -279,6 +588,7 @@ static void Task_SemaphoreTimeout(void *pExpired, int iUnused)
     // A semaphore has timed out.
     //
     BQUE *point = (BQUE *)pExpired;
+    sem_unlink(point);
     add_to(point->u.s.sem, -1, point->u.s.attr);
     point->u.s.sem = NOTHING;
     Task_RunQueueEntry(point, 0);
@@ -294,12 +604,36 @@ void Task_SQLTimeout(void *pExpired, int iUnused)
     Task_RunQueueEntry(point, 0);
 }
 
-static dbref Halt_Player_Target;
-static dbref Halt_Object_Target;
 static int   Halt_Entries;
 static dbref Halt_Player_Run;
 static dbref Halt_Entries_Run;
 
+static void halt_entry(BQUE *point)
+{
+    // Accounting for pennies and queue quota.
+    //
+    dbref dbOwner = point->owner;
+    if (dbOwner != Halt_Player_Run)
+    {
+        if (Halt_Player_Run != NOTHING)
+        {
+            giveto(Halt_Player_Run, mudconf.waitcost * Halt_Entries_Run);
+            a_Queue(Halt_Player_Run, -Halt_Entries_Run);
+        }
+        Halt_Player_Run = dbOwner;
+        Halt_Entries_Run = 0;
+    }
+    Halt_Entries++;
+    Halt_Entries_Run++;
+    if (QUE_SEMAPHORE == point->iQueue)
+    {
+        sem_unlink(point);
+        add_to(point->u.s.sem, -1, point->u.s.attr);
+    }
+    que_unlink(point);
+    que_free(point);
+}
+
 static int CallBack_HaltQueue(PTASK_RECORD p)
 {
     if (  p->fpTask == Task_RunQueueEntry
@@ -308,47 +642,8 @@ static int CallBack_HaltQueue(PTASK_RECORD p)
     {
         // This is a @wait, timed Semaphore Task, or timed SQL Query.
         //
-        BQUE *point = (BQUE *)(p->arg_voidptr);
-        if (que_want(point, Halt_Player_Target, Halt_Object_Target))
-        {
-            // Accounting for pennies and queue quota.
-            //
-            dbref dbOwner = point->executor;
-            if (!isPlayer(dbOwner))
-            {
-                dbOwner = Owner(dbOwner);
-            }
-            if (dbOwner != Halt_Player_Run)
-            {
-                if (Halt_Player_Run != NOTHING)
-                {
-                    giveto(Halt_Player_Run, mudconf.waitcost * Halt_Entries_Run);
-                    a_Queue(Halt_Player_Run, -Halt_Entries_Run);
-                }
-                Halt_Player_Run = dbOwner;
-                Halt_Entries_Run = 0;
-            }
-            Halt_Entries++;
-            Halt_Entries_Run++;
-            if (p->fpTask == Task_SemaphoreTimeout)
-            {
-                add_to(point->u.s.sem, -1, point->u.s.attr);
-            }
-
-            for (int i = 0; i < MAX_GLOBAL_REGS; i++)
-            {
-                if (point->scr[i])
-                {
-                    RegRelease(point->scr[i]);
-                    point->scr[i] = NULL;
-                }
-            }
-
-            MEMFREE(point->text);
-            point->text = NULL;
-            free_qentry(point);
-            return IU_REMOVE_TASK;
-        }
+        halt_entry((BQUE *)(p->arg_voidptr));
+        return IU_REMOVE_TASK;
     }
     return IU_NEXT_TASK;
 }
@@ -363,17 +658,45 @@ static int CallBack_HaltQueue(PTASK_RECORD p)
 // (<executor>, <object>) matches only queue entries run from <objects>
 //                        and owned by <executor>.
 //
+// Except for the first case, only the entries for the object or player are
+// visited.
+//
 int halt_que(dbref executor, dbref object)
 {
-    Halt_Player_Target = executor;
-    Halt_Object_Target = object;
     Halt_Entries       = 0;
     Halt_Player_Run    = NOTHING;
     Halt_Entries_Run   = 0;
 
-    // Process @wait, timed semaphores, and untimed semaphores.
-    //
-    scheduler.TraverseUnordered(CallBack_HaltQueue);
+    if (  NOTHING == executor
+       && NOTHING == object)
+    {
+        // Process @wait, timed semaphores, and untimed semaphores.
+        //
+        scheduler.TraverseUnordered(CallBack_HaltQueue);
+    }
+    else
+    {
+        QUE_LIST *pql = que_list(NOTHING == object ? executor : object, false);
+        BQUE *point = NULL;
+        if (NULL != pql)
+        {
+            point = (NOTHING == object) ? pql->pOwnerHead : pql->pExecHead;
+        }
+
+        // Halting the last entry frees the list, so pql is not used again.
+        //
+        while (NULL != point)
+        {
+            BQUE *pNext = (NOTHING == object) ? point->pOwnerNext : point->pExecNext;
+            if (que_want(point, executor, object))
+            {
+                PTASK_RECORD pTask = point->pTask;
+                halt_entry(point);
+                scheduler.RemoveTask(pTask);
+            }
+            point = pNext;
+        }
+    }
 
     if (Halt_Player_Run != NOTHING)
     {
@@ -459,112 +782,6 @@ void do_halt(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF
     notify(Owner(executor), tprintf(T("%d queue entr%s removed."), numhalted, numhalted == 1 ? "y" : "ies"));
 }
 
-static int Notify_Key;
-static int Notify_Num_Done;
-static int Notify_Num_Max;
-static int Notify_Sem;
-static int Notify_Attr;
-
-// NFY_DRAIN or NFY_NFYALL
-//
-static int CallBack_NotifySemaphoreDrainOrAll(PTASK_RECORD p)
-{
-    if (p->fpTask == Task_SemaphoreTimeout)
-    {
-        // This represents a semaphore.
-        //
-        BQUE *point = (BQUE *)(p->arg_voidptr);
-        if (  point->u.s.sem == Notify_Sem
-           && (  point->u.s.attr == Notify_Attr
-              || !Notify_Attr))
-        {
-            Notify_Num_Done++;
-            if (NFY_DRAIN == (Notify_Key & NFY_MASK))
-            {
-                // Discard the command
-                //
-                giveto(point->executor, mudconf.waitcost);
-                a_Queue(Owner(point->executor), -1);
-
-                for (int i = 0; i < MAX_GLOBAL_REGS; i++)
-                {
-                    if (point->scr[i])
-                    {
-                        RegRelease(point->scr[i]);
-                        point->scr[i] = NULL;
-                    }
-                }
-
-                MEMFREE(point->text);
-                point->text = NULL;
-                free_qentry(point);
-
-                return IU_REMOVE_TASK;
-            }
-            else
-            {
-                // Allow the command to run. The priority may have been
-                // PRIORITY_SUSPEND, so we need to change it.
-                //
-                if (isPlayer(point->enactor))
-                {
-                    p->iPriority = PRIORITY_PLAYER;
-                }
-                else
-                {
-                    p->iPriority = PRIORITY_OBJECT;
-                }
-                p->ltaWhen.GetUTC();
-                p->fpTask = Task_RunQueueEntry;
-                return IU_UPDATE_TASK;
-            }
-        }
-    }
-    return IU_NEXT_TASK;
-}
-
-// NFY_NFY
-//
-static int CallBack_NotifySemaphoreFirst(PTASK_RECORD p)
-{
-    // If we've notified enough, exit.
-    //
-    if (  NFY_NFY == (Notify_Key & NFY_MASK)
-       && Notify_Num_Done >= Notify_Num_Max)
-    {
-        return IU_DONE;
-    }
-
-    if (p->fpTask == Task_SemaphoreTimeout)
-    {
-        // This represents a semaphore.
-        //
-        BQUE *point = (BQUE *)(p->arg_voidptr);
-        if (  point->u.s.sem == Notify_Sem
-           && (  point->u.s.attr == Notify_Attr
-              || !Notify_Attr))
-        {
-            Notify_Num_Done++;
-
-            // Allow the command to run. The priority may have been
-            // PRIORITY_SUSPEND, so we need to change it.
-            //
-            if (isPlayer(point->enactor))
-            {
-                p->iPriority = PRIORITY_PLAYER;
-            }
-            else
-            {
-                p->iPriority = PRIORITY_OBJECT;
-            }
-            p->ltaWhen.GetUTC();
-            p->fpTask = Task_RunQueueEntry;
-            return IU_UPDATE_TASK;
-        }
-    }
-    return IU_NEXT_TASK;
-}
-
 // ---------------------------------------------------------------------------
 // nfy_que: Notify commands from the queue and perform or discard them.
 
@@ -580,20 +797,69 @@ int nfy_que(dbref sem, int attr, int key, int count)
         free_lbuf(str);
     }
 
-    Notify_Num_Done = 0;
+    int nDone = 0;
     if (0 < cSemaphore)
     {
-        Notify_Key     = key;
-        Notify_Sem     = sem;
-        Notify_Attr    = attr;
-        Notify_Num_Max = count;
-        if (NFY_NFY == (key & NFY_MASK))
-        {
-            scheduler.TraverseOrdered(CallBack_NotifySemaphoreFirst);
-        }
-        else
+        SEM_LIST *psl = (SEM_LIST *)hashfindLEN(&sem, sizeof(sem), &mudstate.sem_htab);
+        while (NULL != psl)
         {
-            scheduler.TraverseUnordered(CallBack_NotifySemaphoreDrainOrAll);
+            // Unlinking the last waiter frees the list, so move on first.
+            //
+            SEM_LIST *pslNext = psl->pNext;
+            if (  0 == attr
+               || psl->attr == attr)
+            {
+                BQUE *point = psl->pHead;
+                while (NULL != point)
+                {
+                    if (  NFY_NFY == (key & NFY_MASK)
+                       && count <= nDone)
+                    {
+                        break;
+                    }
+                    nDone++;
+
+                    BQUE *pNext = point->pSemNext;
+                    PTASK_RECORD pTask = point->pTask;
+                    sem_unlink(point);
+
+                    if (NFY_DRAIN == (key & NFY_MASK))
+                    {
+                        // Discard the command
+                        //
+                        giveto(point->owner, mudconf.waitcost);
+                        a_Queue(point->owner, -1);
+                        que_unlink(point);
+                        que_free(point);
+                        scheduler.RemoveTask(pTask);
+                    }
+                    else
+                    {
+                        // Allow the command to run. The priority may have
+                        // been PRIORITY_SUSPEND, so we need to change it.
+                        //
+                        if (isPlayer(point->enactor))
+                        {
+                            pTask->iPriority = PRIORITY_PLAYER;
+                        }
+                        else
+                        {
+                            pTask->iPriority = PRIORITY_OBJECT;
+                        }
+                        pTask->ltaWhen.GetUTC();
+                        pTask->fpTask = Task_RunQueueEntry;
+                        scheduler.UpdateTask(pTask);
+                        que_requeue(point, QUE_WAIT);
+                    }
+
+                    point = pNext;
+                }
+                if (attr)
+                {
+                    break;
+                }
+            }
+            psl = pslNext;
         }
     }
 
@@ -608,7 +874,7 @@ int nfy_que(dbref sem, int attr, int key, int count)
         atr_clr(sem, attr);
     }
 
-    return Notify_Num_Done;
+    return nDone;
 }
 
 // ---------------------------------------------------------------------------
@@ -854,6 +1120,15 @@ static BQUE *setup_que
     tmp->IsTimed = false;
     tmp->u.s.sem = NOTHING;
     tmp->u.s.attr = 0;
+    tmp->owner = Owner(executor);
+    tmp->iQueue = QUE_NONE;
+    tmp->pTask = NULL;
+    tmp->pSemNext = NULL;
+    tmp->pSemPrev = NULL;
+    tmp->pExecNext = NULL;
+    tmp->pExecPrev = NULL;
+    tmp->pOwnerNext = NULL;
+    tmp->pOwnerPrev = NULL;
     tmp->enactor = enactor;
     tmp->caller = caller;
     tmp->eval = eval;
@@ -917,11 +1192,15 @@ void wait_que
         //
         if (tmp->IsTimed)
         {
-            scheduler.DeferTask(tmp->waittime, iPriority, Task_RunQueueEntry, tmp, 0);
+            tmp->pTask = scheduler.DeferTask(tmp->waittime, iPriority, Task_RunQueueEntry, tmp, 0);
         }
         else
         {
-            scheduler.DeferImmediateTask(iPriority, Task_RunQueueEntry, tmp, 0);
+            tmp->pTask = scheduler.DeferImmediateTask(iPriority, Task_RunQueueEntry, tmp, 0);
+        }
+        if (NULL != tmp->pTask)
+        {
+            que_link(tmp, QUE_WAIT);
         }
     }
     else
@@ -934,7 +1213,12 @@ void wait_que
             //
             iPriority = PRIORITY_SUSPEND;
         }
-        scheduler.DeferTask(tmp->waittime, iPriority, Task_SemaphoreTimeout, tmp, 0);
+        tmp->pTask = scheduler.DeferTask(tmp->waittime, iPriority, Task_SemaphoreTimeout, tmp, 0);
+        if (NULL != tmp->pTask)
+        {
+            que_link(tmp, QUE_SEMAPHORE);
+            sem_link(tmp);
+        }
     }
 }
 
@@ -963,6 +1247,7 @@ static int CallBack_QueryComplete(PTASK_RECORD p)
 
             point->u.s.sem    = NOTHING;
             point->u.s.attr   = 0;
+            que_requeue(point, QUE_WAIT);
             QueryComplete_prsResultsSet->AddRef();
             point->pResultsSet = QueryComplete_prsResultsSet;
             point->iRow = RS_TOP;
@@ -1043,11 +1328,22 @@ void sql_que
 
     tmp->u.hQuery = hQuery;
 
-    scheduler.DeferTask(tmp->waittime, PRIORITY_SUSPEND, Task_SQLTimeout, tmp, 0);
+    tmp->pTask = scheduler.DeferTask(tmp->waittime, PRIORITY_SUSPEND, Task_SQLTimeout, tmp, 0);
+    if (NULL == tmp->pTask)
+    {
+        return;
+    }
+    que_link(tmp, QUE_SQL);
+
     MUX_RESULT mr = mudstate.pIQueryControl->Query(hQuery, dbname, query);
     if (MUX_FAILED(mr))
     {
-        scheduler.CancelTask(Task_SQLTimeout, tmp, next_handle);
+        PTASK_RECORD pTask = tmp->pTask;
+        giveto(tmp->owner, mudconf.waitcost);
+        a_Queue(tmp->owner, -1);
+        que_unlink(tmp);
+        que_free(tmp);
+        scheduler.RemoveTask(pTask);
     }
 }
 
@@ -1286,6 +1582,12 @@ static int CallBack_ShowDispatches(PTASK_RECORD p)
     {
         notify(Show_Player, tprintf(T("[%d]Further command quota"), ltd.ReturnSeconds()));
     }
+#if defined(UNIX_THREADS)
+    else if (p->fpTask == Task_PassJobs)
+    {
+        notify(Show_Player, tprintf(T("[%d]Password hashing results"), ltd.ReturnSeconds()));
+    }
+#endif // UNIX_THREADS
 #if defined(WINDOWS_NETWORKING)
     else if (p->fpTask == Task_FreeDescriptor)
     {
@@ -1424,6 +1726,157 @@ int CallBack_ShowSQLQueries(PTASK_RECORD p)
     return IU_NEXT_TASK;
 }
 
+// Orders queue entries the way TraverseOrdered would visit them.
+//
+static int CompareQueueEntries(const void *pa, const void *pb)
+{
+    PTASK_RECORD pTaskA = (*(BQUE **)pa)->pTask;
+    PTASK_RECORD pTaskB = (*(BQUE **)pb)->pTask;
+    if (pTaskA->ltaWhen < pTaskB->ltaWhen)
+    {
+        return -1;
+    }
+    else if (pTaskA->ltaWhen > pTaskB->ltaWhen)
+    {
+        return 1;
+    }
+    return (pTaskA->m_Ticket) - (pTaskB->m_Ticket);
+}
+
+// Lists the entries for one object or one owner from the queue index.
+//
+static void ShowIndexedQueue(void)
+{
+    Total_RunQueueEntry    = s_aQueued[QUE_WAIT];
+    Total_SemaphoreTimeout = s_aQueued[QUE_SEMAPHORE];
+    Total_SQLTimeout       = s_aQueued[QUE_SQL];
+
+    bool bOwner = (NOTHING == Show_Object_Target);
+    QUE_LIST *pql = que_list(bOwner ? Show_Player_Target : Show_Object_Target, false);
+    if (NULL == pql)
+    {
+        return;
+    }
+
+    int nEntries = pql->nExec;
+    if (bOwner)
+    {
+        nEntries = 0;
+        for (int i = 0; i < QUE_KINDS; i++)
+        {
+            nEntries += pql->aOwned[i];
+        }
+    }
+    if (nEntries <= 0)
+    {
+        return;
+    }
+
+    BQUE **aEntries = (BQUE **)MEMALLOC(nEntries * sizeof(BQUE *));
+    ISOUTOFMEMORY(aEntries);
+
+    int nShown = 0;
+    BQUE *point = bOwner ? pql->pOwnerHead : pql->pExecHead;
+    while (  NULL != point
+          && nShown < nEntries)
+    {
+        if (que_want(point, Show_Player_Target, Show_Object_Target))
+        {
+            aEntries[nShown++] = point;
+            switch (point->iQueue)
+            {
+            case QUE_WAIT:
+                Shown_RunQueueEntry++;
+                break;
+
+            case QUE_SEMAPHORE:
+                Shown_SemaphoreTimeout++;
+                break;
+
+            case QUE_SQL:
+                Shown_SQLTimeout++;
+                break;
+            }
+        }
+        point = bOwner ? point->pOwnerNext : point->pExecNext;
+    }
+
+    if (Show_Key != PS_SUMM)
+    {
+        static const UTF8 *aHeadings[QUE_KINDS] =
+        {
+            T("----- Wait Queue -----"),
+            T("----- Semaphore Queue -----"),
+            T("----- SQL Queries -----")
+        };
+
+        qsort(aEntries, nShown, sizeof(BQUE *), CompareQueueEntries);
+        for (int iQueue = 0; iQueue < QUE_KINDS; iQueue++)
+        {
+            bool bFirstLine = true;
+            for (int i = 0; i < nShown; i++)
+            {
+                if (aEntries[i]->iQueue == iQueue)
+                {
+                    if (bFirstLine)
+                    {
+                        notify(Show_Player, aHeadings[iQueue]);
+                        bFirstLine = false;
+                    }
+                    ShowPsLine(aEntries[i]);
+                }
+            }
+        }
+    }
+    MEMFREE(aEntries);
+}
+
+// Formats how long an owner's queue entries have waited to run.
+//
+static void QueueLatency(dbref owner, UTF8 *buff, size_t nBuffer)
+{
+    CLinearTimeDelta ltdAverage, ltdMaximum;
+    int nRun;
+    if (scheduler.ShareLatency(owner, &ltdAverage, &ltdMaximum, &nRun))
+    {
+        mux_sprintf(buff, nBuffer, T("Latency...%ld/%ld ms over %d"),
+            ltdAverage.ReturnMilliseconds(), ltdMaximum.ReturnMilliseconds(), nRun);
+    }
+    else
+    {
+        buff[0] = '\0';
+    }
+}
+
+// Reports the queue counts kept for each owner.
+//
+static void ShowQueueOwners(void)
+{
+    UTF8 *pLatency = alloc_mbuf("ShowQueueOwners");
+    bool bFirstLine = true;
+    for (QUE_LIST *pql = (QUE_LIST *)hash_firstentry(&mudstate.queue_htab);
+         NULL != pql;
+         pql = (QUE_LIST *)hash_nextentry(&mudstate.queue_htab))
+    {
+        if (NULL == pql->pOwnerHead)
+        {
+            continue;
+        }
+        if (bFirstLine)
+        {
+            notify(Show_Player, T("----- Owners -----"));
+            bFirstLine = false;
+        }
+        UTF8 *bufp = unparse_object(Show_Player, pql->thing, false);
+        QueueLatency(pql->thing, pLatency, MBUF_SIZE);
+        notify(Show_Player, tprintf(T("%s: Wait Queue...%d  Semaphores...%d  SQL %d  %s"),
+            bufp, pql->aOwned[QUE_WAIT], pql->aOwned[QUE_SEMAPHORE],
+            pql->aOwned[QUE_SQL], pLatency));
+        free_lbuf(bufp);
+    }
+    free_mbuf(pLatency);
+}
+
 // ---------------------------------------------------------------------------
 // do_ps: tell executor what commands they have pending in the queue
 //
@@ -1480,6 +1933,7 @@ void do_ps(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8
             obj_targ = NOTHING;
         }
     }
+    bool bAll = ((key & PS_ALL) != 0);
     key = key & ~PS_ALL;
 
     switch (key)
@@ -1506,12 +1960,26 @@ void do_ps(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8
     Show_Object_Target = obj_targ;
     Show_Key = key;
     Show_Player = executor;
-    Show_bFirstLine = true;
-    scheduler.TraverseOrdered(CallBack_ShowWait);
-    Show_bFirstLine = true;
-    scheduler.TraverseOrdered(CallBack_ShowSemaphore);
-    Show_bFirstLine = true;
-    scheduler.TraverseOrdered(CallBack_ShowSQLQueries);
+    if (!bAll)
+    {
+        ShowIndexedQueue();
+    }
+    else if (PS_SUMM == key)
+    {
+        Total_RunQueueEntry    = Shown_RunQueueEntry    = s_aQueued[QUE_WAIT];
+        Total_SemaphoreTimeout = Shown_SemaphoreTimeout = s_aQueued[QUE_SEMAPHORE];
+        Total_SQLTimeout       = Shown_SQLTimeout       = s_aQueued[QUE_SQL];
+        ShowQueueOwners();
+    }
+    else
+    {
+        Show_bFirstLine = true;
+        scheduler.TraverseOrdered(CallBack_ShowWait);
+        Show_bFirstLine = true;
+        scheduler.TraverseOrdered(CallBack_ShowSemaphore);
+        Show_bFirstLine = true;
+        scheduler.TraverseOrdered(CallBack_ShowSQLQueries);
+    }
     if (Wizard(executor))
     {
         notify(executor, T("----- System Queue -----"));
@@ -1526,6 +1994,14 @@ void do_ps(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8
         Shown_SemaphoreTimeout, Total_SemaphoreTimeout,
         Shown_SQLTimeout, Total_SQLTimeout);
     notify(executor, bufp);
+    if (NOTHING != executor_targ)
+    {
+        QueueLatency(executor_targ, bufp, MBUF_SIZE);
+        if ('\0' != bufp[0])
+        {
+            notify(executor, tprintf(T("        %s"), bufp));
+        }
+    }
     if (Wizard(executor))
     {
         mux_sprintf(bufp, MBUF_SIZE, T("        System Tasks.....%d"), Total_SystemTasks);
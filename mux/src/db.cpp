@@ -575,6 +575,10 @@ FWDLIST *fwdlist_get(dbref thing)
 // Name, PureName, Moniker, s_Moniker, and s_Name: Get or set object's
 // various names.
 //
+// The name is decoded from A_NAME once and kept in the object until s_Name()
+// changes it, in both disk-based and memory-based builds.  The stripped name
+// and moniker share the name's copy when they are the same.
+//
 const UTF8 *Name(dbref thing)
 {
     if (thing < 0)
@@ -582,22 +586,16 @@ const UTF8 *Name(dbref thing)
         return aszSpecialDBRefNames[-thing];
     }
 
-    dbref aowner;
-    int aflags;
-#ifdef MEMORY_BASED
-    static UTF8 tbuff[LBUF_SIZE];
-    atr_get_str(tbuff, thing, A_NAME, &aowner, &aflags);
-    return tbuff;
-#else // MEMORY_BASED
     if (!db[thing].name)
     {
+        dbref aowner;
+        int aflags;
         size_t len;
         UTF8 *pName = atr_get_LEN(thing, A_NAME, &aowner, &aflags, &len);
         db[thing].name = StringCloneLen(pName, len);
         free_lbuf(pName);
     }
     return db[thing].name;
-#endif // MEMORY_BASED
 }
 
 const UTF8 *PureName(dbref thing)
@@ -607,33 +605,14 @@ const UTF8 *PureName(dbref thing)
         return aszSpecialDBRefNames[-thing];
     }
 
-    dbref aowner;
-    int aflags;
-
     UTF8 *pName, *pPureName;
     if (mudconf.cache_names)
     {
         if (!db[thing].purename)
         {
-            size_t nName;
             size_t nPureName;
-#ifdef MEMORY_BASED
-            pName = atr_get_LEN(thing, A_NAME, &aowner, &aflags, &nName);
-            pPureName = strip_color(pName, &nPureName);
-            free_lbuf(pName);
-            db[thing].purename = StringCloneLen(pPureName, nPureName);
-#else // MEMORY_BASED
-            if (!db[thing].name)
-            {
-                pName = atr_get_LEN(thing, A_NAME, &aowner, &aflags, &nName);
-                db[thing].name = StringCloneLen(pName, nName);
-                free_lbuf(pName);
-            }
-            else
-            {
-                nName = strlen((char *)db[thing].name);
-            }
-            pName = db[thing].name;
+            pName = (UTF8 *)Name(thing);
+            size_t nName = strlen((char *)pName);
             pPureName = strip_color(pName, &nPureName);
             if (nPureName == nName)
             {
@@ -643,14 +622,10 @@ const UTF8 *PureName(dbref thing)
             {
                 db[thing].purename = StringCloneLen(pPureName, nPureName);
             }
-#endif // MEMORY_BASED
         }
         return db[thing].purename;
     }
-    pName = atr_get("PureName.631", thing, A_NAME, &aowner, &aflags);
-    pPureName = strip_color(pName);
-    free_lbuf(pName);
-    return pPureName;
+    return strip_color(Name(thing));
 }
 
 const UTF8 *Moniker(dbref thing)
@@ -687,9 +662,6 @@ const UTF8 *Moniker(dbref thing)
         //
         if (mudconf.cache_names)
         {
-#ifdef MEMORY_BASED
-            db[thing].moniker = StringCloneLen(pMoniker, nMoniker);
-#else // MEMORY_BASED
             if (strcmp((char *)pMoniker, (char *)Name(thing)) == 0)
             {
                 db[thing].moniker = db[thing].name;
@@ -698,7 +670,6 @@ const UTF8 *Moniker(dbref thing)
             {
                 db[thing].moniker = StringCloneLen(pMoniker, nMoniker);
             }
-#endif // MEMORY_BASED
             pReturn = db[thing].moniker;
         }
         else
@@ -712,27 +683,11 @@ const UTF8 *Moniker(dbref thing)
         // @moniker can't be used, so instead reflect @name (whether it
         // contains ANSI color and accents or not).
         //
-#ifdef MEMORY_BASED
-        if (mudconf.cache_names)
-        {
-            db[thing].moniker = StringClone(Name(thing));
-            pReturn = db[thing].moniker;
-        }
-        else
-        {
-            pReturn = Name(thing);
-        }
-#else // MEMORY_BASED
+        pReturn = Name(thing);
         if (mudconf.cache_names)
         {
             db[thing].moniker = db[thing].name;
-            pReturn = db[thing].moniker;
-        }
-        else
-        {
-            pReturn = Name(thing);
         }
-#endif // MEMORY_BASED
     }
     free_lbuf(pMoniker);
     MEMFREE(pPureNameCopy);
@@ -742,7 +697,6 @@ const UTF8 *Moniker(dbref thing)
 
 void free_Names(OBJ *p)
 {
-#ifndef MEMORY_BASED
     if (p->name)
     {
         if (mudconf.cache_names)
@@ -759,7 +713,6 @@ void free_Names(OBJ *p)
         MEMFREE(p->name);
         p->name = NULL;
     }
-#endif // !MEMORY_BASED
 
     if (mudconf.cache_names)
     {
@@ -781,24 +734,21 @@ void s_Name(dbref thing, const UTF8 *s)
 {
     free_Names(&db[thing]);
     atr_add_raw(thing, A_NAME, s);
-#ifndef MEMORY_BASED
+    name_index_invalidate(Location(thing));
     if (NULL != s)
     {
         db[thing].name = StringClone(s);
     }
-#endif // !MEMORY_BASED
 }
 
 void free_Moniker(OBJ *p)
 {
     if (mudconf.cache_names)
     {
-#ifndef MEMORY_BASED
         if (p->name == p->moniker)
         {
             p->moniker = NULL;
         }
-#endif // !MEMORY_BASED
         if (p->moniker)
         {
             MEMFREE(p->moniker);
@@ -896,6 +846,7 @@ void do_attribute
             if (search_nametab(executor, attraccess_nametab, sp, &f))
             {
                 success = true;
+                mudstate.bDirtyAttrNames = true;
                 if (negate)
                 {
                     va->flags &= ~f;
@@ -2030,6 +1981,10 @@ static void atr_decode_LEN(const UTF8 *iattr, size_t nLen, UTF8 *oattr,
 
 void atr_clr(dbref thing, int atr)
 {
+    exec_cache_invalidate(thing, atr);
+    cmd_index_invalidate(thing);
+    s_Dirty(thing);
+
 #ifdef MEMORY_BASED
 
     if (  !db[thing].nALUsed
@@ -2105,6 +2060,7 @@ void atr_clr(dbref thing, int atr)
     case A_LISTEN:
 
         db[thing].fs.word[FLAG_WORD2] &= ~HAS_LISTEN;
+        hearers_invalidate(Location(thing));
         break;
 
     case A_TIMEOUT:
@@ -2140,6 +2096,9 @@ void atr_add_raw_LEN(dbref thing, int atr, const UTF8 *szValue, size_t nValue)
         atr_clr(thing, atr);
         return;
     }
+    exec_cache_invalidate(thing, atr);
+    cmd_index_invalidate(thing);
+    s_Dirty(thing);
 
 #ifdef MEMORY_BASED
     ATRLIST *list = db[thing].pALHead;
@@ -2290,6 +2249,7 @@ FoundAttribute:
     case A_LISTEN:
 
         db[thing].fs.word[FLAG_WORD2] |= HAS_LISTEN;
+        hearers_invalidate(Location(thing));
         break;
 
     case A_TIMEOUT:
@@ -2578,7 +2538,9 @@ bool atr_pget_info(dbref thing, int atr, dbref *owner, int *flags)
 
 void atr_free(dbref thing)
 {
+    cmd_index_invalidate(thing);
 #ifdef MEMORY_BASED
+    s_Dirty(thing);
     if (db[thing].pALHead)
     {
         MEMFREE(db[thing].pALHead);
@@ -2932,9 +2894,8 @@ static void initialize_objects(dbref first, dbref last)
         db[thing].pALHead  = NULL;
         db[thing].nALAlloc = 0;
         db[thing].nALUsed  = 0;
-#else
-        db[thing].name = NULL;
 #endif // MEMORY_BASED
+        db[thing].name = NULL;
         db[thing].purename = NULL;
         db[thing].moniker = NULL;
     }
@@ -2946,6 +2907,7 @@ void db_grow(dbref newtop)
     mudstate.bfNoCommands.Resize(newtop);
     mudstate.bfListens.Resize(newtop);
     mudstate.bfNoListens.Resize(newtop);
+    mudstate.bfDirty.Resize(newtop);
 
     int delta;
     if (mudstate.bStandAlone)
@@ -166,6 +166,7 @@ struct object
     int     throttled_mail;
     int     throttled_references;
 
+    UTF8    *name;      // Decoded A_NAME.  See Name().
     UTF8    *purename;
     UTF8    *moniker;
 
@@ -173,8 +174,6 @@ struct object
     ATRLIST *pALHead;   /* The head of the attribute list.       */
     int      nALAlloc;  /* Size of the allocated attribute list. */
     int      nALUsed;   /* Used portion of the attribute list.   */
-#else
-    UTF8    *name;
 #endif // MEMORY_BASED
 };
 
@@ -203,19 +202,31 @@ extern OBJ *db;
 #define ThMail(t)       db[t].throttled_mail
 #define ThRefs(t)       db[t].throttled_references
 
-#define s_Location(t,n)     db[t].location = (n)
+// Remember which objects an incremental checkpoint needs to write.
+//
+#define s_Dirty(t)          mudstate.bfDirty.Set(t)
 
-#define s_Zone(t,n)         db[t].zone = (n)
+// Forget which objects in a location can hear.  See notify_contents().
+//
+void hearers_invalidate(dbref loc);
 
-#define s_Contents(t,n)     db[t].contents = (n)
-#define s_Exits(t,n)        db[t].exits = (n)
-#define s_Next(t,n)         db[t].next = (n)
-#define s_Link(t,n)         db[t].link = (n)
-#define s_Owner(t,n)        db[t].owner = (n)
-#define s_Parent(t,n)       db[t].parent = (n)
-#define s_Flags(t,f,n)      db[t].fs.word[f] = (n)
-#define s_Powers(t,n)       db[t].powers = (n)
-#define s_Powers2(t,n)      db[t].powers2 = (n)
+// Forget the names of the objects in a location.  See match_list().
+//
+void name_index_invalidate(dbref loc);
+
+#define s_Location(t,n)     (s_Dirty(t), db[t].location = (n))
+
+#define s_Zone(t,n)         (s_Dirty(t), db[t].zone = (n))
+
+#define s_Contents(t,n)     (s_Dirty(t), hearers_invalidate(t), name_index_invalidate(t), db[t].contents = (n))
+#define s_Exits(t,n)        (s_Dirty(t), db[t].exits = (n))
+#define s_Next(t,n)         (s_Dirty(t), hearers_invalidate(db[t].location), name_index_invalidate(db[t].location), db[t].next = (n))
+#define s_Link(t,n)         (s_Dirty(t), db[t].link = (n))
+#define s_Owner(t,n)        (s_Dirty(t), db[t].owner = (n))
+#define s_Parent(t,n)       (s_Dirty(t), db[t].parent = (n))
+#define s_Flags(t,f,n)      (s_Dirty(t), hearers_invalidate(db[t].location), db[t].fs.word[f] = (n))
+#define s_Powers(t,n)       (s_Dirty(t), db[t].powers = (n))
+#define s_Powers2(t,n)      (s_Dirty(t), db[t].powers2 = (n))
 #define s_Home(t,n)         s_Link(t,n)
 #define s_Dropto(t,n)       s_Location(t,n)
 #define s_ThAttrib(t,n)     db[t].throttled_attributes = (n);
@@ -250,6 +261,9 @@ void db_free(void);
 void db_make_minimal(void);
 dbref    db_read(FILE *, int *, int *, int *);
 dbref    db_write(FILE *, int, int);
+dbref    db_write_binary(FILE *, int);
+int      db_read_journal(FILE *);
+int      db_write_journal(FILE *, int);
 void destroy_thing(dbref);
 void destroy_exit(dbref);
 void putstring(FILE *f, const UTF8 *s);
@@ -13,6 +13,10 @@
 #include "mathutil.h"
 #include "vattr.h"
 
+#if defined(UNIX_THREADS)
+#include <signal.h>
+#endif // UNIX_THREADS
+
 static int g_version;
 static int g_format;
 static int g_flags;
@@ -347,139 +351,1171 @@ static bool get_list(FILE *f, dbref i)
     }
 }
 
-dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
+/* ---------------------------------------------------------------------------
+ * db_read_attrname: Read and define one user-named attribute.
+ */
+
+static void db_read_attrname(FILE *f)
 {
-    dbref i, anum;
-    int ch;
-    const UTF8 *tstr;
+    size_t nBuffer;
     int aflags;
-    BOOLEXP *tempbool;
-    UTF8 *buff;
+    int anum = getref(f);
+    const UTF8 *tstr = (UTF8 *)getstring_noalloc(f, true, &nBuffer);
+    if (mux_isdigit(*tstr))
+    {
+        aflags = 0;
+        while (mux_isdigit(*tstr))
+        {
+            aflags = (aflags * 10) + (*tstr++ - '0');
+        }
+        tstr++; // skip ':'
+    }
+    else
+    {
+        aflags = mudconf.vattr_flags;
+    }
+
+    // If v2 flatfile or earlier, convert tstr to UTF-8.
+    //
+    if (g_version <= 2)
+    {
+        size_t nUnused;
+        tstr = ConvertToUTF8((char *)tstr, &nUnused);
+    }
+
+    size_t nName;
+    bool bValid;
+    UTF8 *pName = MakeCanonicalAttributeName(tstr, &nName, &bValid);
+    if (bValid)
+    {
+        // Maximum attribute number across all names.
+        //
+        if (g_max_nam_atr < anum)
+        {
+            g_max_nam_atr = anum;
+        }
+
+        vattr_define_LEN(pName, nName, anum, aflags);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * db_read_object: Read the fields and attributes of one object.
+ */
+
+static bool db_read_object
+(
+    FILE *f,
+    dbref i,
+    bool read_name,
+    bool read_key,
+    bool read_money,
+    bool read_attribs
+)
+{
+    const UTF8 *tstr;
     size_t nBuffer;
+    UTF8 *buff;
+    BOOLEXP *tempbool;
 
-    g_format = F_UNKNOWN;
-    g_version = 0;
-    g_flags = 0;
-    g_max_nam_atr = INT_MIN;
-    g_max_obj_atr = INT_MIN;
+    if (read_name)
+    {
+        tstr = (UTF8 *)getstring_noalloc(f, true, &nBuffer);
+        if (g_version <= 2)
+        {
+            size_t nUsed;
+            tstr = ConvertToUTF8((char *)tstr, &nUsed);
+        }
+        buff = alloc_mbuf("dbread.s_Name");
+        StripTabsAndTruncate(tstr, buff, MBUF_SIZE-1, MBUF_SIZE-1);
+        s_Name(i, buff);
+        free_mbuf(buff);
 
+        s_Location(i, getref(f));
+    }
+    else
+    {
+        s_Location(i, getref(f));
+    }
 
-    bool header_gotten = false;
-    bool size_gotten = false;
-    bool nextattr_gotten = false;
+    // ZONE
+    //
+    int zone;
+    zone = getref(f);
+    if (zone < NOTHING)
+    {
+        zone = NOTHING;
+    }
+    s_Zone(i, zone);
 
-    bool convert_values = false;
-    bool read_attribs = true;
-    bool read_name = true;
-    bool read_key = true;
-    bool read_money = true;
+    // CONTENTS and EXITS
+    //
+    s_Contents(i, getref(f));
+    s_Exits(i, getref(f));
 
-    size_t nName;
-    bool bValid;
-    UTF8 *pName;
+    // LINK
+    //
+    s_Link(i, getref(f));
 
-    int iDotCounter = 0;
-    if (mudstate.bStandAlone)
+    // NEXT
+    //
+    s_Next(i, getref(f));
+
+    // LOCK
+    //
+    if (read_key)
     {
-        Log.WriteString(T("Reading "));
-        Log.Flush();
+        // Parse lock directly from flatfile.
+        // Only used when reading v2 format.
+        //
+        tempbool = getboolexp(f);
+        atr_add_raw(i, A_LOCK, unparse_boolexp_quiet(1, tempbool));
+        free_boolexp(tempbool);
     }
 
-    db_free();
-    for (i = 0;; i++)
+    // OWNER
+    //
+    s_Owner(i, getref(f));
+
+    // PARENT
+    //
+    s_Parent(i, getref(f));
+
+    // PENNIES
+    //
+    if (read_money)
     {
-        if (mudstate.bStandAlone)
+        s_PenniesDirect(i, getref(f));
+    }
+
+    // FLAGS
+    //
+    s_Flags(i, FLAG_WORD1, getref(f));
+    s_Flags(i, FLAG_WORD2, getref(f));
+    s_Flags(i, FLAG_WORD3, getref(f));
+
+    // POWERS
+    //
+    s_Powers(i, getref(f));
+    s_Powers2(i, getref(f));
+
+    // ATTRIBUTES
+    //
+    if (read_attribs)
+    {
+        if (!get_list(f, i))
         {
-            if (!iDotCounter)
-            {
-                iDotCounter = 100;
-                fputc('.', stderr);
-                fflush(stderr);
-            }
-            iDotCounter--;
+            Log.tinyprintf(T(ENDLINE "Error reading attrs for object #%d" ENDLINE), i);
+            return false;
+        }
+    }
+
+    // check to see if it's a player
+    //
+    if (isPlayer(i))
+    {
+        c_Connected(i);
+    }
+    return true;
+}
+
+/* ---------------------------------------------------------------------------
+ * db_check_attr_next: Reconcile the next free attribute number with the
+ * attribute numbers which were actually read.
+ */
+
+static void db_check_attr_next(bool nextattr_gotten)
+{
+    if (g_max_nam_atr < g_max_obj_atr)
+    {
+        Log.tinyprintf(T(ENDLINE "Warning: One or more attribute values are unnamed. Did you use ./Backup on a running game?"));
+    }
+
+    if (!nextattr_gotten)
+    {
+        Log.tinyprintf(T(ENDLINE "Warning: Missing +N<next free>. Adjusting."));
+    }
+
+    if (mudstate.attr_next <= g_max_nam_atr)
+    {
+        if (nextattr_gotten)
+        {
+            Log.tinyprintf(T(ENDLINE "Warning: +N<next free attr> conflicts with existing attribute names. Adjusting."));
         }
+        mudstate.attr_next = g_max_nam_atr + 1;
+    }
 
-        ch = getc(f);
-        switch (ch)
+    if (mudstate.attr_next <= g_max_obj_atr)
+    {
+        if (nextattr_gotten)
         {
-        case '-':   // Misc tag
-            ch = getc(f);
-            if (ch == 'R')
+            Log.tinyprintf(T(ENDLINE "Warning: +N<next free attr> conflicts object attribute numbers. Adjusting."));
+        }
+        mudstate.attr_next = g_max_nam_atr + 1;
+    }
+
+    int max_atr = A_USER_START;
+    if (max_atr < g_max_nam_atr)
+    {
+        max_atr = g_max_nam_atr;
+    }
+
+    if (max_atr < g_max_obj_atr)
+    {
+        max_atr = g_max_obj_atr;
+    }
+
+    if (max_atr + 1 < mudstate.attr_next)
+    {
+        if (nextattr_gotten)
+        {
+            Log.tinyprintf(T(ENDLINE "Info: +N<next free attr> can be safely adjusted down."));
+        }
+        mudstate.attr_next = max_atr + 1;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Binary flatfile.
+ *
+ * A binary flatfile starts with the line "+B1" and is followed by a body of
+ * records.  A record is a one-byte tag, a 32-bit length, and that many bytes.
+ * Integers are 32-bit and little-endian.  Strings are a 32-bit length, the
+ * bytes, and a terminating '\0' so that they can be used in place.
+ *
+ *   'X'  flags and version (as in +X), size (+S), next free attribute
+ *        number (+N), and record number of players (-R).
+ *   'A'  One user-named attribute: number, flags, and name.
+ *   'O'  One object: dbref, name, location, zone, contents, exits, link,
+ *        next, owner, parent, pennies, three flag words, two power words,
+ *        and an attribute count followed by a number and value for each.
+ *        As in the text format, the name, pennies, and attributes are only
+ *        present if the flags say so.
+ *   'I'  The object index: an object count followed by a dbref and the
+ *        64-bit body offset of each 'O' record, in dbref order.
+ *
+ * The body ends with the 64-bit offset of the 'I' record and eight bytes of
+ * BINARY_MAGIC.  Because the index gives the location of every object up
+ * front, ranges of objects can be decoded by several threads at once.
+ */
+
+#define BINARY_VERSION          1
+#define BINARY_MAGIC            "MUXBIDX\n"
+#define SIZEOF_BINARY_TRAILER   16
+#define SIZEOF_BINARY_INDEX     12
+
+#define BINARY_TAG_HEADER       'X'
+#define BINARY_TAG_ATTRNAME     'A'
+#define BINARY_TAG_OBJECT       'O'
+#define BINARY_TAG_INDEX        'I'
+
+// Objects are decoded in ranges of at least this many, and by no more than
+// this many threads.
+//
+#define BINARY_MIN_RANGE        1024
+#define BINARY_MAX_THREADS      8
+
+// Each record is built here before it is written so that its length is
+// known.
+//
+static UINT8 *g_pRecord = NULL;
+static size_t g_nRecord = 0;
+static size_t g_nRecordAlloc = 0;
+static UINT64 g_nBodyWritten = 0;
+
+static void putbin_bytes(const void *p, size_t n)
+{
+    if (g_nRecordAlloc < g_nRecord + n)
+    {
+        size_t nAlloc = 2*g_nRecordAlloc;
+        if (nAlloc < g_nRecord + n)
+        {
+            nAlloc = g_nRecord + n + LBUF_SIZE;
+        }
+        UINT8 *pNew = (UINT8 *)MEMALLOC(nAlloc);
+        ISOUTOFMEMORY(pNew);
+        if (NULL != g_pRecord)
+        {
+            memcpy(pNew, g_pRecord, g_nRecord);
+            MEMFREE(g_pRecord);
+        }
+        g_pRecord = pNew;
+        g_nRecordAlloc = nAlloc;
+    }
+    memcpy(g_pRecord + g_nRecord, p, n);
+    g_nRecord += n;
+}
+
+static void store_u32(UINT8 *p, UINT32 n)
+{
+    p[0] = (UINT8)(n);
+    p[1] = (UINT8)(n >> 8);
+    p[2] = (UINT8)(n >> 16);
+    p[3] = (UINT8)(n >> 24);
+}
+
+static UINT32 fetch_u32(const UINT8 *p)
+{
+    return  ((UINT32)p[0])
+         | (((UINT32)p[1]) << 8)
+         | (((UINT32)p[2]) << 16)
+         | (((UINT32)p[3]) << 24);
+}
+
+static void putbin_u32(UINT32 n)
+{
+    UINT8 a[4];
+    store_u32(a, n);
+    putbin_bytes(a, sizeof(a));
+}
+
+static void putbin_u64(UINT64 n)
+{
+    putbin_u32((UINT32)(n & 0xFFFFFFFFUL));
+    putbin_u32((UINT32)(n >> 32));
+}
+
+static void putbin_string(const UTF8 *p, size_t n)
+{
+    putbin_u32((UINT32)n);
+    putbin_bytes(p, n);
+    putbin_bytes("", 1);
+}
+
+static void putbin_record(FILE *f, UINT8 tag)
+{
+    UINT8 a[5];
+    a[0] = tag;
+    store_u32(a+1, (UINT32)g_nRecord);
+    fwrite(a, sizeof(UINT8), sizeof(a), f);
+    fwrite(g_pRecord, sizeof(UINT8), g_nRecord, f);
+    g_nBodyWritten += sizeof(a) + g_nRecord;
+    g_nRecord = 0;
+}
+
+static void db_write_object_binary(dbref i, int flags)
+{
+    putbin_u32(i);
+    if (!(flags & V_ATRNAME))
+    {
+        const UTF8 *pName = Name(i);
+        putbin_string(pName, strlen((char *)pName));
+    }
+    putbin_u32(Location(i));
+    putbin_u32(Zone(i));
+    putbin_u32(Contents(i));
+    putbin_u32(Exits(i));
+    putbin_u32(Link(i));
+    putbin_u32(Next(i));
+    putbin_u32(Owner(i));
+    putbin_u32(Parent(i));
+    if (!(flags & V_ATRMONEY))
+    {
+        putbin_u32(Pennies(i));
+    }
+    putbin_u32(Flags(i));
+    putbin_u32(Flags2(i));
+    putbin_u32(Flags3(i));
+    putbin_u32(Powers(i));
+    putbin_u32(Powers2(i));
+
+    if (!(flags & V_DATABASE))
+    {
+        // The count is filled in once the attributes have been written.
+        //
+        size_t iCount = g_nRecord;
+        putbin_u32(0);
+
+        UINT32 nAttrs = 0;
+        unsigned char *as;
+        for (int ca = atr_head(i, &as); ca; ca = atr_next(&as))
+        {
+            int j;
+            if (mudstate.bStandAlone)
             {
-                // Record number of players
-                //
-                mudstate.record_players = getref(f);
-                if (mudconf.reset_players)
+                j = ca;
+            }
+            else
+            {
+                ATTR *a = atr_num(ca);
+                if (!a)
                 {
-                    mudstate.record_players = 0;
+                    continue;
                 }
+                j = a->number;
             }
-            break;
 
-        case '+':
-
-            // MUX header
-            //
-            ch = getc(f);
-            if (ch == 'A')
+            if (j < A_USER_START)
             {
-                // USER-NAMED ATTRIBUTE
-                //
-                anum = getref(f);
-                tstr = (UTF8 *)getstring_noalloc(f, true, &nBuffer);
-                if (mux_isdigit(*tstr))
+                switch (j)
                 {
-                    aflags = 0;
-                    while (mux_isdigit(*tstr))
+                case A_NAME:
+                    if (!(flags & V_ATRNAME))
                     {
-                        aflags = (aflags * 10) + (*tstr++ - '0');
+                        continue;
                     }
-                    tstr++; // skip ':'
-                }
-                else
-                {
-                    aflags = mudconf.vattr_flags;
-                }
+                    break;
 
-                // If v2 flatfile or earlier, convert tstr to UTF-8.
-                //
-                if (g_version <= 2)
-                {
-                    size_t nUnused;
-                    tstr = ConvertToUTF8((char *)tstr, &nUnused);
+                case A_LIST:
+                case A_MONEY:
+                    continue;
                 }
+            }
 
-                pName = MakeCanonicalAttributeName(tstr, &nName, &bValid);
-                if (bValid)
-                {
-                    // Maximum attribute number across all names.
-                    //
-                    if (g_max_nam_atr < anum)
-                    {
-                        g_max_nam_atr = anum;
-                    }
+            size_t n;
+            const UTF8 *p = atr_get_raw_LEN(i, j, &n);
+            putbin_u32(j);
+            putbin_string(p, n);
+            nAttrs++;
+        }
+        store_u32(g_pRecord + iCount, nAttrs);
+    }
+}
 
-                    vattr_define_LEN(pName, nName, anum, aflags);
-                }
-            }
-            else if (ch == 'X')
-            {
-                // MUX VERSION
-                //
-                if (header_gotten)
-                {
-                    Log.tinyprintf(T(ENDLINE "Duplicate MUX version header entry at object %d, ignored." ENDLINE), i);
-                    tstr = (UTF8 *)getstring_noalloc(f, false, &nBuffer);
-                }
-                else
-                {
-                    header_gotten = true;
-                    g_format = F_MUX;
-                    g_version = getref(f);
-                    g_flags = g_version & ~V_MASK;
-                    g_version &= V_MASK;
+/*! \brief Write the database as a binary flatfile.
+ *
+ * \param f        Output file.
+ * \param version  Version and flags (as for db_write).
+ * \return         db_top.
+ */
 
-                    if (  g_version < MIN_SUPPORTED_VERSION
+dbref db_write_binary(FILE *f, int version)
+{
+    if (mudstate.bStandAlone)
+    {
+        Log.WriteString(T("Writing "));
+        Log.Flush();
+    }
+
+    mux_fprintf(f, T("+B%d\n"), BINARY_VERSION);
+    g_nBodyWritten = 0;
+    g_nRecord = 0;
+
+    putbin_u32(version);
+    putbin_u32(mudstate.db_top);
+    putbin_u32(mudstate.attr_next);
+    putbin_u32(mudstate.record_players);
+    putbin_record(f, BINARY_TAG_HEADER);
+
+    for (int iAttr = A_USER_START; iAttr <= anum_alc_top; iAttr++)
+    {
+        ATTR *vp = (ATTR *) anum_get(iAttr);
+        if (  vp != NULL
+           && !(vp->flags & AF_DELETED))
+        {
+            putbin_u32(vp->number);
+            putbin_u32(vp->flags);
+            putbin_string(vp->name, strlen((char *)vp->name));
+            putbin_record(f, BINARY_TAG_ATTRNAME);
+        }
+    }
+
+    // Remember where each object went for the index.
+    //
+    UINT64 *aOffsets = (UINT64 *)MEMALLOC((mudstate.db_top + 1) * sizeof(UINT64));
+    ISOUTOFMEMORY(aOffsets);
+
+    int iDotCounter = 0;
+    UINT32 nObjects = 0;
+    dbref i;
+    DO_WHOLE_DB(i)
+    {
+        if (mudstate.bStandAlone)
+        {
+            if (!iDotCounter)
+            {
+                iDotCounter = 100;
+                fputc('.', stderr);
+                fflush(stderr);
+            }
+            iDotCounter--;
+        }
+
+        if (isGarbage(i))
+        {
+            aOffsets[i] = 0;
+        }
+        else
+        {
+            aOffsets[i] = g_nBodyWritten;
+            db_write_object_binary(i, version);
+            putbin_record(f, BINARY_TAG_OBJECT);
+            nObjects++;
+        }
+    }
+
+    // Offset zero always holds the header, so it never names an object.
+    //
+    putbin_u32(nObjects);
+    DO_WHOLE_DB(i)
+    {
+        if (0 != aOffsets[i])
+        {
+            putbin_u32(i);
+            putbin_u64(aOffsets[i]);
+        }
+    }
+    MEMFREE(aOffsets);
+    aOffsets = NULL;
+
+    UINT64 oIndex = g_nBodyWritten;
+    putbin_record(f, BINARY_TAG_INDEX);
+
+    putbin_u64(oIndex);
+    putbin_bytes(BINARY_MAGIC, sizeof(BINARY_MAGIC)-1);
+    fwrite(g_pRecord, sizeof(UINT8), g_nRecord, f);
+
+    MEMFREE(g_pRecord);
+    g_pRecord = NULL;
+    g_nRecord = 0;
+    g_nRecordAlloc = 0;
+
+    if (mudstate.bStandAlone)
+    {
+        Log.WriteString(T(ENDLINE));
+        Log.Flush();
+    }
+    return mudstate.db_top;
+}
+
+// Reading is bounds-checked.  A read past the end of a record marks the
+// reader as failed and returns zero or an empty string.
+//
+typedef struct
+{
+    const UINT8 *p;
+    const UINT8 *pEnd;
+    bool  bOkay;
+} BINARY_READER;
+
+static UINT32 getbin_u32(BINARY_READER *pbr)
+{
+    if (pbr->pEnd - pbr->p < 4)
+    {
+        pbr->p = pbr->pEnd;
+        pbr->bOkay = false;
+        return 0;
+    }
+    UINT32 n = fetch_u32(pbr->p);
+    pbr->p += 4;
+    return n;
+}
+
+static UINT64 getbin_u64(BINARY_READER *pbr)
+{
+    UINT64 lo = getbin_u32(pbr);
+    UINT64 hi = getbin_u32(pbr);
+    return lo | (hi << 32);
+}
+
+static const UTF8 *getbin_string(BINARY_READER *pbr, size_t *pn)
+{
+    size_t n = getbin_u32(pbr);
+    if (  !pbr->bOkay
+       || (size_t)(pbr->pEnd - pbr->p) <= n
+       || '\0' != pbr->p[n])
+    {
+        pbr->p = pbr->pEnd;
+        pbr->bOkay = false;
+        *pn = 0;
+        return T("");
+    }
+    const UTF8 *s = pbr->p;
+    pbr->p += n + 1;
+    *pn = n;
+    return s;
+}
+
+static bool getbin_record(BINARY_READER *pbr, UINT8 *ptag, BINARY_READER *prec)
+{
+    if (pbr->pEnd - pbr->p < 5)
+    {
+        return false;
+    }
+    size_t n = fetch_u32(pbr->p + 1);
+    if ((size_t)(pbr->pEnd - pbr->p - 5) < n)
+    {
+        return false;
+    }
+    *ptag = pbr->p[0];
+    prec->p = pbr->p + 5;
+    prec->pEnd = prec->p + n;
+    prec->bOkay = true;
+    pbr->p = prec->pEnd;
+    return true;
+}
+
+// One range of the object index.  Ranges are decoded independently, and the
+// results are merged afterwards.
+//
+typedef struct
+{
+    const UINT8 *pBody;
+    size_t nBody;
+    const UINT8 *pIndex;
+    int    iFirst;
+    int    iLast;
+    int    max_atr;
+    dbref  dbBad;
+} BINARY_RANGE;
+
+/*! \brief Decode the fixed fields of a range of objects.
+ *
+ * This may run on any thread.  It validates every record in the range and
+ * stores the fixed fields directly into db[], which must already be large
+ * enough.  It does not allocate or log, and leaves names, pennies, and
+ * attribute values for db_load_binary_values().
+ *
+ * \param pVoid    BINARY_RANGE.
+ * \return         NULL.
+ */
+
+static void *db_load_binary_range(void *pVoid)
+{
+    BINARY_RANGE *pr = (BINARY_RANGE *)pVoid;
+    pr->max_atr = INT_MIN;
+    pr->dbBad = NOTHING;
+
+    BINARY_READER idx;
+    idx.p = pr->pIndex + SIZEOF_BINARY_INDEX * pr->iFirst;
+    idx.pEnd = pr->pIndex + SIZEOF_BINARY_INDEX * pr->iLast;
+    idx.bOkay = true;
+    for (int k = pr->iFirst; k < pr->iLast; k++)
+    {
+        dbref i = getbin_u32(&idx);
+        UINT64 offset = getbin_u64(&idx);
+
+        BINARY_READER rd;
+        rd.p = pr->pBody + offset;
+        rd.pEnd = pr->pBody + pr->nBody;
+        rd.bOkay = true;
+
+        UINT8 tag;
+        BINARY_READER rec;
+        if (  !getbin_record(&rd, &tag, &rec)
+           || BINARY_TAG_OBJECT != tag
+           || (dbref)getbin_u32(&rec) != i)
+        {
+            pr->dbBad = i;
+            return NULL;
+        }
+
+        size_t n;
+        if (!(g_flags & V_ATRNAME))
+        {
+            (void)getbin_string(&rec, &n);
+        }
+        dbref location = getbin_u32(&rec);
+        dbref zone     = getbin_u32(&rec);
+        dbref contents = getbin_u32(&rec);
+        dbref exits    = getbin_u32(&rec);
+        dbref link     = getbin_u32(&rec);
+        dbref next     = getbin_u32(&rec);
+        dbref owner    = getbin_u32(&rec);
+        dbref parent   = getbin_u32(&rec);
+        if (!(g_flags & V_ATRMONEY))
+        {
+            (void)getbin_u32(&rec);
+        }
+        FLAG word1  = getbin_u32(&rec);
+        FLAG word2  = getbin_u32(&rec);
+        FLAG word3  = getbin_u32(&rec);
+        POWER powers  = getbin_u32(&rec);
+        POWER powers2 = getbin_u32(&rec);
+
+        if (!(g_flags & V_DATABASE))
+        {
+            UINT32 nAttrs = getbin_u32(&rec);
+            while (  rec.bOkay
+                  && 0 < nAttrs--)
+            {
+                int atr = getbin_u32(&rec);
+                (void)getbin_string(&rec, &n);
+                if (  0 < atr
+                   && pr->max_atr < atr)
+                {
+                    pr->max_atr = atr;
+                }
+            }
+        }
+
+        if (!rec.bOkay)
+        {
+            pr->dbBad = i;
+            return NULL;
+        }
+
+        if (zone < NOTHING)
+        {
+            zone = NOTHING;
+        }
+
+        if ((word1 & TYPE_MASK) == TYPE_PLAYER)
+        {
+            word2 &= ~CONNECTED;
+        }
+
+        // The loaded database is not dirty, so s_Dirty() is not needed.
+        //
+        db[i].location    = location;
+        db[i].zone        = zone;
+        db[i].contents    = contents;
+        db[i].exits       = exits;
+        db[i].link        = link;
+        db[i].next        = next;
+        db[i].owner       = owner;
+        db[i].parent      = parent;
+        db[i].fs.word[FLAG_WORD1] = word1;
+        db[i].fs.word[FLAG_WORD2] = word2;
+        db[i].fs.word[FLAG_WORD3] = word3;
+        db[i].powers      = powers;
+        db[i].powers2     = powers2;
+    }
+    return NULL;
+}
+
+/*! \brief Store the names, pennies, and attribute values of a range of
+ * objects.
+ *
+ * The attribute store is not thread-safe, so this runs on the main thread
+ * after the range has been validated by db_load_binary_range().  Values are
+ * handed to the attribute store in place.
+ *
+ * \param pr       BINARY_RANGE.
+ * \return         None.
+ */
+
+static void db_load_binary_values(BINARY_RANGE *pr)
+{
+    BINARY_READER idx;
+    idx.p = pr->pIndex + SIZEOF_BINARY_INDEX * pr->iFirst;
+    idx.pEnd = pr->pIndex + SIZEOF_BINARY_INDEX * pr->iLast;
+    idx.bOkay = true;
+    for (int k = pr->iFirst; k < pr->iLast; k++)
+    {
+        dbref i = getbin_u32(&idx);
+        UINT64 offset = getbin_u64(&idx);
+
+        BINARY_READER rd;
+        rd.p = pr->pBody + offset;
+        rd.pEnd = pr->pBody + pr->nBody;
+        rd.bOkay = true;
+
+        UINT8 tag;
+        BINARY_READER rec;
+        (void)getbin_record(&rd, &tag, &rec);
+        (void)getbin_u32(&rec);
+
+        size_t n;
+        if (!(g_flags & V_ATRNAME))
+        {
+            const UTF8 *pName = getbin_string(&rec, &n);
+            UTF8 *buff = alloc_mbuf("db_load_binary_values");
+            StripTabsAndTruncate(pName, buff, MBUF_SIZE-1, MBUF_SIZE-1);
+            s_Name(i, buff);
+            free_mbuf(buff);
+        }
+
+        // Location through parent.
+        //
+        rec.p += 8 * 4;
+
+        if (!(g_flags & V_ATRMONEY))
+        {
+            s_PenniesDirect(i, getbin_u32(&rec));
+        }
+
+        // Flags and powers.
+        //
+        rec.p += 5 * 4;
+
+        if (!(g_flags & V_DATABASE))
+        {
+            UINT32 nAttrs = getbin_u32(&rec);
+            while (0 < nAttrs--)
+            {
+                int atr = getbin_u32(&rec);
+                const UTF8 *pValue = getbin_string(&rec, &n);
+                if (0 < atr)
+                {
+                    atr_add_raw_LEN(i, atr, pValue, n);
+                }
+            }
+        }
+    }
+}
+
+/*! \brief Read a binary flatfile.
+ *
+ * db_read() hands off to this after it sees "+B".
+ *
+ * \return         db_top, or -1 if the file is not usable.
+ */
+
+static dbref db_read_binary(FILE *f, int *db_format, int *db_version, int *db_flags)
+{
+    int version = getref(f);
+    if (BINARY_VERSION != version)
+    {
+        Log.tinyprintf(T(ENDLINE "Unsupported binary flatfile version: %d." ENDLINE), version);
+        return -1;
+    }
+
+    // The body is read whole.  Input may be a pipe, so its size is not known
+    // ahead of time.
+    //
+    size_t nAlloc = 1024*1024;
+    size_t nBody = 0;
+    UINT8 *pBody = (UINT8 *)MEMALLOC(nAlloc);
+    ISOUTOFMEMORY(pBody);
+    for (;;)
+    {
+        if (nBody == nAlloc)
+        {
+            UINT8 *pNew = (UINT8 *)MEMALLOC(2*nAlloc);
+            ISOUTOFMEMORY(pNew);
+            memcpy(pNew, pBody, nBody);
+            MEMFREE(pBody);
+            pBody = pNew;
+            nAlloc *= 2;
+        }
+        size_t n = fread(pBody + nBody, sizeof(UINT8), nAlloc - nBody, f);
+        if (0 == n)
+        {
+            break;
+        }
+        nBody += n;
+    }
+
+    UINT64 oIndex = 0;
+    if (SIZEOF_BINARY_TRAILER <= nBody)
+    {
+        BINARY_READER trailer;
+        trailer.p = pBody + nBody - SIZEOF_BINARY_TRAILER;
+        trailer.pEnd = pBody + nBody;
+        trailer.bOkay = true;
+        oIndex = getbin_u64(&trailer);
+        if (0 != memcmp(trailer.p, BINARY_MAGIC, sizeof(BINARY_MAGIC)-1))
+        {
+            oIndex = 0;
+        }
+        nBody -= SIZEOF_BINARY_TRAILER;
+    }
+
+    // Header and attribute names.
+    //
+    BINARY_READER rd;
+    rd.p = pBody;
+    rd.pEnd = pBody + nBody;
+    rd.bOkay = true;
+
+    UINT8 tag;
+    BINARY_READER rec;
+    if (  0 == oIndex
+       || nBody <= oIndex
+       || !getbin_record(&rd, &tag, &rec)
+       || BINARY_TAG_HEADER != tag)
+    {
+        Log.WriteString(T(ENDLINE "Binary flatfile is incomplete." ENDLINE));
+        MEMFREE(pBody);
+        return -1;
+    }
+
+    g_format = F_MUX;
+    g_version = getbin_u32(&rec);
+    g_flags = g_version & ~V_MASK;
+    g_version &= V_MASK;
+    mudstate.min_size = getbin_u32(&rec);
+    mudstate.attr_next = getbin_u32(&rec);
+    mudstate.record_players = getbin_u32(&rec);
+    if (mudconf.reset_players)
+    {
+        mudstate.record_players = 0;
+    }
+
+    if (  4 != g_version
+       || (g_flags & MANDFLAGS_V4) != MANDFLAGS_V4)
+    {
+        Log.tinyprintf(T(ENDLINE "Unsupported binary flatfile version: %d." ENDLINE), g_version);
+        MEMFREE(pBody);
+        return -1;
+    }
+
+    while (  getbin_record(&rd, &tag, &rec)
+          && BINARY_TAG_ATTRNAME == tag)
+    {
+        int anum = getbin_u32(&rec);
+        int aflags = getbin_u32(&rec);
+        size_t n;
+        const UTF8 *pName = getbin_string(&rec, &n);
+
+        size_t nName;
+        bool bValid;
+        UTF8 *pCanonical = MakeCanonicalAttributeName(pName, &nName, &bValid);
+        if (bValid)
+        {
+            if (g_max_nam_atr < anum)
+            {
+                g_max_nam_atr = anum;
+            }
+            vattr_define_LEN(pCanonical, nName, anum, aflags);
+        }
+    }
+
+    // Object index.
+    //
+    rd.p = pBody + oIndex;
+    if (  !getbin_record(&rd, &tag, &rec)
+       || BINARY_TAG_INDEX != tag)
+    {
+        Log.WriteString(T(ENDLINE "Binary flatfile index is missing." ENDLINE));
+        MEMFREE(pBody);
+        return -1;
+    }
+
+    int nObjects = getbin_u32(&rec);
+    if (  nObjects < 0
+       || (size_t)(rec.pEnd - rec.p) < (size_t)nObjects * SIZEOF_BINARY_INDEX)
+    {
+        Log.WriteString(T(ENDLINE "Binary flatfile index is damaged." ENDLINE));
+        MEMFREE(pBody);
+        return -1;
+    }
+    const UINT8 *pIndex = rec.p;
+
+    // Objects must be in dbref order and inside the body.  Then, db[] can
+    // be grown once, and each object belongs to exactly one range.
+    //
+    dbref dbLast = NOTHING;
+    for (int k = 0; k < nObjects; k++)
+    {
+        dbref i = getbin_u32(&rec);
+        UINT64 offset = getbin_u64(&rec);
+        if (  i <= dbLast
+           || nBody <= offset)
+        {
+            Log.tinyprintf(T(ENDLINE "Binary flatfile index is damaged near object #%d." ENDLINE), i);
+            MEMFREE(pBody);
+            return -1;
+        }
+        dbLast = i;
+    }
+    db_grow(dbLast + 1);
+
+    int nRanges = 1;
+#if defined(UNIX_THREADS)
+    long nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (1 < nCPUs)
+    {
+        nRanges = (BINARY_MAX_THREADS < nCPUs) ? BINARY_MAX_THREADS : (int)nCPUs;
+    }
+#endif // UNIX_THREADS
+    if (nObjects < nRanges * BINARY_MIN_RANGE)
+    {
+        nRanges = nObjects / BINARY_MIN_RANGE + 1;
+    }
+
+    BINARY_RANGE *aRanges = (BINARY_RANGE *)MEMALLOC(nRanges * sizeof(BINARY_RANGE));
+    ISOUTOFMEMORY(aRanges);
+    int iRange;
+    for (iRange = 0; iRange < nRanges; iRange++)
+    {
+        BINARY_RANGE *pr = &aRanges[iRange];
+        pr->pBody  = pBody;
+        pr->nBody  = nBody;
+        pr->pIndex = pIndex;
+        pr->iFirst = (int)(((INT64)nObjects * iRange) / nRanges);
+        pr->iLast  = (int)(((INT64)nObjects * (iRange + 1)) / nRanges);
+    }
+
+    if (mudstate.bStandAlone)
+    {
+        Log.tinyprintf(T(ENDLINE "Binary flatfile: %d objects in %d ranges" ENDLINE), nObjects, nRanges);
+    }
+
+#if defined(UNIX_THREADS)
+    // The first range is decoded on this thread.
+    //
+    pthread_t *aThreads = NULL;
+    bool *aStarted = NULL;
+    if (1 < nRanges)
+    {
+        aThreads = (pthread_t *)MEMALLOC(nRanges * sizeof(pthread_t));
+        ISOUTOFMEMORY(aThreads);
+        aStarted = (bool *)MEMALLOC(nRanges * sizeof(bool));
+        ISOUTOFMEMORY(aStarted);
+
+        sigset_t sigAll, sigSaved;
+        sigfillset(&sigAll);
+        pthread_sigmask(SIG_SETMASK, &sigAll, &sigSaved);
+        for (iRange = 1; iRange < nRanges; iRange++)
+        {
+            aStarted[iRange] = (0 == pthread_create(&aThreads[iRange], NULL,
+                db_load_binary_range, &aRanges[iRange]));
+        }
+        pthread_sigmask(SIG_SETMASK, &sigSaved, NULL);
+    }
+    db_load_binary_range(&aRanges[0]);
+    for (iRange = 1; iRange < nRanges; iRange++)
+    {
+        if (aStarted[iRange])
+        {
+            pthread_join(aThreads[iRange], NULL);
+        }
+        else
+        {
+            db_load_binary_range(&aRanges[iRange]);
+        }
+    }
+    if (NULL != aThreads)
+    {
+        MEMFREE(aThreads);
+        MEMFREE(aStarted);
+    }
+#else // UNIX_THREADS
+    for (iRange = 0; iRange < nRanges; iRange++)
+    {
+        db_load_binary_range(&aRanges[iRange]);
+    }
+#endif // UNIX_THREADS
+
+    // Merge the ranges.
+    //
+    bool bOkay = true;
+    for (iRange = 0; iRange < nRanges; iRange++)
+    {
+        BINARY_RANGE *pr = &aRanges[iRange];
+        if (NOTHING != pr->dbBad)
+        {
+            Log.tinyprintf(T(ENDLINE "Bad binary record for object #%d" ENDLINE), pr->dbBad);
+            bOkay = false;
+        }
+        if (g_max_obj_atr < pr->max_atr)
+        {
+            g_max_obj_atr = pr->max_atr;
+        }
+    }
+
+    if (bOkay)
+    {
+        for (iRange = 0; iRange < nRanges; iRange++)
+        {
+            db_load_binary_values(&aRanges[iRange]);
+        }
+        db_check_attr_next(true);
+    }
+
+    MEMFREE(aRanges);
+    MEMFREE(pBody);
+    if (!bOkay)
+    {
+        return -1;
+    }
+
+    *db_version = g_version;
+    *db_format = g_format;
+    *db_flags = g_flags;
+    return mudstate.db_top;
+}
+
+dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
+{
+    dbref i;
+    int ch;
+    const UTF8 *tstr;
+    size_t nBuffer;
+
+    g_format = F_UNKNOWN;
+    g_version = 0;
+    g_flags = 0;
+    g_max_nam_atr = INT_MIN;
+    g_max_obj_atr = INT_MIN;
+
+
+    bool header_gotten = false;
+    bool size_gotten = false;
+    bool nextattr_gotten = false;
+
+    bool convert_values = false;
+    bool read_attribs = true;
+    bool read_name = true;
+    bool read_key = true;
+    bool read_money = true;
+
+    int iDotCounter = 0;
+    if (mudstate.bStandAlone)
+    {
+        Log.WriteString(T("Reading "));
+        Log.Flush();
+    }
+
+    db_free();
+    for (i = 0;; i++)
+    {
+        if (mudstate.bStandAlone)
+        {
+            if (!iDotCounter)
+            {
+                iDotCounter = 100;
+                fputc('.', stderr);
+                fflush(stderr);
+            }
+            iDotCounter--;
+        }
+
+        ch = getc(f);
+        switch (ch)
+        {
+        case '-':   // Misc tag
+            ch = getc(f);
+            if (ch == 'R')
+            {
+                // Record number of players
+                //
+                mudstate.record_players = getref(f);
+                if (mudconf.reset_players)
+                {
+                    mudstate.record_players = 0;
+                }
+            }
+            break;
+
+        case '+':
+
+            // MUX header
+            //
+            ch = getc(f);
+            if (ch == 'A')
+            {
+                // USER-NAMED ATTRIBUTE
+                //
+                db_read_attrname(f);
+            }
+            else if (  ch == 'B'
+                    && !header_gotten)
+            {
+                // BINARY FLATFILE
+                //
+                return db_read_binary(f, db_format, db_version, db_flags);
+            }
+            else if (ch == 'X')
+            {
+                // MUX VERSION
+                //
+                if (header_gotten)
+                {
+                    Log.tinyprintf(T(ENDLINE "Duplicate MUX version header entry at object %d, ignored." ENDLINE), i);
+                    tstr = (UTF8 *)getstring_noalloc(f, false, &nBuffer);
+                }
+                else
+                {
+                    header_gotten = true;
+                    g_format = F_MUX;
+                    g_version = getref(f);
+                    g_flags = g_version & ~V_MASK;
+                    g_version &= V_MASK;
+
+                    if (  g_version < MIN_SUPPORTED_VERSION
                        || MAX_SUPPORTED_VERSION < g_version)
                     {
                         Log.tinyprintf(T(ENDLINE "Unsupported flatfile version: %d." ENDLINE), g_version);
@@ -558,104 +1594,9 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
         case '!':   // MUX entry
             i = getref(f);
             db_grow(i + 1);
-
-            if (read_name)
-            {
-                tstr = (UTF8 *)getstring_noalloc(f, true, &nBuffer);
-                if (g_version <= 2)
-                {
-                    size_t nUsed;
-                    tstr = ConvertToUTF8((char *)tstr, &nUsed);
-                }
-                buff = alloc_mbuf("dbread.s_Name");
-                StripTabsAndTruncate(tstr, buff, MBUF_SIZE-1, MBUF_SIZE-1);
-                s_Name(i, buff);
-                free_mbuf(buff);
-
-                s_Location(i, getref(f));
-            }
-            else
-            {
-                s_Location(i, getref(f));
-            }
-
-            // ZONE
-            //
-            int zone;
-            zone = getref(f);
-            if (zone < NOTHING)
-            {
-                zone = NOTHING;
-            }
-            s_Zone(i, zone);
-
-            // CONTENTS and EXITS
-            //
-            s_Contents(i, getref(f));
-            s_Exits(i, getref(f));
-
-            // LINK
-            //
-            s_Link(i, getref(f));
-
-            // NEXT
-            //
-            s_Next(i, getref(f));
-
-            // LOCK
-            //
-            if (read_key)
+            if (!db_read_object(f, i, read_name, read_key, read_money, read_attribs))
             {
-                // Parse lock directly from flatfile.
-                // Only used when reading v2 format.
-                //
-                tempbool = getboolexp(f);
-                atr_add_raw(i, A_LOCK, unparse_boolexp_quiet(1, tempbool));
-                free_boolexp(tempbool);
-            }
-
-            // OWNER
-            //
-            s_Owner(i, getref(f));
-
-            // PARENT
-            //
-            s_Parent(i, getref(f));
-
-            // PENNIES
-            //
-            if (read_money)
-            {
-                s_PenniesDirect(i, getref(f));
-            }
-
-            // FLAGS
-            //
-            s_Flags(i, FLAG_WORD1, getref(f));
-            s_Flags(i, FLAG_WORD2, getref(f));
-            s_Flags(i, FLAG_WORD3, getref(f));
-
-            // POWERS
-            //
-            s_Powers(i, getref(f));
-            s_Powers2(i, getref(f));
-
-            // ATTRIBUTES
-            //
-            if (read_attribs)
-            {
-                if (!get_list(f, i))
-                {
-                    Log.tinyprintf(T(ENDLINE "Error reading attrs for object #%d" ENDLINE), i);
-                    return -1;
-                }
-            }
-
-            // check to see if it's a player
-            //
-            if (isPlayer(i))
-            {
-                c_Connected(i);
+                return -1;
             }
             break;
 
@@ -668,55 +1609,7 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
             }
             else
             {
-                // Attribute number warnings.
-                //
-                if (g_max_nam_atr < g_max_obj_atr)
-                {
-                    Log.tinyprintf(T(ENDLINE "Warning: One or more attribute values are unnamed. Did you use ./Backup on a running game?"));
-                }
-
-                if (!nextattr_gotten)
-                {
-                    Log.tinyprintf(T(ENDLINE "Warning: Missing +N<next free>. Adjusting."));
-                }
-
-                if (mudstate.attr_next <= g_max_nam_atr)
-                {
-                    if (nextattr_gotten)
-                    {
-                        Log.tinyprintf(T(ENDLINE "Warning: +N<next free attr> conflicts with existing attribute names. Adjusting."));
-                    }
-                    mudstate.attr_next = g_max_nam_atr + 1;
-                }
-
-                if (mudstate.attr_next <= g_max_obj_atr)
-                {
-                    if (nextattr_gotten)
-                    {
-                        Log.tinyprintf(T(ENDLINE "Warning: +N<next free attr> conflicts object attribute numbers. Adjusting."));
-                    }
-                    mudstate.attr_next = g_max_nam_atr + 1;
-                }
-
-                int max_atr = A_USER_START;
-                if (max_atr < g_max_nam_atr)
-                {
-                    max_atr = g_max_nam_atr;
-                }
-
-                if (max_atr < g_max_obj_atr)
-                {
-                    max_atr = g_max_obj_atr;
-                }
-
-                if (max_atr + 1 < mudstate.attr_next)
-                {
-                    if (nextattr_gotten)
-                    {
-                        Log.tinyprintf(T(ENDLINE "Info: +N<next free attr> can be safely adjusted down."));
-                    }
-                    mudstate.attr_next = max_atr + 1;
-                }
+                db_check_attr_next(nextattr_gotten);
 
                 if (convert_values)
                 {
@@ -756,10 +1649,6 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
                     Log.WriteString(T(ENDLINE));
                     Log.Flush();
                 }
-                else
-                {
-                    load_player_names();
-                }
                 return mudstate.db_top;
             }
 
@@ -863,33 +1752,13 @@ static bool db_write_object(FILE *f, dbref i, int db_format, int flags)
     return false;
 }
 
-dbref db_write(FILE *f, int format, int version)
+/* ---------------------------------------------------------------------------
+ * db_write_attrnames: Write the table of user-named attributes.
+ */
+
+static void db_write_attrnames(FILE *f)
 {
-    dbref i;
-    int flags;
     ATTR *vp;
-
-    switch (format)
-    {
-    case F_MUX:
-        flags = version;
-        break;
-
-    default:
-        Log.WriteString(T("Can only write MUX format." ENDLINE));
-        return -1;
-    }
-    if (mudstate.bStandAlone)
-    {
-        Log.WriteString(T("Writing "));
-        Log.Flush();
-    }
-    i = mudstate.attr_next;
-    mux_fprintf(f, T("+X%d\n+S%d\n+N%d\n"), flags, mudstate.db_top, i);
-    mux_fprintf(f, T("-R%d\n"), mudstate.record_players);
-
-    // Dump user-named attribute info.
-    //
     UTF8 Buffer[LBUF_SIZE];
     Buffer[0] = '+';
     Buffer[1] = 'A';
@@ -916,6 +1785,35 @@ dbref db_write(FILE *f, int format, int version)
             fwrite(Buffer, sizeof(UTF8), pBuffer-Buffer, f);
         }
     }
+}
+
+dbref db_write(FILE *f, int format, int version)
+{
+    dbref i;
+    int flags;
+
+    switch (format)
+    {
+    case F_MUX:
+        flags = version;
+        break;
+
+    default:
+        Log.WriteString(T("Can only write MUX format." ENDLINE));
+        return -1;
+    }
+    if (mudstate.bStandAlone)
+    {
+        Log.WriteString(T("Writing "));
+        Log.Flush();
+    }
+    i = mudstate.attr_next;
+    mux_fprintf(f, T("+X%d\n+S%d\n+N%d\n"), flags, mudstate.db_top, i);
+    mux_fprintf(f, T("-R%d\n"), mudstate.record_players);
+
+    // Dump user-named attribute info.
+    //
+    db_write_attrnames(f);
 
     int iDotCounter = 0;
     UTF8 buf[SBUF_SIZE];
@@ -951,3 +1849,204 @@ dbref db_write(FILE *f, int format, int version)
     }
     return mudstate.db_top;
 }
+
+/* ---------------------------------------------------------------------------
+ * Checkpoint journal.
+ *
+ * An incremental checkpoint writes one journal segment instead of the whole
+ * database.  A segment uses flatfile syntax, but it only carries the header,
+ * the user-named attribute table (after "-A", and only if a name changed),
+ * and a record for each object changed since the previous checkpoint,
+ * including objects destroyed since then.  In the journal, each segment is
+ * preceded by its length in bytes so that a segment cut short by a crash can
+ * be recognized and left out.
+ */
+
+int db_write_journal(FILE *f, int version)
+{
+    mux_fprintf(f, T("+X%d\n+S%d\n+N%d\n"), version, mudstate.db_top,
+        mudstate.attr_next);
+    mux_fprintf(f, T("-R%d\n"), mudstate.record_players);
+
+    if (mudstate.bDirtyAttrNames)
+    {
+        fwrite("-A\n", sizeof(UTF8), 3, f);
+        db_write_attrnames(f);
+    }
+
+    int nObjects = 0;
+    UTF8 buf[SBUF_SIZE];
+    buf[0] = '!';
+    dbref i;
+    DO_WHOLE_DB(i)
+    {
+        if (mudstate.bfDirty.IsSet(i))
+        {
+            // Format is: "!%d\n", i
+            //
+            size_t n = mux_ltoa(i, buf+1) + 1;
+            buf[n++] = '\n';
+            fwrite(buf, sizeof(UTF8), n, f);
+            db_write_object(f, i, F_MUX, version);
+            nObjects++;
+        }
+    }
+    fputs("***END OF DUMP***\n", f);
+
+    mudstate.bfDirty.ClearAll();
+    mudstate.bDirtyAttrNames = false;
+    return nObjects;
+}
+
+static bool db_read_journal_segment(FILE *f)
+{
+    bool read_attribs = true;
+    bool read_name = true;
+    bool read_money = true;
+
+    for (;;)
+    {
+        dbref i;
+        int anum;
+        size_t nBuffer;
+        const UTF8 *tstr;
+        int ch = getc(f);
+        switch (ch)
+        {
+        case '-':
+            ch = getc(f);
+            if ('R' == ch)
+            {
+                mudstate.record_players = getref(f);
+                if (mudconf.reset_players)
+                {
+                    mudstate.record_players = 0;
+                }
+            }
+            else if ('A' == ch)
+            {
+                // A complete table of user-named attributes follows, so
+                // forget the ones we have.
+                //
+                (void)getref(f);
+                for (anum = A_USER_START; anum <= anum_alc_top; anum++)
+                {
+                    ATTR *va = (ATTR *)anum_get(anum);
+                    if (NULL != va)
+                    {
+                        UTF8 *pName = (UTF8 *)va->name;
+                        vattr_delete_LEN(pName, strlen((char *)pName));
+                    }
+                }
+            }
+            else
+            {
+                return false;
+            }
+            break;
+
+        case '+':
+            ch = getc(f);
+            if ('A' == ch)
+            {
+                db_read_attrname(f);
+            }
+            else if ('X' == ch)
+            {
+                g_format = F_MUX;
+                g_version = getref(f);
+                g_flags = g_version & ~V_MASK;
+                g_version &= V_MASK;
+                if (g_flags & V_DATABASE)
+                {
+                    read_attribs = false;
+                    read_name = !(g_flags & V_ATRNAME);
+                }
+                read_money = !(g_flags & V_ATRMONEY);
+            }
+            else if ('S' == ch)
+            {
+                db_grow(getref(f));
+            }
+            else if ('N' == ch)
+            {
+                mudstate.attr_next = getref(f);
+            }
+            else
+            {
+                return false;
+            }
+            break;
+
+        case '!':
+            i = getref(f);
+            db_grow(i + 1);
+
+            if (read_attribs)
+            {
+                // The record carries all of the object's attributes, so
+                // replace the ones from earlier rather than merge.
+                //
+#ifdef MEMORY_BASED
+                while (0 < db[i].nALUsed)
+                {
+                    atr_clr(i, db[i].pALHead[0].number);
+                }
+#endif // MEMORY_BASED
+                atr_free(i);
+            }
+
+            if (!db_read_object(f, i, read_name, false, read_money, read_attribs))
+            {
+                return false;
+            }
+            break;
+
+        case '*':
+            tstr = (UTF8 *)getstring_noalloc(f, false, &nBuffer);
+            return strncmp((char *)tstr, "**END OF DUMP***", 16) == 0;
+
+        default:
+            return false;
+        }
+    }
+}
+
+/*! \brief Apply a checkpoint journal on top of a freshly-loaded database.
+ *
+ * \param f       Journal, positioned at its beginning.
+ * \return        Number of segments applied, or -1 if a complete segment
+ *                could not be parsed.
+ */
+
+int db_read_journal(FILE *f)
+{
+    struct stat statbuf;
+    if (fstat(fileno(f), &statbuf) != 0)
+    {
+        return -1;
+    }
+
+    int nSegments = 0;
+    char buf[SBUF_SIZE];
+    while (NULL != fgets(buf, sizeof(buf), f))
+    {
+        long nLength = mux_atol((UTF8 *)buf);
+        long iStart  = ftell(f);
+        if (  nLength <= 0
+           || statbuf.st_size < iStart + nLength)
+        {
+            Log.tinyprintf(T("Ignoring incomplete journal segment after segment %d." ENDLINE), nSegments);
+            break;
+        }
+
+        if (  !db_read_journal_segment(f)
+           || ftell(f) != iStart + nLength)
+        {
+            Log.tinyprintf(T("Damaged journal segment after segment %d." ENDLINE), nSegments);
+            return -1;
+        }
+        nSegments++;
+    }
+    return nSegments;
+}
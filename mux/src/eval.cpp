@@ -711,6 +711,428 @@ TryAgain:
     return rstr;
 }
 
+//-----------------------------------------------------------------------------
+// Compiled softcode cache.
+//
+// The output of mux_exec depends on far too much run-time state to cache
+// results, and even which functions get called cannot be decided from the
+// text alone since function names may be produced by substitutions. However,
+// two pieces of work are pure functions of the text: the bracket matching
+// done by parse_to_lite, and the hash lookup that maps a function name in
+// front of a given '(' to a FUN or UFUN. For attributes evaluated through
+// mux_exec_attr, both are remembered per (object, attribute) so that later
+// evaluations of the same text skip the rescans.
+//
+// An entry is only used while it matches the text being evaluated byte for
+// byte, so a stale entry costs a recompile but never changes results.
+//
+typedef struct
+{
+    int    iKey;            // (offset << 2) | delimiter pair, or -1 if empty.
+    int    iWhichDelim;     // -1 if parse_to_lite did not set it.
+    size_t nLen;
+} SCAN_MEMO;
+
+typedef struct
+{
+    int          iOffset;   // Offset of the '(', or -1 if empty.
+    unsigned int nGeneration;
+    FUN         *fp;
+    UFUN        *ufp;
+    size_t       nName;
+    UTF8         aName[MAX_UFUN_NAME_LEN+1];
+} FUNC_MEMO;
+
+typedef struct tagCompiledText
+{
+    struct tagCompiledText *pPrevEntry;
+    struct tagCompiledText *pNextEntry;
+    Aname       attrKey;
+    size_t      nSize;
+    int         nRefs;
+    bool        bCached;
+
+    size_t      nText;
+    UTF8       *pText;
+    size_t      nScanMask;
+    SCAN_MEMO  *aScan;
+    size_t      nFuncMask;
+    FUNC_MEMO  *aFunc;
+} COMPILED_TEXT, *PCOMPILED_TEXT;
+
+static PCOMPILED_TEXT pExecHead = NULL;
+static PCOMPILED_TEXT pExecTail = NULL;
+static size_t ExecCacheSize = 0;
+
+// The compiled text currently being evaluated by mux_exec_attr, and where
+// the caller's copy of that text lives.
+//
+static PCOMPILED_TEXT pExecActive = NULL;
+static const UTF8    *pExecBase   = NULL;
+
+static void exec_cache_unlink(PCOMPILED_TEXT pct)
+{
+    if (pct->pPrevEntry)
+    {
+        pct->pPrevEntry->pNextEntry = pct->pNextEntry;
+    }
+    else
+    {
+        pExecHead = pct->pNextEntry;
+    }
+
+    if (pct->pNextEntry)
+    {
+        pct->pNextEntry->pPrevEntry = pct->pPrevEntry;
+    }
+    else
+    {
+        pExecTail = pct->pPrevEntry;
+    }
+    pct->pPrevEntry = NULL;
+    pct->pNextEntry = NULL;
+}
+
+static void exec_cache_link(PCOMPILED_TEXT pct)
+{
+    pct->pPrevEntry = NULL;
+    pct->pNextEntry = pExecHead;
+    if (pExecHead)
+    {
+        pExecHead->pPrevEntry = pct;
+    }
+    pExecHead = pct;
+    if (!pExecTail)
+    {
+        pExecTail = pct;
+    }
+}
+
+// Remove an entry from the cache. Entries still in use by an evaluation
+// further up the stack are freed when that evaluation finishes.
+//
+static void exec_cache_remove(PCOMPILED_TEXT pct)
+{
+    exec_cache_unlink(pct);
+    ExecCacheSize -= pct->nSize;
+    hashdeleteLEN(&pct->attrKey, sizeof(Aname), &mudstate.exec_htab);
+    pct->bCached = false;
+    if (0 == pct->nRefs)
+    {
+        MEMFREE(pct);
+    }
+}
+
+static void exec_cache_trim(size_t nLimit)
+{
+    while (  nLimit < ExecCacheSize
+          && pExecTail)
+    {
+        exec_cache_remove(pExecTail);
+    }
+}
+
+/*! \brief Forget any compiled form of an attribute.
+ *
+ * Called whenever an attribute is changed or cleared. This only releases
+ * memory early; entries are always validated against the text anyway.
+ *
+ * \param thing    Object.
+ * \param attr     Attribute number.
+ * \return         None.
+ */
+
+void exec_cache_invalidate(dbref thing, int attr)
+{
+    if (NULL == pExecHead)
+    {
+        return;
+    }
+
+    Aname key;
+    key.object  = thing;
+    key.attrnum = attr;
+    PCOMPILED_TEXT pct = (PCOMPILED_TEXT)hashfindLEN(&key, sizeof(Aname),
+        &mudstate.exec_htab);
+    if (pct)
+    {
+        exec_cache_remove(pct);
+    }
+}
+
+static size_t exec_cache_slots(size_t nStarts)
+{
+    size_t nSlots = 8;
+    while (nSlots < 2*nStarts)
+    {
+        nSlots <<= 1;
+    }
+    return nSlots;
+}
+
+/*! \brief Find or build the compiled form of an attribute's text.
+ *
+ * \param thing    Object the text was fetched for.
+ * \param attr     Attribute number.
+ * \param pText    Attribute text.
+ * \param nText    Length of pText.
+ * \return         Compiled text or NULL if the cache is disabled or full.
+ */
+
+static PCOMPILED_TEXT exec_cache_fetch(dbref thing, int attr, const UTF8 *pText, size_t nText)
+{
+    Aname key;
+    key.object  = thing;
+    key.attrnum = attr;
+
+    PCOMPILED_TEXT pct = (PCOMPILED_TEXT)hashfindLEN(&key, sizeof(Aname),
+        &mudstate.exec_htab);
+    if (pct)
+    {
+        if (  pct->nText == nText
+           && memcmp(pct->pText, pText, nText) == 0)
+        {
+            exec_cache_unlink(pct);
+            exec_cache_link(pct);
+            return pct;
+        }
+
+        // The text changed underneath us, or it was inherited from a
+        // different parent.
+        //
+        exec_cache_remove(pct);
+    }
+
+    // Every scan starts just after one of these characters (or at the
+    // beginning), and every function lookup happens at a '('.
+    //
+    size_t nStarts = 1;
+    size_t nOpen = 0;
+    for (size_t i = 0; i < nText; i++)
+    {
+        switch (pText[i])
+        {
+        case '(':
+            nOpen++;
+            nStarts++;
+            break;
+
+        case '[':
+        case '{':
+        case ',':
+            nStarts++;
+            break;
+        }
+    }
+
+    size_t nScan = exec_cache_slots(nStarts);
+    size_t nFunc = exec_cache_slots(nOpen);
+    size_t nSize = sizeof(COMPILED_TEXT)
+                 + nFunc * sizeof(FUNC_MEMO)
+                 + nScan * sizeof(SCAN_MEMO)
+                 + nText + 1;
+    if (mudconf.exec_cache_size < nSize)
+    {
+        return NULL;
+    }
+    exec_cache_trim(mudconf.exec_cache_size - nSize);
+
+    pct = (PCOMPILED_TEXT)MEMALLOC(nSize);
+    if (NULL == pct)
+    {
+        return NULL;
+    }
+
+    pct->attrKey = key;
+    pct->nSize = nSize;
+    pct->nRefs = 0;
+    pct->bCached = true;
+    pct->aFunc = (FUNC_MEMO *)(pct + 1);
+    pct->nFuncMask = nFunc - 1;
+    pct->aScan = (SCAN_MEMO *)(pct->aFunc + nFunc);
+    pct->nScanMask = nScan - 1;
+    pct->pText = (UTF8 *)(pct->aScan + nScan);
+    pct->nText = nText;
+    memcpy(pct->pText, pText, nText);
+    pct->pText[nText] = '\0';
+
+    for (size_t i = 0; i < nFunc; i++)
+    {
+        pct->aFunc[i].iOffset = -1;
+    }
+    for (size_t i = 0; i < nScan; i++)
+    {
+        pct->aScan[i].iKey = -1;
+    }
+
+    exec_cache_link(pct);
+    ExecCacheSize += nSize;
+    hashaddLEN(&key, sizeof(Aname), pct, &mudstate.exec_htab);
+    return pct;
+}
+
+// Returns the offset of p within the text being evaluated by
+// mux_exec_attr, or -1 if p points somewhere else.
+//
+static inline int exec_offset(const UTF8 *p)
+{
+    if (  NULL != pExecActive
+       && NULL != p
+       && pExecBase <= p
+       && p < pExecBase + pExecActive->nText)
+    {
+        return static_cast<int>(p - pExecBase);
+    }
+    return -1;
+}
+
+// Only the delimiter pairs mux_exec actually uses are remembered.
+//
+static int scan_delims(UTF8 delim1, UTF8 delim2)
+{
+    if (')' == delim2)
+    {
+        if (',' == delim1)
+        {
+            return 0;
+        }
+        else if ('\0' == delim1)
+        {
+            return 1;
+        }
+    }
+    else if ('\0' == delim2)
+    {
+        if (']' == delim1)
+        {
+            return 2;
+        }
+        else if ('}' == delim1)
+        {
+            return 3;
+        }
+    }
+    return -1;
+}
+
+static const UTF8 *parse_to_memo(const UTF8 *dstr, UTF8 delim1, UTF8 delim2, size_t *nLen, int *iWhichDelim)
+{
+    int iOffset = exec_offset(dstr);
+    int iDelims;
+    if (  iOffset < 0
+       || (iDelims = scan_delims(delim1, delim2)) < 0)
+    {
+        return parse_to_lite(dstr, delim1, delim2, nLen, iWhichDelim);
+    }
+
+    int iKey = (iOffset << 2) | iDelims;
+    size_t mask = pExecActive->nScanMask;
+    size_t i = (static_cast<size_t>(iKey) * 2654435761U) & mask;
+    SCAN_MEMO *pEmpty = NULL;
+    for (size_t nProbe = 0; nProbe <= mask; nProbe++)
+    {
+        SCAN_MEMO *psm = &pExecActive->aScan[i];
+        if (psm->iKey == iKey)
+        {
+            *nLen = psm->nLen;
+            if (psm->iWhichDelim < 0)
+            {
+                return NULL;
+            }
+            *iWhichDelim = psm->iWhichDelim;
+            if (0 == psm->iWhichDelim)
+            {
+                return NULL;
+            }
+            return dstr + psm->nLen + 1;
+        }
+        else if (psm->iKey < 0)
+        {
+            pEmpty = psm;
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+
+    int iWhich = -1;
+    const UTF8 *pNext = parse_to_lite(dstr, delim1, delim2, nLen, &iWhich);
+    if (0 <= iWhich)
+    {
+        *iWhichDelim = iWhich;
+    }
+
+    if (pEmpty)
+    {
+        pEmpty->iKey = iKey;
+        pEmpty->nLen = *nLen;
+        pEmpty->iWhichDelim = iWhich;
+    }
+    return pNext;
+}
+
+// Resolve a function name found in front of a '(', remembering the result
+// for the text being evaluated by mux_exec_attr.
+//
+static void lookup_function(const UTF8 *pParen, const UTF8 *pName, size_t nName, FUN **pfp, UFUN **pufp)
+{
+    int iOffset = exec_offset(pParen);
+    FUNC_MEMO *pEmpty = NULL;
+    if (0 <= iOffset)
+    {
+        size_t mask = pExecActive->nFuncMask;
+        size_t i = (static_cast<size_t>(iOffset) * 2654435761U) & mask;
+        for (size_t nProbe = 0; nProbe <= mask; nProbe++)
+        {
+            FUNC_MEMO *pfm = &pExecActive->aFunc[i];
+            if (pfm->iOffset == iOffset)
+            {
+                if (  pfm->nGeneration == mudstate.func_generation
+                   && pfm->nName == nName
+                   && memcmp(pfm->aName, pName, nName) == 0)
+                {
+                    *pfp = pfm->fp;
+                    *pufp = pfm->ufp;
+                    return;
+                }
+
+                // The name in front of this '(' was produced differently
+                // this time, or the function tables have changed.
+                //
+                pEmpty = pfm;
+                break;
+            }
+            else if (pfm->iOffset < 0)
+            {
+                pEmpty = pfm;
+                break;
+            }
+            i = (i + 1) & mask;
+        }
+    }
+
+    FUN  *fp  = (FUN *)hashfindLEN(pName, nName, &mudstate.func_htab);
+    UFUN *ufp = NULL;
+
+    // If not a builtin func, check for global func.
+    //
+    if (NULL == fp)
+    {
+        ufp = (UFUN *)hashfindLEN(pName, nName, &mudstate.ufunc_htab);
+    }
+
+    if (pEmpty)
+    {
+        pEmpty->iOffset = iOffset;
+        pEmpty->nGeneration = mudstate.func_generation;
+        pEmpty->nName = nName;
+        memcpy(pEmpty->aName, pName, nName);
+        pEmpty->fp = fp;
+        pEmpty->ufp = ufp;
+    }
+    *pfp = fp;
+    *pufp = ufp;
+}
+
 //-----------------------------------------------------------------------------
 // parse_arglist: Parse a line into an argument list contained in lbufs. A
 // pointer is returned to whatever follows the final delimiter. If the arglist
@@ -794,11 +1216,11 @@ static const UTF8 *parse_arglist_lite( dbref executor, dbref caller, dbref enact
         pCurr = pNext;
         if (arg < nfargs - 1)
         {
-            pNext = parse_to_lite(pCurr, ',', ')', &nLen, &iWhichDelim);
+            pNext = parse_to_memo(pCurr, ',', ')', &nLen, &iWhichDelim);
         }
         else
         {
-            pNext = parse_to_lite(pCurr, '\0', ')', &nLen, &iWhichDelim);
+            pNext = parse_to_memo(pCurr, '\0', ')', &nLen, &iWhichDelim);
         }
 
         // The following recognizes and returns zero arguments. We avoid
@@ -1437,14 +1859,7 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
             if (  0 < nFun
                && nFun <= MAX_UFUN_NAME_LEN)
             {
-                fp = (FUN *)hashfindLEN(mux_scratch, nFun, &mudstate.func_htab);
-
-                // If not a builtin func, check for global func.
-                //
-                if (NULL == fp)
-                {
-                    ufp = (UFUN *)hashfindLEN(mux_scratch, nFun, &mudstate.ufunc_htab);
-                }
+                lookup_function(pStr + iStr, mux_scratch, nFun, &fp, &ufp);
             }
 
             // Do the right thing if it doesn't exist.
@@ -1554,8 +1969,8 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
                             save_global_regs(preserve);
                         }
 
-                        mux_exec(tbuf, LBUF_SIZE-1, buff, &oldp, i, executor, enactor,
-                            AttrTrace(aflags, feval), (const UTF8 **)fargs, nfargs);
+                        mux_exec_attr(ufp->obj, ufp->atr, tbuf, buff, &oldp, i, executor,
+                            enactor, AttrTrace(aflags, feval), (const UTF8 **)fargs, nfargs);
 
                         if (ufp->flags & FN_PRES)
                         {
@@ -1574,8 +1989,20 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
                            && nfargs <= fp->maxArgs
                            && !MuxAlarm.bAlarmed)
                         {
+                            bool bProfiled = mudstate.bProfiling;
+                            UTF8 *pStart = oldp;
+                            if (bProfiled)
+                            {
+                                profile_enter(NOTHING, 0, fp);
+                            }
+
                             fp->fun(fp, buff, &oldp, executor, caller, enactor,
                                     feval & EV_TRACE, fargs, nfargs, cargs, ncargs);
+
+                            if (bProfiled)
+                            {
+                                profile_leave(oldp - pStart);
+                            }
                         }
                         else
                         {
@@ -2225,7 +2652,7 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
             // continue.
             //
             mudstate.nStackNest++;
-            tstr = parse_to_lite(pStr + iStr + 1, ']', '\0', &n, &at_space);
+            tstr = parse_to_memo(pStr + iStr + 1, ']', '\0', &n, &at_space);
             at_space = 0;
             if (tstr == NULL)
             {
@@ -2280,7 +2707,7 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
             // continue.
             //
             mudstate.nStackNest++;
-            tstr = parse_to_lite(pStr + iStr + 1, '}', '\0', &n, &at_space);
+            tstr = parse_to_memo(pStr + iStr + 1, '}', '\0', &n, &at_space);
             at_space = 0;
             if (NULL == tstr)
             {
@@ -2438,6 +2865,69 @@ void mux_exec( const UTF8 *pStr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref exe
     isSpecial(L1, '[') = bBracketIsSpecialSave;
 }
 
+/*! \brief Evaluate the text of an attribute.
+ *
+ * This behaves exactly like mux_exec, but the scanning work done on the text
+ * is remembered per (thing, attr) in the compiled softcode cache and reused
+ * the next time the same text is evaluated. When @profile is on, the time
+ * spent is also charged to (thing, attr).
+ *
+ * \param thing    Object the text was fetched from (or for).
+ * \param attr     Attribute number.
+ * \param pText    Attribute text. Must not change during evaluation.
+ * \return         None.
+ */
+
+void mux_exec_attr(dbref thing, int attr, const UTF8 *pText, UTF8 *buff, UTF8 **bufc,
+                   dbref executor, dbref caller, dbref enactor, int eval,
+                   const UTF8 *cargs[], int ncargs)
+{
+    bool bProfiled = mudstate.bProfiling;
+    UTF8 *pStart = *bufc;
+    if (bProfiled)
+    {
+        profile_enter(thing, attr, NULL);
+    }
+
+    PCOMPILED_TEXT pct = NULL;
+    if (  NULL != pText
+       && 0 < mudconf.exec_cache_size)
+    {
+        pct = exec_cache_fetch(thing, attr, pText, strlen((const char *)pText));
+    }
+
+    if (NULL == pct)
+    {
+        mux_exec(pText, LBUF_SIZE-1, buff, bufc, executor, caller, enactor,
+            eval, cargs, ncargs);
+    }
+    else
+    {
+        PCOMPILED_TEXT pSaveActive = pExecActive;
+        const UTF8 *pSaveBase = pExecBase;
+        pExecActive = pct;
+        pExecBase = pText;
+        pct->nRefs++;
+
+        mux_exec(pText, LBUF_SIZE-1, buff, bufc, executor, caller, enactor,
+            eval, cargs, ncargs);
+
+        pct->nRefs--;
+        pExecActive = pSaveActive;
+        pExecBase = pSaveBase;
+        if (  0 == pct->nRefs
+           && !pct->bCached)
+        {
+            MEMFREE(pct);
+        }
+    }
+
+    if (bProfiled)
+    {
+        profile_leave(*bufc - pStart);
+    }
+}
+
 /* ---------------------------------------------------------------------------
  * save_global_regs, restore_global_regs:  Save and restore the global
  * registers to protect them from various sorts of munging.
@@ -114,7 +114,7 @@ void finish_mail();
 // From netcommon.cpp.
 //
 void DCL_CDECL raw_broadcast(int, __in_z const UTF8 *, ...);
-void list_siteinfo(dbref);
+void list_siteinfo(dbref player, UTF8 *pCount);
 void logged_out0(dbref executor, dbref caller, dbref enactor, int eval, int key);
 void logged_out1(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8 *arg, const UTF8 *cargs[], int ncargs);
 void init_logout_cmdtab(void);
@@ -132,7 +132,7 @@ void wait_que(dbref executor, dbref caller, dbref enactor, int, bool,
 void query_complete(UINT32 hQuery, UINT32 iError, CResultsSet *prs);
 #endif
 
-#if defined(UNIX_CRYPT)
+#if defined(UNIX_CRYPT) && !defined(HAVE_CRYPT_H)
 extern "C" char *crypt(const char *inptr, const char *inkey);
 #endif // UNIX_CRYPT
 extern bool break_called;
@@ -145,6 +145,15 @@ void parse_arglist(dbref executor, dbref caller, dbref enactor, UTF8 *,
 int get_gender(dbref);
 void mux_exec(const UTF8 *pdstr, size_t nStr, UTF8 *buff, UTF8 **bufc, dbref executor,
               dbref caller, dbref enactor, int eval, const UTF8 *cargs[], int ncargs);
+void mux_exec_attr(dbref thing, int attr, const UTF8 *pText, UTF8 *buff, UTF8 **bufc,
+              dbref executor, dbref caller, dbref enactor, int eval,
+              const UTF8 *cargs[], int ncargs);
+void exec_cache_invalidate(dbref thing, int attr);
+
+/* From profile.cpp */
+struct tagFun;
+void profile_enter(dbref thing, int attr, const struct tagFun *fp);
+void profile_leave(size_t nBytes);
 
 inline void BufAddRef(lbuf_ref *lbufref)
 {
@@ -251,6 +260,7 @@ bool atr_match
     UTF8  *raw_str,
     bool  check_parents
 );
+void cmd_index_invalidate(dbref thing);
 
 bool regexp_match
 (
@@ -261,6 +271,17 @@ bool regexp_match
     int nargs
 );
 
+struct real_pcre;
+struct pcre_extra;
+struct real_pcre *regexp_compile
+(
+    const UTF8         *pattern,
+    int                 options,
+    bool                bStudy,
+    struct pcre_extra **ppStudy,
+    const char        **perrptr
+);
+
 bool list_check
 (
     dbref thing,
@@ -280,6 +301,10 @@ bool html_escape(const UTF8 *src, UTF8 *dest, UTF8 **destp);
 #define NUM_DUMP_TYPES   5
 void dump_database_internal(int);
 void fork_and_dump(int key);
+#if defined(UNIX_DUMP_JOURNAL)
+void dump_journal_drain(void);
+void dump_journal_finish(bool bSuccess);
+#endif // UNIX_DUMP_JOURNAL
 
 #define MUX_OPEN_INVALID_HANDLE_VALUE (-1)
 bool mux_fopen(FILE **pFile, const UTF8 *filename, const UTF8 *mode);
@@ -302,6 +327,7 @@ void log_name_and_loc(dbref);
 void log_type_and_name(dbref);
 
 #define SIZEOF_LOG_BUFFER 1024
+#define SIZEOF_LOG_RING   (64*1024)
 class CLogFile
 {
 private:
@@ -309,6 +335,33 @@ private:
 #if defined(WINDOWS_THREADS)
     CRITICAL_SECTION csLog;
 #endif // WINDOWS_THREADS
+#if defined(UNIX_THREADS)
+    // Background writer.  Log text is queued in m_aRing by the main thread
+    // and written to the file by m_thWriter.  m_mtxFile serializes all
+    // access to the file and is always acquired before m_mtxRing.
+    // m_nGameLocks counts the locks the game thread holds, so that a signal
+    // handler which logs can tell it interrupted the game thread inside the
+    // logger and must not wait on those locks.
+    //
+    pthread_t       m_thWriter;
+    pthread_mutex_t m_mtxRing;
+    pthread_mutex_t m_mtxFile;
+    pthread_cond_t  m_cvWork;
+    pthread_cond_t  m_cvSpace;
+    bool   m_bAsync;
+    bool   m_bStopWriter;
+    volatile bool m_bWriteFailed;
+    volatile bool m_bRotate;
+    volatile int  m_nGameLocks;
+    size_t m_iRingHead;
+    size_t m_nRing;
+    UTF8   m_aRing[SIZEOF_LOG_RING];
+
+    static void *WriterThreadProc(void *pVoid);
+    void WriterLoop(void);
+    void FlushRing(void);
+    void ServiceWriter(void);
+#endif // UNIX_THREADS
 #if defined(WINDOWS_FILES)
     HANDLE m_hFile;
 #elif defined(UNIX_FILES)
@@ -326,6 +379,8 @@ private:
     bool CreateLogFile(void);
     void AppendLogFile(void);
     void CloseLogFile(void);
+    bool WriteToFile(const UTF8 *pBuffer, size_t nBuffer);
+    void RotateLogFile(void);
 public:
     CLogFile(void);
     ~CLogFile(void);
@@ -338,6 +393,13 @@ public:
     void SetBasename(const UTF8 *pBasename);
     void StartLogging(void);
     void StopLogging(void);
+    void StartWriter(void);
+    void StopWriter(void);
+#if defined(UNIX_THREADS)
+    void ForkPrepare(void);
+    void ForkParent(void);
+    void ForkChild(void);
+#endif // UNIX_THREADS
 };
 
 extern CLogFile Log;
@@ -381,6 +443,13 @@ void badname_remove(UTF8 *);
 bool badname_check(UTF8 *);
 void badname_list(dbref, const UTF8 *);
 void ChangePassword(dbref player, const UTF8 *szPassword);
+typedef void FPASSCHECK(void *pContext, dbref player, bool bValid);
+void check_pass_async(dbref player, const UTF8 *pPassword, void *pContext, FPASSCHECK *pfDone);
+void cancel_pass_checks(void *pContext);
+void drain_pass_jobs(void);
+#if defined(UNIX_THREADS)
+void Task_PassJobs(void *pUnused, int iUnused);
+#endif // UNIX_THREADS
 const UTF8 *mux_crypt(const UTF8 *szPassword, const UTF8 *szSalt, int *piType);
 int  QueueMax(dbref);
 int  a_Queue(dbref, int);
@@ -485,6 +554,61 @@ dbref olist_first(void);
 dbref olist_next(void);
 
 /* From wild.cpp */
+
+// A wildcard pattern compiled into literal pieces separated by runs of '*'.
+// Matching places each piece at its earliest workable position, so it takes
+// time proportional to the length of the data times the length of the
+// pattern and never backtracks.  Callers which try one pattern against many
+// strings should compile it once.
+//
+#define WILD_LITERAL 0
+#define WILD_BYTE    1
+#define WILD_CHAR    2
+
+typedef struct
+{
+    UTF8   chType;      // WILD_LITERAL, WILD_BYTE, or WILD_CHAR.
+    UTF8   ch;          // Literal folded to lowercase.
+    int    iArg;        // Argument which captures this '?', or -1.
+} WILD_TOKEN;
+
+typedef struct
+{
+    int    iToken;      // First token of the piece.
+    int    nTokens;
+    int    iArg;        // Argument which captures the '*' before the piece, or -1.
+    size_t nWidth;      // Length in bytes if there are no WILD_CHAR tokens.
+    size_t iStart;      // Where the piece was placed.
+    size_t iEnd;
+    size_t iLimit;      // Latest end which leaves room for the pieces after it.
+} WILD_SEGMENT;
+
+class CWildcard
+{
+private:
+    int           m_nArgs;
+    int           m_nTokens;
+    int           m_nTokensAlloc;
+    WILD_TOKEN   *m_aTokens;
+    int           m_nSegments;
+    int           m_nSegmentsAlloc;
+    WILD_SEGMENT *m_aSegments;
+    bool          m_bVariable;  // A piece after a '*' has a WILD_CHAR token.
+
+    void AddToken(UTF8 chType, UTF8 ch, int iArg);
+    void AddSegment(int iArg);
+    bool MatchSegment(const WILD_SEGMENT *ps, const UTF8 *pData, size_t iPos, size_t *piEnd);
+    bool Locate(const UTF8 *pData);
+
+public:
+    CWildcard();
+    ~CWildcard();
+
+    void Compile(const UTF8 *pPattern, int nArgs = 0);
+    bool Match(const UTF8 *pData);
+    bool Match(const UTF8 *pData, UTF8 *args[]);
+};
+
 bool wild(UTF8 *, UTF8 *, UTF8 *[], int);
 bool wild_match(UTF8 *, const UTF8 *);
 bool quick_wild(const UTF8 *, const UTF8 *);
@@ -757,6 +881,11 @@ extern int anum_alc_top;
 #define PEMIT_ROOM      32  /* Send to containing rm (@femit, additive) */
 #define PEMIT_LIST      64  /* Send to a list */
 #define PEMIT_HTML      128 /* HTML escape, and no newline */
+#define PROFILE_REPORT  0   /* Show collected profile */
+#define PROFILE_ON      1   /* Start collecting */
+#define PROFILE_OFF     2   /* Stop collecting */
+#define PROFILE_RESET   3   /* Discard collected profile */
+#define PROFILE_EXPORT  4   /* Write folded stacks to a file */
 #define PS_BRIEF        0   /* Short PS report */
 #define PS_LONG         1   /* Long PS report */
 #define PS_SUMM         2   /* Queue counts only */
@@ -1017,6 +1146,9 @@ void do_lock(dbref executor, dbref caller, dbref enactor, int eval, int key,
                     int nargs, UTF8 *name, UTF8 *keytext, const UTF8 *cargs[], int ncargs);
 void check_events(void);
 void list_system_resources(dbref player);
+void list_resolver(dbref player);
+void list_scheduler(dbref player, UTF8 *pCount);
+CLinearTimeDelta GetProcessorUsage(void);
 
 #if defined(WOD_REALMS) || defined(REALITY_LVLS)
 
@@ -1063,7 +1195,7 @@ void dispatch_CacheTick(void *pUnused, int iUnused);
 //
 typedef void FTASK(void *, int);
 
-typedef struct
+typedef struct task_record
 {
     CLinearTimeAbsolute ltaWhen;
 
@@ -1073,6 +1205,16 @@ typedef struct
     void       *arg_voidptr;
     int        arg_Integer;
     int        m_iVisitedMark;
+    int        m_iHeapIndex;    // Position within the heap holding the task.
+    int        m_iSlot;         // Timing wheel slot, TASK_SLOT_SHARE, or -1.
+    int        m_iShare;        // Owner charged for the task or NOTHING.
+    struct task_record *m_pNext;    // Next task in the same slot or share.
+    struct task_record *m_pPrev;    // Previous task in the same slot or share.
+
+    // Task records come from their own buffer pool.
+    //
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
 } TASK_RECORD, *PTASK_RECORD;
 
 #define PRIORITY_SYSTEM  100
@@ -1080,6 +1222,10 @@ typedef struct
 #define PRIORITY_OBJECT  300
 #define PRIORITY_SUSPEND 400
 
+// m_iSlot of a ready task waiting in a fair-share queue.
+//
+#define TASK_SLOT_SHARE (-2)
+
 // CF_DEQUEUE driven minimum priority levels.
 //
 #define PRIORITY_CF_DEQUEUE_ENABLED  PRIORITY_OBJECT
@@ -1098,6 +1244,8 @@ private:
     int m_iVisitedMark;
 
     bool Grow(void);
+    void Place(int, PTASK_RECORD);
+    bool Holds(PTASK_RECORD);
     void SiftDown(int, SCHCMP *);
     void SiftUp(int, SCHCMP *);
     PTASK_RECORD Remove(int, SCHCMP *);
@@ -1105,15 +1253,20 @@ private:
     void Sort(SCHCMP *pfCompare);
     void Remake(SCHCMP *pfCompare);
 
+    friend class CTaskWheel;
+
 public:
     CTaskHeap();
     ~CTaskHeap();
 
     void Shrink(void);
+    int  Count(void) { return m_nCurrent; }
     bool Insert(PTASK_RECORD, SCHCMP *);
     PTASK_RECORD PeekAtTopmost(void);
     PTASK_RECORD RemoveTopmost(SCHCMP *);
     void CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    bool UpdateTask(PTASK_RECORD, SCHCMP *);
+    bool RemoveTask(PTASK_RECORD, SCHCMP *);
 
 #define IU_DONE        0
 #define IU_NEXT_TASK   1
@@ -1123,11 +1276,120 @@ public:
     int TraverseOrdered(SCHLOOK *pfLook, SCHCMP *pfCompare);
 };
 
+// Hierarchical timing wheel for tasks that wait for a particular time.
+//
+// Each level has WHEEL_SLOTS slots, and each slot covers WHEEL_SLOTS times as
+// many ticks as a slot on the level below it.  A task goes on the lowest
+// level where its tick and the current tick share all higher digits, so
+// inserting or removing a task takes constant time.  Tasks due by the current
+// tick are kept in a small heap so that they still come out in exact When
+// order.
+//
+#define WHEEL_TICK_SHIFT 20     // A tick is 2^20 100ns units or about 0.1s.
+#define WHEEL_BITS       8
+#define WHEEL_SLOTS      (1 << WHEEL_BITS)
+#define WHEEL_LEVELS     4
+#define WHEEL_OVERFLOW   (WHEEL_LEVELS * WHEEL_SLOTS)
+
+class CTaskWheel
+{
+private:
+    CTaskHeap    m_Near;
+    PTASK_RECORD m_aSlots[WHEEL_OVERFLOW + 1];
+    int          m_anLevel[WHEEL_LEVELS + 1];
+    int          m_nWheel;
+    INT64        m_iCurrent;
+    int          m_iVisitedMark;
+    PTASK_RECORD m_pTraverseNext;
+
+    void LinkSlot(int iSlot, PTASK_RECORD);
+    void UnlinkSlot(PTASK_RECORD);
+    bool Place(PTASK_RECORD);
+    void Cascade(int iSlot);
+    void Advance(void);
+
+public:
+    CTaskWheel();
+    ~CTaskWheel();
+
+    void Shrink(void);
+    bool Insert(PTASK_RECORD, SCHCMP *);
+    PTASK_RECORD PeekAtTopmost(void);
+    PTASK_RECORD RemoveTopmost(SCHCMP *);
+    void CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    bool UpdateTask(PTASK_RECORD, SCHCMP *);
+    bool RemoveTask(PTASK_RECORD, SCHCMP *);
+    int TraverseUnordered(SCHLOOK *pfLook, SCHCMP *pfCompare);
+    int TraverseOrdered(SCHLOOK *pfLook, SCHCMP *pfCompare);
+    void Report(dbref executor);
+};
+
+// Fair-share queues for ready PRIORITY_OBJECT tasks.
+//
+// Each owner (share) with ready tasks has a FIFO on a ring, and the ring is
+// served by deficit round-robin: a share keeps the head of the ring while it
+// has CPU credit, and is given another quantum and moved to the back when its
+// credit runs out.  The CPU time used by each task is charged against its
+// share afterwards, so an owner with a runaway loop gets the same CPU time as
+// everyone else instead of the same number of queue entries.
+//
+typedef struct task_share
+{
+    int          iShare;
+    PTASK_RECORD pHead;
+    PTASK_RECORD pTail;
+    int          nTasks;
+    INT64        iDeficit;      // CPU credit in 100ns units.
+    bool         bActive;       // On the ring.
+    struct task_share *pNext;
+    struct task_share *pPrev;
+
+    // Latency from when a task became ready until it started to run.
+    //
+    INT64        iLatencyAverage;
+    INT64        iLatencyMaximum;
+    int          nRun;
+} TASK_SHARE;
+
+class CTaskShares
+{
+private:
+    CHashTable   m_htShares;
+    TASK_SHARE  *m_pActive;
+    int          m_nActive;
+    int          m_nTasks;
+    int          m_iVisitedMark;
+    PTASK_RECORD m_pTraverseNext;
+
+    TASK_SHARE *Find(int iShare, bool bCreate);
+    void Activate(TASK_SHARE *);
+    void Deactivate(TASK_SHARE *);
+    void Unlink(TASK_SHARE *, PTASK_RECORD);
+    int  Snapshot(TASK_SHARE ***);
+
+public:
+    CTaskShares();
+    ~CTaskShares();
+
+    int  Count(void) { return m_nTasks; }
+    bool Insert(PTASK_RECORD);
+    PTASK_RECORD RemoveNext(INT64 iQuantum);
+    void Charge(int iShare, INT64 iUsed);
+    void Latency(int iShare, INT64 iLatency);
+    bool GetLatency(int iShare, INT64 *piAverage, INT64 *piMaximum, int *pnRun);
+    void CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    bool RemoveTask(PTASK_RECORD);
+    int  TraverseUnordered(SCHLOOK *pfLook);
+    int  TraverseOrdered(SCHLOOK *pfLook, SCHCMP *pfCompare);
+    void Report(dbref executor);
+};
+
 class CScheduler
 {
 private:
-    CTaskHeap m_WhenHeap;
+    CTaskWheel m_WhenHeap;
     CTaskHeap m_PriorityHeap;
+    CTaskShares m_Shares;
     int       m_Ticket;
     int       m_minPriority;
 
@@ -1135,18 +1397,22 @@ public:
     void TraverseUnordered(SCHLOOK *pfLook);
     void TraverseOrdered(SCHLOOK *pfLook);
     CScheduler(void) { m_Ticket = 0; m_minPriority = PRIORITY_CF_DEQUEUE_ENABLED; }
-    void DeferTask(const CLinearTimeAbsolute& ltWhen, int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer);
-    void DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    PTASK_RECORD DeferTask(const CLinearTimeAbsolute& ltWhen, int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    PTASK_RECORD DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer);
     bool WhenNext(CLinearTimeAbsolute *);
     int  RunTasks(int iCount);
     int  RunAllTasks(void);
     int  RunTasks(const CLinearTimeAbsolute& tNow);
     void ReadyTasks(const CLinearTimeAbsolute& tNow);
     void CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    void UpdateTask(PTASK_RECORD pTask);
+    void RemoveTask(PTASK_RECORD pTask);
     void Shrink(void);
 
     void SetMinPriority(int arg_minPriority);
     int  GetMinPriority(void) { return m_minPriority; }
+    bool ShareLatency(int iShare, CLinearTimeDelta *pltdAverage, CLinearTimeDelta *pltdMaximum, int *pnRun);
+    void Report(dbref executor);
 };
 
 extern CScheduler scheduler;
@@ -1222,7 +1488,8 @@ UTF8 *modSpeech(dbref player, UTF8 *message, bool bWhich, UTF8 *command);
 #ifdef DEPRECATED
 void stack_clr(dbref obj);
 #endif // DEPRECATED
-bool parse_and_get_attrib(dbref, UTF8 *[], UTF8 **, dbref *, dbref *, int *, UTF8 *, UTF8 **);
+bool parse_and_get_attrib(dbref, UTF8 *[], UTF8 **, dbref *, dbref *, int *, UTF8 *, UTF8 **,
+                          int *pattr = NULL);
 
 #if defined(TINYMUX_MODULES)
 
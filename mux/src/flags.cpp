@@ -37,6 +37,8 @@ static bool fh_any(dbref target, dbref player, FLAG flag, int fflags, bool reset
 
     // Otherwise we can go do it.
     //
+    s_Dirty(target);
+    hearers_invalidate(Location(target));
     if (reset)
     {
         db[target].fs.word[fflags] &= ~flag;
@@ -44,7 +44,8 @@ bool parse_and_get_attrib
     dbref  *paowner,
     dbref  *paflags,
     UTF8   *buff,
-    UTF8  **bufc
+    UTF8  **bufc,
+    int    *pattr
 )
 {
     ATTR *ap;
@@ -82,6 +83,11 @@ bool parse_and_get_attrib
         free_lbuf(*atext);
         return false;
     }
+
+    if (NULL != pattr)
+    {
+        *pattr = ap->number;
+    }
     return true;
 }
 
@@ -42,12 +42,13 @@ FUNCTION(fun_grab)
 
     // Walk the wordstring, until we find the word we want.
     //
+    CWildcard wc;
+    wc.Compile(fargs[1]);
     UTF8 *s = trim_space_sep(fargs[0], sep);
     do
     {
         UTF8 *r = split_token(&s, sep);
-        mudstate.wild_invk_ctr = 0;
-        if (quick_wild(fargs[1], r))
+        if (wc.Match(r))
         {
             safe_str(r, buff, bufc);
             return;
@@ -68,13 +69,14 @@ FUNCTION(fun_graball)
         return;
     }
 
+    CWildcard wc;
+    wc.Compile(fargs[1]);
     bool bFirst = true;
     UTF8 *s = trim_space_sep(fargs[0], sep);
     do
     {
         UTF8 *r = split_token(&s, sep);
-        mudstate.wild_invk_ctr = 0;
-        if (quick_wild(fargs[1], r))
+        if (wc.Match(r))
         {
             if (!bFirst)
             {
@@ -581,13 +583,14 @@ FUNCTION(fun_matchall)
     // Check each word individually, returning the word number of all that
     // match. If none match, return 0.
     //
+    CWildcard wc;
+    wc.Compile(fargs[1]);
     wcount = 1;
     s = trim_space_sep(fargs[0], sep);
     do
     {
         r = split_token(&s, sep);
-        mudstate.wild_invk_ctr = 0;
-        if (quick_wild(fargs[1], r))
+        if (wc.Match(r))
         {
             mux_ltoa(wcount, tbuf);
             if (old != *bufc)
@@ -2242,15 +2245,15 @@ static void real_regmatch(const UTF8 *search, const UTF8 *pattern, UTF8 *registe
     }
 
     const char *errptr;
-    int erroffset;
     // To capture N substrings, you need space for 3(N+1) offsets in the
     // offset vector. We'll allow 2N-1 substrings and possibly ignore some.
     //
     const int ovecsize = 6 * MAX_GLOBAL_REGS;
     int ovec[ovecsize];
 
-    pcre *re = pcre_compile((char *)pattern, PCRE_UTF8|(cis ? PCRE_CASELESS : 0),
-        &errptr, &erroffset, NULL);
+    pcre_extra *study;
+    pcre *re = regexp_compile(pattern, PCRE_UTF8|(cis ? PCRE_CASELESS : 0),
+        false, &study, &errptr);
     if (!re)
     {
         // Matching error.
@@ -2260,7 +2263,7 @@ static void real_regmatch(const UTF8 *search, const UTF8 *pattern, UTF8 *registe
         return;
     }
 
-    int matches = pcre_exec(re, NULL, (char *)search, static_cast<int>(strlen((char *)search)), 0, 0,
+    int matches = pcre_exec(re, study, (char *)search, static_cast<int>(strlen((char *)search)), 0, 0,
         ovec, ovecsize);
     if (matches == 0)
     {
@@ -2279,7 +2282,6 @@ static void real_regmatch(const UTF8 *search, const UTF8 *pattern, UTF8 *registe
     //
     if (nfargs != 3)
     {
-        MEMFREE(re);
         return;
     }
 
@@ -2313,7 +2315,6 @@ static void real_regmatch(const UTF8 *search, const UTF8 *pattern, UTF8 *registe
             free_lbuf(p);
         }
     }
-    MEMFREE(re);
 }
 
 FUNCTION(fun_regmatch)
@@ -2356,17 +2357,16 @@ static void real_regrab(__in UTF8 *search, __in const UTF8 *pattern, __in const
         return;
     }
     pcre *re;
-    pcre_extra *study = NULL;
+    pcre_extra *study;
     const char *errptr;
-    int erroffset;
     // To capture N substrings, you need space for 3(N+1) offsets in the
     // offset vector. We'll allow 2N-1 substrings and possibly ignore some.
     //
     const int ovecsize = 6 * MAX_GLOBAL_REGS;
     int ovec[ovecsize];
 
-    re = pcre_compile((char *)pattern, PCRE_UTF8|(cis ? PCRE_CASELESS : 0),
-        &errptr, &erroffset, NULL);
+    re = regexp_compile(pattern, PCRE_UTF8|(cis ? PCRE_CASELESS : 0),
+        all, &study, &errptr);
     if (!re)
     {
         // Matching error.
@@ -2376,11 +2376,6 @@ static void real_regrab(__in UTF8 *search, __in const UTF8 *pattern, __in const
         return;
     }
 
-    if (all)
-    {
-        study = pcre_study(re, 0, &errptr);
-    }
-
     bool first = true;
     UTF8 *s = trim_space_sep(search, sep);
     do
@@ -2404,12 +2399,6 @@ static void real_regrab(__in UTF8 *search, __in const UTF8 *pattern, __in const
             }
         }
     } while (s);
-
-    MEMFREE(re);
-    if (study)
-    {
-        MEMFREE(study);
-    }
 }
 
 FUNCTION(fun_regrab)
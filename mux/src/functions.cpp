@@ -2318,7 +2318,9 @@ static void do_ufun(UTF8 *buff, UTF8 **bufc, dbref executor, dbref caller,
     dbref thing;
     dbref aowner;
     int   aflags;
-    if (!parse_and_get_attrib(executor, fargs, &atext, &thing, &aowner, &aflags, buff, bufc))
+    int   attr;
+    if (!parse_and_get_attrib(executor, fargs, &atext, &thing, &aowner, &aflags,
+                              buff, bufc, &attr))
     {
         return;
     }
@@ -2334,7 +2336,7 @@ static void do_ufun(UTF8 *buff, UTF8 **bufc, dbref executor, dbref caller,
 
     // Evaluate it using the rest of the passed function args.
     //
-    mux_exec(atext, LBUF_SIZE-1, buff, bufc, thing, executor, enactor,
+    mux_exec_attr(thing, attr, atext, buff, bufc, thing, executor, enactor,
         AttrTrace(aflags, EV_FCHECK|EV_EVAL),
         (const UTF8 **)&(fargs[1]), nfargs - 1);
     free_lbuf(atext);
@@ -3131,12 +3133,13 @@ static FUNCTION(fun_match)
     // Check each word individually, returning the word number of the first
     // one that matches.  If none match, return 0.
     //
+    CWildcard wc;
+    wc.Compile(fargs[1]);
     int wcount = 1;
     UTF8 *s = trim_space_sep(fargs[0], sep);
     do {
         UTF8 *r = split_token(&s, sep);
-        mudstate.wild_invk_ctr = 0;
-        if (quick_wild(fargs[1], r))
+        if (wc.Match(r))
         {
             safe_ltoa(wcount, buff, bufc);
             return;
@@ -3158,7 +3161,6 @@ static FUNCTION(fun_strmatch)
 
     // Check if we match the whole string.  If so, return 1.
     //
-    mudstate.wild_invk_ctr = 0;
     bool cc = quick_wild(fargs[1], fargs[0]);
     safe_bool(cc, buff, bufc);
 }
@@ -11412,6 +11414,7 @@ void function_add(FUN *fp)
     if (NULL == hashfindLEN(pCased, nCased, &mudstate.func_htab))
     {
         hashaddLEN(pCased, nCased, fp, &mudstate.func_htab);
+        mudstate.func_generation++;
     }
 }
 
@@ -11420,6 +11423,7 @@ void function_remove(FUN *fp)
     size_t nCased;
     UTF8 *pCased = mux_strupr(fp->name, nCased);
     hashdeleteLEN(pCased, nCased, &mudstate.func_htab);
+    mudstate.func_generation++;
 }
 
 void functions_add(FUN funlist[])
@@ -11579,6 +11583,7 @@ void do_function
                 }
             }
             hashdeleteLEN(pName, nLen, &mudstate.ufunc_htab);
+            mudstate.func_generation++;
             delete ufp;
             notify_quiet(executor, tprintf(T("Function %s deleted."), pName));
         }
@@ -11657,6 +11662,7 @@ void do_function
             ufp2->next = ufp;
         }
         hashaddLEN(pName, nLen, ufp, &mudstate.ufunc_htab);
+        mudstate.func_generation++;
     }
     ufp->obj = obj;
     ufp->atr = pattr->number;
@@ -18,6 +18,7 @@
 #include "file_c.h"
 #include "functions.h"
 #include "help.h"
+#include "mathutil.h"
 #include "mguests.h"
 #include "muxcli.h"
 #include "pcre.h"
@@ -73,6 +74,168 @@ void report(void)
     }
 }
 
+/* ----------------------------------------------------------------------
+ * Regular expression cache.
+ *
+ * Compiled patterns are kept in a CHashTable keyed by the compile options
+ * and the pattern text, with a linked list to find the least-recently-used
+ * one. A pattern is studied once it has been used a few times, or right
+ * away if the caller is about to run it against many subjects.
+ */
+
+#define REGEXP_CACHE_MAX    256
+#define REGEXP_STUDY_USES   4
+
+typedef struct tagRegexpEntry
+{
+    struct tagRegexpEntry *pPrevEntry;
+    struct tagRegexpEntry *pNextEntry;
+    pcre       *re;
+    pcre_extra *study;
+    int         nUses;
+    bool        bStudied;
+    size_t      nKey;
+    UTF8        aKey[1];
+} REGEXP_ENTRY, *PREGEXP_ENTRY;
+
+static PREGEXP_ENTRY pRegexpHead = NULL;
+static PREGEXP_ENTRY pRegexpTail = NULL;
+static int nRegexpEntries = 0;
+
+static void regexp_cache_unlink(PREGEXP_ENTRY pre)
+{
+    if (pre->pPrevEntry)
+    {
+        pre->pPrevEntry->pNextEntry = pre->pNextEntry;
+    }
+    else
+    {
+        pRegexpHead = pre->pNextEntry;
+    }
+
+    if (pre->pNextEntry)
+    {
+        pre->pNextEntry->pPrevEntry = pre->pPrevEntry;
+    }
+    else
+    {
+        pRegexpTail = pre->pPrevEntry;
+    }
+    pre->pPrevEntry = NULL;
+    pre->pNextEntry = NULL;
+}
+
+static void regexp_cache_link(PREGEXP_ENTRY pre)
+{
+    pre->pPrevEntry = NULL;
+    pre->pNextEntry = pRegexpHead;
+    if (pRegexpHead)
+    {
+        pRegexpHead->pPrevEntry = pre;
+    }
+    pRegexpHead = pre;
+    if (!pRegexpTail)
+    {
+        pRegexpTail = pre;
+    }
+}
+
+static void regexp_cache_free(PREGEXP_ENTRY pre)
+{
+    regexp_cache_unlink(pre);
+    hashdeleteLEN(pre->aKey, pre->nKey, &mudstate.regexp_htab);
+    MEMFREE(pre->re);
+    if (pre->study)
+    {
+        MEMFREE(pre->study);
+    }
+    MEMFREE(pre);
+    nRegexpEntries--;
+}
+
+/*! \brief Compile a regular expression, or find it already compiled.
+ *
+ * The returned pattern and study data belong to the cache and must not be
+ * freed. They remain valid until the next call to regexp_compile, so the
+ * caller must be finished with them before evaluating any softcode.
+ *
+ * \param pattern  Regular expression.
+ * \param options  PCRE compile options.
+ * \param bStudy   Study the pattern now because it will be used repeatedly.
+ * \param ppStudy  Study data for pcre_exec, or NULL.
+ * \param perrptr  Compile error, if any.
+ * \return         Compiled pattern or NULL on error.
+ */
+
+pcre *regexp_compile
+(
+    const UTF8  *pattern,
+    int          options,
+    bool         bStudy,
+    pcre_extra **ppStudy,
+    const char **perrptr
+)
+{
+    static UTF8 aKey[sizeof(int) + LBUF_SIZE];
+
+    *ppStudy = NULL;
+    size_t nPattern = strlen((const char *)pattern);
+    if (LBUF_SIZE <= nPattern)
+    {
+        nPattern = LBUF_SIZE - 1;
+    }
+    memcpy(aKey, &options, sizeof(int));
+    memcpy(aKey + sizeof(int), pattern, nPattern);
+    size_t nKey = sizeof(int) + nPattern;
+
+    PREGEXP_ENTRY pre = (PREGEXP_ENTRY)hashfindLEN(aKey, nKey, &mudstate.regexp_htab);
+    if (NULL == pre)
+    {
+        int erroffset;
+        pcre *re = pcre_compile((const char *)pattern, options, perrptr,
+            &erroffset, NULL);
+        if (NULL == re)
+        {
+            return NULL;
+        }
+
+        while (  REGEXP_CACHE_MAX <= nRegexpEntries
+              && pRegexpTail)
+        {
+            regexp_cache_free(pRegexpTail);
+        }
+
+        pre = (PREGEXP_ENTRY)MEMALLOC(sizeof(REGEXP_ENTRY) + nKey);
+        ISOUTOFMEMORY(pre);
+        pre->re = re;
+        pre->study = NULL;
+        pre->nUses = 0;
+        pre->bStudied = false;
+        pre->nKey = nKey;
+        memcpy(pre->aKey, aKey, nKey);
+        regexp_cache_link(pre);
+        hashaddLEN(pre->aKey, pre->nKey, pre, &mudstate.regexp_htab);
+        nRegexpEntries++;
+    }
+    else
+    {
+        regexp_cache_unlink(pre);
+        regexp_cache_link(pre);
+    }
+
+    pre->nUses++;
+    if (  !pre->bStudied
+       && (  bStudy
+          || REGEXP_STUDY_USES <= pre->nUses))
+    {
+        const char *errptr;
+        pre->study = pcre_study(pre->re, 0, &errptr);
+        pre->bStudied = true;
+    }
+    *ppStudy = pre->study;
+    return pre->re;
+}
+
 /* ----------------------------------------------------------------------
  * regexp_match: Load a regular expression match and insert it into
  * registers.
@@ -90,17 +253,16 @@ bool regexp_match
     int matches;
     int i;
     const char *errptr;
-    int erroffset;
 
     /*
-     * Load the regexp pattern. This allocates memory which must be
-     * later freed. A free() of the regexp does free all structures
-     * under it.
+     * Load the regexp pattern. The compiled pattern belongs to the
+     * regexp cache.
      */
 
     pcre *re;
+    pcre_extra *study;
     if (  MuxAlarm.bAlarmed
-       || (re = pcre_compile((char *)pattern, PCRE_UTF8|case_opt, &errptr, &erroffset, NULL)) == NULL)
+       || (re = regexp_compile(pattern, PCRE_UTF8|case_opt, false, &study, &errptr)) == NULL)
     {
         /*
          * This is a matching error. We have an error message in
@@ -120,11 +282,10 @@ bool regexp_match
      * Now we try to match the pattern. The relevant fields will
      * automatically be filled in by this.
      */
-    matches = pcre_exec(re, NULL, (char *)str, static_cast<int>(strlen((char *)str)), 0, 0, ovec, ovecsize);
+    matches = pcre_exec(re, study, (char *)str, static_cast<int>(strlen((char *)str)), 0, 0, ovec, ovecsize);
     if (matches < 0)
     {
         delete [] ovec;
-        MEMFREE(re);
         return false;
     }
 
@@ -155,10 +316,261 @@ bool regexp_match
     }
 
     delete [] ovec;
-    MEMFREE(re);
     return true;
 }
 
+/* ----------------------------------------------------------------------
+ * $-command index.
+ *
+ * Matching $-commands and ^-listens used to fetch every attribute on every
+ * object looked at.  What atr_match1() needs from an object's own
+ * attributes is kept here instead: every attribute number with its flags
+ * (for parent exclusion), and every $- and ^-pattern.  A wildcard $-pattern
+ * whose first word is literal can only match a command whose first word is
+ * the same, so such patterns are keyed by a hash of that word and are only
+ * tried against commands with the same key.
+ *
+ * An object's index is thrown away whenever one of its attributes is
+ * written or cleared.  Parents, object flags, and attribute definitions are
+ * looked at when matching, so changing them does not affect the index.
+ */
+
+typedef struct
+{
+    int atr;
+    int aflags;
+} CMDX_ATTR;
+
+typedef struct
+{
+    int     iAttr;          // Index into aAttrs.
+    UTF8    chType;         // AMATCH_CMD or AMATCH_LISTEN.
+    bool    bKeyed;         // First word of pattern is literal.
+    UINT32  uKey;           // Hash of that word.
+    size_t  nPattern;
+    UTF8   *pPattern;       // Pattern without the leadin or ':'.
+    CWildcard *pWild;       // Compiled on first use, unless AF_REGEXP.
+} CMDX_PATTERN;
+
+typedef struct
+{
+    int           nRefs;
+    bool          bCached;
+    int           nAttrs;
+    CMDX_ATTR    *aAttrs;
+    int           nPatterns;
+    CMDX_PATTERN *aPatterns;
+    UINT32        fKeys;        // One bit for each uKey of a $-pattern.
+    bool          bUnkeyed;     // There is an unkeyed $-pattern.
+    bool          bCommands;
+    bool          bListens;
+} CMD_INDEX;
+
+#define CMDX_KEY_BIT(k) (((UINT32)1) << ((k) & 31))
+
+// Hash the first word, folding case the same way wild() does.  Returns
+// false if the first word of a pattern is not entirely literal.
+//
+static bool cmd_index_key(const UTF8 *p, bool bPattern, UINT32 *puKey)
+{
+    UTF8   aWord[LBUF_SIZE];
+    size_t n = 0;
+    while (  '\0' != p[n]
+          && ' ' != p[n])
+    {
+        if (  bPattern
+           && (  '*' == p[n]
+              || '?' == p[n]
+              || '\\' == p[n]))
+        {
+            return false;
+        }
+        aWord[n] = mux_tolower_ascii(p[n]);
+        n++;
+    }
+    if (  bPattern
+       && 0 == n)
+    {
+        return false;
+    }
+    *puKey = HASH_ProcessBuffer(0, aWord, n);
+    return true;
+}
+
+static void cmd_index_free(CMD_INDEX *pIndex)
+{
+    for (int i = 0; i < pIndex->nPatterns; i++)
+    {
+        MEMFREE(pIndex->aPatterns[i].pPattern);
+        if (pIndex->aPatterns[i].pWild)
+        {
+            delete pIndex->aPatterns[i].pWild;
+        }
+    }
+    if (pIndex->aPatterns)
+    {
+        MEMFREE(pIndex->aPatterns);
+    }
+    if (pIndex->aAttrs)
+    {
+        MEMFREE(pIndex->aAttrs);
+    }
+    MEMFREE(pIndex);
+}
+
+static void cmd_index_release(CMD_INDEX *pIndex)
+{
+    pIndex->nRefs--;
+    if (  0 == pIndex->nRefs
+       && !pIndex->bCached)
+    {
+        cmd_index_free(pIndex);
+    }
+}
+
+/*! \brief Forget the $-command index of an object.
+ *
+ * Called whenever one of the object's attributes is changed or cleared.
+ *
+ * \param thing    Object.
+ * \return         None.
+ */
+
+void cmd_index_invalidate(dbref thing)
+{
+    if (0 == mudstate.cmd_index_htab.GetEntryCount())
+    {
+        return;
+    }
+
+    CMD_INDEX *pIndex = (CMD_INDEX *)hashfindLEN(&thing, sizeof(thing),
+        &mudstate.cmd_index_htab);
+    if (pIndex)
+    {
+        hashdeleteLEN(&thing, sizeof(thing), &mudstate.cmd_index_htab);
+        pIndex->bCached = false;
+        if (0 == pIndex->nRefs)
+        {
+            cmd_index_free(pIndex);
+        }
+    }
+}
+
+static CMD_INDEX *cmd_index_build(dbref thing)
+{
+    CMD_INDEX *pIndex = (CMD_INDEX *)MEMALLOC(sizeof(CMD_INDEX));
+    ISOUTOFMEMORY(pIndex);
+    pIndex->nRefs     = 0;
+    pIndex->bCached   = true;
+    pIndex->nAttrs    = 0;
+    pIndex->aAttrs    = NULL;
+    pIndex->nPatterns = 0;
+    pIndex->aPatterns = NULL;
+    pIndex->fKeys     = 0;
+    pIndex->bUnkeyed  = false;
+    pIndex->bCommands = false;
+    pIndex->bListens  = false;
+
+    atr_push();
+    unsigned char *as;
+    int nAlloc = 0;
+    for (int atr = atr_head(thing, &as); atr; atr = atr_next(&as))
+    {
+        nAlloc++;
+    }
+    atr_pop();
+    if (0 == nAlloc)
+    {
+        return pIndex;
+    }
+    pIndex->aAttrs = (CMDX_ATTR *)MEMALLOC(nAlloc * sizeof(CMDX_ATTR));
+    ISOUTOFMEMORY(pIndex->aAttrs);
+
+    int nPatternAlloc = 0;
+    UTF8 *buff = alloc_lbuf("cmd_index_build");
+    atr_push();
+    for (int atr = atr_head(thing, &as); atr && pIndex->nAttrs < nAlloc; atr = atr_next(&as))
+    {
+        dbref aowner;
+        int   aflags;
+        atr_get_str(buff, thing, atr, &aowner, &aflags);
+
+        int iAttr = pIndex->nAttrs++;
+        pIndex->aAttrs[iAttr].atr    = atr;
+        pIndex->aAttrs[iAttr].aflags = aflags;
+
+        if (  (aflags & AF_NOPROG)
+           || (  AMATCH_CMD    != buff[0]
+              && AMATCH_LISTEN != buff[0]))
+        {
+            continue;
+        }
+
+        UTF8 *s = (UTF8 *)strchr((char *)buff+1, ':');
+        if (NULL == s)
+        {
+            continue;
+        }
+        *s = '\0';
+
+        if (pIndex->nPatterns == nPatternAlloc)
+        {
+            nPatternAlloc = (0 == nPatternAlloc) ? 4 : 2*nPatternAlloc;
+            CMDX_PATTERN *aNew = (CMDX_PATTERN *)MEMALLOC(nPatternAlloc * sizeof(CMDX_PATTERN));
+            ISOUTOFMEMORY(aNew);
+            if (pIndex->aPatterns)
+            {
+                memcpy(aNew, pIndex->aPatterns, pIndex->nPatterns * sizeof(CMDX_PATTERN));
+                MEMFREE(pIndex->aPatterns);
+            }
+            pIndex->aPatterns = aNew;
+        }
+
+        CMDX_PATTERN *pp = &pIndex->aPatterns[pIndex->nPatterns++];
+        pp->iAttr    = iAttr;
+        pp->chType   = buff[0];
+        pp->nPattern = s - (buff + 1);
+        pp->pPattern = StringCloneLen(buff + 1, pp->nPattern);
+        pp->pWild    = NULL;
+        pp->bKeyed   = false;
+        pp->uKey     = 0;
+        if (AMATCH_CMD == buff[0])
+        {
+            pIndex->bCommands = true;
+            if (  0 == (aflags & AF_REGEXP)
+               && cmd_index_key(pp->pPattern, true, &pp->uKey))
+            {
+                pp->bKeyed = true;
+                pIndex->fKeys |= CMDX_KEY_BIT(pp->uKey);
+            }
+            else
+            {
+                pIndex->bUnkeyed = true;
+            }
+        }
+        else
+        {
+            pIndex->bListens = true;
+        }
+    }
+    atr_pop();
+    free_lbuf(buff);
+    return pIndex;
+}
+
+static CMD_INDEX *cmd_index_fetch(dbref thing)
+{
+    CMD_INDEX *pIndex = (CMD_INDEX *)hashfindLEN(&thing, sizeof(thing),
+        &mudstate.cmd_index_htab);
+    if (NULL == pIndex)
+    {
+        pIndex = cmd_index_build(thing);
+        hashaddLEN(&thing, sizeof(thing), pIndex, &mudstate.cmd_index_htab);
+    }
+    pIndex->nRefs++;
+    return pIndex;
+}
+
 /* ----------------------------------------------------------------------
  * atr_match: Check attribute list for wild card matches and queue them.
  */
@@ -216,140 +628,164 @@ static int atr_match1
         return match;
     }
 
-    bool bFoundCommands = false;
-    bool bFoundListens  = false;
+    CMD_INDEX *pIndex = cmd_index_fetch(parent);
+    if (pIndex->bCommands)
+    {
+        mudstate.bfNoCommands.Clear(parent);
+        mudstate.bfCommands.Set(parent);
+    }
+    else
+    {
+        mudstate.bfCommands.Clear(parent);
+        mudstate.bfNoCommands.Set(parent);
+    }
 
-    atr_push();
-    unsigned char *as;
-    for (int atr = atr_head(parent, &as); atr; atr = atr_next(&as))
+    if (pIndex->bListens)
     {
-        ATTR *ap = atr_num(atr);
+        mudstate.bfNoListens.Clear(parent);
+        mudstate.bfListens.Set(parent);
+    }
+    else
+    {
+        mudstate.bfListens.Clear(parent);
+        mudstate.bfNoListens.Set(parent);
+    }
 
-        // Never check NOPROG attributes.
-        //
-        if (  !ap
-           || (ap->flags & AF_NOPROG))
+    // Only patterns with the same first word as the command can match it.
+    //
+    UINT32 uKeyStr = 0;
+    UINT32 uKeyRaw = 0;
+    bool bTryKeyed = true;
+    if (AMATCH_CMD == type)
+    {
+        cmd_index_key(str, false, &uKeyStr);
+        cmd_index_key(raw_str, false, &uKeyRaw);
+        bTryKeyed = (0 != (pIndex->fKeys & (CMDX_KEY_BIT(uKeyStr) | CMDX_KEY_BIT(uKeyRaw))));
+    }
+
+    UTF8 *buff = NULL;
+    for (int i = 0; i < pIndex->nPatterns; i++)
+    {
+        CMDX_PATTERN *pp = &pIndex->aPatterns[i];
+        if (type != pp->chType)
         {
             continue;
         }
 
-        // We need to grab the attribute even before we know whether we'll use
-        // it or not in order to maintain cached knowledge about ^-Commands
-        // and $-Commands.
-        //
-        dbref aowner;
-        int   aflags;
-        UTF8 buff[LBUF_SIZE];
-        atr_get_str(buff, parent, atr, &aowner, &aflags);
-
-        UTF8 *s = NULL;
-        if (  0 == (aflags & AF_NOPROG)
-           &&  (  AMATCH_CMD    == buff[0]
-               || AMATCH_LISTEN == buff[0]))
+        CMDX_ATTR *pa = &pIndex->aAttrs[pp->iAttr];
+        if (pp->bKeyed)
         {
-            s = (UTF8 *)strchr((char *)buff+1, ':');
-            if (s)
+            if (  !bTryKeyed
+               || pp->uKey != ((pa->aflags & AF_NOPARSE) ? uKeyRaw : uKeyStr))
             {
-                if (AMATCH_CMD == buff[0])
-                {
-                    bFoundCommands = true;
-                }
-                else
-                {
-                    bFoundListens = true;
-                }
+                continue;
             }
         }
 
+        // Never check NOPROG attributes.
+        //
+        ATTR *ap = atr_num(pa->atr);
+        if (  !ap
+           || (ap->flags & AF_NOPROG))
+        {
+            continue;
+        }
+
         // If we aren't the bottom level, check if we saw this attr
         // before. Also exclude it if the attribute type is PRIVATE.
         //
         if (  check_exclude
            && (  (ap->flags & AF_PRIVATE)
-              || (aflags & AF_PRIVATE)
+              || (pa->aflags & AF_PRIVATE)
               || hashfindLEN(&(ap->number), sizeof(ap->number), &mudstate.parent_htab)))
         {
             continue;
         }
 
-        // If we aren't the top level, remember this attr so we
-        // exclude it from now on.
+        // The action is only fetched for patterns which match.  The
+        // pattern is copied because regexp_match() wants a writable string.
         //
-        if (hash_insert)
-        {
-            hashaddLEN(&(ap->number), sizeof(ap->number), &atr, &mudstate.parent_htab);
-        }
-
-        if (aflags & AF_NOPROG)
+        if (NULL == buff)
         {
-            continue;
+            buff = alloc_lbuf("atr_match1");
         }
 
-        // Check for the leadin character after excluding the attrib.
-        // This lets non-command attribs on the child block commands
-        // on the parent.
-        //
-        if (buff[0] != type)
+        int aflags = pa->aflags;
+        if (  0 == (aflags & AF_REGEXP)
+           && NULL == pp->pWild)
         {
-            continue;
+            pp->pWild = new CWildcard;
+            pp->pWild->Compile(pp->pPattern, NUM_ENV_VARS);
         }
-
-        // Was there a ':'?
-        //
-        if (!s)
+        else if (0 != (aflags & AF_REGEXP))
         {
-            continue;
+            memcpy(buff, pp->pPattern, pp->nPattern + 1);
         }
-        *s++ = '\0';
 
         UTF8 *args[NUM_ENV_VARS];
         if (  (  0 != (aflags & AF_REGEXP)
-            && regexp_match(buff + 1, (aflags & AF_NOPARSE) ? raw_str : str,
+            && regexp_match(buff, (aflags & AF_NOPARSE) ? raw_str : str,
                 ((aflags & AF_CASE) ? 0 : PCRE_CASELESS), args, NUM_ENV_VARS))
            || (  0 == (aflags & AF_REGEXP)
-              && wild(buff + 1, (aflags & AF_NOPARSE) ? raw_str : str,
-                args, NUM_ENV_VARS)))
+              && pp->pWild->Match((aflags & AF_NOPARSE) ? raw_str : str, args)))
         {
-            match = 1;
-            CLinearTimeAbsolute lta;
-            wait_que(thing, player, player, AttrTrace(aflags, 0), false, lta,
-                NOTHING, 0,
-                s,
-                NUM_ENV_VARS, (const UTF8 **)args,
-                mudstate.global_regs);
+            dbref aowner;
+            atr_get_str(buff, parent, pa->atr, &aowner, &aflags);
+            UTF8 *s = buff + 1 + pp->nPattern;
+            if (  type == buff[0]
+               && ':' == *s
+               && memcmp(buff + 1, pp->pPattern, pp->nPattern) == 0)
+            {
+                match = 1;
+                CLinearTimeAbsolute lta;
+                wait_que(thing, player, player, AttrTrace(aflags, 0), false, lta,
+                    NOTHING, 0,
+                    s + 1,
+                    NUM_ENV_VARS, (const UTF8 **)args,
+                    mudstate.global_regs);
+            }
 
-            for (int i = 0; i < NUM_ENV_VARS; i++)
+            for (int j = 0; j < NUM_ENV_VARS; j++)
             {
-                if (args[i])
+                if (args[j])
                 {
-                    free_lbuf(args[i]);
+                    free_lbuf(args[j]);
                 }
             }
         }
     }
-    atr_pop();
-
-    if (bFoundCommands)
-    {
-        mudstate.bfNoCommands.Clear(parent);
-        mudstate.bfCommands.Set(parent);
-    }
-    else
+    if (buff)
     {
-        mudstate.bfCommands.Clear(parent);
-        mudstate.bfNoCommands.Set(parent);
+        free_lbuf(buff);
     }
 
-    if (bFoundListens)
-    {
-        mudstate.bfNoListens.Clear(parent);
-        mudstate.bfListens.Set(parent);
-    }
-    else
+    // If we aren't the top level, remember these attrs so we exclude them
+    // from now on.  This includes attributes which aren't commands, so that
+    // non-command attribs on the child block commands on the parent.
+    //
+    if (hash_insert)
     {
-        mudstate.bfListens.Clear(parent);
-        mudstate.bfNoListens.Set(parent);
+        for (int i = 0; i < pIndex->nAttrs; i++)
+        {
+            CMDX_ATTR *pa = &pIndex->aAttrs[i];
+            ATTR *ap = atr_num(pa->atr);
+            if (  !ap
+               || (ap->flags & AF_NOPROG))
+            {
+                continue;
+            }
+
+            if (  check_exclude
+               && (  (ap->flags & AF_PRIVATE)
+                  || (pa->aflags & AF_PRIVATE)
+                  || hashfindLEN(&(ap->number), sizeof(ap->number), &mudstate.parent_htab)))
+            {
+                continue;
+            }
+            hashaddLEN(&(ap->number), sizeof(ap->number), &pa->atr, &mudstate.parent_htab);
+        }
     }
+    cmd_index_release(pIndex);
     return match;
 }
 
@@ -459,7 +895,6 @@ static bool check_filter(dbref object, dbref player, int filter, const UTF8 *msg
         do
         {
             UTF8 *cp = parse_to(&dp, ',', EV_STRIP_CURLY);
-            mudstate.wild_invk_ctr = 0;
             if (  MuxAlarm.bAlarmed
                || quick_wild(cp, msg))
             {
@@ -473,24 +908,22 @@ static bool check_filter(dbref object, dbref player, int filter, const UTF8 *msg
         int case_opt = (aflags & AF_CASE) ? 0 : PCRE_CASELESS;
         do
         {
-            int erroffset;
             const char *errptr;
             UTF8 *cp = parse_to(&dp, ',', EV_STRIP_CURLY);
             pcre *re;
+            pcre_extra *study;
             if (  !MuxAlarm.bAlarmed
-               && (re = pcre_compile((char *)cp, PCRE_UTF8|case_opt, &errptr, &erroffset, NULL)) != NULL)
+               && (re = regexp_compile(cp, PCRE_UTF8|case_opt, false, &study, &errptr)) != NULL)
             {
                 const int ovecsize = 33;
                 int ovec[ovecsize];
-                int matches = pcre_exec(re, NULL, (char *)msg, static_cast<int>(strlen((char *)msg)), 0, 0,
+                int matches = pcre_exec(re, study, (char *)msg, static_cast<int>(strlen((char *)msg)), 0, 0,
                     ovec, ovecsize);
                 if (0 <= matches)
                 {
-                    MEMFREE(re);
                     free_lbuf(nbuf);
                     return false;
                 }
-                MEMFREE(re);
             }
         } while (dp != NULL);
     }
@@ -610,11 +1043,140 @@ bool html_escape(const UTF8 *src, UTF8 *dest, UTF8 **destp)
     return ret;
 }
 
-void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
+/* ---------------------------------------------------------------------------
+ * Hearers.
+ *
+ * Most things in a room ignore what is said there.  For the kind of message
+ * notify_except() and friends hand to the contents of a location, only
+ * players, puppets, and things with an @listen or the MONITOR flag can do
+ * anything with it.  The list of those is remembered per location and is
+ * thrown away whenever the location's contents list changes or one of its
+ * contents changes a flag.
+ */
+
+typedef struct
 {
-    // If speaker is invalid or message is empty, just exit.
-    //
-    if (  !Good_obj(target)
+    int   nRefs;
+    bool  bCached;
+    int   nHearers;
+    dbref aHearers[1];
+} HEARERS;
+
+// The keys which cannot make a message do anything for a non-hearer.
+//
+#define MSG_HEARER_KEYS (MSG_PUP_ALWAYS|MSG_INV_L|MSG_ME|MSG_S_OUTSIDE|MSG_HTML|MSG_OOC|MSG_SAYPOSE|MSG_SRC_MASK)
+
+static bool CanHear(dbref thing)
+{
+    return (  isPlayer(thing)
+           || Puppet(thing)
+           || H_Listen(thing)
+           || Monitor(thing));
+}
+
+void hearers_invalidate(dbref loc)
+{
+    if (  0 == mudstate.hearer_htab.GetEntryCount()
+       || loc < 0
+       || mudstate.db_top <= loc)
+    {
+        return;
+    }
+
+    HEARERS *ph = (HEARERS *)hashfindLEN(&loc, sizeof(loc), &mudstate.hearer_htab);
+    if (ph)
+    {
+        hashdeleteLEN(&loc, sizeof(loc), &mudstate.hearer_htab);
+        ph->bCached = false;
+        if (0 == ph->nRefs)
+        {
+            MEMFREE(ph);
+        }
+    }
+}
+
+static HEARERS *hearers_fetch(dbref loc)
+{
+    HEARERS *ph = (HEARERS *)hashfindLEN(&loc, sizeof(loc), &mudstate.hearer_htab);
+    if (NULL == ph)
+    {
+        dbref obj;
+        int n = 0;
+        DOLIST(obj, Contents(loc))
+        {
+            if (CanHear(obj))
+            {
+                n++;
+            }
+        }
+
+        ph = (HEARERS *)MEMALLOC(sizeof(HEARERS) + n * sizeof(dbref));
+        ISOUTOFMEMORY(ph);
+        ph->nRefs    = 0;
+        ph->bCached  = true;
+        ph->nHearers = 0;
+        DOLIST(obj, Contents(loc))
+        {
+            if (  CanHear(obj)
+               && ph->nHearers < n)
+            {
+                ph->aHearers[ph->nHearers++] = obj;
+            }
+        }
+        hashaddLEN(&loc, sizeof(loc), ph, &mudstate.hearer_htab);
+    }
+    ph->nRefs++;
+    return ph;
+}
+
+static void hearers_release(HEARERS *ph)
+{
+    ph->nRefs--;
+    if (  0 == ph->nRefs
+       && !ph->bCached)
+    {
+        MEMFREE(ph);
+    }
+}
+
+// Hand a message to everything in a location except exc1 and exc2.
+//
+static void notify_contents(dbref loc, dbref sender, const mux_string &msg, int key,
+    dbref exc1, dbref exc2)
+{
+    dbref obj;
+    if (  0 != (key & ~MSG_HEARER_KEYS)
+       || mudstate.inpipe)
+    {
+        DOLIST(obj, Contents(loc))
+        {
+            if (  obj != exc1
+               && obj != exc2)
+            {
+                notify_check(obj, sender, msg, key);
+            }
+        }
+        return;
+    }
+
+    HEARERS *ph = hearers_fetch(loc);
+    for (int i = 0; i < ph->nHearers; i++)
+    {
+        obj = ph->aHearers[i];
+        if (  obj != exc1
+           && obj != exc2)
+        {
+            notify_check(obj, sender, msg, key);
+        }
+    }
+    hearers_release(ph);
+}
+
+void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
+{
+    // If speaker is invalid or message is empty, just exit.
+    //
+    if (  !Good_obj(target)
        || 0 == msg.length_byte())
     {
         return;
@@ -656,6 +1218,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
     dbref aowner,  recip, obj;
     int i, nargs, aflags;
     FWDLIST *fp;
+    bool bNospoof = false;
 
     // If we want NOSPOOF output, generate it.  It is only needed if we are
     // sending the message to the target object.
@@ -667,6 +1230,8 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
            && target != mudstate.curr_enactor
            && target != mudstate.curr_executor)
         {
+            bNospoof = true;
+
             // I'd really like to use tprintf here but I can't because the
             // caller may have.  notify(target, tprintf(...)) is quite common
             // in the code.
@@ -734,6 +1299,15 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
             {
                 raw_notify_html(target, *msg_ns);
             }
+            else if (  !bNospoof
+                    && !Html(target))
+            {
+                // Without a NOSPOOF prefix, the message goes out unchanged.
+                // Passing the caller's copy lets a broadcast share the
+                // rendering.
+                //
+                raw_notify(target, msg);
+            }
             else
             {
                 msgFinal->import(*msg_ns);
@@ -982,14 +1556,9 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                 msgFinal->import(msg);
             }
 
-            DOLIST(obj, Contents(target))
-            {
-                if (obj != target)
-                {
-                    notify_check(obj, sender, *msgFinal,
-                        MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | (key & (MSG_HTML | MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC)));
-                }
-            }
+            notify_contents(target, sender, *msgFinal,
+                MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | (key & (MSG_HTML | MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC)),
+                target, NOTHING);
         }
 
         // Deliver message to neighbors.
@@ -1013,15 +1582,9 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                 msgFinal->import(msg);
             }
 
-            DOLIST(obj, Contents(targetloc))
-            {
-                if (  obj != target
-                   && obj != targetloc)
-                {
-                    notify_check(obj, sender, *msgFinal,
-                        MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | (key & (MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC)));
-                }
-            }
+            notify_contents(targetloc, sender, *msgFinal,
+                MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | (key & (MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC)),
+                target, targetloc);
         }
 
         // Deliver message to container.
@@ -1074,38 +1637,51 @@ void notify_check(dbref target, dbref sender, const UTF8 *msg, int key)
 
 void notify_except(dbref loc, dbref player, dbref exception, const UTF8 *msg, int key)
 {
-    dbref first;
-
-    if (loc != exception)
+    if (  !msg
+       || !*msg)
     {
-        notify_check(loc, player, msg, MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A | key);
+        return;
     }
-    DOLIST(first, Contents(loc))
+
+    // Everyone in the room hears the same message, so parse it once and let
+    // the network layer render it once per kind of client.
+    //
+    mux_string *sMsg = new mux_string(msg);
+    broadcast_begin();
+    broadcast_message(*sMsg);
+
+    if (loc != exception)
     {
-        if (first != exception)
-        {
-            notify_check(first, player, msg, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | key);
-        }
+        notify_check(loc, player, *sMsg, MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A | key);
     }
+    notify_contents(loc, player, *sMsg, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | key,
+        exception, NOTHING);
+
+    broadcast_end();
+    delete sMsg;
 }
 
 void notify_except2(dbref loc, dbref player, dbref exc1, dbref exc2, const UTF8 *msg)
 {
-    dbref first;
+    if (  !msg
+       || !*msg)
+    {
+        return;
+    }
+
+    mux_string *sMsg = new mux_string(msg);
+    broadcast_begin();
+    broadcast_message(*sMsg);
 
     if (  loc != exc1
        && loc != exc2)
     {
-        notify_check(loc, player, msg, MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A);
-    }
-    DOLIST(first, Contents(loc))
-    {
-        if (  first != exc1
-           && first != exc2)
-        {
-            notify_check(first, player, msg, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE);
-        }
+        notify_check(loc, player, *sMsg, MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A);
     }
+    notify_contents(loc, player, *sMsg, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE, exc1, exc2);
+
+    broadcast_end();
+    delete sMsg;
 }
 
 /* ----------------------------------------------------------------------
@@ -1203,172 +1779,609 @@ void do_timecheck(dbref executor, dbref caller, dbref enactor, int eval, int key
     UNUSED_PARAMETER(enactor);
     UNUSED_PARAMETER(eval);
 
-    bool yes_screen, yes_log, yes_clear;
+    bool yes_screen, yes_log, yes_clear;
+
+    yes_screen = yes_log = yes_clear = false;
+
+    if (key == 0)
+    {
+        // No switches, default to printing to screen and clearing counters.
+        //
+        yes_screen = true;
+        yes_clear = true;
+    }
+    else
+    {
+        if (key & TIMECHK_RESET)
+        {
+            yes_clear = true;
+        }
+        if (key & TIMECHK_SCREEN)
+        {
+            yes_screen = true;
+        }
+        if (key & TIMECHK_LOG)
+        {
+            yes_log = true;
+        }
+    }
+    report_timecheck(executor, yes_screen, yes_log, yes_clear);
+}
+
+void do_shutdown
+(
+    dbref executor,
+    dbref caller,
+    dbref enactor,
+    int   eval,
+    int   key,
+    UTF8 *message,
+    const UTF8 *cargs[],
+    int ncargs
+)
+{
+    UNUSED_PARAMETER(caller);
+    UNUSED_PARAMETER(enactor);
+    UNUSED_PARAMETER(eval);
+    UNUSED_PARAMETER(cargs);
+    UNUSED_PARAMETER(ncargs);
+
+    if (!Can_SiteAdmin(executor))
+    {
+        notify(executor, NOPERM_MESSAGE);
+        return;
+    }
+
+    raw_broadcast(0, T("GAME: Shutdown by %s"), Moniker(Owner(executor)));
+    STARTLOG(LOG_ALWAYS, "WIZ", "SHTDN");
+    log_text(T("Shutdown by "));
+    log_name(executor);
+    ENDLOG;
+
+    STARTLOG(LOG_ALWAYS, "WIZ", "SHTDN");
+    log_text(T("Shutdown status: "));
+    log_text(message);
+    ENDLOG;
+
+    int fd;
+    if (mux_open(&fd, mudconf.status_file, O_RDWR|O_CREAT|O_TRUNC|O_BINARY))
+    {
+        mux_write(fd, message, static_cast<unsigned int>(strlen((char *)message)));
+        mux_write(fd, ENDLINE, sizeof(ENDLINE)-1);
+        DebugTotalFiles++;
+        if (mux_close(fd) == 0)
+        {
+            DebugTotalFiles--;
+        }
+    }
+
+    // Do we perform a normal or an emergency shutdown? Normal
+    // shutdown is handled by exiting the main loop in shovechars,
+    // emergency shutdown is done here.
+    //
+    if (key & SHUTDN_PANIC)
+    {
+        // Close down the network interface.
+        //
+        emergency_shutdown();
+
+        local_presync_database();
+#if defined(TINYMUX_MODULES)
+        ServerEventsSinkNode *p = g_pServerEventsSinkListHead;
+        while (NULL != p)
+        {
+            p->pSink->presync_database();
+            p = p->pNext;
+        }
+        final_modules();
+#endif // TINYMUX_MODULES
+
+        // Close the attribute text db and dump the header db.
+        //
+#ifndef MEMORY_BASED
+        // Save cached modified attribute list
+        //
+        al_store();
+#endif // MEMORY_BASED
+
+        pcache_sync();
+        SYNC;
+        CLOSE;
+
+        STARTLOG(LOG_ALWAYS, "DMP", "PANIC");
+        log_text(T("Panic dump: "));
+        log_text(mudconf.crashdb);
+        ENDLOG;
+        dump_database_internal(DUMP_I_PANIC);
+        STARTLOG(LOG_ALWAYS, "DMP", "DONE");
+        log_text(T("Panic dump complete: "));
+        log_text(mudconf.crashdb);
+        ENDLOG;
+    }
+
+    // Set up for normal shutdown.
+    //
+    mudstate.shutdown_flag = true;
+}
+
+// There are several types of dumps:
+//
+// Type 0 - Normal   mudstate.dumping controlled
+// Type 1 - Panic    uncontrolled but only one of these happening at a time.
+// Type 2 - Restart  mudstate.dumping controlled.
+// Type 3 - FLAT     mudstate.dumping controlled.
+// Type 4 - signal   uncontrolled and if we fault twice, the game ends --
+//                   see check_panicking.
+//
+// When changing this function and to keep forking dumps safe, keep in mind
+// that the following combinations can be occuring at the same time. Don't
+// touch each other's files.
+//
+// Type 0 and 2 are allowed to touch each other's files. Type 1 and 4 should not
+// touch files used in Type 0 or Type 2.
+//
+typedef struct
+{
+    UTF8      **ppszOutputBase;
+    const UTF8 *szOutputSuffix;
+    bool        bUseTemporary;
+    int         fType;
+    const UTF8 *pszErrorMessage;
+} DUMP_PROCEDURE;
+
+static DUMP_PROCEDURE DumpProcedures[NUM_DUMP_TYPES] =
+{
+    { NULL,             T(""),     false, 0,                             T("") }, // 0 -- Handled specially.
+    { &mudconf.crashdb, T(""),     false, UNLOAD_VERSION | UNLOAD_FLAGS, T("Opening crash file") }, // 1
+    { &mudconf.indb,    T(""),     true,  OUTPUT_VERSION | OUTPUT_FLAGS, T("Opening input file") }, // 2
+    { &mudconf.indb,   T(".FLAT"), false, UNLOAD_VERSION | UNLOAD_FLAGS, T("Opening flatfile")   }, // 3
+    { &mudconf.indb,   T(".SIG"),  false, UNLOAD_VERSION | UNLOAD_FLAGS, T("Opening signalled flatfile")}  // 4
+};
+
+#if defined(WINDOWS_FILES)
+#define POPEN_READ_OP "rb"
+#define POPEN_WRITE_OP "wb"
+#elif defined(UNIX_FILES)
+#define POPEN_READ_OP "r"
+#define POPEN_WRITE_OP "w"
+#endif // UNIX_FILES
+
+#if defined(UNIX_DUMP_JOURNAL)
+
+// Checkpoint journal writer.
+//
+// An incremental checkpoint is serialized into memory on the game thread and
+// handed to a writer thread, which writes and fsync()s it.  Journal segments
+// are appended to <outdb>.delta, and the mail and comsys databases are
+// replaced through a temporary file.  Finished jobs are freed and write
+// failures are reported by the game thread.
+//
+typedef struct dump_job DUMP_JOB;
+struct dump_job
+{
+    DUMP_JOB *next;
+    char     *pData;
+    size_t    nData;
+    bool      bAppend;
+    bool      bFailed;
+    UTF8      szPath[SIZEOF_PATHNAME+8];
+    UTF8      szTemp[SIZEOF_PATHNAME+8];
+};
+
+static pthread_t       thDumpWriter;
+static pthread_mutex_t mtxDumpJobs = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cvDumpWork  = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  cvDumpDone  = PTHREAD_COND_INITIALIZER;
+static DUMP_JOB *pDumpQueueHead = NULL;
+static DUMP_JOB *pDumpQueueTail = NULL;
+static DUMP_JOB *pDumpDone      = NULL;
+static bool bDumpWriterBusy     = false;
+static bool bDumpWriterStarted  = false;
+
+static bool dump_write_all(int fd, const char *pData, size_t nData)
+{
+    while (0 < nData)
+    {
+        ssize_t cc = mux_write(fd, pData, nData);
+        if (cc < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return false;
+        }
+        pData += cc;
+        nData -= cc;
+    }
+    return true;
+}
+
+// Runs on the writer thread.  Nothing here may allocate from the game's
+// pools or log.
+//
+static bool dump_job_write(DUMP_JOB *pJob)
+{
+    int fd;
+    bool bSuccess;
+    if (pJob->bAppend)
+    {
+        if (!mux_open(&fd, pJob->szPath, O_WRONLY|O_CREAT|O_APPEND|O_BINARY))
+        {
+            return false;
+        }
+
+        // Each segment is preceded by its length.
+        //
+        UTF8 aLength[I64BUF_SIZE+1];
+        size_t nLength = mux_i64toa(pJob->nData, aLength);
+        aLength[nLength++] = '\n';
+        bSuccess =  dump_write_all(fd, (char *)aLength, nLength)
+                 && dump_write_all(fd, pJob->pData, pJob->nData)
+                 && fsync(fd) == 0;
+        mux_close(fd);
+    }
+    else
+    {
+        if (!mux_open(&fd, pJob->szTemp, O_WRONLY|O_CREAT|O_TRUNC|O_BINARY))
+        {
+            return false;
+        }
+        bSuccess =  dump_write_all(fd, pJob->pData, pJob->nData)
+                 && fsync(fd) == 0;
+        mux_close(fd);
+        bSuccess = bSuccess
+                && rename((char *)pJob->szTemp, (char *)pJob->szPath) == 0;
+    }
+    return bSuccess;
+}
+
+static void *dump_writer_proc(void *pUnused)
+{
+    UNUSED_PARAMETER(pUnused);
+
+    pthread_mutex_lock(&mtxDumpJobs);
+    for (;;)
+    {
+        while (NULL == pDumpQueueHead)
+        {
+            pthread_cond_wait(&cvDumpWork, &mtxDumpJobs);
+        }
+        DUMP_JOB *pJob = pDumpQueueHead;
+        pDumpQueueHead = pJob->next;
+        if (NULL == pDumpQueueHead)
+        {
+            pDumpQueueTail = NULL;
+        }
+        bDumpWriterBusy = true;
+        pthread_mutex_unlock(&mtxDumpJobs);
+
+        pJob->bFailed = !dump_job_write(pJob);
+
+        pthread_mutex_lock(&mtxDumpJobs);
+        pJob->next = pDumpDone;
+        pDumpDone = pJob;
+        bDumpWriterBusy = false;
+        pthread_cond_broadcast(&cvDumpDone);
+    }
+    return NULL;
+}
+
+// Free finished jobs and report the ones which failed.  Called on the game
+// thread with mtxDumpJobs held.
+//
+static void dump_journal_reap(void)
+{
+    while (NULL != pDumpDone)
+    {
+        DUMP_JOB *pJob = pDumpDone;
+        pDumpDone = pJob->next;
+        if (pJob->bFailed)
+        {
+            STARTLOG(LOG_PROBLEMS, "DMP", "FAIL");
+            log_text(T("Unable to write checkpoint file: "));
+            log_text(pJob->szPath);
+            ENDLOG;
+            raw_broadcast(WIZARD,
+                T("GAME: Unable to write %s.  The disk may be full."),
+                pJob->szPath);
+        }
+        free(pJob->pData);
+        MEMFREE(pJob);
+    }
+}
+
+static bool dump_journal_queue
+(
+    const UTF8 *pPath,
+    bool  bAppend,
+    char *pData,
+    size_t nData
+)
+{
+    if (!bDumpWriterStarted)
+    {
+        // Signals are handled by the game thread only.
+        //
+        sigset_t sigAll, sigSaved;
+        sigfillset(&sigAll);
+        pthread_sigmask(SIG_SETMASK, &sigAll, &sigSaved);
+        int cc = pthread_create(&thDumpWriter, NULL, dump_writer_proc, NULL);
+        pthread_sigmask(SIG_SETMASK, &sigSaved, NULL);
+        if (0 != cc)
+        {
+            free(pData);
+            return false;
+        }
+        bDumpWriterStarted = true;
+    }
+
+    DUMP_JOB *pJob = (DUMP_JOB *)MEMALLOC(sizeof(DUMP_JOB));
+    ISOUTOFMEMORY(pJob);
+    pJob->next    = NULL;
+    pJob->pData   = pData;
+    pJob->nData   = nData;
+    pJob->bAppend = bAppend;
+    pJob->bFailed = false;
+    mux_strncpy(pJob->szPath, pPath, sizeof(pJob->szPath)-1);
+    mux_sprintf(pJob->szTemp, sizeof(pJob->szTemp), T("%s.#"), pPath);
+
+    pthread_mutex_lock(&mtxDumpJobs);
+    dump_journal_reap();
+    if (NULL == pDumpQueueTail)
+    {
+        pDumpQueueHead = pJob;
+    }
+    else
+    {
+        pDumpQueueTail->next = pJob;
+    }
+    pDumpQueueTail = pJob;
+    pthread_cond_signal(&cvDumpWork);
+    pthread_mutex_unlock(&mtxDumpJobs);
+    return true;
+}
+
+/*! \brief Wait until everything handed to the checkpoint writer is on disk.
+ *
+ * \return         None.
+ */
+
+void dump_journal_drain(void)
+{
+    if (!bDumpWriterStarted)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&mtxDumpJobs);
+    while (  NULL != pDumpQueueHead
+          || bDumpWriterBusy)
+    {
+        pthread_cond_wait(&cvDumpDone, &mtxDumpJobs);
+    }
+    dump_journal_reap();
+    pthread_mutex_unlock(&mtxDumpJobs);
+}
+
+// Serialize a stream into memory and queue it for the writer thread.
+//
+static bool dump_journal_open(FILE **pf, char **ppData, size_t *pnData)
+{
+    *ppData = NULL;
+    *pnData = 0;
+    *pf = open_memstream(ppData, pnData);
+    return (NULL != *pf);
+}
+
+// The buffer and its size are only final once the stream is closed.
+//
+static bool dump_journal_close(FILE *f, char **ppData, size_t *pnData,
+    const UTF8 *pPath, bool bAppend)
+{
+    if (fclose(f) != 0)
+    {
+        free(*ppData);
+        return false;
+    }
+    return dump_journal_queue(pPath, bAppend, *ppData, *pnData);
+}
+
+/*! \brief Take an incremental checkpoint.
+ *
+ * Objects changed since the previous checkpoint are serialized as one
+ * journal segment, and the mail and comsys databases are serialized whole.
+ * The game thread only pays for the serialization.  The writer thread does
+ * the I/O.
+ *
+ * \return         false if the segment could not be produced, in which case
+ *                 the caller should take a full checkpoint instead.
+ */
+
+static bool dump_journal_checkpoint(void)
+{
+    FILE *f;
+    char *pData;
+    size_t nData;
+    if (!dump_journal_open(&f, &pData, &nData))
+    {
+        return false;
+    }
+
+    local_dump_database(DUMP_I_NORMAL);
+#if defined(TINYMUX_MODULES)
+    ServerEventsSinkNode *p = g_pServerEventsSinkListHead;
+    while (NULL != p)
+    {
+        p->pSink->dump_database(DUMP_I_NORMAL);
+        p = p->pNext;
+    }
+#endif // TINYMUX_MODULES
+
+    int nObjects = db_write_journal(f, OUTPUT_VERSION | OUTPUT_FLAGS);
+    UTF8 szJournal[SIZEOF_PATHNAME+8];
+    mux_sprintf(szJournal, sizeof(szJournal), T("%s.delta"), mudconf.outdb);
+    if (!dump_journal_close(f, &pData, &nData, szJournal, true))
+    {
+        // The changed objects are no longer marked.  Only a full checkpoint
+        // can make up for it.
+        //
+        return false;
+    }
 
-    yes_screen = yes_log = yes_clear = false;
+    STARTLOG(LOG_DBSAVES, "DMP", "CHKPT");
+    log_text(tprintf(T("Journaled %d objects (%s bytes) to "), nObjects,
+        mux_i64toa_t(nData)));
+    log_text(szJournal);
+    ENDLOG;
 
-    if (key == 0)
+    if (  mudconf.have_mailer
+       && dump_journal_open(&f, &pData, &nData))
     {
-        // No switches, default to printing to screen and clearing counters.
-        //
-        yes_screen = true;
-        yes_clear = true;
+        dump_mail(f);
+        dump_journal_close(f, &pData, &nData, mudconf.mail_db, false);
     }
-    else
+
+    if (  mudconf.have_comsys
+       && dump_journal_open(&f, &pData, &nData))
     {
-        if (key & TIMECHK_RESET)
-        {
-            yes_clear = true;
-        }
-        if (key & TIMECHK_SCREEN)
-        {
-            yes_screen = true;
-        }
-        if (key & TIMECHK_LOG)
-        {
-            yes_log = true;
-        }
+        save_comsys_stream(f);
+        dump_journal_close(f, &pData, &nData, mudconf.comsys_db, false);
     }
-    report_timecheck(executor, yes_screen, yes_log, yes_clear);
+    return true;
 }
 
-void do_shutdown
-(
-    dbref executor,
-    dbref caller,
-    dbref enactor,
-    int   eval,
-    int   key,
-    UTF8 *message,
-    const UTF8 *cargs[],
-    int ncargs
-)
+/*! \brief Move the journal aside for a full checkpoint.
+ *
+ * The forked child only covers the segments written before the fork, so it
+ * removes <outdb>.delta.dump rather than <outdb>.delta, which the parent
+ * goes on appending to.  If an earlier full checkpoint never finished, its
+ * <outdb>.delta.dump is still there, and the journal is appended to it so
+ * that segments are replayed in the order they were written.
+ *
+ * \return         None.
+ */
+
+static void dump_journal_rotate(void)
 {
-    UNUSED_PARAMETER(caller);
-    UNUSED_PARAMETER(enactor);
-    UNUSED_PARAMETER(eval);
-    UNUSED_PARAMETER(cargs);
-    UNUSED_PARAMETER(ncargs);
+    UTF8 szJournal[SIZEOF_PATHNAME+8];
+    UTF8 szRotated[SIZEOF_PATHNAME+16];
+    mux_sprintf(szJournal, sizeof(szJournal), T("%s.delta"), mudconf.outdb);
+    mux_sprintf(szRotated, sizeof(szRotated), T("%s.delta.dump"), mudconf.outdb);
 
-    if (!Can_SiteAdmin(executor))
+    FILE *fIn;
+    if (!mux_fopen(&fIn, szJournal, T("rb")))
     {
-        notify(executor, NOPERM_MESSAGE);
         return;
     }
 
-    raw_broadcast(0, T("GAME: Shutdown by %s"), Moniker(Owner(executor)));
-    STARTLOG(LOG_ALWAYS, "WIZ", "SHTDN");
-    log_text(T("Shutdown by "));
-    log_name(executor);
-    ENDLOG;
-
-    STARTLOG(LOG_ALWAYS, "WIZ", "SHTDN");
-    log_text(T("Shutdown status: "));
-    log_text(message);
-    ENDLOG;
-
-    int fd;
-    if (mux_open(&fd, mudconf.status_file, O_RDWR|O_CREAT|O_TRUNC|O_BINARY))
+    FILE *fOut;
+    if (!mux_fopen(&fOut, szRotated, T("rb")))
     {
-        mux_write(fd, message, static_cast<unsigned int>(strlen((char *)message)));
-        mux_write(fd, ENDLINE, sizeof(ENDLINE)-1);
-        DebugTotalFiles++;
-        if (mux_close(fd) == 0)
+        fclose(fIn);
+        if (ReplaceFile(szJournal, szRotated) < 0)
         {
-            DebugTotalFiles--;
+            log_perror(T("DMP"), T("FAIL"), T("Renaming journal"), szJournal);
         }
+        return;
     }
+    fclose(fOut);
 
-    // Do we perform a normal or an emergency shutdown? Normal
-    // shutdown is handled by exiting the main loop in shovechars,
-    // emergency shutdown is done here.
-    //
-    if (key & SHUTDN_PANIC)
+    bool bFailed = !mux_fopen(&fOut, szRotated, T("ab"));
+    if (!bFailed)
     {
-        // Close down the network interface.
-        //
-        emergency_shutdown();
-
-        local_presync_database();
-#if defined(TINYMUX_MODULES)
-        ServerEventsSinkNode *p = g_pServerEventsSinkListHead;
-        while (NULL != p)
+        char buf[16384];
+        size_t n;
+        while (0 < (n = fread(buf, 1, sizeof(buf), fIn)))
         {
-            p->pSink->presync_database();
-            p = p->pNext;
+            if (fwrite(buf, 1, n, fOut) != n)
+            {
+                bFailed = true;
+                break;
+            }
         }
-        final_modules();
-#endif // TINYMUX_MODULES
+        if (  ferror(fIn)
+           || 0 != fflush(fOut)
+           || 0 != fsync(fileno(fOut)))
+        {
+            bFailed = true;
+        }
+        fclose(fOut);
+    }
+    fclose(fIn);
 
-        // Close the attribute text db and dump the header db.
-        //
-#ifndef MEMORY_BASED
-        // Save cached modified attribute list
+    if (bFailed)
+    {
+        // Leave both journals.  The full checkpoint will not remove the
+        // newer one, which is only replayed again.
         //
-        al_store();
-#endif // MEMORY_BASED
+        log_perror(T("DMP"), T("FAIL"), T("Appending journal"), szRotated);
+    }
+    else
+    {
+        RemoveFile(szJournal);
+    }
+}
 
-        pcache_sync();
-        SYNC;
-        CLOSE;
+/*! \brief Get the journal ready for a full checkpoint.
+ *
+ * A full checkpoint removes the journal once it has replaced the output
+ * database.  If this process has written journal segments, one last segment
+ * brings the journal up to the moment of the full checkpoint, so a journal
+ * which outlives the full checkpoint is harmless, and an interrupted full
+ * checkpoint loses nothing.  Otherwise, the journal is left alone until the
+ * full checkpoint has replaced the output database it goes with.  Either
+ * way, what is left is moved aside so that segments written after a fork
+ * are kept.
+ *
+ * No incremental checkpoints are taken until dump_journal_finish() reports
+ * that the full checkpoint succeeded.
+ *
+ * \return         None.
+ */
 
-        STARTLOG(LOG_ALWAYS, "DMP", "PANIC");
-        log_text(T("Panic dump: "));
-        log_text(mudconf.crashdb);
-        ENDLOG;
-        dump_database_internal(DUMP_I_PANIC);
-        STARTLOG(LOG_ALWAYS, "DMP", "DONE");
-        log_text(T("Panic dump complete: "));
-        log_text(mudconf.crashdb);
-        ENDLOG;
+static void dump_journal_seal(void)
+{
+    if (  mudstate.nIncrementalDumps <= 0
+       || !dump_journal_checkpoint())
+    {
+        // The full checkpoint will include everything.  If it fails, the
+        // next checkpoint is a full one, too.
+        //
+        mudstate.bfDirty.ClearAll();
+        mudstate.bDirtyAttrNames = false;
     }
-
-    // Set up for normal shutdown.
-    //
-    mudstate.shutdown_flag = true;
+    dump_journal_drain();
+    dump_journal_rotate();
+    mudstate.nIncrementalDumps = -2;
 }
 
-// There are several types of dumps:
-//
-// Type 0 - Normal   mudstate.dumping controlled
-// Type 1 - Panic    uncontrolled but only one of these happening at a time.
-// Type 2 - Restart  mudstate.dumping controlled.
-// Type 3 - FLAT     mudstate.dumping controlled.
-// Type 4 - signal   uncontrolled and if we fault twice, the game ends --
-//                   see check_panicking.
-//
-// When changing this function and to keep forking dumps safe, keep in mind
-// that the following combinations can be occuring at the same time. Don't
-// touch each other's files.
-//
-// Type 0 and 2 are allowed to touch each other's files. Type 1 and 4 should not
-// touch files used in Type 0 or Type 2.
-//
-typedef struct
-{
-    UTF8      **ppszOutputBase;
-    const UTF8 *szOutputSuffix;
-    bool        bUseTemporary;
-    int         fType;
-    const UTF8 *pszErrorMessage;
-} DUMP_PROCEDURE;
+/*! \brief Learn how a full checkpoint ended.
+ *
+ * Called on the game thread after an in-process full checkpoint, and from
+ * the SIGCHLD handler when a forked one exits.  Journal segments are only
+ * written once the output database they apply to is known to be complete.
+ *
+ * \param bSuccess  Whether the output database was replaced.
+ * \return          None.
+ */
 
-static DUMP_PROCEDURE DumpProcedures[NUM_DUMP_TYPES] =
+void dump_journal_finish(bool bSuccess)
 {
-    { NULL,             T(""),     false, 0,                             T("") }, // 0 -- Handled specially.
-    { &mudconf.crashdb, T(""),     false, UNLOAD_VERSION | UNLOAD_FLAGS, T("Opening crash file") }, // 1
-    { &mudconf.indb,    T(""),     true,  OUTPUT_VERSION | OUTPUT_FLAGS, T("Opening input file") }, // 2
-    { &mudconf.indb,   T(".FLAT"), false, UNLOAD_VERSION | UNLOAD_FLAGS, T("Opening flatfile")   }, // 3
-    { &mudconf.indb,   T(".SIG"),  false, UNLOAD_VERSION | UNLOAD_FLAGS, T("Opening signalled flatfile")}  // 4
-};
+    // Anything else, such as @dbclean asking for another full checkpoint,
+    // stands.
+    //
+    if (-2 == mudstate.nIncrementalDumps)
+    {
+        mudstate.nIncrementalDumps = bSuccess ? 0 : -1;
+    }
+}
 
-#if defined(WINDOWS_FILES)
-#define POPEN_READ_OP "rb"
-#define POPEN_WRITE_OP "wb"
-#elif defined(UNIX_FILES)
-#define POPEN_READ_OP "r"
-#define POPEN_WRITE_OP "w"
-#endif // UNIX_FILES
+#endif // UNIX_DUMP_JOURNAL
+
+// Whether the last DUMP_I_NORMAL dump replaced the output database.
+//
+static bool bOutputDumped = false;
 
 void dump_database_internal(int dump_type)
 {
@@ -1433,7 +2446,15 @@ void dump_database_internal(int dump_type)
         {
             DebugTotalFiles++;
             setvbuf(f, NULL, _IOFBF, 16384);
-            db_write(f, F_MUX, dp->fType);
+            if (  DUMP_I_RESTART == dump_type
+               && mudconf.binary_database)
+            {
+                db_write_binary(f, dp->fType);
+            }
+            else
+            {
+                db_write(f, F_MUX, dp->fType);
+            }
             if (fclose(f) == 0)
             {
                 DebugTotalFiles--;
@@ -1443,6 +2464,17 @@ void dump_database_internal(int dump_type)
             {
                 ReplaceFile(tmpfile, outfn);
             }
+
+            if (DUMP_I_RESTART == dump_type)
+            {
+                // The input database is complete, so its checkpoint journals
+                // no longer apply.
+                //
+                mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.delta"), mudconf.indb);
+                RemoveFile(tmpfile);
+                mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.delta.dump"), mudconf.indb);
+                RemoveFile(tmpfile);
+            }
         }
         else
         {
@@ -1473,6 +2505,7 @@ void dump_database_internal(int dump_type)
 
     // Nuke our predecessor
     //
+    bOutputDumped = false;
     if (mudconf.compress_db)
     {
         mux_sprintf(prevfile, sizeof(prevfile), T("%s.prev.gz"), mudconf.outdb);
@@ -1486,7 +2519,14 @@ void dump_database_internal(int dump_type)
         {
             DebugTotalFiles++;
             setvbuf(f, NULL, _IOFBF, 16384);
-            db_write(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS);
+            if (mudconf.binary_database)
+            {
+                db_write_binary(f, OUTPUT_VERSION | OUTPUT_FLAGS);
+            }
+            else
+            {
+                db_write(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS);
+            }
             if (pclose(f) != -1)
             {
                 DebugTotalFiles--;
@@ -1496,6 +2536,16 @@ void dump_database_internal(int dump_type)
             {
                 log_perror(T("SAV"), T("FAIL"), T("Renaming output file to DB file"), tmpfile);
             }
+            else
+            {
+                // The output database is complete, so the journal moved aside
+                // before it was started no longer applies.  Segments written
+                // since then are still needed.
+                //
+                mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.delta.dump"), mudconf.outdb);
+                RemoveFile(tmpfile);
+                bOutputDumped = true;
+            }
         }
         else
         {
@@ -1513,7 +2563,14 @@ void dump_database_internal(int dump_type)
         {
             DebugTotalFiles++;
             setvbuf(f, NULL, _IOFBF, 16384);
-            db_write(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS);
+            if (mudconf.binary_database)
+            {
+                db_write_binary(f, OUTPUT_VERSION | OUTPUT_FLAGS);
+            }
+            else
+            {
+                db_write(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS);
+            }
             if (fclose(f) == 0)
             {
                 DebugTotalFiles--;
@@ -1523,6 +2580,12 @@ void dump_database_internal(int dump_type)
             {
                 log_perror(T("SAV"), T("FAIL"), T("Renaming output file to DB file"), tmpfile);
             }
+            else
+            {
+                mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.delta.dump"), mudconf.outdb);
+                RemoveFile(tmpfile);
+                bOutputDumped = true;
+            }
         }
         else
         {
@@ -1599,7 +2662,13 @@ static void dump_database(void)
 
     pcache_sync();
 
+#if defined(UNIX_DUMP_JOURNAL)
+    dump_journal_seal();
+#endif // UNIX_DUMP_JOURNAL
     dump_database_internal(DUMP_I_NORMAL);
+#if defined(UNIX_DUMP_JOURNAL)
+    dump_journal_finish(bOutputDumped);
+#endif // UNIX_DUMP_JOURNAL
     SYNC;
 
     STARTLOG(LOG_DBSAVES, "DMP", "DONE")
@@ -1704,6 +2773,27 @@ void fork_and_dump(int key)
     pcache_sync();
     SYNC;
 
+#if defined(UNIX_DUMP_JOURNAL)
+    if (key & DUMP_STRUCT)
+    {
+        if (  0 < mudconf.dump_incremental
+           && 0 <= mudstate.nIncrementalDumps
+           && mudstate.nIncrementalDumps < mudconf.dump_incremental
+           && dump_journal_checkpoint())
+        {
+            // Only the objects which changed were written, and there is
+            // nothing to fork.
+            //
+            mudstate.nIncrementalDumps++;
+            key &= ~DUMP_STRUCT;
+        }
+        else
+        {
+            dump_journal_seal();
+        }
+    }
+#endif // UNIX_DUMP_JOURNAL
+
 #if defined(HAVE_WORKING_FORK)
     mudstate.write_protect = true;
     int child = 0;
@@ -1741,6 +2831,9 @@ void fork_and_dump(int key)
             if (key & DUMP_STRUCT)
             {
                 dump_database_internal(DUMP_I_NORMAL);
+#if defined(UNIX_DUMP_JOURNAL)
+                dump_journal_finish(bOutputDumped);
+#endif // UNIX_DUMP_JOURNAL
             }
             if (key & DUMP_FLATFILE)
             {
@@ -1749,12 +2842,18 @@ void fork_and_dump(int key)
 #if defined(HAVE_WORKING_FORK)
             if (mudconf.fork_dump)
             {
-                _exit(0);
+                // The exit status tells the parent whether the output
+                // database was replaced.
+                //
+                _exit(((key & DUMP_STRUCT) && !bOutputDumped) ? 1 : 0);
             }
         }
         else if (child < 0)
         {
             log_perror(T("DMP"), T("FORK"), NULL, T("fork()"));
+#if defined(UNIX_DUMP_JOURNAL)
+            dump_journal_finish(false);
+#endif // UNIX_DUMP_JOURNAL
         }
         else
         {
@@ -1824,7 +2923,7 @@ static int load_game(int ccPageFile)
 #endif // MEMORY_BASED
 {
     FILE *f = NULL;
-    UTF8 infile[SIZEOF_PATHNAME+8];
+    UTF8 infile[SIZEOF_PATHNAME+16];
     struct stat statbuf;
     int db_format, db_version, db_flags;
 
@@ -1914,6 +3013,47 @@ static int load_game(int ccPageFile)
     }
     f = 0;
 
+    // Apply any incremental checkpoints taken since the input database was
+    // written.  A journal moved aside for a full checkpoint which did not
+    // finish comes before the current one.
+    //
+    for (int i = 0; i < 2; i++)
+    {
+        mux_sprintf(infile, sizeof(infile), (0 == i) ? T("%s.delta.dump") : T("%s.delta"),
+            mudconf.indb);
+        if (!mux_fopen(&f, infile, T("rb")))
+        {
+            continue;
+        }
+        DebugTotalFiles++;
+        setvbuf(f, NULL, _IOFBF, 16384);
+        STARTLOG(LOG_STARTUP, "INI", "LOAD")
+        log_text(T("Loading: "));
+        log_text(infile);
+        ENDLOG
+        int nSegments = db_read_journal(f);
+        if (fclose(f) == 0)
+        {
+            DebugTotalFiles--;
+        }
+        f = 0;
+
+        if (nSegments < 0)
+        {
+            STARTLOG(LOG_ALWAYS, "INI", "FATAL")
+            log_text(T("Error loading "));
+            log_text(infile);
+            ENDLOG
+            return LOAD_GAME_LOADING_PROBLEM;
+        }
+    }
+    load_player_names();
+
+    // Checkpoints start from what was just loaded.
+    //
+    mudstate.bfDirty.ClearAll();
+    mudstate.bDirtyAttrNames = false;
+
 #ifndef MEMORY_BASED
     if (db_flags & V_DATABASE)
     {
@@ -2236,6 +3376,7 @@ static const UTF8 *standalone_basename = NULL;
 static bool standalone_check = false;
 static bool standalone_load = false;
 static bool standalone_unload = false;
+static bool standalone_binary = false;
 
 static void dbconvert(void)
 {
@@ -2252,6 +3393,7 @@ static void dbconvert(void)
     pool_init(POOL_SBUF, SBUF_SIZE);
     pool_init(POOL_BOOL, sizeof(struct boolexp));
     pool_init(POOL_STRING, sizeof(mux_string));
+    pool_init(POOL_TASK, sizeof(TASK_RECORD));
 
     cf_init();
 
@@ -2340,6 +3482,28 @@ static void dbconvert(void)
         exit(1);
     }
 
+    // Fold in the checkpoint journals that go with the input file, if any.
+    //
+    for (int i = 0; i < 2; i++)
+    {
+        UTF8 szJournal[SIZEOF_PATHNAME+16];
+        mux_sprintf(szJournal, sizeof(szJournal), (0 == i) ? T("%s.delta.dump") : T("%s.delta"),
+            standalone_infile);
+        FILE *fpJournal;
+        if (mux_fopen(&fpJournal, szJournal, T("rb")))
+        {
+            int nSegments = db_read_journal(fpJournal);
+            fclose(fpJournal);
+            if (nSegments < 0)
+            {
+                cache_cleanup();
+                exit(1);
+            }
+            Log.tinyprintf(T("Applied %d journal segments from %s" ENDLINE), nSegments, szJournal);
+        }
+    }
+    load_player_names();
+
     if (do_redirect)
     {
         cache_pass2();
@@ -2378,7 +3542,14 @@ static void dbconvert(void)
         //
         al_store();
 #endif // MEMORY_BASED
-        db_write(fpOut, F_MUX, db_ver | db_flags);
+        if (standalone_binary)
+        {
+            db_write_binary(fpOut, db_ver | db_flags);
+        }
+        else
+        {
+            db_write(fpOut, F_MUX, db_ver | db_flags);
+        }
         fclose(fpOut);
     }
     CLOSE;
@@ -2487,6 +3658,7 @@ long DebugTotalMemory = 0;
 #define CLI_DO_BASENAME    CLI_USER+9
 #define CLI_DO_PID_FILE    CLI_USER+10
 #define CLI_DO_ERRORPATH   CLI_USER+11
+#define CLI_DO_BINARY      CLI_USER+12
 
 static bool bMinDB = false;
 static bool bSyntaxError = false;
@@ -2509,6 +3681,7 @@ static CLI_OptionEntry OptionTable[] =
     { "l", CLI_NONE,     CLI_DO_LOAD        },
     { "u", CLI_NONE,     CLI_DO_UNLOAD      },
     { "d", CLI_REQUIRED, CLI_DO_BASENAME    },
+    { "b", CLI_NONE,     CLI_DO_BINARY      },
 #endif // MEMORY_BASED
     { "p", CLI_REQUIRED, CLI_DO_PID_FILE    },
     { "e", CLI_REQUIRED, CLI_DO_ERRORPATH   }
@@ -2575,6 +3748,11 @@ static void CLI_CallBack(CLI_OptionEntry *p, const char *pValue)
             mudstate.bStandAlone = true;
             standalone_basename = (UTF8 *)pValue;
             break;
+
+        case CLI_DO_BINARY:
+            mudstate.bStandAlone = true;
+            standalone_binary = true;
+            break;
 #endif
 
         case CLI_DO_USAGE:
@@ -3239,7 +4417,8 @@ int DCL_CDECL main(int argc, char *argv[])
         mux_fprintf(stderr, T("Version: %s" ENDLINE), mudstate.version);
         if (mudstate.bStandAlone)
         {
-            mux_fprintf(stderr, T("Usage: %s -d <dbname> -i <infile> [-o <outfile>] [-l|-u|-k]" ENDLINE), pProg);
+            mux_fprintf(stderr, T("Usage: %s -d <dbname> -i <infile> [-o <outfile>] [-l|-u|-k] [-b]" ENDLINE), pProg);
+            mux_fprintf(stderr, T("  -b  Write a binary flatfile." ENDLINE));
             mux_fprintf(stderr, T("  -d  Basename." ENDLINE));
             mux_fprintf(stderr, T("  -i  Input file." ENDLINE));
             mux_fprintf(stderr, T("  -k  Check." ENDLINE));
@@ -3325,6 +4504,7 @@ int DCL_CDECL main(int argc, char *argv[])
     pool_init(POOL_LBUFREF, sizeof(lbuf_ref));
     pool_init(POOL_REGREF, sizeof(reg_ref));
     pool_init(POOL_STRING, sizeof(mux_string));
+    pool_init(POOL_TASK, sizeof(TASK_RECORD));
     tcache_init();
     pcache_init();
     cf_init();
@@ -3504,6 +4684,8 @@ int DCL_CDECL main(int argc, char *argv[])
     hashreset(&mudstate.fwdlist_htab);
     hashreset(&mudstate.desc_htab);
     hashreset(&mudstate.reference_htab);
+    hashreset(&mudstate.queue_htab);
+    hashreset(&mudstate.sem_htab);
 
     ValidateConfigurationDbrefs();
     process_preload();
@@ -3548,6 +4730,11 @@ int DCL_CDECL main(int argc, char *argv[])
 
     init_timer();
 
+    if (mudconf.log_async)
+    {
+        Log.StartWriter();
+    }
+
     shovechars(nMainGamePorts, aMainGamePorts);
 
 #ifdef INLINESQL
@@ -3562,6 +4749,7 @@ int DCL_CDECL main(int argc, char *argv[])
 #endif // INLINESQL
 
     close_sockets(false, T("Going down - Bye"));
+    drain_pass_jobs();
     dump_database();
 
     // All shutdown, barring logfiles, should be done, shutdown the
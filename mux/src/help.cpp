@@ -269,13 +269,14 @@ static void ReportMatchedTopics(dbref executor, const UTF8 *topic, CHashTable *h
     UTF8 *topic_list = NULL;
     UTF8 *buffp = NULL;
     struct help_entry *htab_entry;
+    CWildcard wc;
+    wc.Compile(topic);
     for (htab_entry = (struct help_entry *)hash_firstentry(htab);
          htab_entry != NULL;
          htab_entry = (struct help_entry *)hash_nextentry(htab))
     {
-        mudstate.wild_invk_ctr = 0;
         if (  htab_entry->key
-           && quick_wild(topic, htab_entry->key))
+           && wc.Match(htab_entry->key))
         {
             if (!matched)
             {
@@ -23,6 +23,8 @@ struct name_table
 
 /* BQUE - Command queue */
 
+struct task_record;
+
 typedef struct bque BQUE;
 struct bque
 {
@@ -50,6 +52,15 @@ struct bque
     int     iRow;                   // Current Row
 #endif // STUB_SLAVE
     bool    IsTimed;                // Is there a waittime time on this entry?
+    dbref   owner;                  // Owner charged for the entry.
+    int     iQueue;                 // Wait, semaphore, or SQL queue.
+    struct task_record *pTask;      // Task which will run this entry.
+    BQUE    *pSemNext;              // Next waiter on the same semaphore.
+    BQUE    *pSemPrev;              // Previous waiter on the same semaphore.
+    BQUE    *pExecNext;             // Next entry for the same executor.
+    BQUE    *pExecPrev;             // Previous entry for the same executor.
+    BQUE    *pOwnerNext;            // Next entry for the same owner.
+    BQUE    *pOwnerPrev;            // Previous entry for the same owner.
 };
 
 class CBitField
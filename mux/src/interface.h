@@ -59,6 +59,17 @@ typedef struct cmd_block
 } CBLK;
 
 #define TBLK_FLAG_LOCKED    0x01
+#define TBLK_FLAG_SHARED    0x02    // Header only.  Text is in pShared.
+
+// Text rendered once and queued to several descriptors.  Each output block
+// which refers to it holds a reference.
+//
+typedef struct shared_text
+{
+    int     nRefs;
+    size_t  nBytes;
+    char    aText[1];
+} SHARED_TEXT;
 
 typedef struct text_block TBLOCK;
 typedef struct text_block_hdr
@@ -68,6 +79,7 @@ typedef struct text_block_hdr
     UTF8    *end;
     size_t   nchars;
     int      flags;
+    SHARED_TEXT *pShared;
 }   TBLOCKHDR;
 
 typedef struct text_block
@@ -199,6 +211,7 @@ struct descriptor_data
   int nvt_him_state[256];
   int nvt_us_state[256];
   UTF8 *ttype;
+  UTF8 *auth_user;        // Name given by a pending connect.
   int encoding;
   int negotiated_encoding;
   int width;
@@ -213,11 +226,16 @@ struct descriptor_data
 
   UTF8 addr[51];
   UTF8 username[11];
+  bool bHostnamePending;  // Waiting on the slave for a hostname.
   UTF8 doing[SIZEOF_DOING_STRING];
 
 #ifdef UNIX_SSL
   SSL *ssl_session;
 #endif
+
+#if defined(UNIX_NETWORKING_EPOLL)
+  unsigned int epoll_events;  // Events currently registered with epoll.
+#endif // UNIX_NETWORKING_EPOLL
 };
 
 int HimState(DESC *d, unsigned char chOption);
@@ -231,6 +249,9 @@ void DisableUs(DESC *d, unsigned char chOption);
 #define DS_CONNECTED    0x0001      // player is connected.
 #define DS_AUTODARK     0x0002      // Wizard was auto set dark.
 #define DS_PUEBLOCLIENT 0x0004      // Client is Pueblo-enhanced.
+#define DS_AUTHPENDING  0x0008      // Waiting for a password check.
+#define DS_AUTHDARK     0x0010      // Pending connect asked to be dark.
+#define DS_AUTHGUEST    0x0020      // Pending connect is to a guest.
 
 extern DESC *descriptor_list;
 extern unsigned int ndescriptors;
@@ -297,6 +318,11 @@ extern void queue_write(DESC *, const char *);
 extern void queue_string(DESC *, const UTF8 *);
 extern void queue_string(DESC *d, const mux_string &s);
 extern void freeqs(DESC *);
+extern TBLOCK *tblock_alloc(void);
+extern void tblock_free(TBLOCK *tb);
+extern void broadcast_begin(void);
+extern void broadcast_message(const mux_string &sMsg);
+extern void broadcast_end(void);
 extern void welcome_user(DESC *);
 extern void save_command(DESC *, CBLK *);
 extern void announce_disconnect(dbref, DESC *, const UTF8 *);
@@ -317,7 +343,7 @@ extern void handle_prog(DESC *d, UTF8 *message);
 // From player.cpp
 //
 void record_login(dbref, bool, UTF8 *, UTF8 *, UTF8 *, UTF8 *);
-extern dbref connect_player(UTF8 *, UTF8 *, UTF8 *, UTF8 *, UTF8 *);
+extern dbref connect_player(dbref, bool, UTF8 *, UTF8 *, UTF8 *);
 
 
 #define DESC_ITER_PLAYER(p,d) \
@@ -370,6 +396,43 @@ extern NAMETAB sigactions_nametab[];
 extern int maxd;
 #endif // UNIX_NETWORKING_SELECT
 
+#if defined(UNIX_NETWORKING_EPOLL)
+void UpdateDescriptorInterest(DESC *d);
+#define DESC_INTEREST_CHANGED(d) UpdateDescriptorInterest(d)
+#else // UNIX_NETWORKING_EPOLL
+#define DESC_INTEREST_CHANGED(d)
+#endif // UNIX_NETWORKING_EPOLL
+
+// Main loop statistics reported by @list process.
+//
+typedef struct
+{
+    const UTF8 *pBackend;             // Readiness backend in use.
+    CLinearTimeAbsolute ltaIntervalStart;
+    UINT64 nIterations;               // Iterations in the current interval.
+    UINT64 nReady;                    // Ready sockets in the current interval.
+    double dIterationsPerSecond;      // From the last completed interval.
+    double dAverageReady;             // From the last completed interval.
+} NETLOOP_STATS;
+
+extern NETLOOP_STATS NetLoopStats;
+
+// Output flush statistics reported by @list process.  A flush is one call
+// to process_output() with something queued.
+//
+typedef struct
+{
+    UINT64 nFlushes;
+    UINT64 nBytes;                    // Bytes accepted by the network.
+    UINT64 nCalls;                    // Write system calls.
+    UINT64 nBlocks;                   // Output blocks completely sent.
+    int    nFreeBlocks;               // Output blocks kept for reuse.
+    UINT64 nBroadcastRenders;         // Broadcast messages rendered.
+    UINT64 nBroadcastShared;          // Deliveries which reused a rendering.
+} OUTPUT_STATS;
+
+extern OUTPUT_STATS OutputStats;
+
 extern long DebugTotalSockets;
 
 #if defined(WINDOWS_NETWORKING)
@@ -10,6 +10,10 @@
 #include "config.h"
 #include "externs.h"
 
+#if defined(UNIX_THREADS)
+#include <signal.h>
+#endif // UNIX_THREADS
+
 #include "command.h"
 #include "mathutil.h"
 
@@ -107,7 +111,6 @@ bool start_log(const UTF8 * primary, const UTF8 * secondary)
 void end_log(void)
 {
     Log.WriteString((UTF8 *) ENDLINE);
-    Log.Flush();
     mudstate.logging--;
 }
 
@@ -134,7 +137,6 @@ void log_perror(const UTF8 * primary, const UTF8 * secondary,
 #ifndef WIN32
     Log.WriteString((UTF8 *) ENDLINE);
 #endif // !WIN32
-    Log.Flush();
     mudstate.logging--;
 }
 
@@ -364,6 +366,14 @@ void do_log
     return;
 }
 
+#if defined(UNIX_THREADS)
+// The writer thread flushes the log ring after at least this many bytes are
+// queued, or after this many milliseconds, whichever comes first.
+//
+#define LOG_RING_FLUSH_SIZE (8*1024)
+#define LOG_RING_FLUSH_MSEC 200
+#endif // UNIX_THREADS
+
 CLogFile Log;
 void CLogFile::WriteInteger(int iNumber)
 {
@@ -379,6 +389,66 @@ void CLogFile::WriteBuffer(size_t nString, const UTF8 * pString)
         return;
     }
 
+#if defined(UNIX_THREADS)
+    if (m_bAsync)
+    {
+        if (0 < m_nGameLocks)
+        {
+            // A signal handler interrupted the game thread while it held
+            // m_mtxRing or m_mtxFile.  Neither lock is recursive, so write
+            // the text straight to the file instead of queuing it.
+            //
+            if (!WriteToFile(pString, nString))
+            {
+                m_bWriteFailed = true;
+            }
+            return;
+        }
+
+        ServiceWriter();
+
+        // Queue the text for the writer thread.  The game only waits here
+        // if the writer has fallen an entire ring behind.
+        //
+        m_nGameLocks++;
+        pthread_mutex_lock(&m_mtxRing);
+        while (nString > 0)
+        {
+            size_t nAvailable = SIZEOF_LOG_RING - m_nRing;
+            if (nAvailable == 0)
+            {
+                pthread_cond_signal(&m_cvWork);
+                pthread_cond_wait(&m_cvSpace, &m_mtxRing);
+                continue;
+            }
+
+            size_t iTail = (m_iRingHead + m_nRing) % SIZEOF_LOG_RING;
+            size_t nToMove = SIZEOF_LOG_RING - iTail;
+            if (nAvailable < nToMove)
+            {
+                nToMove = nAvailable;
+            }
+            if (nString < nToMove)
+            {
+                nToMove = nString;
+            }
+
+            memcpy(m_aRing + iTail, pString, nToMove);
+            pString += nToMove;
+            nString -= nToMove;
+            m_nRing += nToMove;
+        }
+
+        if (LOG_RING_FLUSH_SIZE <= m_nRing)
+        {
+            pthread_cond_signal(&m_cvWork);
+        }
+        pthread_mutex_unlock(&m_mtxRing);
+        m_nGameLocks--;
+        return;
+    }
+#endif // UNIX_THREADS
+
 #if defined(WINDOWS_THREADS)
     EnterCriticalSection(&csLog);
 #endif // WINDOWS_THREADS
@@ -508,6 +578,17 @@ void CLogFile::AppendLogFile(void)
     }
 }
 
+void CLogFile::RotateLogFile(void)
+{
+    CloseLogFile();
+
+    m_ltaStarted.GetLocal();
+    MakeLogName(m_pBasename, m_szPrefix, m_ltaStarted, m_szFilename,
+        sizeof(m_szFilename));
+
+    CreateLogFile();
+}
+
 void CLogFile::CloseLogFile(void)
 {
 #if defined(WINDOWS_FILES)
@@ -527,8 +608,47 @@ void CLogFile::CloseLogFile(void)
 
 #define FILE_SIZE_TRIGGER (512*1024UL)
 
+bool CLogFile::WriteToFile(const UTF8 *pBuffer, size_t nBuffer)
+{
+    m_nSize += nBuffer;
+#if defined(WINDOWS_FILES)
+    unsigned long nWritten;
+    bool fSuccess = true;
+    if (!WriteFile(m_hFile, pBuffer, (DWORD) nBuffer, &nWritten, NULL))
+    {
+        fSuccess = false;
+    }
+#elif defined(UNIX_FILES)
+    ssize_t written = mux_write(m_fdFile, pBuffer, nBuffer);
+    bool fSuccess = (0 < written && nBuffer == (size_t) written);
+#endif // UNIX_FILES
+    return fSuccess;
+}
+
 void CLogFile::Flush(void)
 {
+#if defined(UNIX_THREADS)
+    if (m_bAsync)
+    {
+        if (0 < m_nGameLocks)
+        {
+            // Called from a signal handler which interrupted the logger.
+            // The ring may be half-updated, and the writer drains it anyway.
+            //
+            return;
+        }
+
+        // Write everything queued so far on this thread, without waiting
+        // for the writer.  This is what panics and shutdowns depend on.
+        //
+        m_nGameLocks++;
+        FlushRing();
+        m_nGameLocks--;
+        ServiceWriter();
+        return;
+    }
+#endif // UNIX_THREADS
+
     if (  m_nBuffer <= 0
        || !bEnabled)
     {
@@ -543,20 +663,7 @@ void CLogFile::Flush(void)
     }
     else
     {
-        m_nSize += m_nBuffer;
-#if defined(WINDOWS_FILES)
-        unsigned long nWritten;
-        bool fSuccess = true;
-        if (!WriteFile(m_hFile, m_aBuffer, (DWORD) m_nBuffer, &nWritten, NULL))
-        {
-            fSuccess = false;
-        }
-#elif defined(UNIX_FILES)
-        ssize_t written = mux_write(m_fdFile, m_aBuffer, m_nBuffer);
-        bool fSuccess = (0 < written && m_nBuffer == (size_t) written);
-#endif // UNIX_FILES
-
-        if (!fSuccess)
+        if (!WriteToFile(m_aBuffer, m_nBuffer))
         {
             raw_broadcast(WIZARD,
                 T("GAME: Unable to write to the log.  The disk may be full."));
@@ -564,16 +671,239 @@ void CLogFile::Flush(void)
 
         if (m_nSize > FILE_SIZE_TRIGGER)
         {
-            CloseLogFile();
+            RotateLogFile();
+        }
+    }
+    m_nBuffer = 0;
+}
+
+#if defined(UNIX_THREADS)
+
+/*! \brief Write all queued log text to the file.
+ *
+ * Called by the writer thread and, for synchronous flushes, by the game
+ * thread.  Text queued while the file is being written is picked up by
+ * the same call.
+ *
+ * \return         None.
+ */
 
-            m_ltaStarted.GetLocal();
-            MakeLogName(m_pBasename, m_szPrefix, m_ltaStarted, m_szFilename,
-                sizeof(m_szFilename));
+void CLogFile::FlushRing(void)
+{
+    pthread_mutex_lock(&m_mtxFile);
+    pthread_mutex_lock(&m_mtxRing);
+    while (0 < m_nRing)
+    {
+        size_t iHead = m_iRingHead;
+        size_t nChunk = SIZEOF_LOG_RING - iHead;
+        if (m_nRing < nChunk)
+        {
+            nChunk = m_nRing;
+        }
+        pthread_mutex_unlock(&m_mtxRing);
 
-            CreateLogFile();
+        if (!WriteToFile(m_aRing + iHead, nChunk))
+        {
+            m_bWriteFailed = true;
         }
+
+        pthread_mutex_lock(&m_mtxRing);
+        m_iRingHead = (iHead + nChunk) % SIZEOF_LOG_RING;
+        m_nRing -= nChunk;
+        pthread_cond_broadcast(&m_cvSpace);
+    }
+    pthread_mutex_unlock(&m_mtxRing);
+
+    if (FILE_SIZE_TRIGGER < m_nSize)
+    {
+        // Choosing the new name depends on the local timezone code, which
+        // is only safe to call from the game thread.
+        //
+        m_bRotate = true;
     }
+    pthread_mutex_unlock(&m_mtxFile);
+}
+
+// Handle things the writer thread has noticed but cannot do itself.  This is
+// only called from the game thread.
+//
+void CLogFile::ServiceWriter(void)
+{
+    if (m_bWriteFailed)
+    {
+        m_bWriteFailed = false;
+        raw_broadcast(WIZARD,
+            T("GAME: Unable to write to the log.  The disk may be full."));
+    }
+
+    if (m_bRotate)
+    {
+        m_nGameLocks++;
+        pthread_mutex_lock(&m_mtxFile);
+        m_bRotate = false;
+        RotateLogFile();
+        pthread_mutex_unlock(&m_mtxFile);
+        m_nGameLocks--;
+    }
+}
+
+void CLogFile::WriterLoop(void)
+{
+    pthread_mutex_lock(&m_mtxRing);
+    while (!m_bStopWriter)
+    {
+        if (m_nRing < LOG_RING_FLUSH_SIZE)
+        {
+            struct timeval tv;
+            gettimeofday(&tv, NULL);
+            struct timespec ts;
+            ts.tv_sec  = tv.tv_sec + LOG_RING_FLUSH_MSEC / 1000;
+            ts.tv_nsec = (tv.tv_usec + (LOG_RING_FLUSH_MSEC % 1000) * 1000) * 1000;
+            if (1000000000 <= ts.tv_nsec)
+            {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&m_cvWork, &m_mtxRing, &ts);
+        }
+
+        if (0 < m_nRing)
+        {
+            pthread_mutex_unlock(&m_mtxRing);
+            FlushRing();
+            pthread_mutex_lock(&m_mtxRing);
+        }
+    }
+    pthread_mutex_unlock(&m_mtxRing);
+}
+
+void *CLogFile::WriterThreadProc(void *pVoid)
+{
+    CLogFile *pLog = static_cast<CLogFile *>(pVoid);
+    pLog->WriterLoop();
+    return NULL;
+}
+
+static void LogForkPrepare(void)
+{
+    Log.ForkPrepare();
+}
+
+static void LogForkParent(void)
+{
+    Log.ForkParent();
+}
+
+static void LogForkChild(void)
+{
+    Log.ForkChild();
+}
+
+// Keep the writer from holding m_mtxRing across fork().  m_mtxFile is not
+// taken here because the writer holds it while it writes to the disk, and
+// fork() should not wait on that.
+//
+void CLogFile::ForkPrepare(void)
+{
+    m_nGameLocks++;
+    pthread_mutex_lock(&m_mtxRing);
+}
+
+void CLogFile::ForkParent(void)
+{
+    pthread_mutex_unlock(&m_mtxRing);
+    m_nGameLocks--;
+}
+
+// The child has no writer thread.  Anything already queued belongs to the
+// parent, and the child logs synchronously from here on.  The child's copy
+// of m_mtxFile may have been held by the writer, so it is started over.
+//
+void CLogFile::ForkChild(void)
+{
+    m_nRing = 0;
+    m_bAsync = false;
     m_nBuffer = 0;
+    m_nGameLocks = 0;
+    pthread_mutex_unlock(&m_mtxRing);
+    pthread_mutex_init(&m_mtxFile, NULL);
+}
+
+#endif // UNIX_THREADS
+
+/*! \brief Move log writes to a background thread.
+ *
+ * Afterwards, WriteBuffer() only queues text, and Flush() still writes
+ * everything queued before returning.  Logging to stderr is not affected.
+ *
+ * \return         None.
+ */
+
+void CLogFile::StartWriter(void)
+{
+#if defined(UNIX_THREADS)
+    if (  m_bAsync
+       || !bEnabled
+       || bUseStderr)
+    {
+        return;
+    }
+
+    static bool bAtFork = false;
+    if (!bAtFork)
+    {
+        pthread_atfork(LogForkPrepare, LogForkParent, LogForkChild);
+        bAtFork = true;
+    }
+
+    Flush();
+    m_iRingHead = 0;
+    m_nRing = 0;
+    m_bStopWriter = false;
+    m_bWriteFailed = false;
+    m_bRotate = false;
+
+    // Signals are handled by the game thread only.
+    //
+    sigset_t sigAll, sigSaved;
+    sigfillset(&sigAll);
+    pthread_sigmask(SIG_SETMASK, &sigAll, &sigSaved);
+    int cc = pthread_create(&m_thWriter, NULL, WriterThreadProc, this);
+    pthread_sigmask(SIG_SETMASK, &sigSaved, NULL);
+    if (0 == cc)
+    {
+        m_bAsync = true;
+    }
+#endif // UNIX_THREADS
+}
+
+/*! \brief Write everything queued and return to synchronous logging.
+ *
+ * \return         None.
+ */
+
+void CLogFile::StopWriter(void)
+{
+#if defined(UNIX_THREADS)
+    if (!m_bAsync)
+    {
+        return;
+    }
+
+    m_nGameLocks++;
+    pthread_mutex_lock(&m_mtxRing);
+    m_bStopWriter = true;
+    pthread_cond_signal(&m_cvWork);
+    pthread_mutex_unlock(&m_mtxRing);
+    m_nGameLocks--;
+    pthread_join(m_thWriter, NULL);
+
+    m_nGameLocks++;
+    FlushRing();
+    m_nGameLocks--;
+    m_bAsync = false;
+    ServiceWriter();
+#endif // UNIX_THREADS
 }
 
 void CLogFile::SetPrefix(const UTF8 * szPrefix)
@@ -581,6 +911,14 @@ void CLogFile::SetPrefix(const UTF8 * szPrefix)
     if (  !bUseStderr
        && strcmp((char *) szPrefix, (char *) m_szPrefix) != 0)
     {
+#if defined(UNIX_THREADS)
+        if (m_bAsync)
+        {
+            Flush();
+            m_nGameLocks++;
+            pthread_mutex_lock(&m_mtxFile);
+        }
+#endif // UNIX_THREADS
         if (bEnabled)
         {
             CloseLogFile();
@@ -600,6 +938,13 @@ void CLogFile::SetPrefix(const UTF8 * szPrefix)
         {
             AppendLogFile();
         }
+#if defined(UNIX_THREADS)
+        if (m_bAsync)
+        {
+            pthread_mutex_unlock(&m_mtxFile);
+            m_nGameLocks--;
+        }
+#endif // UNIX_THREADS
     }
 }
 
@@ -635,6 +980,19 @@ CLogFile::CLogFile(void)
 #if defined(WINDOWS_THREADS)
     InitializeCriticalSection(&csLog);
 #endif // WINDOWS_THREADS
+#if defined(UNIX_THREADS)
+    pthread_mutex_init(&m_mtxRing, NULL);
+    pthread_mutex_init(&m_mtxFile, NULL);
+    pthread_cond_init(&m_cvWork, NULL);
+    pthread_cond_init(&m_cvSpace, NULL);
+    m_bAsync = false;
+    m_bStopWriter = false;
+    m_bWriteFailed = false;
+    m_bRotate = false;
+    m_nGameLocks = 0;
+    m_iRingHead = 0;
+    m_nRing = 0;
+#endif // UNIX_THREADS
 
     m_ltaStarted.GetLocal();
 #if defined(WINDOWS_FILES)
@@ -665,6 +1023,7 @@ void CLogFile::StartLogging()
 
 void CLogFile::StopLogging(void)
 {
+    StopWriter();
     Flush();
     bEnabled = false;
     if (!bUseStderr)
@@ -339,36 +339,374 @@ void match_here(void)
     }
 }
 
-static void match_list(dbref first, int local)
+/* ---------------------------------------------------------------------------
+ * Name index.
+ *
+ * match_list() compares the name of everything in a location with what was
+ * typed.  A location holding at least match_index_min objects gets an index
+ * of its contents keyed by a hash of each whole name and of the first few
+ * characters of each word in it, so only objects which could match are
+ * compared.  The index is thrown away whenever the location's contents list
+ * changes or one of its contents is renamed.
+ */
+
+#define NAME_INDEX_PREFIX 3
+
+typedef struct
+{
+    UINT32 uKey;
+    int    iObject;         // Position in the contents list.
+} NAME_INDEX_KEY;
+
+typedef struct
+{
+    int             nRefs;
+    bool            bCached;
+    int             nObjects;
+    dbref          *aObjects;
+    int             nKeys;
+    NAME_INDEX_KEY *aKeys;  // Sorted by uKey, then iObject.
+} NAME_INDEX;
+
+// Fold case and runs of spaces the way string_compare() does.  The result is
+// hashed with its terminating null so that it cannot be mistaken for a
+// prefix.
+//
+static UINT32 name_index_whole(const UTF8 *p)
+{
+    UTF8   aName[LBUF_SIZE];
+    size_t n = 0;
+    while (mux_isspace(*p))
+    {
+        p++;
+    }
+    while (  '\0' != *p
+          && n < LBUF_SIZE-2)
+    {
+        if (mux_isspace(*p))
+        {
+            while (mux_isspace(*p))
+            {
+                p++;
+            }
+            if ('\0' != *p)
+            {
+                aName[n++] = ' ';
+            }
+        }
+        else
+        {
+            aName[n++] = mux_tolower_ascii(*p);
+            p++;
+        }
+    }
+    aName[n++] = '\0';
+    return HASH_ProcessBuffer(0, aName, n);
+}
+
+// Hash up to NAME_INDEX_PREFIX characters the way string_prefix() compares
+// them.
+//
+static UINT32 name_index_prefix(const UTF8 *p, size_t n)
+{
+    UTF8 aPrefix[NAME_INDEX_PREFIX];
+    for (size_t i = 0; i < n; i++)
+    {
+        aPrefix[i] = mux_tolower_ascii(p[i]);
+    }
+    return HASH_ProcessBuffer(0, aPrefix, n);
+}
+
+static int name_index_compare(const void *a, const void *b)
+{
+    const NAME_INDEX_KEY *pa = (const NAME_INDEX_KEY *)a;
+    const NAME_INDEX_KEY *pb = (const NAME_INDEX_KEY *)b;
+    if (pa->uKey != pb->uKey)
+    {
+        return (pa->uKey < pb->uKey) ? -1 : 1;
+    }
+    return pa->iObject - pb->iObject;
+}
+
+static void name_index_free(NAME_INDEX *pni)
+{
+    if (pni->aObjects)
+    {
+        MEMFREE(pni->aObjects);
+    }
+    if (pni->aKeys)
+    {
+        MEMFREE(pni->aKeys);
+    }
+    MEMFREE(pni);
+}
+
+void name_index_invalidate(dbref loc)
+{
+    if (  0 == mudstate.name_index_htab.GetEntryCount()
+       || loc < 0
+       || mudstate.db_top <= loc)
+    {
+        return;
+    }
+
+    NAME_INDEX *pni = (NAME_INDEX *)hashfindLEN(&loc, sizeof(loc),
+        &mudstate.name_index_htab);
+    if (pni)
+    {
+        hashdeleteLEN(&loc, sizeof(loc), &mudstate.name_index_htab);
+        pni->bCached = false;
+        if (0 == pni->nRefs)
+        {
+            name_index_free(pni);
+        }
+    }
+}
+
+static void name_index_add(NAME_INDEX *pni, int *pnAlloc, UINT32 uKey, int iObject)
+{
+    if (pni->nKeys == *pnAlloc)
+    {
+        *pnAlloc = (0 == *pnAlloc) ? 64 : 2 * *pnAlloc;
+        NAME_INDEX_KEY *aNew = (NAME_INDEX_KEY *)MEMALLOC(*pnAlloc * sizeof(NAME_INDEX_KEY));
+        ISOUTOFMEMORY(aNew);
+        if (pni->aKeys)
+        {
+            memcpy(aNew, pni->aKeys, pni->nKeys * sizeof(NAME_INDEX_KEY));
+            MEMFREE(pni->aKeys);
+        }
+        pni->aKeys = aNew;
+    }
+    pni->aKeys[pni->nKeys].uKey    = uKey;
+    pni->aKeys[pni->nKeys].iObject = iObject;
+    pni->nKeys++;
+}
+
+// Returns NULL if the location is too small to be worth indexing.
+//
+static NAME_INDEX *name_index_fetch(dbref loc)
+{
+    if (mudconf.match_index_min <= 0)
+    {
+        return NULL;
+    }
+
+    NAME_INDEX *pni = (NAME_INDEX *)hashfindLEN(&loc, sizeof(loc),
+        &mudstate.name_index_htab);
+    if (NULL == pni)
+    {
+        dbref obj;
+        int n = 0;
+        DOLIST(obj, Contents(loc))
+        {
+            n++;
+        }
+        if (n < mudconf.match_index_min)
+        {
+            return NULL;
+        }
+
+        pni = (NAME_INDEX *)MEMALLOC(sizeof(NAME_INDEX));
+        ISOUTOFMEMORY(pni);
+        pni->nRefs    = 0;
+        pni->bCached  = true;
+        pni->nObjects = 0;
+        pni->aObjects = (dbref *)MEMALLOC(n * sizeof(dbref));
+        ISOUTOFMEMORY(pni->aObjects);
+        pni->nKeys    = 0;
+        pni->aKeys    = NULL;
+
+        // Every place string_match() tries is keyed: the start of the name
+        // and each alphanumeric character which follows a non-alphanumeric
+        // one.
+        //
+        int nAlloc = 0;
+        DOLIST(obj, Contents(loc))
+        {
+            if (n <= pni->nObjects)
+            {
+                break;
+            }
+            int iObject = pni->nObjects++;
+            pni->aObjects[iObject] = obj;
+
+            const UTF8 *pName = PureName(obj);
+            name_index_add(pni, &nAlloc, name_index_whole(pName), iObject);
+            for (size_t i = 0; '\0' != pName[i]; i++)
+            {
+                if (  0 == i
+                   || (  mux_isalnum(pName[i])
+                      && !mux_isalnum(pName[i-1])))
+                {
+                    for (size_t j = 1; j <= NAME_INDEX_PREFIX && '\0' != pName[i+j-1]; j++)
+                    {
+                        name_index_add(pni, &nAlloc, name_index_prefix(pName + i, j), iObject);
+                    }
+                }
+            }
+        }
+
+        if (0 < pni->nKeys)
+        {
+            qsort(pni->aKeys, pni->nKeys, sizeof(NAME_INDEX_KEY), name_index_compare);
+            int nKeys = 1;
+            for (int i = 1; i < pni->nKeys; i++)
+            {
+                if (  pni->aKeys[i].uKey != pni->aKeys[nKeys-1].uKey
+                   || pni->aKeys[i].iObject != pni->aKeys[nKeys-1].iObject)
+                {
+                    pni->aKeys[nKeys++] = pni->aKeys[i];
+                }
+            }
+            pni->nKeys = nKeys;
+        }
+        hashaddLEN(&loc, sizeof(loc), pni, &mudstate.name_index_htab);
+    }
+    pni->nRefs++;
+    return pni;
+}
+
+static void name_index_release(NAME_INDEX *pni)
+{
+    pni->nRefs--;
+    if (  0 == pni->nRefs
+       && !pni->bCached)
+    {
+        name_index_free(pni);
+    }
+}
+
+// Returns the first key equal to uKey, or nKeys.
+//
+static int name_index_find(NAME_INDEX *pni, UINT32 uKey)
+{
+    int lo = 0;
+    int hi = pni->nKeys;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (pni->aKeys[mid].uKey < uKey)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void match_name(dbref thing, int local)
+{
+    /*
+     * Warning: make sure there are no other calls to Name() in
+     * promote_match or its called subroutines; they
+     * would overwrite Name()'s static buffer which is
+     * needed by string_match().
+     */
+    const UTF8 *namebuf = PureName(thing);
+
+    if (!string_compare(namebuf, md.string))
+    {
+        promote_match(thing, CON_COMPLETE | local);
+    }
+    else if (string_match(namebuf, md.string))
+    {
+        promote_match(thing, local);
+    }
+}
+
+static void match_list(dbref loc, int local)
 {
     if (md.confidence >= CON_DBREF)
     {
         return;
     }
-    DOLIST(first, first)
+
+    NAME_INDEX *pni = NULL;
+    if ('\0' != md.string[0])
+    {
+        pni = name_index_fetch(loc);
+    }
+
+    dbref first;
+    if (NULL == pni)
     {
-        if (first == md.absolute_form)
+        DOLIST(first, Contents(loc))
         {
-            promote_match(first, CON_DBREF | local);
-            return;
+            if (first == md.absolute_form)
+            {
+                promote_match(first, CON_DBREF | local);
+                return;
+            }
+            match_name(first, local);
         }
-        /*
-         * Warning: make sure there are no other calls to Name() in
-         * promote_match or its called subroutines; they
-         * would overwrite Name()'s static buffer which is
-         * needed by string_match().
-         */
-        const UTF8 *namebuf = PureName(first);
+        return;
+    }
 
-        if (!string_compare(namebuf, md.string))
+    // The whole name and the prefix each give a run of candidates in
+    // contents order.  Walking both together visits every object which
+    // could match once, in the same order as walking the contents list.
+    //
+    int iAbsolute = pni->nObjects;
+    if (  Good_obj(md.absolute_form)
+       && Location(md.absolute_form) == loc)
+    {
+        for (int i = 0; i < pni->nObjects; i++)
         {
-            promote_match(first, CON_COMPLETE | local);
+            if (pni->aObjects[i] == md.absolute_form)
+            {
+                iAbsolute = i;
+                break;
+            }
+        }
+    }
+
+    size_t nString = strlen((char *)md.string);
+    UINT32 uWhole  = name_index_whole(md.string);
+    UINT32 uPrefix = name_index_prefix(md.string,
+        (nString < NAME_INDEX_PREFIX) ? nString : NAME_INDEX_PREFIX);
+    int iWhole  = name_index_find(pni, uWhole);
+    int iPrefix = name_index_find(pni, uPrefix);
+    for (;;)
+    {
+        int iObject = iAbsolute;
+        if (  iWhole < pni->nKeys
+           && pni->aKeys[iWhole].uKey == uWhole
+           && pni->aKeys[iWhole].iObject < iObject)
+        {
+            iObject = pni->aKeys[iWhole].iObject;
+        }
+        if (  iPrefix < pni->nKeys
+           && pni->aKeys[iPrefix].uKey == uPrefix
+           && pni->aKeys[iPrefix].iObject < iObject)
+        {
+            iObject = pni->aKeys[iPrefix].iObject;
         }
-        else if (string_match(namebuf, md.string))
+        if (iAbsolute <= iObject)
         {
-            promote_match(first, local);
+            break;
         }
+
+        if (  iWhole < pni->nKeys
+           && pni->aKeys[iWhole].iObject == iObject)
+        {
+            iWhole++;
+        }
+        if (  iPrefix < pni->nKeys
+           && pni->aKeys[iPrefix].iObject == iObject)
+        {
+            iPrefix++;
+        }
+        match_name(pni->aObjects[iObject], local);
+    }
+
+    if (iAbsolute < pni->nObjects)
+    {
+        promote_match(md.absolute_form, CON_DBREF | local);
     }
+    name_index_release(pni);
 }
 
 void match_possession(void)
@@ -379,7 +717,7 @@ void match_possession(void)
     }
     if (Good_obj(md.player) && Has_contents(md.player))
     {
-        match_list(Contents(md.player), CON_LOCAL);
+        match_list(md.player, CON_LOCAL);
     }
 }
 
@@ -395,7 +733,7 @@ void match_neighbor(void)
         dbref loc = Location(md.player);
         if (Good_obj(loc))
         {
-            match_list(Contents(loc), CON_LOCAL);
+            match_list(loc, CON_LOCAL);
         }
     }
 }
@@ -165,6 +165,7 @@ const UTF8 *CGuests::Create(DESC *d)
 
             // Copy flags from guest prototype.
             //
+            s_Dirty(guest_player);
             db[guest_player].fs = db[mudconf.guest_char].fs;
 
             // Strip flags, enforce PLAYER type.
@@ -333,6 +334,7 @@ dbref CGuests::MakeGuestChar(void)
     //
     FLAGSET f = db[mudconf.guest_char].fs;
     f.word[FLAG_WORD1] |= TYPE_PLAYER;
+    s_Dirty(player);
     db[player].fs = f;
 
     // Strip flags.
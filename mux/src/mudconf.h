@@ -36,6 +36,8 @@ typedef struct confdata CONFDATA;
 struct confdata
 {
     bool    autozone;           // New objects are automatically zoned.
+    bool    binary_database;    // Write checkpoints as binary flatfiles.
+    bool    cache_mmap;         // Read attribute pages in place from a mapped page file.
     bool    cache_names;        /* Should object names be cached separately */
     bool    clone_copy_cost;    /* Does @clone copy value? */
     bool    compress_db;        // should we use compress.
@@ -46,6 +48,7 @@ struct confdata
     bool    exam_public;        /* Does EXAM show public attrs by default? */
     bool    fascist_tport;      /* Src of teleport must be owned/JUMP_OK */
     bool    fork_dump;          // perform dump in a forked process.
+    bool    log_async;          // Write log files from a background thread.
     bool    have_comsys;        // Should the comsystem be active?
     bool    have_mailer;        // Should @mail be active?
     bool    have_zones;         // Should zones be active?
@@ -61,6 +64,7 @@ struct confdata
     bool    pub_flags;          /* true = flags() works on anything */
     bool    quiet_look;         /* true = don't see attribs when looking */
     bool    quiet_whisper;      /* Can others tell when you whisper? */
+    bool    queue_fair_share;   // Share object queue CPU time evenly among owners.
     bool    quotas;             /* true = have building quotas */
     bool    read_rem_desc;      /* Can the DESCs of nonlocal objs be read? */
     bool    read_rem_name;      /* Can the NAMEs of nonlocal objs be read? */
@@ -106,6 +110,7 @@ struct confdata
     int     createmax;          /* max cost of @create command */
     int     createmin;          /* default (and minimum) cost of @create cmd */
     int     digcost;            /* cost of @dig command */
+    int     dump_incremental;   // incremental checkpoints between full ones.
     int     dump_interval;      /* interval between ckp dumps in seconds */
     int     dump_offset;        /* when to take first checkpoint dump */
     int     events_daily_hour;  /* At what hour should @daily be executed? */
@@ -125,6 +130,7 @@ struct confdata
     int     machinecost;        /* One in mc+1 cmds costs 1 penny (POW2-1) */
     int     mail_expiration;    /* Number of days to wait to delete mail */
     int     mail_per_hour;      // Maximum sent @mail per hour per object.
+    int     match_index_min;    // Contents needed to index names in a location.
     int     max_players;        /* Max # of connected players */
     int     min_guests;         // The # we should start nuking at.
     int     nStackLimit;        // Current stack limit.
@@ -134,6 +140,7 @@ struct confdata
     int     room_name_charset;  // Charset restrictions for room names.
     int     thing_name_charset; // Charset restrictions for thing names.
     int     password_methods;   // Password encryption methods.
+    int     password_threads;   // Threads which hash passwords.
     int     default_charset;    // Default client charset mapping.
 #ifdef REALITY_LVLS
     int     no_levels;          /* Number of reality levels */
@@ -155,6 +162,7 @@ struct confdata
     int     ntfy_nest_lim;      /* Max nesting of notifys */
     int     number_guests;      // number of guest characters allowed.
     int     opencost;           /* cost of @open command */
+    int     output_cork;        // Cork flushes of at least this many bytes.
     int     output_limit;       /* Max # chars queued for output */
     int     pagecost;           /* cost of @page command */
     int     parent_nest_lim;    /* Max levels of parents */
@@ -165,6 +173,7 @@ struct confdata
     int     player_quota;       /* quota needed to make a robot player */
     int     pcreate_per_hour;   // Maximum allowed players created per hour */
     int     queue_chunk;        /* # cmds to run from queue when idle */
+    int     queue_fair_quantum; // CPU microseconds an owner gets per turn.
     int     queuemax;           /* max commands a player may have in queue */
     int     references_per_hour;/* Maximum allowed @reference adds per hour per object */
     int     retry_limit;        /* close conn after this many bad logins */
@@ -181,13 +190,13 @@ struct confdata
     int     vattr_flags;        /* Attr flags for all user-defined attrs */
     int     vattr_per_hour;     // Maximum allowed vattrs per hour per object.
     int     waitcost;           /* cost of @wait (refunded when finishes) */
-    int     wild_invk_lim;      // Max Regular Expression function calls.
     int     zone_nest_lim;      /* Max nesting of zones */
     int     restrict_home;      // Special condition to restrict 'home' command
     int     float_precision;    // Maximum precision of float-to-string conversion.
     int     lbuf_size;          // LBUF_SIZE accessible to softcode.
 
     unsigned int    max_cache_size; /* Max size of attribute cache */
+    unsigned int    exec_cache_size; // Max size of compiled softcode cache.
     unsigned int    site_chars; // where to truncate site name.
 
     IntArray    ports;          // user ports.
@@ -278,8 +287,12 @@ struct confdata
 
 extern CONFDATA mudconf;
 
-// Subnets
+// Subnets are kept in a path-compressed binary radix (Patricia) trie, one
+// for each address family.  A node covers the first nBits of aKey.  Nodes
+// without a subnet only join two branches.
 //
+#define SUBNET_KEY_SIZE 16
+
 class mux_subnet_node
 {
 public:
@@ -288,9 +301,9 @@ public:
 
 private:
     mux_subnet      *msn;
-    mux_subnet_node *pnLeft;
-    mux_subnet_node *pnInside;
-    mux_subnet_node *pnRight;
+    mux_subnet_node *pnChild[2];
+    unsigned char    aKey[SUBNET_KEY_SIZE];
+    int              nBits;
     unsigned long    ulControl;
 
     friend class mux_subnets;
@@ -365,14 +378,10 @@ public:
     ~mux_subnets();
 
 private:
-    mux_subnet_node *msnRoot;
-    void insert(mux_subnet_node **msnRoot, mux_subnet_node *msn);
-    void search(mux_subnet_node *msnRoot, MUX_SOCKADDR *msa, unsigned long *pulInfo);
-    mux_subnet_node *remove(mux_subnet_node *msnRoot, mux_subnet *msn_arg);
-
-    mux_subnet_node *rotr(mux_subnet_node *msnRoot);
-    mux_subnet_node *rollallr(mux_subnet_node *msnRoot);
-    mux_subnet_node *joinlr(mux_subnet_node *a, mux_subnet_node *b);
+    mux_subnet_node *msnRoot[2];
+    bool insert(mux_subnet *msn, unsigned long ulControl);
+    unsigned long search(MUX_SOCKADDR *msa);
+    mux_subnet_node *remove(mux_subnet_node *p, const unsigned char *aKey, int nBits);
 };
 
 typedef struct objlist_block OBLOCK;
@@ -429,6 +438,8 @@ typedef struct statedata STATEDATA;
 struct statedata
 {
     bool bCanRestart;           // are we ready to even attempt a restart.
+    bool bDirtyAttrNames;       // Have user attribute names changed since the last checkpoint?
+    bool bProfiling;            // Is @profile collecting?
     bool bReadingConfiguration; // are we reading the config file at startup?
     bool bStackLimitReached;    // Was stack slammed?
     bool bStandAlone;           // Are we running in dbconvert mode.
@@ -457,6 +468,7 @@ struct statedata
     int     events_flag;        /* Flags for check_events */
     int     func_invk_ctr;      /* Functions invoked so far by this command */
     int     func_nest_lev;      /* Current nesting of functions */
+    unsigned int func_generation; // Bumped when function tables change.
     int     generation;         /* DB global generation number */
     int     in_loop;            // Loop nesting level.
     int     lock_nest_lev;      /* Current nesting of lock evals */
@@ -466,6 +478,7 @@ struct statedata
     int     mHelpDesc;          // Number of entries allocated.
     int     min_size;           /* Minimum db size (from file header) */
     int     mstat_curr;         /* Which sample is latest */
+    int     nIncrementalDumps;  // Incremental checkpoints since the last full one (-1 forces a full one, -2 while one is written).
     int     nHelpDesc;          // Number of entries used.
     int     nObjEvalNest;       // The nesting level of objeval() invocations.
     int     nStackNest;         // Current stack depth.
@@ -475,7 +488,6 @@ struct statedata
     int     ntfy_nest_lev;      // Current nesting of notifys.
     int     train_nest_lev;     // Current nesting of train.
     int     record_players;     // The maximum # of player logged on.
-    int     wild_invk_ctr;      // Regular Expression function calls.
     int     zone_nest_num;      /* Global current zone nest position */
     int     mstat_idrss[2];     /* Summed private data size */
     int     mstat_isrss[2];     /* Summed private stack size */
@@ -529,17 +541,25 @@ struct statedata
 #endif // MEMORY_BASED
     CHashTable attr_name_htab;  /* Attribute names hashtable */
     CHashTable channel_htab;    /* Channels hashtable */
+    CHashTable cmd_index_htab;  // $-command patterns by object
     CHashTable command_htab;    /* Commands hashtable */
     CHashTable desc_htab;       /* Socket descriptor hashtable */
+    CHashTable exec_htab;       // Compiled softcode cache
     CHashTable flags_htab;      /* Flags hashtable */
     CHashTable func_htab;       /* Functions hashtable */
+    CHashTable hearer_htab;     // Objects which can hear, by location
+    CHashTable name_index_htab; // Names of contents, by location
     CHashTable fwdlist_htab;    /* Room forwardlists */
     CHashTable logout_cmd_htab; /* Logged-out commands hashtable (WHO, etc) */
     CHashTable mail_htab;       /* Mail players hashtable */
     CHashTable parent_htab;     /* Parent $-command exclusion */
     CHashTable player_htab;     /* Player name->number hashtable */
     CHashTable powers_htab;     /* Powers hashtable */
+    CHashTable profile_htab;    // Softcode profile entries
+    CHashTable queue_htab;      // Queue entries by executor and owner
     CHashTable reference_htab;  /* @reference hashtable */
+    CHashTable regexp_htab;     // Compiled regular expressions
+    CHashTable sem_htab;        // Semaphore wait lists
     CHashTable ufunc_htab;      /* Local functions hashtable */
     CHashTable vattr_name_htab; /* User attribute names hashtable */
     CHashTable scratch_htab;    /* Multi-purpose scratch hash table */
@@ -549,6 +569,8 @@ struct statedata
     CBitField bfCommands;       // Cache knowledge that there are $-Commands.
     CBitField bfListens;        // Cache knowledge that there are ^-Commands.
 
+    CBitField bfDirty;          // Objects changed since the last checkpoint.
+
     CBitField bfReport;         // Used for LROOMS.
     CBitField bfTraverse;       // Used for LROOMS.
 };
@@ -292,6 +292,101 @@ void clearstrings(DESC *d)
     }
 }
 
+// Output blocks are recycled through a free list instead of going back to
+// the heap each time a block is sent.  The list is bounded so that one large
+// burst does not pin memory forever.
+//
+#define TBLOCK_FREE_MAX 64
+
+OUTPUT_STATS OutputStats;
+static TBLOCK *tblock_free_list = NULL;
+
+/*! \brief Allocate an empty output block.
+ *
+ * \return         Output block.  Does not return on failure.
+ */
+
+TBLOCK *tblock_alloc(void)
+{
+    TBLOCK *tp = tblock_free_list;
+    if (NULL != tp)
+    {
+        tblock_free_list = tp->hdr.nxt;
+        OutputStats.nFreeBlocks--;
+    }
+    else
+    {
+        tp = (TBLOCK *)MEMALLOC(OUTPUT_BLOCK_SIZE);
+        ISOUTOFMEMORY(tp);
+    }
+
+    tp->hdr.nxt = NULL;
+    tp->hdr.start = tp->data;
+    tp->hdr.end = tp->data;
+    tp->hdr.nchars = 0;
+    tp->hdr.flags = 0;
+    tp->hdr.pShared = NULL;
+    return tp;
+}
+
+/*! \brief Allocate an output block which refers to shared text.
+ *
+ * The block is only a header.  Its text is the shared text, and it holds a
+ * reference to it until the block is freed.  Nothing can be appended to it.
+ *
+ * \param pst      Shared text.
+ * \return         Output block.  Does not return on failure.
+ */
+
+static TBLOCK *tblock_alloc_shared(SHARED_TEXT *pst)
+{
+    TBLOCK *tp = (TBLOCK *)MEMALLOC(sizeof(TBLOCKHDR));
+    ISOUTOFMEMORY(tp);
+
+    pst->nRefs++;
+    tp->hdr.nxt = NULL;
+    tp->hdr.start = (UTF8 *)pst->aText;
+    tp->hdr.end = (UTF8 *)pst->aText + pst->nBytes;
+    tp->hdr.nchars = pst->nBytes;
+    tp->hdr.flags = TBLK_FLAG_SHARED;
+    tp->hdr.pShared = pst;
+    return tp;
+}
+
+static void shared_text_release(SHARED_TEXT *pst)
+{
+    pst->nRefs--;
+    if (0 == pst->nRefs)
+    {
+        MEMFREE(pst);
+    }
+}
+
+/*! \brief Release an output block, keeping it for reuse if there is room.
+ *
+ * \param tb       Output block which is no longer in any output queue.
+ * \return         None.
+ */
+
+void tblock_free(TBLOCK *tb)
+{
+    if (tb->hdr.flags & TBLK_FLAG_SHARED)
+    {
+        shared_text_release(tb->hdr.pShared);
+        MEMFREE(tb);
+    }
+    else if (OutputStats.nFreeBlocks < TBLOCK_FREE_MAX)
+    {
+        tb->hdr.nxt = tblock_free_list;
+        tblock_free_list = tb;
+        OutputStats.nFreeBlocks++;
+    }
+    else
+    {
+        MEMFREE(tb);
+    }
+}
+
 /*! \brief Add text to the output queue of the indicated network descriptor
  *         without questions.
  *
@@ -316,23 +411,9 @@ static void add_to_output_queue(DESC *d, const char *b, size_t n)
     //
     if (NULL == d->output_head)
     {
-        tp = (TBLOCK *)MEMALLOC(OUTPUT_BLOCK_SIZE);
-        if (NULL != tp)
-        {
-            tp->hdr.nxt = NULL;
-            tp->hdr.start = tp->data;
-            tp->hdr.end = tp->data;
-            tp->hdr.nchars = 0;
-            tp->hdr.flags = 0;
-
-            d->output_head = tp;
-            d->output_tail = tp;
-        }
-        else
-        {
-            ISOUTOFMEMORY(tp);
-            return;
-        }
+        tp = tblock_alloc();
+        d->output_head = tp;
+        d->output_tail = tp;
     }
     else
     {
@@ -347,9 +428,18 @@ static void add_to_output_queue(DESC *d, const char *b, size_t n)
         // string.  If so, copy it and update the pointers.
         //
         // We cannot update a buffer marked TBLK_FLAG_LOCKED.  If fact, we
-        // should not read or write to such a buffer in any fashion.
+        // should not read or write to such a buffer in any fashion.  A
+        // TBLK_FLAG_SHARED block has no room of its own.
         //
-        left = OUTPUT_BLOCK_SIZE - (tp->hdr.end - (UTF8 *)tp + 1);
+        if (tp->hdr.flags & TBLK_FLAG_SHARED)
+        {
+            left = 0;
+        }
+        else
+        {
+            left = OUTPUT_BLOCK_SIZE - (tp->hdr.end - (UTF8 *)tp + 1);
+        }
+
         if (  n <= left
            && 0 == (tp->hdr.flags & TBLK_FLAG_LOCKED))
         {
@@ -373,48 +463,17 @@ static void add_to_output_queue(DESC *d, const char *b, size_t n)
                 n -= left;
             }
 
-            tp = (TBLOCK *)MEMALLOC(OUTPUT_BLOCK_SIZE);
-            if (NULL != tp)
-            {
-                tp->hdr.nxt = NULL;
-                tp->hdr.start = tp->data;
-                tp->hdr.end = tp->data;
-                tp->hdr.nchars = 0;
-                tp->hdr.flags = 0;
-
-                d->output_tail->hdr.nxt = tp;
-                d->output_tail = tp;
-            }
-            else
-            {
-                ISOUTOFMEMORY(tp);
-                return;
-            }
+            tp = tblock_alloc();
+            d->output_tail->hdr.nxt = tp;
+            d->output_tail = tp;
         }
     } while (n > 0);
 }
 
-/*! \brief Add text to the output queue of the indicated network descriptor.
- *
- * This is the network output interface available to the rest of the server.
- * Above this point, we would typically find the Telnet negotiation, encoding,
- * and parsing layer.  Below this point, there exists only input and output
- * byte streams which may or may not use multi-threaded access to the network,
- * may or may not use SSL, and must be resilient to platform interface
- * concerns, abuse from the network, and the mis-match in flow rates between
- * inside and outside.
- *
- * Since the network layer is necessarily dealing intimately with the outside,
- * it necessarily has some hysteresis built into it so that on average, it's
- * attention is spent on useful things, and postponable things are postponed.
- *
- * \param d         Network descriptor state.
- * \param b         buffer to add to the output queue.
- * \param n         Number of bytes in buffer, b, to add to the output queue.
- * \return          None.
- */
-
-void queue_write_LEN(DESC *d, const char *b, size_t n)
+// Add text to the output queue, either by copying it or, when pst is given,
+// by linking a block which refers to the shared text.  See queue_write_LEN().
+//
+static void queue_write_text(DESC *d, const char *b, size_t n, SHARED_TEXT *pst)
 {
     if (0 == n)
     {
@@ -494,7 +553,7 @@ void queue_write_LEN(DESC *d, const char *b, size_t n)
                 {
                     d->output_tail = NULL;
                 }
-                MEMFREE(tp);
+                tblock_free(tp);
                 tp = NULL;
             }
         }
@@ -502,9 +561,26 @@ void queue_write_LEN(DESC *d, const char *b, size_t n)
 
     // Append the request to the end of the output queue for later transmission.
     //
-    add_to_output_queue(d, b, n);
+    if (NULL != pst)
+    {
+        TBLOCK *tp = tblock_alloc_shared(pst);
+        if (NULL == d->output_head)
+        {
+            d->output_head = tp;
+        }
+        else
+        {
+            d->output_tail->hdr.nxt = tp;
+        }
+        d->output_tail = tp;
+    }
+    else
+    {
+        add_to_output_queue(d, b, n);
+    }
     d->output_size += n;
     d->output_tot += n;
+    DESC_INTEREST_CHANGED(d);
 
 #if defined(WINDOWS_NETWORKING)
     // As part of the heuristics for good performance, we may not call
@@ -521,6 +597,31 @@ void queue_write_LEN(DESC *d, const char *b, size_t n)
 #endif // WINDOWS_NETWORKING
 }
 
+/*! \brief Add text to the output queue of the indicated network descriptor.
+ *
+ * This is the network output interface available to the rest of the server.
+ * Above this point, we would typically find the Telnet negotiation, encoding,
+ * and parsing layer.  Below this point, there exists only input and output
+ * byte streams which may or may not use multi-threaded access to the network,
+ * may or may not use SSL, and must be resilient to platform interface
+ * concerns, abuse from the network, and the mis-match in flow rates between
+ * inside and outside.
+ *
+ * Since the network layer is necessarily dealing intimately with the outside,
+ * it necessarily has some hysteresis built into it so that on average, it's
+ * attention is spent on useful things, and postponable things are postponed.
+ *
+ * \param d         Network descriptor state.
+ * \param b         buffer to add to the output queue.
+ * \param n         Number of bytes in buffer, b, to add to the output queue.
+ * \return          None.
+ */
+
+void queue_write_LEN(DESC *d, const char *b, size_t n)
+{
+    queue_write_text(d, b, n, NULL);
+}
+
 void queue_write(DESC *d, const char *b)
 {
     queue_write_LEN(d, b, strlen(b));
@@ -621,7 +722,11 @@ void queue_string(DESC *d, const UTF8 *s)
     queue_write(d, q);
 }
 
-void queue_string(DESC *d, const mux_string &s)
+// Render a message for the client on the other end of a descriptor: color,
+// HTML, character set, and Telnet IAC escapes.  The result is in a static
+// buffer.
+//
+static const char *render_string(DESC *d, const mux_string &s)
 {
     const UTF8 *p = s.export_TextConverted((d->flags & DS_CONNECTED) && Ansi(d->player), NoBleed(d->player), Color256(d->player), Html(d->player));
 
@@ -650,8 +755,179 @@ void queue_string(DESC *d, const mux_string &s)
         }
     }
 
-    q = encode_iac(q);
-    queue_write(d, q);
+    return encode_iac(q);
+}
+
+// Broadcasts.  While a broadcast is in progress, a registered message is
+// rendered at most once for each distinct client profile (encoding, color,
+// and HTML settings), and the rendered text is shared by every descriptor
+// with that profile.  Short renderings are still copied into each output
+// queue because a shared block costs more than the copy.
+//
+#define BROADCAST_MAX_MESSAGES  4
+#define BROADCAST_MAX_RENDERS   32
+#define BROADCAST_SHARE_MIN     512
+
+typedef struct
+{
+    const mux_string *pMsg;
+    int               iProfile;
+    SHARED_TEXT      *pst;
+} BROADCAST_RENDER;
+
+static int nBroadcastNest = 0;
+static int nBroadcastMessages = 0;
+static const mux_string *apBroadcastMessages[BROADCAST_MAX_MESSAGES];
+static int nBroadcastRenders = 0;
+static BROADCAST_RENDER aBroadcastRenders[BROADCAST_MAX_RENDERS];
+
+/*! \brief Begin a broadcast.
+ *
+ * Broadcasts may nest, but only messages registered by the outermost
+ * broadcast are shared.
+ *
+ * \return         None.
+ */
+
+void broadcast_begin(void)
+{
+    nBroadcastNest++;
+}
+
+/*! \brief Register a message which is about to be sent to many players.
+ *
+ * The message is recognized by its address, so it must not change or go
+ * away before broadcast_end(), and the same object must be passed all the
+ * way down to raw_notify().
+ *
+ * \param sMsg     Message.
+ * \return         None.
+ */
+
+void broadcast_message(const mux_string &sMsg)
+{
+    if (  1 == nBroadcastNest
+       && nBroadcastMessages < BROADCAST_MAX_MESSAGES)
+    {
+        apBroadcastMessages[nBroadcastMessages++] = &sMsg;
+    }
+}
+
+/*! \brief End a broadcast and release its renderings.
+ *
+ * Output queues keep their own references to any text they still need.
+ *
+ * \return         None.
+ */
+
+void broadcast_end(void)
+{
+    nBroadcastNest--;
+    if (0 == nBroadcastNest)
+    {
+        for (int i = 0; i < nBroadcastRenders; i++)
+        {
+            shared_text_release(aBroadcastRenders[i].pst);
+            aBroadcastRenders[i].pst = NULL;
+        }
+        nBroadcastRenders = 0;
+        nBroadcastMessages = 0;
+    }
+}
+
+static int client_profile(DESC *d)
+{
+    int iProfile = d->encoding << 4;
+    if (  (d->flags & DS_CONNECTED)
+       && Ansi(d->player))
+    {
+        iProfile |= 1;
+    }
+    if (NoBleed(d->player))
+    {
+        iProfile |= 2;
+    }
+    if (Color256(d->player))
+    {
+        iProfile |= 4;
+    }
+    if (Html(d->player))
+    {
+        iProfile |= 8;
+    }
+    return iProfile;
+}
+
+// Find or make the shared rendering of a registered message for this
+// descriptor.  Returns NULL if the message is not part of a broadcast.
+//
+static SHARED_TEXT *broadcast_render(DESC *d, const mux_string &s)
+{
+    int i;
+    for (i = 0; i < nBroadcastMessages; i++)
+    {
+        if (&s == apBroadcastMessages[i])
+        {
+            break;
+        }
+    }
+    if (nBroadcastMessages == i)
+    {
+        return NULL;
+    }
+
+    int iProfile = client_profile(d);
+    for (i = 0; i < nBroadcastRenders; i++)
+    {
+        if (  &s == aBroadcastRenders[i].pMsg
+           && iProfile == aBroadcastRenders[i].iProfile)
+        {
+            OutputStats.nBroadcastShared++;
+            return aBroadcastRenders[i].pst;
+        }
+    }
+
+    if (BROADCAST_MAX_RENDERS <= nBroadcastRenders)
+    {
+        return NULL;
+    }
+
+    const char *q = render_string(d, s);
+    size_t n = strlen(q);
+    SHARED_TEXT *pst = (SHARED_TEXT *)MEMALLOC(sizeof(SHARED_TEXT) + n);
+    ISOUTOFMEMORY(pst);
+    pst->nRefs = 1;
+    pst->nBytes = n;
+    memcpy(pst->aText, q, n + 1);
+
+    aBroadcastRenders[nBroadcastRenders].pMsg = &s;
+    aBroadcastRenders[nBroadcastRenders].iProfile = iProfile;
+    aBroadcastRenders[nBroadcastRenders].pst = pst;
+    nBroadcastRenders++;
+    OutputStats.nBroadcastRenders++;
+    return pst;
+}
+
+void queue_string(DESC *d, const mux_string &s)
+{
+    if (0 < nBroadcastNest)
+    {
+        SHARED_TEXT *pst = broadcast_render(d, s);
+        if (NULL != pst)
+        {
+            if (pst->nBytes < BROADCAST_SHARE_MIN)
+            {
+                queue_write_LEN(d, pst->aText, pst->nBytes);
+            }
+            else
+            {
+                queue_write_text(d, pst->aText, pst->nBytes, pst);
+            }
+            return;
+        }
+    }
+
+    queue_write(d, render_string(d, s));
 }
 
 void freeqs(DESC *d)
@@ -663,7 +939,7 @@ void freeqs(DESC *d)
     while (tb)
     {
         tnext = tb->hdr.nxt;
-        MEMFREE(tb);
+        tblock_free(tb);
         tb = tnext;
     }
     d->output_head = NULL;
@@ -784,6 +1060,7 @@ void save_command(DESC *d, CBLK *command)
         // We have added our first command to an empty list. Go process it later.
         //
         scheduler.DeferImmediateTask(PRIORITY_SYSTEM, Task_ProcessCommand, d, 0);
+        DESC_INTEREST_CHANGED(d);
     }
     else
     {
@@ -1333,11 +1610,13 @@ void announce_disconnect(dbref player, DESC *d, const UTF8 *reason)
         if (d->flags & DS_AUTODARK)
         {
             d->flags &= ~DS_AUTODARK;
+            s_Dirty(player);
             db[player].fs.word[FLAG_WORD1] &= ~DARK;
         }
 
         if (Guest(player))
         {
+            s_Dirty(player);
             db[player].fs.word[FLAG_WORD1] |= DARK;
             halt_que(NOTHING, player);
         }
@@ -1644,6 +1923,7 @@ void check_idle(void)
                     }
                     if (!bFound)
                     {
+                        s_Dirty(d->player);
                         db[d->player].fs.word[FLAG_WORD1] |= DARK;
                         DESC_ITER_PLAYER(d->player, d1)
                         {
@@ -2320,57 +2600,300 @@ static void failconn(const UTF8 *logcode, const UTF8 *logtype, const UTF8 *logre
 
 static const UTF8 *connect_fail = T("Either that player does not exist, or has a different password.\r\n");
 
-static bool check_connect(DESC *d, UTF8 *msg)
+// Tell the connection that the player or password was wrong.  Returns false
+// if the connection has used up its retries and was closed.
+//
+static bool connect_failed(DESC *d, const UTF8 *user)
+{
+    queue_write(d, (char *)connect_fail);
+    STARTLOG(LOG_LOGIN | LOG_SECURITY, "CON", "BAD");
+    UTF8 *buff = alloc_lbuf("connect_failed.LOG.bad");
+    mux_sprintf(buff, LBUF_SIZE, T("[%u/%s] Failed connect to \xE2\x80\x98%s\xE2\x80\x99"), d->descriptor, d->addr, user);
+    log_text(buff);
+    free_lbuf(buff);
+    ENDLOG;
+    if (--(d->retries_left) <= 0)
+    {
+        shutdownsock(d, R_BADLOGIN);
+        return false;
+    }
+    return true;
+}
+
+/*! \brief Finish connecting once the password has been checked.
+ *
+ * \param pContext   The descriptor which asked to connect.
+ * \param player     Player it asked to connect to.
+ * \param bValidPass Whether the password was right.
+ * \return           None.
+ */
+
+static void check_connect_done(void *pContext, dbref player, bool bValidPass)
 {
+    DESC *d = (DESC *)pContext;
     UTF8 *buff;
-    dbref player, aowner;
+    dbref aowner;
     int aflags, nplayers;
     DESC *d2;
-    const UTF8 *p;
-    bool isGuest = false;
 
     const UTF8 *cmdsave = mudstate.debug_cmd;
     mudstate.debug_cmd = T("< check_connect >");
 
-    // Hide the password length from SESSION.
-    //
-    d->input_tot -= (strlen((char *)msg) + 1);
+    bool isGuest = ((d->flags & DS_AUTHGUEST) != 0);
+    bool isDark  = ((d->flags & DS_AUTHDARK) != 0);
+    d->flags &= ~(DS_AUTHPENDING | DS_AUTHDARK | DS_AUTHGUEST);
 
-    // Crack the command apart.
+    // failconn() wants these.
     //
     UTF8 *command = alloc_lbuf("check_conn.cmd");
     UTF8 *user = alloc_lbuf("check_conn.user");
     UTF8 *password = alloc_lbuf("check_conn.pass");
-    parse_connect(msg, command, user, password);
+    command[0] = '\0';
+    password[0] = '\0';
+    mux_strncpy(user, d->auth_user, LBUF_SIZE-1);
+    MEMFREE(d->auth_user);
+    d->auth_user = NULL;
 
     int host_info = mudstate.access_list.check(&d->address);
 
-    // At this point, command, user, and password are all less than
-    // MBUF_SIZE.
+    // See if this connection would exceed the max #players.
     //
-    if (  strncmp((char *)command, "co", 2) == 0
-       || strncmp((char *)command, "cd", 2) == 0)
+    if (mudconf.max_players < 0)
     {
-        if (string_prefix(user, mudconf.guest_prefix))
+        nplayers = mudconf.max_players - 1;
+    }
+    else
+    {
+        nplayers = 0;
+        DESC_ITER_CONN(d2)
         {
-            if (host_info & HI_NOGUEST)
-            {
-                // Someone from an IP with guest restrictions is
-                // trying to use a guest account. Give them the blurb
-                // most likely to have instructions about requesting a
-                // character by other means and then fail this
-                // connection.
-                //
-                // The guest 'power' is handled separately further
-                // down.
-                //
-                failconn(T("CONN"), T("Connect"), T("Guest Site Forbidden"), d,
-                    R_GAMEDOWN, NOTHING, FC_CONN_REG, mudconf.downmotd_msg,
-                    command, user, password, cmdsave);
-                return false;
-            }
+            nplayers++;
+        }
+    }
 
-            if (mudconf.control_flags & CF_LOGIN)
+    UTF8 host_address[MBUF_SIZE];
+    d->address.ntop(host_address, sizeof(host_address));
+
+    // The player may have been destroyed or @toad'ed while the password
+    // was being checked.  Don't log in as it, or record the attempt on it.
+    //
+    if (  Good_obj(player)
+       && isPlayer(player)
+       && !Going(player))
+    {
+        player = connect_player(player, bValidPass, d->addr, d->username, host_address);
+    }
+    else
+    {
+        player = NOTHING;
+    }
+
+    if (  player == NOTHING
+       || (!isGuest && Guest.CheckGuest(player)))
+    {
+        // Wrong password, or not a guest.
+        //
+        if (!connect_failed(d, user))
+        {
+            free_lbuf(command);
+            free_lbuf(user);
+            free_lbuf(password);
+            mudstate.debug_cmd = cmdsave;
+            return;
+        }
+    }
+    else if (  (  (mudconf.control_flags & CF_LOGIN)
+               && (nplayers < mudconf.max_players))
+            || RealWizRoy(player)
+            || God(player))
+    {
+        if (  isDark
+           && (  RealWizard(player)
+              || God(player)))
+        {
+            s_Dirty(player);
+            db[player].fs.word[FLAG_WORD1] |= DARK;
+        }
+
+        // Make sure we don't have a guest from an unwanted host.
+        // The majority of these are handled above.
+        //
+        // The following code handles the case where a staffer
+        // (#1-only by default) has specifically given the guest 'power'
+        // to an existing player.
+        //
+        // In this case, the player -already- has an account complete
+        // with password. We still fail the connection to -this- player
+        // but if the site isn't register_sited, this player can simply
+        // auto-create another player. So, the procedure is not much
+        // different from @newpassword'ing them. Oh well. We are just
+        // following orders. ;)
+        //
+        if (  Guest(player)
+           && (host_info & HI_NOGUEST))
+        {
+            failconn(T("CON"), T("Connect"), T("Guest Site Forbidden"), d,
+                R_GAMEDOWN, player, FC_CONN_SITE,
+                mudconf.downmotd_msg, command, user, password,
+                cmdsave);
+            return;
+        }
+
+        // Logins are enabled, or wiz or god.
+        //
+        STARTLOG(LOG_LOGIN, "CON", "LOGIN");
+        buff = alloc_mbuf("check_conn.LOG.login");
+        mux_sprintf(buff, MBUF_SIZE, T("[%u/%s] Connected to "), d->descriptor, d->addr);
+        log_text(buff);
+        log_name_and_loc(player);
+        free_mbuf(buff);
+        ENDLOG;
+        d->flags |= DS_CONNECTED;
+        d->connected_at.GetUTC();
+        d->player = player;
+
+        // Check to see if the player is currently running an
+        // @program. If so, drop the new descriptor into it.
+        //
+        DESC_ITER_PLAYER(player, d2)
+        {
+            if (  NULL != d2->program_data
+               && NULL == d->program_data)
+            {
+                d->program_data = d2->program_data;
+            }
+            else if (NULL != d2->program_data)
+            {
+                // Enforce that all program_data pointers for this player
+                // are the same.
+                //
+                mux_assert(d->program_data == d2->program_data);
+            }
+        }
+
+        // Give the player the MOTD file and the settable MOTD
+        // message(s). Use raw notifies so the player doesn't try
+        // to match on the text.
+        //
+        if (Guest(player))
+        {
+            fcache_dump(d, FC_CONN_GUEST);
+        }
+        else
+        {
+            buff = atr_get("check_connect.2375", player, A_LAST, &aowner, &aflags);
+            if (*buff == '\0')
+                fcache_dump(d, FC_CREA_NEW);
+            else
+                fcache_dump(d, FC_MOTD);
+            if (Wizard(player))
+                fcache_dump(d, FC_WIZMOTD);
+            free_lbuf(buff);
+        }
+        announce_connect(player, d);
+
+        DESC* dtemp;
+        int num_con = 0;
+        DESC_ITER_PLAYER(player, dtemp)
+        {
+            num_con++;
+        }
+        local_connect(player, 0, num_con);
+
+#if defined(TINYMUX_MODULES)
+        ServerEventsSinkNode *pNode = g_pServerEventsSinkListHead;
+        while (NULL != pNode)
+        {
+            pNode->pSink->connect(player, 0, num_con);
+            pNode = pNode->pNext;
+        }
+#endif // TINYMUX_MODULES
+
+        // If stuck in an @prog, show the prompt.
+        //
+        if (NULL != d->program_data)
+        {
+            queue_write_LEN(d, ">\377\371", 3);
+        }
+    }
+    else if (!(mudconf.control_flags & CF_LOGIN))
+    {
+        failconn(T("CON"), T("Connect"), T("Logins Disabled"), d, R_GAMEDOWN, player, FC_CONN_DOWN,
+            mudconf.downmotd_msg, command, user, password, cmdsave);
+        return;
+    }
+    else
+    {
+        failconn(T("CON"), T("Connect"), T("Game Full"), d, R_GAMEFULL, player, FC_CONN_FULL,
+            mudconf.fullmotd_msg, command, user, password, cmdsave);
+        return;
+    }
+
+    free_lbuf(command);
+    free_lbuf(user);
+    free_lbuf(password);
+
+    // Anything typed in the meantime can go now.
+    //
+    if (NULL != d->input_head)
+    {
+        scheduler.CancelTask(Task_ProcessCommand, d, 0);
+        scheduler.DeferImmediateTask(PRIORITY_SYSTEM, Task_ProcessCommand, d, 0);
+    }
+    mudstate.debug_cmd = cmdsave;
+}
+
+static bool check_connect(DESC *d, UTF8 *msg)
+{
+    UTF8 *buff;
+    dbref player;
+    int nplayers;
+    DESC *d2;
+    const UTF8 *p;
+    bool isGuest = false;
+
+    const UTF8 *cmdsave = mudstate.debug_cmd;
+    mudstate.debug_cmd = T("< check_connect >");
+
+    // Hide the password length from SESSION.
+    //
+    d->input_tot -= (strlen((char *)msg) + 1);
+
+    // Crack the command apart.
+    //
+    UTF8 *command = alloc_lbuf("check_conn.cmd");
+    UTF8 *user = alloc_lbuf("check_conn.user");
+    UTF8 *password = alloc_lbuf("check_conn.pass");
+    parse_connect(msg, command, user, password);
+
+    int host_info = mudstate.access_list.check(&d->address);
+
+    // At this point, command, user, and password are all less than
+    // MBUF_SIZE.
+    //
+    if (  strncmp((char *)command, "co", 2) == 0
+       || strncmp((char *)command, "cd", 2) == 0)
+    {
+        if (string_prefix(user, mudconf.guest_prefix))
+        {
+            if (host_info & HI_NOGUEST)
+            {
+                // Someone from an IP with guest restrictions is
+                // trying to use a guest account. Give them the blurb
+                // most likely to have instructions about requesting a
+                // character by other means and then fail this
+                // connection.
+                //
+                // The guest 'power' is handled separately further
+                // down.
+                //
+                failconn(T("CONN"), T("Connect"), T("Guest Site Forbidden"), d,
+                    R_GAMEDOWN, NOTHING, FC_CONN_REG, mudconf.downmotd_msg,
+                    command, user, password, cmdsave);
+                return false;
+            }
+
+            if (mudconf.control_flags & CF_LOGIN)
             {
                 if (  mudconf.number_guests <= 0
                    || !Good_obj(mudconf.guest_char)
@@ -2398,171 +2921,40 @@ static bool check_connect(DESC *d, UTF8 *msg)
             }
         }
 
-        // See if this connection would exceed the max #players.
-        //
-        if (mudconf.max_players < 0)
-        {
-            nplayers = mudconf.max_players - 1;
-        }
-        else
+        player = lookup_player(NOTHING, user, false);
+        if (NOTHING == player)
         {
-            nplayers = 0;
-            DESC_ITER_CONN(d2)
-            {
-                nplayers++;
-            }
-        }
-
-        UTF8 host_address[MBUF_SIZE];
-        d->address.ntop(host_address, sizeof(host_address));
-        player = connect_player(user, password, d->addr, d->username, host_address);
-        if (  player == NOTHING
-           || (!isGuest && Guest.CheckGuest(player)))
-        {
-            // Not a player, or wrong password.
+            // Not a player.
             //
-            queue_write(d, (char *)connect_fail);
-            STARTLOG(LOG_LOGIN | LOG_SECURITY, "CON", "BAD");
-            buff = alloc_lbuf("check_conn.LOG.bad");
-            mux_sprintf(buff, LBUF_SIZE, T("[%u/%s] Failed connect to \xE2\x80\x98%s\xE2\x80\x99"), d->descriptor, d->addr, user);
-            log_text(buff);
-            free_lbuf(buff);
-            ENDLOG;
-            if (--(d->retries_left) <= 0)
-            {
-                free_lbuf(command);
-                free_lbuf(user);
-                free_lbuf(password);
-                shutdownsock(d, R_BADLOGIN);
-                mudstate.debug_cmd = cmdsave;
-                return false;
-            }
+            connect_failed(d, user);
         }
-        else if (  (  (mudconf.control_flags & CF_LOGIN)
-                   && (nplayers < mudconf.max_players))
-                || RealWizRoy(player)
-                || God(player))
+        else
         {
-            if (  strncmp((char *)command, "cd", 2) == 0
-               && (  RealWizard(player)
-                  || God(player)))
-            {
-                db[player].fs.word[FLAG_WORD1] |= DARK;
-            }
-
-            // Make sure we don't have a guest from an unwanted host.
-            // The majority of these are handled above.
-            //
-            // The following code handles the case where a staffer
-            // (#1-only by default) has specifically given the guest 'power'
-            // to an existing player.
-            //
-            // In this case, the player -already- has an account complete
-            // with password. We still fail the connection to -this- player
-            // but if the site isn't register_sited, this player can simply
-            // auto-create another player. So, the procedure is not much
-            // different from @newpassword'ing them. Oh well. We are just
-            // following orders. ;)
-            //
-            if (  Guest(player)
-               && (host_info & HI_NOGUEST))
-            {
-                failconn(T("CON"), T("Connect"), T("Guest Site Forbidden"), d,
-                    R_GAMEDOWN, player, FC_CONN_SITE,
-                    mudconf.downmotd_msg, command, user, password,
-                    cmdsave);
-                return false;
-            }
-
-            // Logins are enabled, or wiz or god.
-            //
-            STARTLOG(LOG_LOGIN, "CON", "LOGIN");
-            buff = alloc_mbuf("check_conn.LOG.login");
-            mux_sprintf(buff, MBUF_SIZE, T("[%u/%s] Connected to "), d->descriptor, d->addr);
-            log_text(buff);
-            log_name_and_loc(player);
-            free_mbuf(buff);
-            ENDLOG;
-            d->flags |= DS_CONNECTED;
-            d->connected_at.GetUTC();
-            d->player = player;
-
-            // Check to see if the player is currently running an
-            // @program. If so, drop the new descriptor into it.
+            // The rest happens in check_connect_done() once the password
+            // has been hashed.  Input waits until then.
             //
-            DESC_ITER_PLAYER(player, d2)
+            d->flags |= DS_AUTHPENDING;
+            d->flags &= ~(DS_AUTHDARK | DS_AUTHGUEST);
+            if (strncmp((char *)command, "cd", 2) == 0)
             {
-                if (  NULL != d2->program_data
-                   && NULL == d->program_data)
-                {
-                    d->program_data = d2->program_data;
-                }
-                else if (NULL != d2->program_data)
-                {
-                    // Enforce that all program_data pointers for this player
-                    // are the same.
-                    //
-                    mux_assert(d->program_data == d2->program_data);
-                }
+                d->flags |= DS_AUTHDARK;
             }
-
-            // Give the player the MOTD file and the settable MOTD
-            // message(s). Use raw notifies so the player doesn't try
-            // to match on the text.
-            //
-            if (Guest(player))
+            if (isGuest)
             {
-                fcache_dump(d, FC_CONN_GUEST);
+                d->flags |= DS_AUTHGUEST;
             }
-            else
-            {
-                buff = atr_get("check_connect.2375", player, A_LAST, &aowner, &aflags);
-                if (*buff == '\0')
-                    fcache_dump(d, FC_CREA_NEW);
-                else
-                    fcache_dump(d, FC_MOTD);
-                if (Wizard(player))
-                    fcache_dump(d, FC_WIZMOTD);
-                free_lbuf(buff);
-            }
-            announce_connect(player, d);
-
-            DESC* dtemp;
-            int num_con = 0;
-            DESC_ITER_PLAYER(player, dtemp)
+            if (NULL != d->auth_user)
             {
-                num_con++;
+                MEMFREE(d->auth_user);
             }
-            local_connect(player, 0, num_con);
+            d->auth_user = StringClone(user);
 
-#if defined(TINYMUX_MODULES)
-            ServerEventsSinkNode *pNode = g_pServerEventsSinkListHead;
-            while (NULL != pNode)
-            {
-                pNode->pSink->connect(player, 0, num_con);
-                pNode = pNode->pNext;
-            }
-#endif // TINYMUX_MODULES
-
-            // If stuck in an @prog, show the prompt.
-            //
-            if (NULL != d->program_data)
-            {
-                queue_write_LEN(d, ">\377\371", 3);
-            }
-
-        }
-        else if (!(mudconf.control_flags & CF_LOGIN))
-        {
-            failconn(T("CON"), T("Connect"), T("Logins Disabled"), d, R_GAMEDOWN, player, FC_CONN_DOWN,
-                mudconf.downmotd_msg, command, user, password, cmdsave);
-            return false;
-        }
-        else
-        {
-            failconn(T("CON"), T("Connect"), T("Game Full"), d, R_GAMEFULL, player, FC_CONN_FULL,
-                mudconf.fullmotd_msg, command, user, password, cmdsave);
-            return false;
+            free_lbuf(command);
+            free_lbuf(user);
+            mudstate.debug_cmd = cmdsave;
+            check_pass_async(player, password, d, check_connect_done);
+            free_lbuf(password);
+            return true;
         }
     }
     else if (strncmp((char *)command, "cr", 2) == 0)
@@ -2934,7 +3326,8 @@ void Task_ProcessCommand(void *arg_voidptr, int arg_iInteger)
     UNUSED_PARAMETER(arg_iInteger);
 
     DESC *d = (DESC *)arg_voidptr;
-    if (d)
+    if (  d
+       && 0 == (d->flags & DS_AUTHPENDING))
     {
         CBLK *t = d->input_head;
         if (t)
@@ -2952,6 +3345,7 @@ void Task_ProcessCommand(void *arg_voidptr, int arg_iInteger)
                 else
                 {
                     d->input_tail = NULL;
+                    DESC_INTEREST_CHANGED(d);
                 }
                 d->input_size -= strlen((char *)t->cmd);
                 d->last_time.GetUTC();
@@ -2978,13 +3372,156 @@ void Task_ProcessCommand(void *arg_voidptr, int arg_iInteger)
     }
 }
 
+#if defined(HAVE_IN_ADDR)
+// The game does not run while the benchmark does, so it is kept to a few
+// milliseconds.
+//
+#define BENCHMARK_MAX_SUBNETS 5000
+#define BENCHMARK_LOOKUPS     10000
+#define BENCHMARK_SCANS       100
+
+static UINT32 RandomAddress(void)
+{
+    return ((UINT32)RandomINT32(0, 65535) << 16) | (UINT32)RandomINT32(0, 65535);
+}
+
+static mux_subnet *BenchmarkSubnet(dbref player, UINT32 ulBase, int nBits)
+{
+    UTF8 buf[SBUF_SIZE];
+    mux_sprintf(buf, sizeof(buf), T("%d.%d.%d.%d/%d"), (ulBase >> 24) & 0xFF,
+        (ulBase >> 16) & 0xFF, (ulBase >> 8) & 0xFF, ulBase & 0xFF, nBits);
+    return ParseSubnet(buf, player, (UTF8 *)T("@list site_information"));
+}
+
+// Compare the trie against a scan of the same subnets, which is what the
+// previous tree degenerated into when fed a sorted blocklist.
+//
+static void BenchmarkSubnets(dbref player, int nSubnets)
+{
+    UINT32 *aBase = (UINT32 *)MEMALLOC(nSubnets * sizeof(UINT32));
+    ISOUTOFMEMORY(aBase);
+    int *aBits = (int *)MEMALLOC(nSubnets * sizeof(int));
+    ISOUTOFMEMORY(aBits);
+    mux_subnet **aSubnets = (mux_subnet **)MEMALLOC(nSubnets * sizeof(mux_subnet *));
+    ISOUTOFMEMORY(aSubnets);
+
+    for (int i = 0; i < nSubnets; i++)
+    {
+        aBits[i] = RandomINT32(16, 32);
+        UINT32 ulMask = (32 == aBits[i]) ? 0xFFFFFFFFUL : ~(0xFFFFFFFFUL >> aBits[i]);
+        aBase[i] = RandomAddress() & ulMask;
+        aSubnets[i] = BenchmarkSubnet(player, aBase[i], aBits[i]);
+    }
+
+    // Half of the addresses fall inside some subnet.
+    //
+    MUX_SOCKADDR *aAddresses = new MUX_SOCKADDR[BENCHMARK_LOOKUPS];
+    for (int i = 0; i < BENCHMARK_LOOKUPS; i++)
+    {
+        UINT32 ulAddress = RandomAddress();
+        if (0 == (i & 1))
+        {
+            int j = RandomINT32(0, nSubnets - 1);
+            UINT32 ulMask = (32 == aBits[j]) ? 0xFFFFFFFFUL : ~(0xFFFFFFFFUL >> aBits[j]);
+            ulAddress = aBase[j] | (ulAddress & ~ulMask);
+        }
+        mux_in_addr ia(ulAddress);
+        aAddresses[i].SetAddress(&ia);
+    }
+
+    INT64 tInsert, tLookup, tScan;
+    int nFound = 0;
+    int nScanFound = 0;
+    int nDisagree = 0;
+    {
+        mux_subnets trie;
+        CLinearTimeAbsolute ltaBegin, ltaEnd;
+        ltaBegin.GetUTC();
+        for (int i = 0; i < nSubnets; i++)
+        {
+            trie.forbid(BenchmarkSubnet(player, aBase[i], aBits[i]));
+        }
+        ltaEnd.GetUTC();
+        tInsert = (ltaEnd - ltaBegin).Return100ns();
+
+        ltaBegin.GetUTC();
+        for (int i = 0; i < BENCHMARK_LOOKUPS; i++)
+        {
+            if (trie.isForbid(&aAddresses[i]))
+            {
+                nFound++;
+            }
+        }
+        ltaEnd.GetUTC();
+        tLookup = (ltaEnd - ltaBegin).Return100ns();
+
+        ltaBegin.GetUTC();
+        for (int i = 0; i < BENCHMARK_SCANS; i++)
+        {
+            bool fFound = false;
+            for (int j = 0; j < nSubnets && !fFound; j++)
+            {
+                fFound = (mux_subnet::kContains == aSubnets[j]->CompareTo(&aAddresses[i]));
+            }
+            if (fFound)
+            {
+                nScanFound++;
+            }
+            if (fFound != trie.isForbid(&aAddresses[i]))
+            {
+                nDisagree++;
+            }
+        }
+        ltaEnd.GetUTC();
+        tScan = (ltaEnd - ltaBegin).Return100ns();
+    }
+
+    notify(player, tprintf(T("Benchmark of %d subnets in nanoseconds per operation:"), nSubnets));
+    notify(player, T("              Insert   Lookup  Matched"));
+    notify(player, tprintf(T("Trie        %8d %8d %7d%%"), (int)((100 * tInsert) / nSubnets),
+        (int)((100 * tLookup) / BENCHMARK_LOOKUPS), (100 * nFound) / BENCHMARK_LOOKUPS));
+    notify(player, tprintf(T("Scan               - %8d %7d%% %s"),
+        (int)((100 * tScan) / BENCHMARK_SCANS), (100 * nScanFound) / BENCHMARK_SCANS,
+        nDisagree ? T("DISAGREES") : T("")));
+
+    delete [] aAddresses;
+    for (int i = 0; i < nSubnets; i++)
+    {
+        delete aSubnets[i];
+    }
+    MEMFREE(aSubnets);
+    MEMFREE(aBits);
+    MEMFREE(aBase);
+}
+#endif // HAVE_IN_ADDR
+
 /* ---------------------------------------------------------------------------
  * list_siteinfo: List information about specially-marked sites.
  */
 
-void list_siteinfo(dbref player)
+void list_siteinfo(dbref player, UTF8 *pCount)
 {
     mudstate.access_list.listinfo(player);
+#if defined(HAVE_IN_ADDR)
+    if (  NULL == pCount
+       || !is_integer(pCount, NULL))
+    {
+        return;
+    }
+
+    int nSubnets = mux_atol(pCount);
+    if (nSubnets <= 0)
+    {
+        return;
+    }
+    else if (BENCHMARK_MAX_SUBNETS < nSubnets)
+    {
+        nSubnets = BENCHMARK_MAX_SUBNETS;
+    }
+    BenchmarkSubnets(player, nSubnets);
+#else // HAVE_IN_ADDR
+    UNUSED_PARAMETER(pCount);
+#endif // HAVE_IN_ADDR
 }
 
 /* ---------------------------------------------------------------------------
@@ -3407,298 +3944,356 @@ CLinearTimeAbsolute fetch_logouttime(dbref target)
     return lta;
 }
 
+// Control codes come in groups.  Within a group, the more specific subnet
+// wins.
+//
+static const unsigned long aControlGroups[] =
+{
+    HC_PERMIT|HC_REGISTER|HC_FORBID,
+    HC_NOSITEMON|HC_SITEMON,
+    HC_NOGUEST|HC_GUEST,
+    HC_SUSPECT|HC_TRUST
+};
+
+static inline int subnet_bit(const unsigned char *aKey, int iBit)
+{
+    return (aKey[iBit >> 3] >> (7 - (iBit & 7))) & 1;
+}
+
+// Return the number of leading bits (up to nBits) which two keys share.
+//
+static int subnet_common(const unsigned char *aKey1, const unsigned char *aKey2, int nBits)
+{
+    int iBit = 0;
+    for (int i = 0; iBit < nBits; i++, iBit += 8)
+    {
+        unsigned char ch = aKey1[i] ^ aKey2[i];
+        if (0 != ch)
+        {
+            while (0 == (ch & 0x80))
+            {
+                ch <<= 1;
+                iBit++;
+            }
+            break;
+        }
+    }
+    return (iBit < nBits) ? iBit : nBits;
+}
+
+static int subnet_family(int family)
+{
+    switch (family)
+    {
+#if defined(HAVE_IN_ADDR)
+    case AF_INET:
+        return 0;
+#endif
+#if defined(HAVE_IN6_ADDR)
+    case AF_INET6:
+        return 1;
+#endif
+    }
+    return -1;
+}
+
 mux_subnets::mux_subnets()
 {
-    msnRoot = NULL;
+    msnRoot[0] = NULL;
+    msnRoot[1] = NULL;
 }
 
 mux_subnets::~mux_subnets()
 {
-    delete msnRoot;
+    delete msnRoot[0];
+    delete msnRoot[1];
 }
 
 mux_subnet_node::mux_subnet_node(mux_subnet *msn_arg, unsigned long ulControl_arg)
 {
     msn = msn_arg;
-    pnLeft = NULL;
-    pnInside = NULL;
-    pnRight = NULL;
+    pnChild[0] = NULL;
+    pnChild[1] = NULL;
+    memset(aKey, 0, sizeof(aKey));
+    nBits = 0;
+    if (NULL != msn)
+    {
+        msn->getKey(aKey);
+        nBits = msn->getLeadingBits();
+    }
     ulControl = ulControl_arg;
 }
 
 mux_subnet_node::~mux_subnet_node()
 {
     delete msn;
-    delete pnLeft;
-    delete pnInside;
-    delete pnRight;
+    delete pnChild[0];
+    delete pnChild[1];
 }
 
-void mux_subnets::insert(mux_subnet_node **msnRoot, mux_subnet_node *msn_arg)
+bool mux_subnets::insert(mux_subnet *msn_arg, unsigned long ulControl_arg)
 {
-    if (NULL == *msnRoot)
+    int iFamily = subnet_family(msn_arg->getFamily());
+    if (iFamily < 0)
     {
-        *msnRoot = msn_arg;
-        return;
+        delete msn_arg;
+        return false;
     }
 
-    mux_subnet::Comparison ct = (*msnRoot)->msn->CompareTo(msn_arg->msn);
-    switch (ct)
+    mux_subnet_node *pnNew = new mux_subnet_node(msn_arg, ulControl_arg);
+    mux_subnet_node **pp = &msnRoot[iFamily];
+    for (;;)
     {
-    case mux_subnet::kLessThan:
-        insert(&(*msnRoot)->pnRight, msn_arg);
-        break;
-
-    case mux_subnet::kEqual:
-        if (0 != ((HC_PERMIT|HC_REGISTER|HC_FORBID) & msn_arg->ulControl))
+        mux_subnet_node *p = *pp;
+        if (NULL == p)
         {
-            (*msnRoot)->ulControl &= ~(HC_PERMIT|HC_REGISTER|HC_FORBID);
-            (*msnRoot)->ulControl |= (msn_arg->ulControl) & (HC_PERMIT|HC_REGISTER|HC_FORBID);
+            *pp = pnNew;
+            return true;
         }
 
-        if (0 != ((HC_NOSITEMON|HC_SITEMON) & msn_arg->ulControl))
+        int nShorter = (p->nBits < pnNew->nBits) ? p->nBits : pnNew->nBits;
+        int nCommon = subnet_common(p->aKey, pnNew->aKey, nShorter);
+        if (nCommon < p->nBits)
         {
-            (*msnRoot)->ulControl &= ~(HC_NOSITEMON|HC_SITEMON);
-            (*msnRoot)->ulControl |= (msn_arg->ulControl) & ~(HC_NOSITEMON|HC_SITEMON);
+            if (nCommon == pnNew->nBits)
+            {
+                // The new subnet contains this one.
+                //
+                pnNew->pnChild[subnet_bit(p->aKey, nCommon)] = p;
+                *pp = pnNew;
+            }
+            else
+            {
+                // The two diverge.  Join them under a branch.
+                //
+                mux_subnet_node *pnBranch = new mux_subnet_node(NULL, 0);
+                memcpy(pnBranch->aKey, pnNew->aKey, sizeof(pnBranch->aKey));
+                pnBranch->nBits = nCommon;
+                pnBranch->pnChild[subnet_bit(pnNew->aKey, nCommon)] = pnNew;
+                pnBranch->pnChild[subnet_bit(p->aKey, nCommon)] = p;
+                *pp = pnBranch;
+            }
+            return true;
         }
 
-        if (0 != ((HC_NOGUEST|HC_GUEST) & msn_arg->ulControl))
+        if (p->nBits == pnNew->nBits)
         {
-            (*msnRoot)->ulControl &= ~(HC_NOGUEST|HC_GUEST);
-            (*msnRoot)->ulControl |= (msn_arg->ulControl) & ~(HC_NOGUEST|HC_GUEST);
+            // Same subnet.  The new control codes replace the old ones in
+            // their groups.
+            //
+            if (NULL == p->msn)
+            {
+                p->msn = pnNew->msn;
+                pnNew->msn = NULL;
+            }
+            for (size_t i = 0; i < sizeof(aControlGroups)/sizeof(aControlGroups[0]); i++)
+            {
+                if (0 != (aControlGroups[i] & ulControl_arg))
+                {
+                    p->ulControl &= ~aControlGroups[i];
+                    p->ulControl |= aControlGroups[i] & ulControl_arg;
+                }
+            }
+            delete pnNew;
+            return true;
         }
+        pp = &p->pnChild[subnet_bit(pnNew->aKey, p->nBits)];
+    }
+}
+
+// Visit the subnets containing the address from the widest to the narrowest
+// so that narrower subnets override wider ones.
+//
+unsigned long mux_subnets::search(MUX_SOCKADDR *msa)
+{
+    unsigned long ulInfo = HI_PERMIT;
 
-        if (0 != ((HC_SUSPECT|HC_TRUST) & msn_arg->ulControl))
+    unsigned char aKey[SUBNET_KEY_SIZE];
+    int nKeyBits;
+    mux_subnet_node *p;
+    switch (msa->Family())
+    {
+#if defined(HAVE_IN_ADDR)
+    case AF_INET:
         {
-            (*msnRoot)->ulControl &= ~(HC_SUSPECT|HC_TRUST);
-            (*msnRoot)->ulControl |= (msn_arg->ulControl) & ~(HC_SUSPECT|HC_TRUST);
+            struct in_addr ia;
+            msa->GetAddress(&ia);
+            memcpy(aKey, &ia.s_addr, sizeof(ia.s_addr));
+            nKeyBits = 32;
+            p = msnRoot[0];
         }
-
-        delete msn_arg;
-        break;
-
-    case mux_subnet::kContains:
-        insert(&(*msnRoot)->pnInside, msn_arg);
         break;
+#endif
 
-    case mux_subnet::kContainedBy:
+#if defined(HAVE_IN6_ADDR)
+    case AF_INET6:
         {
-            msn_arg->pnInside = *msnRoot;
-            msn_arg->pnLeft = (*msnRoot)->pnLeft;
-            msn_arg->pnRight = (*msnRoot)->pnRight;
-            (*msnRoot)->pnLeft = NULL;
-            (*msnRoot)->pnRight = NULL;
-            *msnRoot = msn_arg;
+            struct in6_addr ia6;
+            msa->GetAddress(&ia6);
+            memcpy(aKey, ia6.s6_addr, sizeof(ia6.s6_addr));
+            nKeyBits = 128;
+            p = msnRoot[1];
         }
         break;
+#endif
 
-    case mux_subnet::kGreaterThan:
-        insert(&(*msnRoot)->pnLeft, msn_arg);
-        break;
-    }
-}
-
-void mux_subnets::search(mux_subnet_node *msnRoot, MUX_SOCKADDR *msa, unsigned long *pulInfo)
-{
-    if (NULL == msnRoot)
-    {
-        return;
+    default:
+        return ulInfo;
     }
 
-    mux_subnet::Comparison ct = msnRoot->msn->CompareTo(msa);
-    switch (ct)
+    while (  NULL != p
+          && p->nBits <= nKeyBits
+          && subnet_common(p->aKey, aKey, p->nBits) == p->nBits)
     {
-    case mux_subnet::kLessThan:
-        search(msnRoot->pnRight, msa, pulInfo);
-        break;
-
-    case mux_subnet::kContains:
-        if (HC_PERMIT & msnRoot->ulControl)
-        {
-            *pulInfo &= ~(HI_REGISTER|HI_FORBID);
-        }
-        else if (HC_REGISTER & msnRoot->ulControl)
-        {
-            *pulInfo |= HI_REGISTER;
-        }
-        else if (HC_FORBID & msnRoot->ulControl)
+        if (NULL != p->msn)
         {
-            *pulInfo |= HI_FORBID;
-        }
+            if (HC_PERMIT & p->ulControl)
+            {
+                ulInfo &= ~(HI_REGISTER|HI_FORBID);
+            }
+            else if (HC_REGISTER & p->ulControl)
+            {
+                ulInfo |= HI_REGISTER;
+            }
+            else if (HC_FORBID & p->ulControl)
+            {
+                ulInfo |= HI_FORBID;
+            }
 
-        if (HC_NOSITEMON & msnRoot->ulControl)
-        {
-            *pulInfo |= HI_NOSITEMON;
-        }
-        else if (HC_SITEMON & msnRoot->ulControl)
-        {
-            *pulInfo &= ~(HI_NOSITEMON);
-        }
+            if (HC_NOSITEMON & p->ulControl)
+            {
+                ulInfo |= HI_NOSITEMON;
+            }
+            else if (HC_SITEMON & p->ulControl)
+            {
+                ulInfo &= ~(HI_NOSITEMON);
+            }
 
-        if (HC_NOGUEST & msnRoot->ulControl)
-        {
-            *pulInfo |= HI_NOGUEST;
-        }
-        else if (HC_GUEST & msnRoot->ulControl)
-        {
-            *pulInfo &= ~(HI_NOGUEST);
-        }
+            if (HC_NOGUEST & p->ulControl)
+            {
+                ulInfo |= HI_NOGUEST;
+            }
+            else if (HC_GUEST & p->ulControl)
+            {
+                ulInfo &= ~(HI_NOGUEST);
+            }
 
-        if (HC_SUSPECT & msnRoot->ulControl)
-        {
-            *pulInfo |= HI_SUSPECT;
+            if (HC_SUSPECT & p->ulControl)
+            {
+                ulInfo |= HI_SUSPECT;
+            }
+            else if (HC_TRUST & p->ulControl)
+            {
+                ulInfo &= ~(HI_SUSPECT);
+            }
         }
-        else if (HC_TRUST & msnRoot->ulControl)
+
+        if (p->nBits == nKeyBits)
         {
-            *pulInfo &= ~(HI_SUSPECT);
+            break;
         }
-
-        search(msnRoot->pnInside, msa, pulInfo);
-        break;
-
-    case mux_subnet::kGreaterThan:
-        search(msnRoot->pnLeft, msa, pulInfo);
-        break;
-
-    default:
-        break;
+        p = p->pnChild[subnet_bit(aKey, p->nBits)];
     }
+    return ulInfo;
 }
 
-mux_subnet_node *mux_subnets::rotr(mux_subnet_node *msnRoot)
-{
-    mux_subnet_node *x = msnRoot->pnLeft;
-    msnRoot->pnLeft = x->pnRight;
-    x->pnRight = msnRoot;
-    return x;
-}
-
-mux_subnet_node *mux_subnets::rollallr(mux_subnet_node *msnRoot)
+// Remove the given subnet and every subnet inside it.  Branches left with
+// fewer than two children are folded away.
+//
+mux_subnet_node *mux_subnets::remove(mux_subnet_node *p, const unsigned char *aKey, int nBits)
 {
-    if (NULL != msnRoot->pnLeft)
+    if (NULL == p)
     {
-        msnRoot->pnLeft = rollallr(msnRoot->pnLeft);
-        msnRoot = rotr(msnRoot);
+        return NULL;
     }
-    return msnRoot;
-}
 
-mux_subnet_node *mux_subnets::joinlr(mux_subnet_node *a, mux_subnet_node *b)
-{
-    if (NULL == b)
+    if (nBits <= p->nBits)
     {
-        return a;
+        if (subnet_common(p->aKey, aKey, nBits) == nBits)
+        {
+            delete p;
+            return NULL;
+        }
+        return p;
     }
-    b = rollallr(b);
-    b->pnLeft = a;
-    return b;
-}
 
-mux_subnet_node *mux_subnets::remove(mux_subnet_node *msnRoot, mux_subnet *msn_arg)
-{
-    if (NULL == msnRoot)
+    if (subnet_common(p->aKey, aKey, p->nBits) < p->nBits)
     {
-        return NULL;
+        return p;
     }
-    mux_subnet::Comparison ct = msnRoot->msn->CompareTo(msn_arg);
-    switch (ct)
-    {
-    case mux_subnet::kLessThan:
-        msnRoot->pnRight = remove(msnRoot->pnRight, msn_arg);
-        break;
 
-    case mux_subnet::kEqual:
-        {
-            mux_subnet_node *x = msnRoot;
-            delete msnRoot->pnInside;
-            msnRoot->pnInside = NULL;
-            msnRoot = joinlr(msnRoot->pnLeft, msnRoot->pnRight);
-            delete x;
-        }
-        break;
+    int i = subnet_bit(aKey, p->nBits);
+    p->pnChild[i] = remove(p->pnChild[i], aKey, nBits);
 
-    case mux_subnet::kContains:
-        msnRoot->pnInside = remove(msnRoot->pnInside, msn_arg);
-        break;
-
-    case mux_subnet::kContainedBy:
-        delete msnRoot;
-        msnRoot = NULL;
-        break;
-
-    case mux_subnet::kGreaterThan:
-        msnRoot->pnLeft = remove(msnRoot->pnLeft, msn_arg);
-        break;
+    if (  NULL == p->msn
+       && (  NULL == p->pnChild[0]
+          || NULL == p->pnChild[1]))
+    {
+        mux_subnet_node *pnOnly = (NULL == p->pnChild[0]) ? p->pnChild[1] : p->pnChild[0];
+        p->pnChild[0] = NULL;
+        p->pnChild[1] = NULL;
+        delete p;
+        return pnOnly;
     }
-    return msnRoot;
+    return p;
 }
 
 bool mux_subnets::permit(mux_subnet *msn_arg)
 {
-    mux_subnet_node *msn = new mux_subnet_node(msn_arg, HC_PERMIT);
-    insert(&msnRoot, msn);
-    return true;
+    return insert(msn_arg, HC_PERMIT);
 }
 
 bool mux_subnets::registered(mux_subnet *msn_arg)
 {
-    mux_subnet_node *msn = new mux_subnet_node(msn_arg, HC_REGISTER);
-    insert(&msnRoot, msn);
-    return true;
+    return insert(msn_arg, HC_REGISTER);
 }
 
 bool mux_subnets::forbid(mux_subnet *msn_arg)
 {
-    mux_subnet_node *msn = new mux_subnet_node(msn_arg, HC_FORBID);
-    insert(&msnRoot, msn);
-    return true;
+    return insert(msn_arg, HC_FORBID);
 }
 
 bool mux_subnets::nositemon(mux_subnet *msn_arg)
 {
-    mux_subnet_node *msn = new mux_subnet_node(msn_arg, HC_NOSITEMON);
-    insert(&msnRoot, msn);
-    return true;
+    return insert(msn_arg, HC_NOSITEMON);
 }
 
 bool mux_subnets::sitemon(mux_subnet *msn_arg)
 {
-    mux_subnet_node *msn = new mux_subnet_node(msn_arg, HC_SITEMON);
-    insert(&msnRoot, msn);
-    return true;
+    return insert(msn_arg, HC_SITEMON);
 }
 
 bool mux_subnets::noguest(mux_subnet *msn_arg)
 {
-    mux_subnet_node *msn = new mux_subnet_node(msn_arg, HC_NOGUEST);
-    insert(&msnRoot, msn);
-    return true;
+    return insert(msn_arg, HC_NOGUEST);
 }
 
 bool mux_subnets::guest(mux_subnet *msn_arg)
 {
-    mux_subnet_node *msn = new mux_subnet_node(msn_arg, HC_GUEST);
-    insert(&msnRoot, msn);
-    return true;
+    return insert(msn_arg, HC_GUEST);
 }
 
 bool mux_subnets::suspect(mux_subnet *msn_arg)
 {
-    mux_subnet_node *msn = new mux_subnet_node(msn_arg, HC_SUSPECT);
-    insert(&msnRoot, msn);
-    return true;
+    return insert(msn_arg, HC_SUSPECT);
 }
 
 bool mux_subnets::trust(mux_subnet *msn_arg)
 {
-    mux_subnet_node *msn = new mux_subnet_node(msn_arg, HC_TRUST);
-    insert(&msnRoot, msn);
-    return true;
+    return insert(msn_arg, HC_TRUST);
 }
 
 bool mux_subnets::reset(mux_subnet *msn_arg)
 {
-    mux_subnet_node *msn = remove(msnRoot, msn_arg);
+    int iFamily = subnet_family(msn_arg->getFamily());
+    if (0 <= iFamily)
+    {
+        unsigned char aKey[SUBNET_KEY_SIZE];
+        memset(aKey, 0, sizeof(aKey));
+        msn_arg->getKey(aKey);
+        msnRoot[iFamily] = remove(msnRoot[iFamily], aKey, msn_arg->getLeadingBits());
+    }
+    delete msn_arg;
     return true;
 }
 
@@ -3725,14 +4320,20 @@ void mux_subnets::listinfo(dbref player, UTF8 *sLine, UTF8 *sAddress, UTF8 *sCon
     {
         return;
     }
-    listinfo(player, sLine, sAddress, sControl, p->pnLeft);
+
+    if (NULL == p->msn)
+    {
+        listinfo(player, sLine, sAddress, sControl, p->pnChild[0]);
+        listinfo(player, sLine, sAddress, sControl, p->pnChild[1]);
+        return;
+    }
 
     int nLeadingBits;
     p->msn->listinfo(sLine, &nLeadingBits);
 
     bool fFirst = true;
     UTF8* bufc = sControl;
-    for (int i = 0; i < sizeof(access_keywords)/sizeof(access_keywords[0]); i++)
+    for (size_t i = 0; i < sizeof(access_keywords)/sizeof(access_keywords[0]); i++)
     {
         if (p->ulControl & access_keywords[i].m)
         {
@@ -3754,8 +4355,8 @@ void mux_subnets::listinfo(dbref player, UTF8 *sLine, UTF8 *sAddress, UTF8 *sCon
     mux_sprintf(sLine, LBUF_SIZE, T("%-50s %s"), sAddress, sControl);
     notify(player, sLine);
 
-    listinfo(player, sLine, sAddress, sControl, p->pnInside);
-    listinfo(player, sLine, sAddress, sControl, p->pnRight);
+    listinfo(player, sLine, sAddress, sControl, p->pnChild[0]);
+    listinfo(player, sLine, sAddress, sControl, p->pnChild[1]);
 }
 
 void mux_subnets::listinfo(dbref player)
@@ -3767,7 +4368,8 @@ void mux_subnets::listinfo(dbref player)
     UTF8 *sControl = alloc_lbuf("list_sites.control");
     UTF8 *sLine = alloc_lbuf("list_sites.line");
 
-    listinfo(player, sLine, sAddress, sControl, msnRoot);
+    listinfo(player, sLine, sAddress, sControl, msnRoot[0]);
+    listinfo(player, sLine, sAddress, sControl, msnRoot[1]);
 
     free_lbuf(sLine);
     free_lbuf(sControl);
@@ -3776,28 +4378,20 @@ void mux_subnets::listinfo(dbref player)
 
 int mux_subnets::check(MUX_SOCKADDR *msa)
 {
-    unsigned long ulInfo = HI_PERMIT;
-    search(msnRoot, msa, &ulInfo);
-    return ulInfo;
+    return search(msa);
 }
 
 bool mux_subnets::isRegistered(MUX_SOCKADDR *msa)
 {
-    unsigned long ulInfo = HI_PERMIT;
-    search(msnRoot, msa, &ulInfo);
-    return 0 != (ulInfo & HI_REGISTER);
+    return 0 != (search(msa) & HI_REGISTER);
 }
 
 bool mux_subnets::isForbid(MUX_SOCKADDR *msa)
 {
-    unsigned long ulInfo = HI_PERMIT;
-    search(msnRoot, msa, &ulInfo);
-    return 0 != (ulInfo & HI_FORBID);
+    return 0 != (search(msa) & HI_FORBID);
 }
 
 bool mux_subnets::isSuspect(MUX_SOCKADDR *msa)
 {
-    unsigned long ulInfo = HI_PERMIT;
-    search(msnRoot, msa, &ulInfo);
-    return 0 != (ulInfo & HI_SUSPECT);
+    return 0 != (search(msa) & HI_SUSPECT);
 }
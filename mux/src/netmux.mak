@@ -79,6 +79,7 @@ CLEAN :
 	-@erase "$(INTDIR)\player_c.obj"
 	-@erase "$(INTDIR)\plusemail.obj"
 	-@erase "$(INTDIR)\powers.obj"
+	-@erase "$(INTDIR)\profile.obj"
 	-@erase "$(INTDIR)\predicates.obj"
 	-@erase "$(INTDIR)\quota.obj"
 	-@erase "$(INTDIR)\rob.obj"
@@ -172,6 +173,7 @@ LINK32_OBJS= \
 	"$(INTDIR)\player_c.obj" \
 	"$(INTDIR)\plusemail.obj" \
 	"$(INTDIR)\powers.obj" \
+	"$(INTDIR)\profile.obj" \
 	"$(INTDIR)\predicates.obj" \
 	"$(INTDIR)\quota.obj" \
 	"$(INTDIR)\rob.obj" \
@@ -255,6 +257,7 @@ CLEAN :
 	-@erase "$(INTDIR)\player_c.obj"
 	-@erase "$(INTDIR)\plusemail.obj"
 	-@erase "$(INTDIR)\powers.obj"
+	-@erase "$(INTDIR)\profile.obj"
 	-@erase "$(INTDIR)\predicates.obj"
 	-@erase "$(INTDIR)\quota.obj"
 	-@erase "$(INTDIR)\rob.obj"
@@ -353,6 +356,7 @@ LINK32_OBJS= \
 	"$(INTDIR)\player_c.obj" \
 	"$(INTDIR)\plusemail.obj" \
 	"$(INTDIR)\powers.obj" \
+	"$(INTDIR)\profile.obj" \
 	"$(INTDIR)\predicates.obj" \
 	"$(INTDIR)\quota.obj" \
 	"$(INTDIR)\rob.obj" \
@@ -601,6 +605,11 @@ SOURCE=.\powers.cpp
 "$(INTDIR)\powers.obj": $(SOURCE) "$(INTDIR)"
 
 
+SOURCE=.\profile.cpp
+
+"$(INTDIR)\profile.obj": $(SOURCE) "$(INTDIR)"
+
+
 SOURCE=.\predicates.cpp
 
 "$(INTDIR)\predicates.obj": $(SOURCE) "$(INTDIR)"
@@ -888,6 +888,7 @@ static void purge_going(void)
                 }
                 log_text(T("GOING object doesn\xE2\x80\x99t remember its destroyer. GOING reset."));
                 ENDLOG;
+                s_Dirty(i);
                 db[i].fs.word[FLAG_WORD1] &= ~GOING;
             }
             else
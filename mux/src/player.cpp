@@ -24,6 +24,9 @@
 #else
 #include "sha1.h"
 #endif
+#if defined(HAVE_CRYPT_H)
+#include <crypt.h>
+#endif // HAVE_CRYPT_H
 
 #define NUM_GOOD    4   // # of successful logins to save data for.
 #define NUM_BAD     3   // # of failed logins to save data for.
@@ -400,30 +403,28 @@ static const UTF8 *GenerateSalt(int iType)
     return szSalt;
 }
 
-void ChangePassword(dbref player, const UTF8 *szPassword)
+// Everything a password hash is computed into.  The game thread and each
+// password thread have their own.
+//
+typedef struct crypt_state
 {
-    int iTypeOut;
-    const UTF8 *pEncodedPassword = NULL;
-    int methods[] = { CRYPT_SHA512, CRYPT_SHA256, CRYPT_MD5, CRYPT_SHA1, CRYPT_DES };
-    for (size_t i = 0; i < sizeof(methods)/sizeof(methods[0]); i++)
-    {
-        if (  (mudconf.password_methods & methods[i])
-           && NULL != (pEncodedPassword = mux_crypt(szPassword, GenerateSalt(methods[i]), &iTypeOut)))
-        {
-            break;
-        }
-    }
+    UTF8 aBuffer[LBUF_SIZE];
+#if defined(HAVE_CRYPT) && defined(HAVE_CRYPT_R)
+    struct crypt_data cd;
+#endif
+} CRYPT_STATE;
 
-    if (NULL == pEncodedPassword)
-    {
-        pEncodedPassword = mux_crypt(szPassword, GenerateSalt(CRYPT_SHA1), &iTypeOut);
-        mux_assert(NULL != pEncodedPassword);
-    }
-    s_Pass(player, pEncodedPassword);
+static void crypt_state_init(CRYPT_STATE *pcs)
+{
+    memset(pcs, 0, sizeof(CRYPT_STATE));
 }
 
+#if defined(HAVE_CRYPT) && !defined(HAVE_CRYPT_R) && defined(UNIX_THREADS)
+static pthread_mutex_t mtxCrypt = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 #ifdef UNIX_DIGEST
-const UTF8 *p6h_xx_crypt(const UTF8 *szPassword)
+static const UTF8 *p6h_xx_crypt(const UTF8 *szPassword, CRYPT_STATE *pcs)
 {
     // Calculate SHA-0 Hash.
     //
@@ -437,7 +438,7 @@ const UTF8 *p6h_xx_crypt(const UTF8 *szPassword)
     // 1234567890123456789012345678
     // $P6H$$XXhhhhhhhhhhhhhhhhhhhh
     //
-    static UTF8 buf[P6H_PREFIX_LENGTH + 1 + P6H_XX_HASH_LENGTH_MAX + 1 + 16];
+    UTF8 *buf = pcs->aBuffer;
     mux_strncpy(buf, szP6HPrefix, P6H_PREFIX_LENGTH);
     buf[P6H_PREFIX_LENGTH] = '$';
 
@@ -456,7 +457,7 @@ const UTF8 *p6h_xx_crypt(const UTF8 *szPassword)
 }
 #endif
 
-const UTF8 *p6h_vaht_crypt(const UTF8 *szPassword, const UTF8 *szSetting)
+static const UTF8 *p6h_vaht_crypt(const UTF8 *szPassword, const UTF8 *szSetting, CRYPT_STATE *pcs)
 {
     size_t nSetting = strlen((char *)szSetting);
     if (  P6H_VAHT_1SHA1_PREFIX_LENGTH <= nSetting
@@ -474,7 +475,7 @@ const UTF8 *p6h_vaht_crypt(const UTF8 *szPassword, const UTF8 *szSetting)
         // 123456789012345678901234567890123456789012345678901234567890123456
         // $P6H$$1:sha1:hhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhh:tttttttttttt
         //
-        static UTF8 buff[LBUF_SIZE];
+        UTF8 *buff = pcs->aBuffer;
         UTF8 *bufc = buff;
 
         safe_str(szP6HPrefix1SHA1, buff, &bufc);
@@ -492,7 +493,7 @@ const UTF8 *p6h_vaht_crypt(const UTF8 *szPassword, const UTF8 *szSetting)
 // build.  To convert these, using #1 to @newpassword, go through an older
 // version of TinyMUX, or go through a Unix host.
 //
-const UTF8 *mux_crypt(const UTF8 *szPassword, const UTF8 *szSetting, int *piType)
+static const UTF8 *mux_crypt_r(const UTF8 *szPassword, const UTF8 *szSetting, int *piType, CRYPT_STATE *pcs)
 {
     const UTF8 *pSaltField = NULL;
     size_t nSaltField = 0;
@@ -600,10 +601,10 @@ const UTF8 *mux_crypt(const UTF8 *szPassword, const UTF8 *szSetting, int *piType
 
 #ifdef UNIX_DIGEST
     case CRYPT_P6H_XX:
-        return p6h_xx_crypt(szPassword);
+        return p6h_xx_crypt(szPassword, pcs);
 #endif
     case CRYPT_P6H_VAHT:
-        return p6h_vaht_crypt(szPassword, szSetting);
+        return p6h_vaht_crypt(szPassword, szSetting, pcs);
 
     case CRYPT_OTHER:
     case CRYPT_DES_EXT:
@@ -618,7 +619,30 @@ const UTF8 *mux_crypt(const UTF8 *szPassword, const UTF8 *szSetting, int *piType
 
     case CRYPT_DES:
 #if defined(HAVE_CRYPT)
-        return (UTF8 *)crypt((char *)szPassword, (char *)szSetting);
+#if defined(HAVE_CRYPT_R)
+        {
+            const char *p = crypt_r((char *)szPassword, (char *)szSetting, &pcs->cd);
+            return (NULL == p) ? szFail : (UTF8 *)p;
+        }
+#else
+        {
+            // crypt() is not reentrant.
+            //
+#if defined(UNIX_THREADS)
+            pthread_mutex_lock(&mtxCrypt);
+#endif // UNIX_THREADS
+            const char *p = crypt((char *)szPassword, (char *)szSetting);
+            if (NULL == p)
+            {
+                p = (const char *)szFail;
+            }
+            mux_strncpy(pcs->aBuffer, (const UTF8 *)p, LBUF_SIZE-1);
+#if defined(UNIX_THREADS)
+            pthread_mutex_unlock(&mtxCrypt);
+#endif // UNIX_THREADS
+            return pcs->aBuffer;
+        }
+#endif // HAVE_CRYPT_R
 #else
         return szFail;
 #endif
@@ -638,7 +662,7 @@ const UTF8 *mux_crypt(const UTF8 *szPassword, const UTF8 *szSetting, int *piType
     // 12345678901234567890123456789012345678901234567
     // $SHA1$ssssssssssss$hhhhhhhhhhhhhhhhhhhhhhhhhhhh
     //
-    static UTF8 buf[SHA1_PREFIX_LENGTH + SHA1_ENCODED_SALT_LENGTH + 1 + SHA1_ENCODED_HASH_LENGTH + 1 + 16];
+    UTF8 *buf = pcs->aBuffer;
     mux_strncpy(buf, szSHA1Prefix, SHA1_PREFIX_LENGTH);
     memcpy(buf + SHA1_PREFIX_LENGTH, pSaltField, nSaltField);
     buf[SHA1_PREFIX_LENGTH + nSaltField] = '$';
@@ -646,6 +670,530 @@ const UTF8 *mux_crypt(const UTF8 *szPassword, const UTF8 *szSetting, int *piType
     return buf;
 }
 
+const UTF8 *mux_crypt(const UTF8 *szPassword, const UTF8 *szSetting, int *piType)
+{
+    static CRYPT_STATE cs;
+    return mux_crypt_r(szPassword, szSetting, piType, &cs);
+}
+
+// ---------------------------------------------------------------------------
+// Password threads.
+//
+// Hashing a password is meant to be expensive, so the password checks made
+// for logins and the hashing done by ChangePassword() are handed to a small
+// pool of threads.  The game thread generates salts, compares the results
+// against A_PASS, and stores new hashes.  Because a result is compared with
+// A_PASS as it stands when the result comes back, a password which changes
+// in the meantime is never matched against a stale hash.
+//
+#define PJ_CHECK  0
+#define PJ_CHANGE 1
+
+typedef struct pass_job PASS_JOB;
+struct pass_job
+{
+    PASS_JOB   *pNext;          // Work, done, or held list.
+    PASS_JOB   *pAllNext;       // Every job not yet finished.
+    int         iKind;
+    dbref       player;
+    UTF8       *pPassword;
+    UTF8       *pSetting;       // Stored hash to check, or salt to use.
+    int         iMethod;        // Next method for PJ_CHANGE to try.
+    int         iType;
+    bool        bSuperseded;    // A later ChangePassword() replaces this.
+    void       *pContext;
+    FPASSCHECK *pfDone;         // NULL if nobody is waiting any longer.
+    UTF8        aResult[LBUF_SIZE];
+};
+
+static const int aPassMethods[] = { CRYPT_SHA512, CRYPT_SHA256, CRYPT_MD5, CRYPT_SHA1, CRYPT_DES };
+#define NUM_PASS_METHODS (sizeof(aPassMethods)/sizeof(aPassMethods[0]))
+
+static PASS_JOB *pPassAll  = NULL;
+static PASS_JOB *pPassHeld = NULL;
+static int  nPassInFlight  = 0;
+static bool bPassTaskScheduled = false;
+
+#if defined(UNIX_THREADS)
+static pthread_mutex_t mtxPassJobs = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cvPassWork  = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  cvPassDone  = PTHREAD_COND_INITIALIZER;
+static PASS_JOB *pPassWorkHead = NULL;
+static PASS_JOB *pPassWorkTail = NULL;
+static PASS_JOB *pPassDone     = NULL;
+static int nPassThreads = 0;
+#endif // UNIX_THREADS
+
+static void pass_job_submit(PASS_JOB *pJob);
+
+static void pass_job_hash(PASS_JOB *pJob, CRYPT_STATE *pcs)
+{
+    const UTF8 *p = mux_crypt_r(pJob->pPassword, pJob->pSetting, &pJob->iType, pcs);
+    mux_strncpy(pJob->aResult, p, sizeof(pJob->aResult)-1);
+}
+
+static PASS_JOB *pass_job_alloc(int iKind, dbref player, const UTF8 *pPassword, const UTF8 *pSetting)
+{
+    PASS_JOB *pJob = (PASS_JOB *)MEMALLOC(sizeof(PASS_JOB));
+    ISOUTOFMEMORY(pJob);
+    pJob->pNext       = NULL;
+    pJob->iKind       = iKind;
+    pJob->player      = player;
+    pJob->pPassword   = StringClone(pPassword);
+    pJob->pSetting    = StringClone(pSetting);
+    pJob->iMethod     = 0;
+    pJob->iType       = CRYPT_FAIL;
+    pJob->bSuperseded = false;
+    pJob->pContext    = NULL;
+    pJob->pfDone      = NULL;
+    pJob->aResult[0]  = '\0';
+
+    pJob->pAllNext = pPassAll;
+    pPassAll = pJob;
+    return pJob;
+}
+
+static void pass_job_set_setting(PASS_JOB *pJob, const UTF8 *pSetting)
+{
+    MEMFREE(pJob->pSetting);
+    pJob->pSetting = StringClone(pSetting);
+}
+
+static void pass_job_free(PASS_JOB *pJob)
+{
+    PASS_JOB **pp = &pPassAll;
+    while (*pp != pJob)
+    {
+        pp = &(*pp)->pAllNext;
+    }
+    *pp = pJob->pAllNext;
+
+    // Don't leave passwords lying around in freed memory.
+    //
+    memset(pJob->pPassword, 0, strlen((char *)pJob->pPassword));
+    MEMFREE(pJob->pPassword);
+    MEMFREE(pJob->pSetting);
+    memset(pJob->aResult, 0, sizeof(pJob->aResult));
+    MEMFREE(pJob);
+}
+
+static bool pass_change_pending(dbref player)
+{
+    for (PASS_JOB *p = pPassAll; p; p = p->pAllNext)
+    {
+        if (  PJ_CHANGE == p->iKind
+           && !p->bSuperseded
+           && player == p->player)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Checks against a password which is still being hashed wait for it.
+//
+static void pass_check_submit(PASS_JOB *pJob)
+{
+    if (pass_change_pending(pJob->player))
+    {
+        pJob->pNext = pPassHeld;
+        pPassHeld = pJob;
+    }
+    else
+    {
+        pass_job_submit(pJob);
+    }
+}
+
+static void pass_release_held(void)
+{
+    PASS_JOB **pp = &pPassHeld;
+    while (NULL != *pp)
+    {
+        PASS_JOB *pJob = *pp;
+        if (pass_change_pending(pJob->player))
+        {
+            pp = &pJob->pNext;
+            continue;
+        }
+        *pp = pJob->pNext;
+        pJob->pNext = NULL;
+
+        int   aflags;
+        dbref aowner;
+        UTF8 *pTarget = atr_get("pass_release_held.1", pJob->player, A_PASS, &aowner, &aflags);
+        pass_job_set_setting(pJob, pTarget);
+        free_lbuf(pTarget);
+        pass_job_submit(pJob);
+    }
+}
+
+static void pass_check_finish(PASS_JOB *pJob)
+{
+    if (NULL == pJob->pfDone)
+    {
+        // The connection has gone away.
+        //
+        pass_job_free(pJob);
+        return;
+    }
+
+    dbref player = pJob->player;
+    bool bValidPass = false;
+    if (  Good_obj(player)
+       && isPlayer(player)
+       && !Going(player))
+    {
+        int   aflags;
+        dbref aowner;
+        UTF8 *pTarget = atr_get("pass_check_finish.1", player, A_PASS, &aowner, &aflags);
+        if (  strcmp((char *)pTarget, (char *)pJob->pSetting) != 0
+           || pass_change_pending(player))
+        {
+            // The password changed while it was being checked.  Check it
+            // again.
+            //
+            pass_job_set_setting(pJob, pTarget);
+            free_lbuf(pTarget);
+            pass_check_submit(pJob);
+            return;
+        }
+
+        if (  '\0' != pTarget[0]
+           && strcmp((char *)pJob->aResult, (char *)pTarget) == 0)
+        {
+            bValidPass = true;
+            if (0 == (pJob->iType & mudconf.password_methods))
+            {
+                ChangePassword(player, pJob->pPassword);
+            }
+        }
+        free_lbuf(pTarget);
+    }
+
+    FPASSCHECK *pfDone = pJob->pfDone;
+    void *pContext = pJob->pContext;
+    pass_job_free(pJob);
+    pfDone(pContext, player, bValidPass);
+}
+
+// Find the next requested method, starting with iMethod.  SHA1 is the last
+// resort.
+//
+static bool pass_change_salt(PASS_JOB *pJob)
+{
+    while (pJob->iMethod < (int)NUM_PASS_METHODS)
+    {
+        int iMethod = aPassMethods[pJob->iMethod++];
+        if (mudconf.password_methods & iMethod)
+        {
+            pass_job_set_setting(pJob, GenerateSalt(iMethod));
+            return true;
+        }
+    }
+    if (pJob->iMethod == (int)NUM_PASS_METHODS)
+    {
+        pJob->iMethod++;
+        pass_job_set_setting(pJob, GenerateSalt(CRYPT_SHA1));
+        return true;
+    }
+    return false;
+}
+
+static void pass_change_finish(PASS_JOB *pJob)
+{
+    if (  '\0' == pJob->aResult[0]
+       || strcmp((char *)pJob->aResult, (char *)szFail) == 0)
+    {
+        // This method is not available.  Try the next one.
+        //
+        if (pass_change_salt(pJob))
+        {
+            pass_job_submit(pJob);
+            return;
+        }
+    }
+    else if (  !pJob->bSuperseded
+            && Good_obj(pJob->player))
+    {
+        s_Pass(pJob->player, pJob->aResult);
+    }
+    pass_job_free(pJob);
+    pass_release_held();
+}
+
+static void pass_job_finish(PASS_JOB *pJob)
+{
+    if (PJ_CHECK == pJob->iKind)
+    {
+        pass_check_finish(pJob);
+    }
+    else
+    {
+        pass_change_finish(pJob);
+    }
+}
+
+#if defined(UNIX_THREADS)
+
+static void *pass_thread_proc(void *pArg)
+{
+    CRYPT_STATE *pcs = (CRYPT_STATE *)pArg;
+
+    pthread_mutex_lock(&mtxPassJobs);
+    for (;;)
+    {
+        while (NULL == pPassWorkHead)
+        {
+            pthread_cond_wait(&cvPassWork, &mtxPassJobs);
+        }
+        PASS_JOB *pJob = pPassWorkHead;
+        pPassWorkHead = pJob->pNext;
+        if (NULL == pPassWorkHead)
+        {
+            pPassWorkTail = NULL;
+        }
+        pthread_mutex_unlock(&mtxPassJobs);
+
+        pass_job_hash(pJob, pcs);
+
+        pthread_mutex_lock(&mtxPassJobs);
+        pJob->pNext = pPassDone;
+        pPassDone = pJob;
+        pthread_cond_broadcast(&cvPassDone);
+    }
+    return NULL;
+}
+
+static bool pass_threads_start(void)
+{
+    while (nPassThreads < mudconf.password_threads)
+    {
+        CRYPT_STATE *pcs = (CRYPT_STATE *)MEMALLOC(sizeof(CRYPT_STATE));
+        ISOUTOFMEMORY(pcs);
+        crypt_state_init(pcs);
+
+        // Signals are handled by the game thread only.
+        //
+        pthread_t th;
+        sigset_t sigAll, sigSaved;
+        sigfillset(&sigAll);
+        pthread_sigmask(SIG_SETMASK, &sigAll, &sigSaved);
+        int cc = pthread_create(&th, NULL, pass_thread_proc, pcs);
+        pthread_sigmask(SIG_SETMASK, &sigSaved, NULL);
+        if (0 != cc)
+        {
+            MEMFREE(pcs);
+            break;
+        }
+        pthread_detach(th);
+        nPassThreads++;
+    }
+    return (0 < nPassThreads);
+}
+
+// Finish the jobs which have come back from the password threads.
+//
+static void pass_jobs_reap(void)
+{
+    pthread_mutex_lock(&mtxPassJobs);
+    PASS_JOB *pJob = pPassDone;
+    pPassDone = NULL;
+    pthread_mutex_unlock(&mtxPassJobs);
+
+    while (NULL != pJob)
+    {
+        PASS_JOB *pNext = pJob->pNext;
+        pJob->pNext = NULL;
+        nPassInFlight--;
+        pass_job_finish(pJob);
+        pJob = pNext;
+    }
+}
+
+// Wait for a player's own password change to be stored.  Other finished
+// jobs are left for Task_PassJobs so nothing else runs from here.
+//
+static void pass_change_wait(dbref player)
+{
+    while (pass_change_pending(player))
+    {
+        pthread_mutex_lock(&mtxPassJobs);
+        PASS_JOB **pp = &pPassDone;
+        while (  NULL != *pp
+              && PJ_CHANGE != (*pp)->iKind)
+        {
+            pp = &(*pp)->pNext;
+        }
+        if (NULL == *pp)
+        {
+            pthread_cond_wait(&cvPassDone, &mtxPassJobs);
+            pthread_mutex_unlock(&mtxPassJobs);
+            continue;
+        }
+        PASS_JOB *pJob = *pp;
+        *pp = pJob->pNext;
+        pthread_mutex_unlock(&mtxPassJobs);
+
+        pJob->pNext = NULL;
+        nPassInFlight--;
+        pass_change_finish(pJob);
+    }
+}
+
+void Task_PassJobs(void *pUnused, int iUnused)
+{
+    UNUSED_PARAMETER(pUnused);
+    UNUSED_PARAMETER(iUnused);
+
+    bPassTaskScheduled = false;
+    pass_jobs_reap();
+    if (  0 < nPassInFlight
+       && !bPassTaskScheduled)
+    {
+        CLinearTimeAbsolute ltaWhen;
+        ltaWhen.GetUTC();
+        scheduler.DeferTask(ltaWhen + time_5ms, PRIORITY_SYSTEM, Task_PassJobs, 0, 0);
+        bPassTaskScheduled = true;
+    }
+}
+#endif // UNIX_THREADS
+
+static void pass_job_submit(PASS_JOB *pJob)
+{
+#if defined(UNIX_THREADS)
+    if (  0 < mudconf.password_threads
+       && !mudstate.bStandAlone
+       && pass_threads_start())
+    {
+        pJob->pNext = NULL;
+        pthread_mutex_lock(&mtxPassJobs);
+        if (NULL == pPassWorkTail)
+        {
+            pPassWorkHead = pJob;
+        }
+        else
+        {
+            pPassWorkTail->pNext = pJob;
+        }
+        pPassWorkTail = pJob;
+        pthread_cond_signal(&cvPassWork);
+        pthread_mutex_unlock(&mtxPassJobs);
+        nPassInFlight++;
+
+        if (!bPassTaskScheduled)
+        {
+            CLinearTimeAbsolute ltaWhen;
+            ltaWhen.GetUTC();
+            scheduler.DeferTask(ltaWhen + time_5ms, PRIORITY_SYSTEM, Task_PassJobs, 0, 0);
+            bPassTaskScheduled = true;
+        }
+        return;
+    }
+#endif // UNIX_THREADS
+
+    // Hash it here and now.
+    //
+    static CRYPT_STATE cs;
+    pass_job_hash(pJob, &cs);
+    pass_job_finish(pJob);
+}
+
+/*! \brief Check a player's password without waiting for the hash.
+ *
+ * pfDone is called from the game loop once the answer is known, or before
+ * this function returns if there are no password threads.
+ *
+ * \param player     Player.
+ * \param pPassword  Password to check.
+ * \param pContext   Passed to pfDone and cancel_pass_checks().
+ * \param pfDone     Called with the answer.
+ * \return           None.
+ */
+
+void check_pass_async(dbref player, const UTF8 *pPassword, void *pContext, FPASSCHECK *pfDone)
+{
+    int   aflags;
+    dbref aowner;
+    UTF8 *pTarget = atr_get("check_pass_async.1", player, A_PASS, &aowner, &aflags);
+    PASS_JOB *pJob = pass_job_alloc(PJ_CHECK, player, pPassword, pTarget);
+    free_lbuf(pTarget);
+
+    pJob->pContext = pContext;
+    pJob->pfDone   = pfDone;
+    pass_check_submit(pJob);
+}
+
+/*! \brief Forget about password checks for something which has gone away.
+ *
+ * \param pContext   As given to check_pass_async().
+ * \return           None.
+ */
+
+void cancel_pass_checks(void *pContext)
+{
+    for (PASS_JOB *p = pPassAll; p; p = p->pAllNext)
+    {
+        if (  PJ_CHECK == p->iKind
+           && pContext == p->pContext)
+        {
+            p->pContext = NULL;
+            p->pfDone = NULL;
+        }
+    }
+}
+
+/*! \brief Wait for the password threads to finish everything.
+ *
+ * Called before the final checkpoint so that changed passwords are saved.
+ *
+ * \return           None.
+ */
+
+void drain_pass_jobs(void)
+{
+#if defined(UNIX_THREADS)
+    while (0 < nPassInFlight)
+    {
+        pthread_mutex_lock(&mtxPassJobs);
+        while (NULL == pPassDone)
+        {
+            pthread_cond_wait(&cvPassDone, &mtxPassJobs);
+        }
+        pthread_mutex_unlock(&mtxPassJobs);
+        pass_jobs_reap();
+    }
+#endif // UNIX_THREADS
+}
+
+/*! \brief Hash and store a new password for a player.
+ *
+ * The salt is chosen here, but the hash itself is computed by a password
+ * thread when there is one, so A_PASS changes a little later.  Logins
+ * checked in the meantime wait for it.
+ *
+ * \param player     Player.
+ * \param szPassword New password.
+ * \return           None.
+ */
+
+void ChangePassword(dbref player, const UTF8 *szPassword)
+{
+    for (PASS_JOB *p = pPassAll; p; p = p->pAllNext)
+    {
+        if (  PJ_CHANGE == p->iKind
+           && player == p->player)
+        {
+            p->bSuperseded = true;
+        }
+    }
+
+    PASS_JOB *pJob = pass_job_alloc(PJ_CHANGE, player, szPassword, T(""));
+    pass_change_salt(pJob);
+    pass_job_submit(pJob);
+}
+
 /* ---------------------------------------------------------------------------
  * check_pass: Test a password to see if it is correct.
  */
@@ -683,21 +1231,17 @@ static bool check_pass(dbref player, const UTF8 *pPassword)
 }
 
 /* ---------------------------------------------------------------------------
- * connect_player: Try to connect to an existing player.
+ * connect_player: Connect to an existing player once its password has been
+ * checked.
  */
 
-dbref connect_player(UTF8 *name, UTF8 *password, UTF8 *host, UTF8 *username, UTF8 *ipaddr)
+dbref connect_player(dbref player, bool bValidPass, UTF8 *host, UTF8 *username, UTF8 *ipaddr)
 {
     CLinearTimeAbsolute ltaNow;
     ltaNow.GetLocal();
     UTF8 *time_str = ltaNow.ReturnDateString(7);
 
-    dbref player = lookup_player(NOTHING, name, false);
-    if (player == NOTHING)
-    {
-        return NOTHING;
-    }
-    if (!check_pass(player, password))
+    if (!bValidPass)
     {
         record_login(player, false, time_str, host, username, ipaddr);
         return NOTHING;
@@ -821,6 +1365,12 @@ void do_password
     UNUSED_PARAMETER(cargs);
     UNUSED_PARAMETER(ncargs);
 
+#if defined(UNIX_THREADS)
+    // The old password may still be on its way into A_PASS.
+    //
+    pass_change_wait(executor);
+#endif // UNIX_THREADS
+
     dbref aowner;
     int   aflags;
     UTF8 *target = atr_get("do_password.618", executor, A_PASS, &aowner, &aflags);
@@ -1204,7 +1754,6 @@ bool badname_check(UTF8 *bad_name)
     //
     for (bp = mudstate.badname_head; bp; bp = bp->next)
     {
-        mudstate.wild_invk_ctr = 0;
         if (quick_wild(bp->name, bad_name))
         {
             return false;
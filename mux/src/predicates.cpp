@@ -1610,6 +1610,10 @@ void do_restart(dbref executor, dbref caller, dbref enactor, int eval, int key)
     log_name(executor);
     ENDLOG;
 
+    // Finish logins and password changes which are still being hashed.
+    //
+    drain_pass_jobs();
+
 #ifdef UNIX_SSL
     CleanUpSSLConnections();
 #endif
@@ -1629,6 +1633,9 @@ void do_restart(dbref executor, dbref caller, dbref enactor, int eval, int key)
     al_store();
 #endif
     pcache_sync();
+#if defined(UNIX_DUMP_JOURNAL)
+    dump_journal_drain();
+#endif // UNIX_DUMP_JOURNAL
     dump_database_internal(DUMP_I_RESTART);
     SYNC;
     CLOSE;
@@ -0,0 +1,486 @@
+/*! \file profile.cpp
+ * \brief Softcode profiler.
+ *
+ * $Id$
+ *
+ * While @profile/on is in effect, mux_exec brackets every attribute
+ * evaluation and every built-in function call with profile_enter() and
+ * profile_leave().  The time spent and the output produced are charged to a
+ * node for the (object, attribute) or FUN involved, and the exclusive time is
+ * also charged to the call path which led there, so the result can be
+ * written out as folded stacks for the usual flamegraph tools.
+ */
+
+#include "copyright.h"
+#include "autoconf.h"
+#include "config.h"
+#include "externs.h"
+
+#include "attrs.h"
+#include "command.h"
+#include "functions.h"
+#include "mathutil.h"
+
+#define PROFILE_MAX_NODES   4096    // Distinct attributes and functions.
+#define PROFILE_MAX_PATHS   16384   // Distinct call paths.
+#define PROFILE_MAX_DEPTH   100     // Frames tracked on the call stack.
+#define PROFILE_REPORT_TOP  25      // Rows shown by @profile/report.
+
+// A node is keyed on the attribute being evaluated or the built-in function
+// being called.  Only one of the two halves of the key is used.
+//
+typedef struct
+{
+    dbref       thing;
+    int         attr;
+    const FUN  *fp;
+} PROF_KEY;
+
+typedef struct
+{
+    PROF_KEY     key;
+    int          iNode;
+    unsigned int nCalls;
+    INT64        ltInclusive;
+    INT64        ltExclusive;
+    INT64        nBytes;
+} PROF_NODE;
+
+// A path is a node reached from a particular parent path.
+//
+typedef struct
+{
+    int   iParent;
+    int   iNode;
+} PROF_PATH_KEY;
+
+typedef struct
+{
+    PROF_PATH_KEY key;
+    int           iPath;
+    INT64         ltExclusive;
+} PROF_PATH;
+
+typedef struct
+{
+    int   iNode;
+    int   iPath;
+    INT64 ltStart;
+    INT64 ltChildren;
+} PROF_FRAME;
+
+static PROF_NODE *aProfNodes[PROFILE_MAX_NODES];
+static PROF_PATH *aProfPaths[PROFILE_MAX_PATHS];
+static int nProfNodes = 0;
+static int nProfPaths = 0;
+static unsigned int nProfDropped = 0;
+
+static PROF_FRAME aProfStack[PROFILE_MAX_DEPTH];
+static int nProfDepth = 0;
+
+static CLinearTimeAbsolute ltaProfStarted;
+static CLinearTimeDelta    ltdProfCollected;
+
+static int profile_node(dbref thing, int attr, const FUN *fp)
+{
+    PROF_KEY key;
+    memset(&key, 0, sizeof(key));
+    key.thing = thing;
+    key.attr  = attr;
+    key.fp    = fp;
+
+    PROF_NODE *pn = (PROF_NODE *)hashfindLEN(&key, sizeof(key), &mudstate.profile_htab);
+    if (NULL != pn)
+    {
+        return pn->iNode;
+    }
+
+    if (PROFILE_MAX_NODES <= nProfNodes)
+    {
+        return -1;
+    }
+
+    pn = (PROF_NODE *)MEMALLOC(sizeof(PROF_NODE));
+    ISOUTOFMEMORY(pn);
+    memset(pn, 0, sizeof(PROF_NODE));
+    pn->key = key;
+    pn->iNode = nProfNodes++;
+    aProfNodes[pn->iNode] = pn;
+    hashaddLEN(&pn->key, sizeof(pn->key), pn, &mudstate.profile_htab);
+    return pn->iNode;
+}
+
+static int profile_path(int iParent, int iNode)
+{
+    if (iNode < 0)
+    {
+        return -1;
+    }
+
+    PROF_PATH_KEY key;
+    key.iParent = iParent;
+    key.iNode   = iNode;
+
+    // Paths share the profile table with the nodes.  Their keys are a
+    // different length, so the two can never collide.
+    //
+    PROF_PATH *pp = (PROF_PATH *)hashfindLEN(&key, sizeof(key), &mudstate.profile_htab);
+    if (NULL != pp)
+    {
+        return pp->iPath;
+    }
+
+    if (PROFILE_MAX_PATHS <= nProfPaths)
+    {
+        return -1;
+    }
+
+    pp = (PROF_PATH *)MEMALLOC(sizeof(PROF_PATH));
+    ISOUTOFMEMORY(pp);
+    pp->key = key;
+    pp->iPath = nProfPaths++;
+    pp->ltExclusive = 0;
+    aProfPaths[pp->iPath] = pp;
+    hashaddLEN(&pp->key, sizeof(pp->key), pp, &mudstate.profile_htab);
+    return pp->iPath;
+}
+
+/*! \brief Begin charging time to an attribute or built-in function.
+ *
+ * Every call must be matched with a call to profile_leave() once the
+ * evaluation is complete.  Callers should test mudstate.bProfiling before
+ * calling and remember the result so that turning the profiler off in the
+ * middle of an evaluation leaves the stack balanced.
+ *
+ * \param thing    Object the attribute is on, or NOTHING.
+ * \param attr     Attribute number, or 0 for a function.
+ * \param fp       Built-in function, or NULL for an attribute.
+ * \return         None.
+ */
+
+void profile_enter(dbref thing, int attr, const FUN *fp)
+{
+    if (PROFILE_MAX_DEPTH <= nProfDepth)
+    {
+        // Too deep to track.  The time will be charged to the frame which
+        // is tracked.
+        //
+        nProfDepth++;
+        nProfDropped++;
+        return;
+    }
+
+    PROF_FRAME *pf = &aProfStack[nProfDepth];
+    int iParent = (0 < nProfDepth) ? aProfStack[nProfDepth-1].iPath : -1;
+
+    pf->iNode = profile_node(thing, attr, fp);
+    if (  0 < nProfDepth
+       && iParent < 0)
+    {
+        // The parent was not tracked, so neither is this one.
+        //
+        pf->iPath = -1;
+    }
+    else
+    {
+        pf->iPath = profile_path(iParent, pf->iNode);
+    }
+    if (pf->iNode < 0)
+    {
+        nProfDropped++;
+    }
+    pf->ltChildren = 0;
+    nProfDepth++;
+    GetUTCLinearTime(&pf->ltStart);
+}
+
+/*! \brief Finish charging time started by profile_enter().
+ *
+ * \param nBytes   Output produced by the evaluation.
+ * \return         None.
+ */
+
+void profile_leave(size_t nBytes)
+{
+    if (nProfDepth <= 0)
+    {
+        return;
+    }
+
+    nProfDepth--;
+    if (PROFILE_MAX_DEPTH <= nProfDepth)
+    {
+        return;
+    }
+
+    INT64 ltNow;
+    GetUTCLinearTime(&ltNow);
+
+    PROF_FRAME *pf = &aProfStack[nProfDepth];
+    INT64 ltInclusive = ltNow - pf->ltStart;
+    if (ltInclusive < 0)
+    {
+        // The clock was set back.
+        //
+        ltInclusive = 0;
+    }
+
+    if (pf->iNode < 0)
+    {
+        // Not tracked.  Leave the time with the parent as exclusive time.
+        //
+        return;
+    }
+
+    INT64 ltExclusive = ltInclusive - pf->ltChildren;
+    if (ltExclusive < 0)
+    {
+        ltExclusive = 0;
+    }
+
+    PROF_NODE *pn = aProfNodes[pf->iNode];
+    pn->nCalls++;
+    pn->ltInclusive += ltInclusive;
+    pn->ltExclusive += ltExclusive;
+    pn->nBytes += nBytes;
+
+    if (0 <= pf->iPath)
+    {
+        aProfPaths[pf->iPath]->ltExclusive += ltExclusive;
+    }
+
+    if (0 < nProfDepth)
+    {
+        aProfStack[nProfDepth-1].ltChildren += ltInclusive;
+    }
+}
+
+static void profile_reset(void)
+{
+    hashflush(&mudstate.profile_htab);
+    for (int i = 0; i < nProfNodes; i++)
+    {
+        MEMFREE(aProfNodes[i]);
+        aProfNodes[i] = NULL;
+    }
+    for (int i = 0; i < nProfPaths; i++)
+    {
+        MEMFREE(aProfPaths[i]);
+        aProfPaths[i] = NULL;
+    }
+    nProfNodes = 0;
+    nProfPaths = 0;
+    nProfDropped = 0;
+
+    // Frames still on the stack refer to nodes which no longer exist.
+    //
+    int nTracked = (nProfDepth < PROFILE_MAX_DEPTH) ? nProfDepth : PROFILE_MAX_DEPTH;
+    for (int i = 0; i < nTracked; i++)
+    {
+        aProfStack[i].iNode = -1;
+        aProfStack[i].iPath = -1;
+    }
+
+    ltdProfCollected.Set100ns(0);
+    ltaProfStarted.GetUTC();
+}
+
+// Name a node the way the report and the folded stacks show it: #dbref/ATTR
+// for attributes and NAME() for built-in functions.
+//
+static void profile_name(PROF_NODE *pn, UTF8 *buff, UTF8 **bufc)
+{
+    if (NULL != pn->key.fp)
+    {
+        safe_str(pn->key.fp->name, buff, bufc);
+        safe_str(T("()"), buff, bufc);
+    }
+    else
+    {
+        safe_chr('#', buff, bufc);
+        safe_ltoa(pn->key.thing, buff, bufc);
+        safe_chr('/', buff, bufc);
+        ATTR *pattr = atr_num(pn->key.attr);
+        if (NULL != pattr)
+        {
+            safe_str(pattr->name, buff, bufc);
+        }
+        else
+        {
+            safe_ltoa(pn->key.attr, buff, bufc);
+        }
+    }
+}
+
+static int DCL_CDECL profile_compare(const void *p1, const void *p2)
+{
+    const PROF_NODE *pn1 = *(const PROF_NODE * const *)p1;
+    const PROF_NODE *pn2 = *(const PROF_NODE * const *)p2;
+    if (pn1->ltInclusive > pn2->ltInclusive)
+    {
+        return -1;
+    }
+    else if (pn1->ltInclusive < pn2->ltInclusive)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+static void profile_report(dbref player)
+{
+    CLinearTimeDelta ltdCollected = ltdProfCollected;
+    if (mudstate.bProfiling)
+    {
+        CLinearTimeAbsolute ltaNow;
+        ltaNow.GetUTC();
+        ltdCollected += ltaNow - ltaProfStarted;
+    }
+
+    notify(player, tprintf(T("Profiler is %s. %d seconds collected, %d entries, %u calls not tracked."),
+        mudstate.bProfiling ? T("on") : T("off"),
+        ltdCollected.ReturnSeconds(), nProfNodes, nProfDropped));
+
+    if (0 == nProfNodes)
+    {
+        return;
+    }
+
+    PROF_NODE **apSorted = (PROF_NODE **)MEMALLOC(nProfNodes * sizeof(PROF_NODE *));
+    ISOUTOFMEMORY(apSorted);
+    memcpy(apSorted, aProfNodes, nProfNodes * sizeof(PROF_NODE *));
+    qsort(apSorted, nProfNodes, sizeof(PROF_NODE *), profile_compare);
+
+    notify(player, T("     Calls   Incl(us)   Excl(us)      Bytes  Name"));
+    int nShown = (nProfNodes < PROFILE_REPORT_TOP) ? nProfNodes : PROFILE_REPORT_TOP;
+    for (int i = 0; i < nShown; i++)
+    {
+        PROF_NODE *pn = apSorted[i];
+        UTF8 aInclusive[I64BUF_SIZE];
+        UTF8 aExclusive[I64BUF_SIZE];
+        UTF8 aBytes[I64BUF_SIZE];
+        mux_i64toa(pn->ltInclusive / FACTOR_100NS_PER_MICROSECOND, aInclusive);
+        mux_i64toa(pn->ltExclusive / FACTOR_100NS_PER_MICROSECOND, aExclusive);
+        mux_i64toa(pn->nBytes, aBytes);
+
+        UTF8 *buff = alloc_lbuf("profile_report");
+        UTF8 *bufc = buff;
+        profile_name(pn, buff, &bufc);
+        *bufc = '\0';
+        notify(player, tprintf(T("%10u %10s %10s %10s  %s"), pn->nCalls,
+            aInclusive, aExclusive, aBytes, buff));
+        free_lbuf(buff);
+    }
+    MEMFREE(apSorted);
+}
+
+// Write the exclusive time of each call path as one line of folded stacks,
+// frames separated by semicolons and followed by the time in microseconds.
+//
+static void profile_export(dbref player)
+{
+    UTF8 *pFilename = alloc_mbuf("profile_export");
+    mux_sprintf(pFilename, MBUF_SIZE, T("%s/profile.folded"),
+        mudconf.log_dir ? mudconf.log_dir : T("."));
+
+    FILE *fp;
+    if (!mux_fopen(&fp, pFilename, T("wb")))
+    {
+        notify(player, tprintf(T("Cannot open %s."), pFilename));
+        free_mbuf(pFilename);
+        return;
+    }
+
+    UTF8 *buff = alloc_lbuf("profile_export");
+    int aChain[PROFILE_MAX_DEPTH];
+    int nLines = 0;
+    for (int i = 0; i < nProfPaths; i++)
+    {
+        PROF_PATH *pp = aProfPaths[i];
+        INT64 usExclusive = pp->ltExclusive / FACTOR_100NS_PER_MICROSECOND;
+        if (usExclusive <= 0)
+        {
+            continue;
+        }
+
+        int nChain = 0;
+        for (int iPath = i; 0 <= iPath && nChain < PROFILE_MAX_DEPTH; iPath = aProfPaths[iPath]->key.iParent)
+        {
+            aChain[nChain++] = iPath;
+        }
+
+        UTF8 *bufc = buff;
+        while (0 < nChain)
+        {
+            nChain--;
+            profile_name(aProfNodes[aProfPaths[aChain[nChain]]->key.iNode], buff, &bufc);
+            if (0 < nChain)
+            {
+                safe_chr(';', buff, &bufc);
+            }
+        }
+        safe_chr(' ', buff, &bufc);
+        safe_i64toa(usExclusive, buff, &bufc);
+        *bufc = '\0';
+
+        fputs((char *)buff, fp);
+        fputs("\n", fp);
+        nLines++;
+    }
+    fclose(fp);
+    free_lbuf(buff);
+
+    notify(player, tprintf(T("%d stacks written to %s."), nLines, pFilename));
+    free_mbuf(pFilename);
+}
+
+void do_profile(dbref executor, dbref caller, dbref enactor, int eval, int key)
+{
+    UNUSED_PARAMETER(caller);
+    UNUSED_PARAMETER(enactor);
+    UNUSED_PARAMETER(eval);
+
+    switch (key)
+    {
+    case PROFILE_ON:
+        if (mudstate.bProfiling)
+        {
+            notify(executor, T("Profiler is already on."));
+        }
+        else
+        {
+            mudstate.bProfiling = true;
+            ltaProfStarted.GetUTC();
+            notify(executor, T("Profiler on."));
+        }
+        break;
+
+    case PROFILE_OFF:
+        if (mudstate.bProfiling)
+        {
+            CLinearTimeAbsolute ltaNow;
+            ltaNow.GetUTC();
+            ltdProfCollected += ltaNow - ltaProfStarted;
+            mudstate.bProfiling = false;
+            notify(executor, T("Profiler off."));
+        }
+        else
+        {
+            notify(executor, T("Profiler is already off."));
+        }
+        break;
+
+    case PROFILE_RESET:
+        profile_reset();
+        notify(executor, T("Profile data cleared."));
+        break;
+
+    case PROFILE_EXPORT:
+        profile_export(executor);
+        break;
+
+    default:
+        profile_report(executor);
+        break;
+    }
+}
@@ -143,7 +143,7 @@ void do_chzone
 
     // Everything is okay, do the change.
     //
-    db[thing].zone = zone;
+    s_Zone(thing, zone);
     if (!isPlayer(thing))
     {
         // If the object is a player, resetting these flags is rather
@@ -801,6 +801,7 @@ void SetClearFlags
     FLAG aSetFlags[3]
 )
 {
+    s_Dirty(thing);
     int j;
     for (j = FLAG_WORD1; j <= FLAG_WORD3; j++)
     {
@@ -1615,6 +1616,9 @@ void find_wild_attrs(dbref player, dbref thing, const UTF8 *str, bool check_excl
     dbref aowner;
     int ca, ok, aflags;
 
+    CWildcard wc;
+    wc.Compile(str);
+
     // Walk the attribute list of the object.
     //
     atr_push();
@@ -1656,9 +1660,8 @@ void find_wild_attrs(dbref player, dbref thing, const UTF8 *str, bool check_excl
             ok = See_attr(player, thing, pattr);
         }
 
-        mudstate.wild_invk_ctr = 0;
         if (  ok
-           && quick_wild(str, pattr->name))
+           && wc.Match(pattr->name))
         {
             olist_add(ca);
             if (hash_insert)
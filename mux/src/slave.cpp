@@ -3,11 +3,11 @@
  *
  * $Id$
  *
- * The philosophy is to keep this program as simple/small as possible.  It
- * routinely performs non-vfork forks()s, so the conventional wisdom is that
- * the smaller it is, the faster it goes.  However, with modern memory
- * management support (including copy on reference paging), size is probably
- * not the issue it once was.
+ * The philosophy is to keep this program as simple/small as possible.  Where
+ * threads are available, lookups are handed to a small pool of worker
+ * threads, and answers are remembered for a while so that the same address
+ * (often an ISP's NAT) is not looked up over and over.  Otherwise, the slave
+ * falls back to forking a child for each lookup.
  */
 
 #include "autoconf.h"
@@ -58,14 +58,12 @@ char *mux_stpcpy(char *dest, const char *src)
     return (dest);
 }
 
-void child_timeout_signal(int iSig)
-{
-    exit(1);
-}
-
-int query(char *ip)
+// Look up the hostname for an address.  On failure, the hostname is the
+// address itself.
+//
+bool query(const char *ip, char *host, size_t nHost)
 {
-    const char *pHName = ip;
+    bool bResolved = false;
 
 #if defined(HAVE_GETADDRINFO) && defined(HAVE_GETNAMEINFO)
 
@@ -76,17 +74,16 @@ int query(char *ip)
     hints.ai_family   = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_protocol = IPPROTO_TCP;
-    hints.ai_flags = AI_ADDRCONFIG;
+    hints.ai_flags = AI_ADDRCONFIG | AI_NUMERICHOST;
 
     struct addrinfo *servinfo;
-    char host[MAX_STRING];
     if (0 == getaddrinfo(ip, NULL, &hints, &servinfo))
     {
         for (struct addrinfo *p = servinfo; NULL != p; p = p->ai_next)
         {
-            if (0 == getnameinfo(p->ai_addr, p->ai_addrlen, host, sizeof(host), NULL, 0, NI_NUMERICSERV))
+            if (0 == getnameinfo(p->ai_addr, p->ai_addrlen, host, nHost, NULL, 0, NI_NUMERICSERV | NI_NAMEREQD))
             {
-                pHName = host;
+                bResolved = true;
                 break;
             }
         }
@@ -100,36 +97,26 @@ int query(char *ip)
 #endif
 
     in_addr_t addr = inet_addr(ip);
-    if (INADDR_NONE == addr)
-    {
-        return -1;
-    }
 
 #if defined(HAVE_GETHOSTBYADDR)
-    struct hostent *hp = gethostbyaddr((char *) &addr, sizeof(addr), AF_INET);
-    if (  NULL != hp
-       && strlen(hp->h_name) < MAX_STRING)
+    if (INADDR_NONE != addr)
     {
-        pHName = hp->h_name;
+        struct hostent *hp = gethostbyaddr((char *) &addr, sizeof(addr), AF_INET);
+        if (  NULL != hp
+           && strlen(hp->h_name) < nHost)
+        {
+            mux_stpcpy(host, hp->h_name);
+            bResolved = true;
+        }
     }
 #endif
 #endif
 
-    char buf[MAX_STRING * 2];
-    char *p = mux_stpcpy(buf, ip);
-    *p++ = ' ';
-    p = mux_stpcpy(p, pHName);
-    *p++ = '\n';
-    *p++ = '\0';
-
-    size_t len = strlen(buf);
-    ssize_t written = write(1, buf, len);
-    if (  written < 0
-       || len != (size_t)written)
+    if (!bResolved)
     {
-        return (-1);
+        mux_stpcpy(host, ip);
     }
-    return 0;
+    return bResolved;
 }
 
 void alarm_signal(int iSig)
@@ -150,6 +137,419 @@ void alarm_signal(int iSig)
     setitimer(ITIMER_REAL, &itime, 0);
 }
 
+// Addresses are at most INET6_ADDRSTRLEN (46) characters.
+//
+#define ADDR_SIZE 64
+
+#if defined(UNIX_THREADS)
+
+#define NUM_WORKERS   8
+#define CACHE_SIZE    2048
+#define CACHE_BUCKETS 1024
+#define NAME_SIZE     256
+#define POSITIVE_TTL  3600  // 1 hour.
+#define NEGATIVE_TTL  300   // 5 minutes.
+#define OUT_SIZE      4000
+
+// Recent answers are kept in a ring of entries which are also chained into
+// a hash table by address.  New answers reuse the oldest entry in the ring.
+//
+typedef struct cache_entry
+{
+    struct cache_entry *pNext;
+    time_t  tExpires;
+    bool    bResolved;
+    char    aAddress[ADDR_SIZE];
+    char    aName[NAME_SIZE];
+} CACHE_ENTRY;
+
+static CACHE_ENTRY  aCache[CACHE_SIZE];
+static CACHE_ENTRY *apBucket[CACHE_BUCKETS];
+static int iCacheNext = 0;
+
+typedef struct request
+{
+    struct request *pNext;
+    char    aAddress[ADDR_SIZE];
+} REQUEST;
+
+// The queue of waiting lookups, the lookups in progress, and the cache are
+// guarded by mtxQueue.
+//
+static pthread_mutex_t mtxQueue = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cvWork = PTHREAD_COND_INITIALIZER;
+static REQUEST *pQueueHead = NULL;
+static REQUEST *pQueueTail = NULL;
+static REQUEST *apWorking[NUM_WORKERS];
+
+// Answers collect in aOut until someone writes them as one datagram.  Only
+// one thread writes at a time.
+//
+static pthread_mutex_t mtxOut = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cvOut = PTHREAD_COND_INITIALIZER;
+static char   aOut[OUT_SIZE];
+static size_t nOut = 0;
+static bool   bWriting = false;
+
+static unsigned int cache_hash(const char *pAddress)
+{
+    unsigned int nHash = 2166136261U;
+    while ('\0' != *pAddress)
+    {
+        nHash = (nHash ^ (unsigned char)*pAddress++) * 16777619U;
+    }
+    return nHash % CACHE_BUCKETS;
+}
+
+static CACHE_ENTRY *cache_find(const char *pAddress)
+{
+    CACHE_ENTRY *pEntry = apBucket[cache_hash(pAddress)];
+    while (  NULL != pEntry
+          && 0 != strcmp(pEntry->aAddress, pAddress))
+    {
+        pEntry = pEntry->pNext;
+    }
+    return pEntry;
+}
+
+static void cache_add(const char *pAddress, const char *pName, bool bResolved)
+{
+    if (NAME_SIZE <= strlen(pName))
+    {
+        return;
+    }
+
+    CACHE_ENTRY *pEntry = cache_find(pAddress);
+    if (NULL == pEntry)
+    {
+        // Take the oldest entry in the ring and unchain it from its bucket.
+        //
+        pEntry = &aCache[iCacheNext];
+        iCacheNext = (iCacheNext + 1) % CACHE_SIZE;
+        if ('\0' != pEntry->aAddress[0])
+        {
+            CACHE_ENTRY **pp = &apBucket[cache_hash(pEntry->aAddress)];
+            while (*pp != pEntry)
+            {
+                pp = &(*pp)->pNext;
+            }
+            *pp = pEntry->pNext;
+        }
+
+        mux_stpcpy(pEntry->aAddress, pAddress);
+        unsigned int iBucket = cache_hash(pAddress);
+        pEntry->pNext = apBucket[iBucket];
+        apBucket[iBucket] = pEntry;
+    }
+    mux_stpcpy(pEntry->aName, pName);
+    pEntry->bResolved = bResolved;
+    pEntry->tExpires = time(NULL) + (bResolved ? POSITIVE_TTL : NEGATIVE_TTL);
+}
+
+// Write out everything in aOut.  Called with mtxOut held.
+//
+static void write_results(void)
+{
+    char aBatch[OUT_SIZE];
+
+    bWriting = true;
+    while (0 < nOut)
+    {
+        size_t len = nOut;
+        memcpy(aBatch, aOut, len);
+        nOut = 0;
+        pthread_cond_broadcast(&cvOut);
+        pthread_mutex_unlock(&mtxOut);
+
+        ssize_t written;
+        do
+        {
+            written = write(1, aBatch, len);
+        } while (  written < 0
+                && EINTR == errno);
+
+        if (  written < 0
+           || len != (size_t)written)
+        {
+            // Our parent has gone away.
+            //
+            exit(1);
+        }
+        pthread_mutex_lock(&mtxOut);
+    }
+    bWriting = false;
+}
+
+static void flush_results(void)
+{
+    pthread_mutex_lock(&mtxOut);
+    if (!bWriting)
+    {
+        write_results();
+    }
+    pthread_mutex_unlock(&mtxOut);
+}
+
+static void add_result(const char *ip, const char *pName, char chStatus, bool bFlush)
+{
+    char buf[ADDR_SIZE + MAX_STRING + 4];
+    char *p = mux_stpcpy(buf, ip);
+    *p++ = ' ';
+    p = mux_stpcpy(p, pName);
+    *p++ = ' ';
+    *p++ = chStatus;
+    *p++ = '\n';
+    size_t len = p - buf;
+
+    pthread_mutex_lock(&mtxOut);
+    while (sizeof(aOut) < nOut + len)
+    {
+        if (bWriting)
+        {
+            pthread_cond_wait(&cvOut, &mtxOut);
+        }
+        else
+        {
+            write_results();
+        }
+    }
+    memcpy(aOut + nOut, buf, len);
+    nOut += len;
+    if (  bFlush
+       && !bWriting)
+    {
+        write_results();
+    }
+    pthread_mutex_unlock(&mtxOut);
+}
+
+static void *worker_proc(void *pArg)
+{
+    size_t iWorker = (size_t)pArg;
+    char host[MAX_STRING];
+
+    pthread_mutex_lock(&mtxQueue);
+    for (;;)
+    {
+        while (NULL == pQueueHead)
+        {
+            pthread_cond_wait(&cvWork, &mtxQueue);
+        }
+        REQUEST *pRequest = pQueueHead;
+        pQueueHead = pRequest->pNext;
+        if (NULL == pQueueHead)
+        {
+            pQueueTail = NULL;
+        }
+        apWorking[iWorker] = pRequest;
+        pthread_mutex_unlock(&mtxQueue);
+
+        bool bResolved = query(pRequest->aAddress, host, sizeof(host));
+
+        pthread_mutex_lock(&mtxQueue);
+        cache_add(pRequest->aAddress, host, bResolved);
+        apWorking[iWorker] = NULL;
+        pthread_mutex_unlock(&mtxQueue);
+
+        add_result(pRequest->aAddress, host,
+            bResolved ? SLAVE_RESOLVED : SLAVE_FAILED, true);
+        free(pRequest);
+
+        pthread_mutex_lock(&mtxQueue);
+    }
+    return NULL;
+}
+
+// Answer from the cache if we can.  Otherwise, queue a lookup unless one for
+// the same address is already waiting or in progress.
+//
+static void submit(const char *ip)
+{
+    char host[NAME_SIZE];
+
+    pthread_mutex_lock(&mtxQueue);
+    CACHE_ENTRY *pEntry = cache_find(ip);
+    if (  NULL != pEntry
+       && time(NULL) < pEntry->tExpires)
+    {
+        mux_stpcpy(host, pEntry->aName);
+        char chStatus = pEntry->bResolved ? SLAVE_CACHED : SLAVE_NEGATIVE;
+        pthread_mutex_unlock(&mtxQueue);
+        add_result(ip, host, chStatus, false);
+        return;
+    }
+
+    for (REQUEST *p = pQueueHead; NULL != p; p = p->pNext)
+    {
+        if (0 == strcmp(p->aAddress, ip))
+        {
+            pthread_mutex_unlock(&mtxQueue);
+            return;
+        }
+    }
+
+    for (int i = 0; i < NUM_WORKERS; i++)
+    {
+        if (  NULL != apWorking[i]
+           && 0 == strcmp(apWorking[i]->aAddress, ip))
+        {
+            pthread_mutex_unlock(&mtxQueue);
+            return;
+        }
+    }
+
+    REQUEST *pRequest = (REQUEST *)malloc(sizeof(REQUEST));
+    if (NULL == pRequest)
+    {
+        exit(1);
+    }
+    pRequest->pNext = NULL;
+    mux_stpcpy(pRequest->aAddress, ip);
+    if (NULL == pQueueTail)
+    {
+        pQueueHead = pRequest;
+    }
+    else
+    {
+        pQueueTail->pNext = pRequest;
+    }
+    pQueueTail = pRequest;
+    pthread_cond_signal(&cvWork);
+    pthread_mutex_unlock(&mtxQueue);
+}
+
+// Cache hits are held back while more requests are waiting to be read so
+// that they leave together.
+//
+static bool more_input(void)
+{
+#if defined(FIONREAD)
+    int n = 0;
+    return (  0 == ioctl(0, FIONREAD, &n)
+           && 0 < n);
+#else
+    return false;
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    char arg[MAX_STRING];
+    int len;
+
+    parent_pid = getppid();
+    if (parent_pid == 1)
+    {
+        // Our real parent process is gone, and we have been inherited by the
+        // init process.
+        //
+        exit(1);
+    }
+
+    signal(SIGPIPE, SIG_DFL);
+
+    // Start the workers with SIGALRM blocked so that it is always delivered
+    // to the main thread.
+    //
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+    for (size_t i = 0; i < NUM_WORKERS; i++)
+    {
+        pthread_t thread;
+        if (0 != pthread_create(&thread, NULL, worker_proc, (void *)i))
+        {
+            exit(1);
+        }
+        pthread_detach(thread);
+    }
+    pthread_sigmask(SIG_UNBLOCK, &sigs, NULL);
+    alarm_signal(SIGALRM);
+
+    for (;;)
+    {
+        len = read(0, arg, MAX_STRING - 1);
+        if (len == 0)
+        {
+            break;
+        }
+
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                errno = 0;
+                continue;
+            }
+            break;
+        }
+        arg[len] = '\0';
+
+        // One address per line.
+        //
+        char *p = arg;
+        while ('\0' != *p)
+        {
+            char *q = p;
+            while (  '\0' != *q
+                  && '\n' != *q)
+            {
+                q++;
+            }
+            bool bMore = ('\0' != *q);
+            *q = '\0';
+            if (  '\0' != *p
+               && strlen(p) < ADDR_SIZE)
+            {
+                submit(p);
+            }
+            if (!bMore)
+            {
+                break;
+            }
+            p = q + 1;
+        }
+
+        if (!more_input())
+        {
+            flush_results();
+        }
+    }
+    exit(0);
+}
+
+#else // UNIX_THREADS
+
+void child_timeout_signal(int iSig)
+{
+    exit(1);
+}
+
+int query_child(char *ip)
+{
+    char host[MAX_STRING];
+    bool bResolved = query(ip, host, sizeof(host));
+
+    char buf[MAX_STRING * 2 + 4];
+    char *p = mux_stpcpy(buf, ip);
+    *p++ = ' ';
+    p = mux_stpcpy(p, host);
+    *p++ = ' ';
+    *p++ = bResolved ? SLAVE_RESOLVED : SLAVE_FAILED;
+    *p++ = '\n';
+    *p++ = '\0';
+
+    size_t len = strlen(buf);
+    ssize_t written = write(1, buf, len);
+    if (  written < 0
+       || len != (size_t)written)
+    {
+        return (-1);
+    }
+    return 0;
+}
+
 #define MAX_CHILDREN 20
 volatile int nChildrenStarted = 0;
 volatile int nChildrenEndedSIGCHLD = 0;
@@ -210,6 +610,17 @@ int main(int argc, char *argv[])
         }
         arg[len] = '\0';
 
+        char *p = strchr(arg, '\n');
+        if (NULL != p)
+        {
+            *p = '\0';
+        }
+        if (  '\0' == arg[0]
+           || ADDR_SIZE <= strlen(arg))
+        {
+            continue;
+        }
+
         child = fork();
         switch (child)
         {
@@ -231,7 +642,7 @@ int main(int argc, char *argv[])
                 signal(SIGALRM, CAST_SIGNAL_FUNC child_timeout_signal);
                 setitimer(ITIMER_REAL, &itime, 0);
             }
-            exit(query(arg) != 0);
+            exit(query_child(arg) != 0);
             break;
         }
 
@@ -255,3 +666,5 @@ int main(int argc, char *argv[])
     }
     exit(0);
 }
+
+#endif // UNIX_THREADS
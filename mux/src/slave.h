@@ -3,10 +3,20 @@
  *
  * $Id$
  *
- * This enum doesn't actually appear to be used for anything.
+ * The first enum doesn't actually appear to be used for anything.
  */
 
 enum {
     SLAVE_IDENTQ = 'i',
     SLAVE_IPTONAME = 'h'
 };
+
+// Each line the slave returns is '<address> <hostname> <status>'.  Several
+// lines may arrive in the same datagram.
+//
+enum {
+    SLAVE_RESOLVED = 'R',   // Answered by a lookup.
+    SLAVE_FAILED   = 'F',   // Lookup failed.  The hostname is the address.
+    SLAVE_CACHED   = 'C',   // Answered from the cache of hostnames.
+    SLAVE_NEGATIVE = 'N'    // Answered from the cache of failed lookups.
+};
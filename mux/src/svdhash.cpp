@@ -19,6 +19,7 @@ int cs_fails    = 0;    // attempts to grab nonexistent
 int cs_syncs    = 0;    // total cache syncs
 int cs_dbreads  = 0;    // total read-throughs
 int cs_dbwrites = 0;    // total write-throughs
+int cs_dbmaps   = 0;    // pages read in place from the mapped file
 int cs_whits    = 0;    // writes into cached pages
 int cs_rhits    = 0;    // read from cached pages
 
@@ -413,6 +414,7 @@ bool CHashPage::Allocate(unsigned int nPageSize)
 
     m_nPageSize = nPageSize;
     m_pPage = new unsigned char[nPageSize];
+    m_pBuffer = m_pPage;
     if (m_pPage)
     {
         return true;
@@ -424,15 +426,17 @@ CHashPage::CHashPage(void)
 {
     m_nPageSize = 0;
     m_pPage = 0;
+    m_pBuffer = 0;
 }
 
 CHashPage::~CHashPage(void)
 {
-    if (m_pPage)
+    if (m_pBuffer)
     {
-        delete [] m_pPage;
-        m_pPage = 0;
+        delete [] m_pBuffer;
+        m_pBuffer = 0;
     }
+    m_pPage = 0;
 }
 
 // GetStats
@@ -1003,6 +1007,21 @@ void CHashPage::HeapCopy(UINT32 iDir, HP_PHEAPLENGTH pnRecord, void *pRecord)
     }
 }
 
+// HeapPeek - Returns a pointer to the record associated with iDir without
+//            copying it. The pointer is only good until the page changes.
+//
+const void *CHashPage::HeapPeek(UINT32 iDir, HP_PHEAPLENGTH pnRecord)
+{
+    if (m_pDirectory[iDir] < HP_DIR_DELETED) // ValidateAllocatedBlock(iDir))
+    {
+        HP_PHEAPNODE pNode = (HP_PHEAPNODE)(m_pHeapStart + m_pDirectory[iDir]);
+        *pnRecord = pNode->u.s.nRecordSize;
+        return pNode+1;
+    }
+    *pnRecord = 0;
+    return NULL;
+}
+
 void CHashPage::HeapUpdate(UINT32 iDir, HP_HEAPLENGTH nRecord, void *pRecord)
 {
     if (nRecord == 0 || pRecord == 0) return;
@@ -1238,6 +1257,39 @@ bool CHashPage::ReadPage(HANDLE hFile, HF_FILEOFFSET oWhere)
 }
 #endif // UNIX_FILES
 
+// MapPage
+//
+// Views a page in place (e.g., in a mapping of the page file) instead of
+// reading it into our own buffer. The page must not be modified through this
+// view.
+//
+void CHashPage::MapPage(unsigned char *pMapped)
+{
+    m_pPage = pMapped;
+    SetFixedPointers();
+    SetVariablePointers();
+}
+
+// UnmapPage
+//
+// Returns to our own buffer. If asked, the page contents are carried over so
+// that the page can be modified.
+//
+void CHashPage::UnmapPage(bool bKeepContents)
+{
+    if (m_pPage != m_pBuffer)
+    {
+        unsigned char *pMapped = m_pPage;
+        m_pPage = m_pBuffer;
+        SetFixedPointers();
+        if (bKeepContents)
+        {
+            memcpy(m_pPage, pMapped, m_nPageSize);
+            SetVariablePointers();
+        }
+    }
+}
+
 #endif // MEMORY_BASED
 
 UINT32 CHashPage::GetDepth(void)
@@ -1287,6 +1339,10 @@ bool CHashPage::Defrag(HP_HEAPLENGTH nExtra)
         hpNew->m_pPage = m_pPage;
         m_pPage = tmp;
 
+        tmp = hpNew->m_pBuffer;
+        hpNew->m_pBuffer = m_pBuffer;
+        m_pBuffer = tmp;
+
         SetFixedPointers();
         SetVariablePointers();
         delete hpNew;
@@ -1343,6 +1399,9 @@ CHashFile::CHashFile(void)
     SeedRandomNumberGenerator();
     m_Cache = NULL;
     m_nCache = 0;
+#if defined(UNIX_FILES_MMAP)
+    m_bMapPages = false;
+#endif // UNIX_FILES_MMAP
     Init();
 }
 
@@ -1361,6 +1420,10 @@ void CHashFile::Init(void)
     m_hpCacheLookup = NULL;
     iCache = 0;
     m_iLastFlushed = 0;
+#if defined(UNIX_FILES_MMAP)
+    m_pMapped = NULL;
+    m_nMapped = 0UL;
+#endif // UNIX_FILES_MMAP
 }
 
 #if defined(WINDOWS_FILES)
@@ -1671,11 +1734,16 @@ void CHashFile::InitCache(int nCachePages)
     m_iOldest = 0;
 }
 
-int CHashFile::Open(const UTF8 *szDirFile, const UTF8 *szPageFile, int nCachePages)
+int CHashFile::Open(const UTF8 *szDirFile, const UTF8 *szPageFile, int nCachePages, bool bMapPages)
 {
     CloseAll();
     FinalCache();
     InitCache(nCachePages);
+#if defined(UNIX_FILES_MMAP)
+    m_bMapPages = bMapPages;
+#else // UNIX_FILES_MMAP
+    UNUSED_PARAMETER(bMapPages);
+#endif // UNIX_FILES_MMAP
 
     // First let's try to open the page file. This is the more important file.
     //
@@ -1869,6 +1937,10 @@ void CHashFile::CloseAll(void)
             m_hpCacheLookup = NULL;
         }
 
+#if defined(UNIX_FILES_MMAP)
+        UnmapFile();
+#endif // UNIX_FILES_MMAP
+
 #if defined(WINDOWS_FILES)
         CloseHandle(m_hPageFile);
 #elif defined(UNIX_FILES)
@@ -1933,6 +2005,10 @@ bool CHashFile::Insert(HP_HEAPLENGTH nRecord, UINT32 nHash, void *pRecord)
                 iFileDir, nStart, nEnd);
             return false;
         }
+        // A page viewed in place in the mapped file is read-only. Take our
+        // own copy before changing it.
+        //
+        m_Cache[iCache].m_hp.UnmapPage(true);
         int errInserted = m_Cache[iCache].m_hp.Insert(nRecord, nHash, pRecord);
         if (IS_HP_SUCCESS(errInserted))
         {
@@ -1947,12 +2023,13 @@ bool CHashFile::Insert(HP_HEAPLENGTH nRecord, UINT32 nHash, void *pRecord)
         }
 
 #if defined(HAVE_WORKING_FORK)
-        // First, if we are @dumping, then we have a @forked process
-        // that is also reading from the file. We must pause and let
-        // this reader process finish.
+        // First, if we are @dumping with a @forked process, it is also
+        // reading from the file. We must pause and let this reader process
+        // finish.  A dump done in this process has no such reader.
         //
         if (  !mudstate.bStandAlone
-           && mudstate.dumping)
+           && mudstate.dumping
+           && 0 != mudstate.dumper)
         {
             STARTLOG(LOG_DBSAVES, "DMP", "DUMP");
             log_text(T("Waiting on previously-forked child before page-splitting... "));
@@ -2212,9 +2289,26 @@ void CHashFile::Copy(UINT32 iDir, HP_PHEAPLENGTH pnRecord, void *pRecord)
     m_Cache[iCache].m_hp.HeapCopy(iDir, pnRecord, pRecord);
 }
 
+// Peek - Returns a pointer to the record instead of copying it. The pointer
+//        is good until the next call which reads or changes the file.
+//
+const void *CHashFile::Peek(UINT32 iDir, HP_PHEAPLENGTH pnRecord)
+{
+    return m_Cache[iCache].m_hp.HeapPeek(iDir, pnRecord);
+}
+
+// IsMapped - Is the page found by the last FindFirstKey() being read in
+//            place from the mapped page file?
+//
+bool CHashFile::IsMapped(void)
+{
+    return m_Cache[iCache].m_hp.IsMapped();
+}
+
 void CHashFile::Remove(UINT32 iDir)
 {
     cs_dels++;
+    m_Cache[iCache].m_hp.UnmapPage(true);
     m_Cache[iCache].m_hp.HeapFree(iDir);
     m_Cache[iCache].m_iState = HF_CACHE_UNPROTECTED;
 }
@@ -2232,6 +2326,16 @@ bool CHashFile::FlushCache(int iCache)
         if (m_Cache[iCache].m_hp.WritePage(m_hPageFile, m_Cache[iCache].m_o))
         {
             m_Cache[iCache].m_iState = HF_CACHE_CLEAN;
+#if defined(UNIX_FILES_MMAP)
+            // The mapping is coherent with what we just wrote, so the page
+            // can go back to being read in place, and our copy is idle.
+            //
+            unsigned char *pMapped = MappedPage(m_Cache[iCache].m_o);
+            if (NULL != pMapped)
+            {
+                m_Cache[iCache].m_hp.MapPage(pMapped);
+            }
+#endif // UNIX_FILES_MMAP
         }
         else
         {
@@ -2273,6 +2377,7 @@ int CHashFile::AllocateEmptyPage(int nSafe, int Safe[])
                 }
                 m_Cache[i].m_iState = HF_CACHE_EMPTY;
             }
+            m_Cache[i].m_hp.UnmapPage(false);
             return i;
         }
     }
@@ -2360,7 +2465,18 @@ int CHashFile::ReadCache(UINT32 iFileDir, int *phits)
 
     if ((iCache = AllocateEmptyPage(0, NULL)) >= 0)
     {
+#if defined(UNIX_FILES_MMAP)
+        unsigned char *pMapped = MappedPage(oPage);
+        if (NULL != pMapped)
+        {
+            cs_dbmaps++;
+            m_Cache[iCache].m_hp.MapPage(pMapped);
+        }
+        if (  NULL != pMapped
+           || m_Cache[iCache].m_hp.ReadPage(m_hPageFile, oPage))
+#else // UNIX_FILES_MMAP
         if (m_Cache[iCache].m_hp.ReadPage(m_hPageFile, oPage))
+#endif // UNIX_FILES_MMAP
         {
             //if (m_Cache[i].m_hp.Validate())
             //{
@@ -2386,6 +2502,75 @@ int CHashFile::ReadCache(UINT32 iFileDir, int *phits)
     return -1;
 }
 
+#if defined(UNIX_FILES_MMAP)
+// MappedPage
+//
+// Returns where the page at oPage can be read in place, or NULL if the page
+// file is not mapped. The page must already be in the file. The mapping is
+// grown ahead of the end of the file, and pages being viewed in the old
+// mapping are moved to the new one.
+//
+unsigned char *CHashFile::MappedPage(HF_FILEOFFSET oPage)
+{
+    HF_FILEOFFSET oEnd = oPage + HF_SIZEOF_PAGE;
+    if (m_nMapped < oEnd)
+    {
+        if (!m_bMapPages)
+        {
+            return NULL;
+        }
+
+        HF_FILEOFFSET nMapped = oEnd + oEnd/4 + 64*HF_SIZEOF_PAGE;
+        nMapped -= nMapped % HF_SIZEOF_PAGE;
+        void *pMapped = mmap(NULL, nMapped, PROT_READ, MAP_SHARED, m_hPageFile, 0);
+        if (MAP_FAILED == pMapped)
+        {
+            // Pages already viewed through the current mapping stay valid
+            // until the file is closed, but new pages are read as usual.
+            //
+            Log.tinyprintf(T("CHashFile::MappedPage - mmap error %u. Reading pages instead." ENDLINE), errno);
+            m_bMapPages = false;
+            return NULL;
+        }
+
+        unsigned char *pOld = m_pMapped;
+        HF_FILEOFFSET nOld = m_nMapped;
+        m_pMapped = (unsigned char *)pMapped;
+        m_nMapped = nMapped;
+        for (int i = 0; i < m_nCache; i++)
+        {
+            if (m_Cache[i].m_hp.IsMapped())
+            {
+                m_Cache[i].m_hp.MapPage(m_pMapped + m_Cache[i].m_o);
+            }
+        }
+        if (NULL != pOld)
+        {
+            munmap(pOld, nOld);
+        }
+    }
+    return m_pMapped + oPage;
+}
+
+void CHashFile::UnmapFile(void)
+{
+    if (NULL != m_pMapped)
+    {
+        for (int i = 0; i < m_nCache; i++)
+        {
+            if (m_Cache[i].m_hp.IsMapped())
+            {
+                m_Cache[i].m_hp.UnmapPage(false);
+                m_Cache[i].m_iState = HF_CACHE_EMPTY;
+            }
+        }
+        munmap(m_pMapped, m_nMapped);
+        m_pMapped = NULL;
+        m_nMapped = 0UL;
+    }
+}
+#endif // UNIX_FILES_MMAP
+
 #endif // MEMORY_BASED
 
 CHashTable::CHashTable(void)
@@ -19,6 +19,7 @@ extern int cs_fails;        // attempts to grab nonexistent
 extern int cs_syncs;        // total cache syncs
 extern int cs_dbreads;      // total read-throughs
 extern int cs_dbwrites;     // total write-throughs
+extern int cs_dbmaps;       // total pages read in place from the mapped file
 extern int cs_rhits;        // total reads filled from cache
 extern int cs_whits;        // total writes to dirty cache
 #endif // !MEMORY_BASED
@@ -122,6 +123,7 @@ class CHashPage
 {
 private:
     unsigned char  *m_pPage;
+    unsigned char  *m_pBuffer;
     unsigned int    m_nPageSize;
     HP_PHEADER      m_pHeader;
     HP_PHEAPOFFSET  m_pDirectory;
@@ -164,12 +166,16 @@ public:
     UINT32 FindFirst(HP_PHEAPLENGTH pnRecord, void *pRecord);
     UINT32 FindNext(HP_PHEAPLENGTH pnRecord, void *pRecord);
     void HeapCopy(UINT32 iDir, HP_PHEAPLENGTH pnRecord, void *pRecord);
+    const void *HeapPeek(UINT32 iDir, HP_PHEAPLENGTH pnRecord);
     void HeapFree(UINT32 iDir);
     void HeapUpdate(UINT32 iDir, HP_HEAPLENGTH nRecord, void *pRecord);
 
 #if !defined(MEMORY_BASED)
     bool WritePage(HANDLE hFile, HF_FILEOFFSET oWhere);
     bool ReadPage(HANDLE hFile, HF_FILEOFFSET oWhere);
+    void MapPage(unsigned char *pMapped);
+    void UnmapPage(bool bKeepContents);
+    bool IsMapped(void) { return m_pPage != m_pBuffer; }
 #endif // MEMORY_BASED
 
     UINT32 GetDepth(void);
@@ -214,6 +220,13 @@ private:
     HF_CACHE        *m_Cache;
     int             m_nCache;
     HF_PFILEOFFSET  m_pDir;
+#if defined(UNIX_FILES_MMAP)
+    bool            m_bMapPages;
+    unsigned char  *m_pMapped;
+    HF_FILEOFFSET   m_nMapped;
+    unsigned char  *MappedPage(HF_FILEOFFSET oPage);
+    void UnmapFile(void);
+#endif // UNIX_FILES_MMAP
     bool DoubleDirectory(void);
 
     int AllocateEmptyPage(int nSafe, int Safe[]);
@@ -236,11 +249,13 @@ public:
 #define HF_OPEN_STATUS_ERROR -1
 #define HF_OPEN_STATUS_NEW    0
 #define HF_OPEN_STATUS_OLD    1
-    int Open(const UTF8 *szDirFile, const UTF8 *szPageFile, int nCachePages);
+    int Open(const UTF8 *szDirFile, const UTF8 *szPageFile, int nCachePages, bool bMapPages);
     bool Insert(HP_HEAPLENGTH nRecord, UINT32 nHash, void *pRecord);
     UINT32 FindFirstKey(UINT32 nHash);
     UINT32 FindNextKey(UINT32 iDir, UINT32 nHash);
     void Copy(UINT32 iDir, HP_PHEAPLENGTH pnRecord, void *pRecord);
+    const void *Peek(UINT32 iDir, HP_PHEAPLENGTH pnRecord);
+    bool IsMapped(void);
     void Remove(UINT32 iDir);
     void CloseAll(void);
     void Sync(void);
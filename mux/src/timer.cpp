@@ -297,6 +297,20 @@ void do_timewarp(dbref executor, dbref caller, dbref enactor, int eval, int key,
     }
 }
 
+void *task_record::operator new(size_t size)
+{
+    mux_assert(size == sizeof(TASK_RECORD));
+    return alloc_task("new");
+}
+
+void task_record::operator delete(void *p)
+{
+    if (NULL != p)
+    {
+        free_task(p);
+    }
+}
+
 #define INITIAL_TASKS 100
 
 CTaskHeap::CTaskHeap(void)
@@ -339,7 +353,7 @@ bool CTaskHeap::Insert(PTASK_RECORD pTask, SCHCMP *pfCompare)
     }
     pTask->m_iVisitedMark = m_iVisitedMark-1;
 
-    m_pHeap[m_nCurrent] = pTask;
+    Place(m_nCurrent, pTask);
     m_nCurrent++;
     SiftUp(m_nCurrent-1, pfCompare);
     return true;
@@ -434,6 +448,43 @@ void CTaskHeap::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
     }
 }
 
+// Tasks always know where they are in the heap so that a particular task
+// can be updated or removed without searching for it.
+//
+void CTaskHeap::Place(int iNode, PTASK_RECORD pTask)
+{
+    m_pHeap[iNode] = pTask;
+    pTask->m_iHeapIndex = iNode;
+}
+
+bool CTaskHeap::Holds(PTASK_RECORD pTask)
+{
+    int iNode = pTask->m_iHeapIndex;
+    return (  0 <= iNode
+           && iNode < m_nCurrent
+           && m_pHeap[iNode] == pTask);
+}
+
+bool CTaskHeap::UpdateTask(PTASK_RECORD pTask, SCHCMP *pfCompare)
+{
+    if (!Holds(pTask))
+    {
+        return false;
+    }
+    Update(pTask->m_iHeapIndex, pfCompare);
+    return true;
+}
+
+bool CTaskHeap::RemoveTask(PTASK_RECORD pTask, SCHCMP *pfCompare)
+{
+    if (!Holds(pTask))
+    {
+        return false;
+    }
+    Remove(pTask->m_iHeapIndex, pfCompare);
+    return true;
+}
+
 static int ComparePriority(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
 {
     int i = (pTaskA->iPriority) - (pTaskB->iPriority);
@@ -466,11 +517,11 @@ static int CompareWhen(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
     }
 }
 
-void CScheduler::DeferTask(const CLinearTimeAbsolute& ltaWhen, int iPriority,
+PTASK_RECORD CScheduler::DeferTask(const CLinearTimeAbsolute& ltaWhen, int iPriority,
                            FTASK *fpTask, void *arg_voidptr, int arg_Integer)
 {
     PTASK_RECORD pTask = new TASK_RECORD;
-    if (!pTask) return;
+    if (!pTask) return NULL;
 
     pTask->ltaWhen = ltaWhen;
     pTask->iPriority = iPriority;
@@ -478,19 +529,26 @@ void CScheduler::DeferTask(const CLinearTimeAbsolute& ltaWhen, int iPriority,
     pTask->arg_voidptr = arg_voidptr;
     pTask->arg_Integer = arg_Integer;
     pTask->m_Ticket = m_Ticket++;
+    pTask->m_iHeapIndex = -1;
+    pTask->m_iSlot = -1;
+    pTask->m_iShare = NOTHING;
+    pTask->m_pNext = NULL;
+    pTask->m_pPrev = NULL;
 
     // Must add to the WhenHeap so that network is still serviced.
     //
     if (!m_WhenHeap.Insert(pTask, CompareWhen))
     {
         delete pTask;
+        return NULL;
     }
+    return pTask;
 }
 
-void CScheduler::DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer)
+PTASK_RECORD CScheduler::DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer)
 {
     PTASK_RECORD pTask = new TASK_RECORD;
-    if (!pTask) return;
+    if (!pTask) return NULL;
 
     //pTask->ltaWhen = ltaWhen;
     pTask->iPriority = iPriority;
@@ -498,24 +556,69 @@ void CScheduler::DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_void
     pTask->arg_voidptr = arg_voidptr;
     pTask->arg_Integer = arg_Integer;
     pTask->m_Ticket = m_Ticket++;
+    pTask->m_iHeapIndex = -1;
+    pTask->m_iSlot = -1;
+    pTask->m_iShare = NOTHING;
+    pTask->m_pNext = NULL;
+    pTask->m_pPrev = NULL;
 
     // Must add to the WhenHeap so that network is still serviced.
     //
     if (!m_WhenHeap.Insert(pTask, CompareWhen))
     {
         delete pTask;
+        return NULL;
     }
+    return pTask;
 }
 
 void CScheduler::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
 {
     m_WhenHeap.CancelTask(fpTask, arg_voidptr, arg_Integer);
     m_PriorityHeap.CancelTask(fpTask, arg_voidptr, arg_Integer);
+    m_Shares.CancelTask(fpTask, arg_voidptr, arg_Integer);
+}
+
+/*! \brief Reposition a task after its time or priority has been changed.
+ *
+ * \param pTask    A task which is still waiting to run.
+ * \return         None.
+ */
+
+void CScheduler::UpdateTask(PTASK_RECORD pTask)
+{
+    if (TASK_SLOT_SHARE == pTask->m_iSlot)
+    {
+        // Already ready to run.  It keeps its place in its owner's queue.
+        //
+        return;
+    }
+    if (!m_WhenHeap.UpdateTask(pTask, CompareWhen))
+    {
+        m_PriorityHeap.UpdateTask(pTask, ComparePriority);
+    }
+}
+
+/*! \brief Remove and free a task which is still waiting to run.
+ *
+ * \param pTask    Task.
+ * \return         None.
+ */
+
+void CScheduler::RemoveTask(PTASK_RECORD pTask)
+{
+    if (  m_WhenHeap.RemoveTask(pTask, CompareWhen)
+       || m_PriorityHeap.RemoveTask(pTask, ComparePriority)
+       || m_Shares.RemoveTask(pTask))
+    {
+        delete pTask;
+    }
 }
 
 void CScheduler::ReadyTasks(const CLinearTimeAbsolute& ltaNow)
 {
-    // Move ready-to-run tasks off the WhenHeap and onto the PriorityHeap.
+    // Move ready-to-run tasks off the WhenHeap and onto the PriorityHeap,
+    // or onto their owner's fair-share queue.
     //
     PTASK_RECORD pTask = m_WhenHeap.PeekAtTopmost();
     while (  pTask
@@ -524,11 +627,37 @@ void CScheduler::ReadyTasks(const CLinearTimeAbsolute& ltaNow)
         pTask = m_WhenHeap.RemoveTopmost(CompareWhen);
         if (pTask)
         {
-            if (  NULL == pTask->fpTask
-               || !m_PriorityHeap.Insert(pTask, ComparePriority))
+            if (NULL == pTask->fpTask)
             {
                 delete pTask;
             }
+            else
+            {
+                if (  NOTHING != pTask->m_iShare
+                   && 0 == pTask->ltaWhen.Return100ns())
+                {
+                    // Immediate tasks start waiting now.
+                    //
+                    pTask->ltaWhen = ltaNow;
+                }
+
+                bool bInserted;
+                if (  mudconf.queue_fair_share
+                   && NOTHING != pTask->m_iShare
+                   && PRIORITY_OBJECT == pTask->iPriority)
+                {
+                    bInserted = m_Shares.Insert(pTask);
+                }
+                else
+                {
+                    bInserted = m_PriorityHeap.Insert(pTask, ComparePriority);
+                }
+
+                if (!bInserted)
+                {
+                    delete pTask;
+                }
+            }
         }
         pTask = m_WhenHeap.PeekAtTopmost();
     }
@@ -553,26 +682,65 @@ int CScheduler::RunTasks(int iCount)
     while (iCount--)
     {
         PTASK_RECORD pTask = m_PriorityHeap.PeekAtTopmost();
-        if (!pTask) break;
-
-        if (pTask->iPriority > m_minPriority)
+        if (  pTask
+           && pTask->iPriority > m_minPriority)
         {
             // This is related to CF_DEQUEUE and also to untimed (SUSPENDED)
             // semaphore entries that we would like to manage together with
             // the timed ones.
             //
-            break;
+            pTask = NULL;
         }
-        pTask = m_PriorityHeap.RemoveTopmost(ComparePriority);
-        if (pTask)
+
+        // System tasks, player commands, and anything else in the priority
+        // heap go first.  Object queue entries waiting in fair-share queues
+        // are then served in deficit round-robin order.
+        //
+        bool bShare = false;
+        if (  0 < m_Shares.Count()
+           && PRIORITY_OBJECT <= m_minPriority
+           && (  NULL == pTask
+              || PRIORITY_OBJECT < pTask->iPriority))
+        {
+            pTask = m_Shares.RemoveNext(mudconf.queue_fair_quantum * FACTOR_100NS_PER_MICROSECOND);
+            bShare = (NULL != pTask);
+        }
+        else if (pTask)
         {
-            if (pTask->fpTask)
+            pTask = m_PriorityHeap.RemoveTopmost(ComparePriority);
+        }
+
+        if (!pTask) break;
+
+        if (pTask->fpTask)
+        {
+            CLinearTimeDelta ltdBegin;
+            if (NOTHING != pTask->m_iShare)
             {
-                pTask->fpTask(pTask->arg_voidptr, pTask->arg_Integer);
-                nTasks++;
+                CLinearTimeAbsolute ltaNow;
+                ltaNow.GetUTC();
+                CLinearTimeDelta ltdLatency = ltaNow - pTask->ltaWhen;
+                m_Shares.Latency(pTask->m_iShare, ltdLatency.Return100ns());
+                if (bShare)
+                {
+                    ltdBegin = GetProcessorUsage();
+                }
             }
-            delete pTask;
+
+            pTask->fpTask(pTask->arg_voidptr, pTask->arg_Integer);
+            nTasks++;
+
+            if (bShare)
+            {
+                CLinearTimeDelta ltdUsed = GetProcessorUsage() - ltdBegin;
+                m_Shares.Charge(pTask->m_iShare, ltdUsed.Return100ns());
+            }
+        }
+        else if (bShare)
+        {
+            m_Shares.Charge(pTask->m_iShare, 0);
         }
+        delete pTask;
     }
     return nTasks;
 }
@@ -604,6 +772,12 @@ bool CScheduler::WhenNext(CLinearTimeAbsolute  *ltaWhen)
             return true;
         }
     }
+    if (  0 < m_Shares.Count()
+       && PRIORITY_OBJECT <= m_minPriority)
+    {
+        ltaWhen->SetSeconds(0);
+        return true;
+    }
 
     // Check the When Queue next.
     //
@@ -640,11 +814,11 @@ void CTaskHeap::SiftDown(int iSubRoot, SCHCMP *pfCompare)
         if (pfCompare(Ref, m_pHeap[child]) <= 0)
             break;
 
-        m_pHeap[parent] = m_pHeap[child];
+        Place(parent, m_pHeap[child]);
         parent = child;
         child = HEAP_LEFT_CHILD(parent);
     }
-    m_pHeap[parent] = Ref;
+    Place(parent, Ref);
 }
 
 void CTaskHeap::SiftUp(int child, SCHCMP *pfCompare)
@@ -657,8 +831,8 @@ void CTaskHeap::SiftUp(int child, SCHCMP *pfCompare)
 
         PTASK_RECORD Tmp;
         Tmp = m_pHeap[child];
-        m_pHeap[child] = m_pHeap[parent];
-        m_pHeap[parent] = Tmp;
+        Place(child, m_pHeap[parent]);
+        Place(parent, Tmp);
 
         child = parent;
     }
@@ -671,9 +845,12 @@ PTASK_RECORD CTaskHeap::Remove(int iNode, SCHCMP *pfCompare)
     PTASK_RECORD pTask = m_pHeap[iNode];
 
     m_nCurrent--;
-    m_pHeap[iNode] = m_pHeap[m_nCurrent];
-    SiftDown(iNode, pfCompare);
-    SiftUp(iNode, pfCompare);
+    if (iNode < m_nCurrent)
+    {
+        Place(iNode, m_pHeap[m_nCurrent]);
+        SiftDown(iNode, pfCompare);
+        SiftUp(iNode, pfCompare);
+    }
 
     return pTask;
 }
@@ -691,15 +868,17 @@ void CTaskHeap::Update(int iNode, SCHCMP *pfCompare)
 
 void CScheduler::TraverseUnordered(SCHLOOK *pfLook)
 {
-    if (m_WhenHeap.TraverseUnordered(pfLook, CompareWhen))
+    if (  m_WhenHeap.TraverseUnordered(pfLook, CompareWhen)
+       && m_PriorityHeap.TraverseUnordered(pfLook, ComparePriority))
     {
-        m_PriorityHeap.TraverseUnordered(pfLook, ComparePriority);
+        m_Shares.TraverseUnordered(pfLook);
     }
 }
 
 void CScheduler::TraverseOrdered(SCHLOOK *pfLook)
 {
     m_PriorityHeap.TraverseOrdered(pfLook, ComparePriority);
+    m_Shares.TraverseOrdered(pfLook, ComparePriority);
     m_WhenHeap.TraverseOrdered(pfLook, CompareWhen);
 }
 
@@ -746,7 +925,7 @@ int CTaskHeap::TraverseUnordered(SCHLOOK *pfLook, SCHCMP *pfCompare)
             switch (cmd)
             {
             case IU_REMOVE_TASK:
-                Remove(i, pfCompare);
+                delete Remove(i, pfCompare);
                 break;
 
             case IU_DONE:
@@ -789,8 +968,8 @@ void CTaskHeap::Sort(SCHCMP *pfCompare)
     while (m_nCurrent--)
     {
         PTASK_RECORD p = m_pHeap[m_nCurrent];
-        m_pHeap[m_nCurrent] = m_pHeap[0];
-        m_pHeap[0] = p;
+        Place(m_nCurrent, m_pHeap[0]);
+        Place(0, p);
         SiftDown(0, pfCompare);
     }
     m_nCurrent = s_nCurrent;
@@ -803,17 +982,1104 @@ void CTaskHeap::Remake(SCHCMP *pfCompare)
     while (s_nCurrent--)
     {
         m_nCurrent++;
+        Place(m_nCurrent-1, m_pHeap[m_nCurrent-1]);
         SiftUp(m_nCurrent-1, pfCompare);
     }
 }
 
-void CScheduler::SetMinPriority(int arg_minPriority)
+// ---------------------------------------------------------------------------
+// CTaskWheel.
+//
+static INT64 WheelTick(PTASK_RECORD pTask)
 {
-    m_minPriority = arg_minPriority;
+    return pTask->ltaWhen.Return100ns() >> WHEEL_TICK_SHIFT;
 }
 
-void CScheduler::Shrink(void)
+CTaskWheel::CTaskWheel(void)
 {
-    m_WhenHeap.Shrink();
-    m_PriorityHeap.Shrink();
+    for (int i = 0; i <= WHEEL_OVERFLOW; i++)
+    {
+        m_aSlots[i] = NULL;
+    }
+    for (int i = 0; i <= WHEEL_LEVELS; i++)
+    {
+        m_anLevel[i] = 0;
+    }
+    m_nWheel = 0;
+    m_iCurrent = 0;
+    m_iVisitedMark = 0;
+    m_pTraverseNext = NULL;
+}
+
+CTaskWheel::~CTaskWheel(void)
+{
+    for (int i = 0; i <= WHEEL_OVERFLOW; i++)
+    {
+        PTASK_RECORD pTask = m_aSlots[i];
+        while (pTask)
+        {
+            PTASK_RECORD pNext = pTask->m_pNext;
+            delete pTask;
+            pTask = pNext;
+        }
+        m_aSlots[i] = NULL;
+    }
+}
+
+void CTaskWheel::LinkSlot(int iSlot, PTASK_RECORD pTask)
+{
+    pTask->m_iSlot = iSlot;
+    pTask->m_pPrev = NULL;
+    pTask->m_pNext = m_aSlots[iSlot];
+    if (m_aSlots[iSlot])
+    {
+        m_aSlots[iSlot]->m_pPrev = pTask;
+    }
+    m_aSlots[iSlot] = pTask;
+    m_anLevel[iSlot / WHEEL_SLOTS]++;
+    m_nWheel++;
+}
+
+void CTaskWheel::UnlinkSlot(PTASK_RECORD pTask)
+{
+    int iSlot = pTask->m_iSlot;
+    if (pTask == m_pTraverseNext)
+    {
+        m_pTraverseNext = pTask->m_pNext;
+    }
+    if (pTask->m_pPrev)
+    {
+        pTask->m_pPrev->m_pNext = pTask->m_pNext;
+    }
+    else
+    {
+        m_aSlots[iSlot] = pTask->m_pNext;
+    }
+    if (pTask->m_pNext)
+    {
+        pTask->m_pNext->m_pPrev = pTask->m_pPrev;
+    }
+    pTask->m_iSlot = -1;
+    pTask->m_pNext = NULL;
+    pTask->m_pPrev = NULL;
+    m_anLevel[iSlot / WHEEL_SLOTS]--;
+    m_nWheel--;
+}
+
+// Tasks due by the current tick go on the near heap.  Otherwise, the highest
+// digit where the task's tick differs from the current tick chooses the
+// level, and the task's digit at that level chooses the slot.
+//
+bool CTaskWheel::Place(PTASK_RECORD pTask)
+{
+    INT64 iTick = WheelTick(pTask);
+    if (iTick <= m_iCurrent)
+    {
+        return m_Near.Insert(pTask, CompareWhen);
+    }
+
+    UINT64 iDiffer = ((UINT64)iTick) ^ ((UINT64)m_iCurrent);
+    int iLevel = 0;
+    while (  iLevel < WHEEL_LEVELS
+          && (iDiffer >> (WHEEL_BITS * (iLevel + 1))) != 0)
+    {
+        iLevel++;
+    }
+
+    if (WHEEL_LEVELS == iLevel)
+    {
+        LinkSlot(WHEEL_OVERFLOW, pTask);
+    }
+    else
+    {
+        int iDigit = (int)((iTick >> (WHEEL_BITS * iLevel)) & (WHEEL_SLOTS - 1));
+        LinkSlot(iLevel * WHEEL_SLOTS + iDigit, pTask);
+    }
+    return true;
+}
+
+// Redistributes a slot's tasks now that the current tick has reached it.
+//
+void CTaskWheel::Cascade(int iSlot)
+{
+    PTASK_RECORD pTask = m_aSlots[iSlot];
+    while (pTask)
+    {
+        PTASK_RECORD pNext = pTask->m_pNext;
+        UnlinkSlot(pTask);
+        if (!Place(pTask))
+        {
+            delete pTask;
+        }
+        pTask = pNext;
+    }
+}
+
+// Moves the current tick forward to the start of the next occupied slot.
+// Nothing between the old and new tick is skipped because a lower level is
+// always searched before a higher one.
+//
+void CTaskWheel::Advance(void)
+{
+    INT64 iNext = m_iCurrent;
+    int iLevel;
+    for (iLevel = 0; iLevel < WHEEL_LEVELS && iNext == m_iCurrent; iLevel++)
+    {
+        if (0 == m_anLevel[iLevel])
+        {
+            continue;
+        }
+
+        int iShift = WHEEL_BITS * iLevel;
+        int iDigit = (int)((m_iCurrent >> iShift) & (WHEEL_SLOTS - 1));
+        for (int j = iDigit + 1; j < WHEEL_SLOTS; j++)
+        {
+            if (m_aSlots[iLevel * WHEEL_SLOTS + j])
+            {
+                iNext = ((m_iCurrent >> (iShift + WHEEL_BITS)) << (iShift + WHEEL_BITS))
+                      | (((INT64)j) << iShift);
+                break;
+            }
+        }
+    }
+
+    const int iSpan = WHEEL_BITS * WHEEL_LEVELS;
+    if (iNext == m_iCurrent)
+    {
+        // Only the overflow list is occupied.  Move to the start of the span
+        // holding the earliest task there.
+        //
+        INT64 iEarliest = 0;
+        for (PTASK_RECORD p = m_aSlots[WHEEL_OVERFLOW]; p; p = p->m_pNext)
+        {
+            INT64 iTick = WheelTick(p);
+            if (  0 == iEarliest
+               || iTick < iEarliest)
+            {
+                iEarliest = iTick;
+            }
+        }
+        iNext = (iEarliest >> iSpan) << iSpan;
+    }
+    m_iCurrent = iNext;
+
+    if (0 == (m_iCurrent & ((((INT64)1) << iSpan) - 1)))
+    {
+        Cascade(WHEEL_OVERFLOW);
+    }
+    for (iLevel = WHEEL_LEVELS - 1; 0 <= iLevel; iLevel--)
+    {
+        int iShift = WHEEL_BITS * iLevel;
+        if (0 == (m_iCurrent & ((((INT64)1) << iShift) - 1)))
+        {
+            int iDigit = (int)((m_iCurrent >> iShift) & (WHEEL_SLOTS - 1));
+            Cascade(iLevel * WHEEL_SLOTS + iDigit);
+        }
+    }
+}
+
+bool CTaskWheel::Insert(PTASK_RECORD pTask, SCHCMP *pfCompare)
+{
+    UNUSED_PARAMETER(pfCompare);
+
+    if (0 == m_nWheel)
+    {
+        // With nothing on the wheel, the current tick can catch up to the
+        // present without cascading anything.
+        //
+        CLinearTimeAbsolute ltaNow;
+        ltaNow.GetUTC();
+        INT64 iNow = ltaNow.Return100ns() >> WHEEL_TICK_SHIFT;
+        if (m_iCurrent < iNow)
+        {
+            m_iCurrent = iNow;
+        }
+    }
+    pTask->m_iVisitedMark = m_iVisitedMark-1;
+    pTask->m_iSlot = -1;
+    return Place(pTask);
+}
+
+PTASK_RECORD CTaskWheel::PeekAtTopmost(void)
+{
+    for (;;)
+    {
+        PTASK_RECORD pTask = m_Near.PeekAtTopmost();
+        if (  0 == m_nWheel
+           || (  pTask
+              && WheelTick(pTask) <= m_iCurrent))
+        {
+            return pTask;
+        }
+        Advance();
+    }
+}
+
+PTASK_RECORD CTaskWheel::RemoveTopmost(SCHCMP *pfCompare)
+{
+    if (PeekAtTopmost())
+    {
+        return m_Near.RemoveTopmost(pfCompare);
+    }
+    return NULL;
+}
+
+void CTaskWheel::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
+{
+    m_Near.CancelTask(fpTask, arg_voidptr, arg_Integer);
+    for (int i = 0; i <= WHEEL_OVERFLOW; i++)
+    {
+        for (PTASK_RECORD p = m_aSlots[i]; p; p = p->m_pNext)
+        {
+            if (  p->fpTask == fpTask
+               && p->arg_voidptr == arg_voidptr
+               && p->arg_Integer == arg_Integer)
+            {
+                p->fpTask = NULL;
+            }
+        }
+    }
+}
+
+bool CTaskWheel::UpdateTask(PTASK_RECORD pTask, SCHCMP *pfCompare)
+{
+    if (0 <= pTask->m_iSlot)
+    {
+        UnlinkSlot(pTask);
+        if (!Place(pTask))
+        {
+            delete pTask;
+        }
+        return true;
+    }
+    return m_Near.UpdateTask(pTask, pfCompare);
+}
+
+bool CTaskWheel::RemoveTask(PTASK_RECORD pTask, SCHCMP *pfCompare)
+{
+    if (0 <= pTask->m_iSlot)
+    {
+        UnlinkSlot(pTask);
+        return true;
+    }
+    return m_Near.RemoveTask(pTask, pfCompare);
+}
+
+void CTaskWheel::Shrink(void)
+{
+    m_Near.Shrink();
+}
+
+// Like CTaskHeap::TraverseUnordered, this visits every task exactly once
+// even if tasks are removed or updated along the way.
+//
+int CTaskWheel::TraverseUnordered(SCHLOOK *pfLook, SCHCMP *pfCompare)
+{
+    if (!m_Near.TraverseUnordered(pfLook, pfCompare))
+    {
+        return false;
+    }
+
+    m_iVisitedMark++;
+    if (m_iVisitedMark == 0)
+    {
+        for (int i = 0; i <= WHEEL_OVERFLOW; i++)
+        {
+            for (PTASK_RECORD p = m_aSlots[i]; p; p = p->m_pNext)
+            {
+                p->m_iVisitedMark = m_iVisitedMark;
+            }
+        }
+        m_iVisitedMark++;
+    }
+
+    int bUnvisitedRecords;
+    do
+    {
+        bUnvisitedRecords = false;
+        for (int i = 0; i <= WHEEL_OVERFLOW; i++)
+        {
+            PTASK_RECORD p = m_aSlots[i];
+            while (p)
+            {
+                m_pTraverseNext = p->m_pNext;
+                if (p->m_iVisitedMark != m_iVisitedMark)
+                {
+                    bUnvisitedRecords = true;
+                    p->m_iVisitedMark = m_iVisitedMark;
+
+                    int cmd = pfLook(p);
+                    switch (cmd)
+                    {
+                    case IU_REMOVE_TASK:
+                        UnlinkSlot(p);
+                        delete p;
+                        break;
+
+                    case IU_DONE:
+                        m_pTraverseNext = NULL;
+                        return false;
+
+                    case IU_UPDATE_TASK:
+                        UpdateTask(p, pfCompare);
+                        break;
+                    }
+                }
+                p = m_pTraverseNext;
+            }
+        }
+    } while (bUnvisitedRecords);
+    m_pTraverseNext = NULL;
+    return true;
+}
+
+static int CompareWhenIndirect(const void *pa, const void *pb)
+{
+    return CompareWhen(*(PTASK_RECORD *)pa, *(PTASK_RECORD *)pb);
+}
+
+// Like CTaskHeap::TraverseOrdered, this visits every task in When order, and
+// the tasks must not be changed along the way.
+//
+int CTaskWheel::TraverseOrdered(SCHLOOK *pfLook, SCHCMP *pfCompare)
+{
+    UNUSED_PARAMETER(pfCompare);
+
+    int nTasks = m_Near.m_nCurrent + m_nWheel;
+    if (0 == nTasks)
+    {
+        return true;
+    }
+
+    PTASK_RECORD *aTasks = NULL;
+    try
+    {
+        aTasks = new PTASK_RECORD[nTasks];
+    }
+    catch (...)
+    {
+        ; // Nothing.
+    }
+
+    if (!aTasks)
+    {
+        return false;
+    }
+
+    int n = 0;
+    for (int i = 0; i < m_Near.m_nCurrent; i++)
+    {
+        aTasks[n++] = m_Near.m_pHeap[i];
+    }
+    for (int i = 0; i <= WHEEL_OVERFLOW; i++)
+    {
+        for (PTASK_RECORD p = m_aSlots[i]; p; p = p->m_pNext)
+        {
+            aTasks[n++] = p;
+        }
+    }
+    qsort(aTasks, n, sizeof(PTASK_RECORD), CompareWhenIndirect);
+
+    for (int i = 0; i < n; i++)
+    {
+        if (IU_DONE == pfLook(aTasks[i]))
+        {
+            break;
+        }
+    }
+    delete [] aTasks;
+    return true;
+}
+
+void CTaskWheel::Report(dbref executor)
+{
+    notify(executor, tprintf(T("When wheel: %d due, %d on levels %d/%d/%d/%d, %d beyond."),
+        m_Near.m_nCurrent, m_nWheel - m_anLevel[WHEEL_LEVELS],
+        m_anLevel[0], m_anLevel[1], m_anLevel[2], m_anLevel[3],
+        m_anLevel[WHEEL_LEVELS]));
+}
+
+// ---------------------------------------------------------------------------
+// CTaskShares: deficit round-robin over per-owner FIFOs of ready tasks.
+//
+CTaskShares::CTaskShares(void)
+{
+    m_pActive = NULL;
+    m_nActive = 0;
+    m_nTasks = 0;
+    m_iVisitedMark = 0;
+    m_pTraverseNext = NULL;
+}
+
+CTaskShares::~CTaskShares(void)
+{
+    TASK_SHARE *ps = (TASK_SHARE *)hash_firstentry(&m_htShares);
+    while (ps)
+    {
+        PTASK_RECORD pTask = ps->pHead;
+        while (pTask)
+        {
+            PTASK_RECORD pNext = pTask->m_pNext;
+            delete pTask;
+            pTask = pNext;
+        }
+        MEMFREE(ps);
+        ps = (TASK_SHARE *)hash_nextentry(&m_htShares);
+    }
+    m_htShares.Reset();
+}
+
+TASK_SHARE *CTaskShares::Find(int iShare, bool bCreate)
+{
+    TASK_SHARE *ps = (TASK_SHARE *)hashfindLEN(&iShare, sizeof(iShare), &m_htShares);
+    if (  NULL == ps
+       && bCreate)
+    {
+        ps = (TASK_SHARE *)MEMALLOC(sizeof(TASK_SHARE));
+        ISOUTOFMEMORY(ps);
+        ps->iShare          = iShare;
+        ps->pHead           = NULL;
+        ps->pTail           = NULL;
+        ps->nTasks          = 0;
+        ps->iDeficit        = 0;
+        ps->bActive         = false;
+        ps->pNext           = NULL;
+        ps->pPrev           = NULL;
+        ps->iLatencyAverage = 0;
+        ps->iLatencyMaximum = 0;
+        ps->nRun            = 0;
+        hashaddLEN(&iShare, sizeof(iShare), ps, &m_htShares);
+    }
+    return ps;
+}
+
+// A newly-active share goes to the back of the ring.
+//
+void CTaskShares::Activate(TASK_SHARE *ps)
+{
+    if (ps->bActive)
+    {
+        return;
+    }
+    ps->bActive = true;
+    ps->iDeficit = 0;
+    if (m_pActive)
+    {
+        ps->pNext = m_pActive;
+        ps->pPrev = m_pActive->pPrev;
+        ps->pPrev->pNext = ps;
+        m_pActive->pPrev = ps;
+    }
+    else
+    {
+        ps->pNext = ps;
+        ps->pPrev = ps;
+        m_pActive = ps;
+    }
+    m_nActive++;
+}
+
+// An idle share leaves the ring and loses any credit it had left.
+//
+void CTaskShares::Deactivate(TASK_SHARE *ps)
+{
+    if (!ps->bActive)
+    {
+        return;
+    }
+    ps->bActive = false;
+    ps->iDeficit = 0;
+    if (ps->pNext == ps)
+    {
+        m_pActive = NULL;
+    }
+    else
+    {
+        ps->pPrev->pNext = ps->pNext;
+        ps->pNext->pPrev = ps->pPrev;
+        if (m_pActive == ps)
+        {
+            m_pActive = ps->pNext;
+        }
+    }
+    ps->pNext = NULL;
+    ps->pPrev = NULL;
+    m_nActive--;
+}
+
+void CTaskShares::Unlink(TASK_SHARE *ps, PTASK_RECORD pTask)
+{
+    if (m_pTraverseNext == pTask)
+    {
+        m_pTraverseNext = pTask->m_pNext;
+    }
+
+    if (pTask->m_pPrev)
+    {
+        pTask->m_pPrev->m_pNext = pTask->m_pNext;
+    }
+    else
+    {
+        ps->pHead = pTask->m_pNext;
+    }
+
+    if (pTask->m_pNext)
+    {
+        pTask->m_pNext->m_pPrev = pTask->m_pPrev;
+    }
+    else
+    {
+        ps->pTail = pTask->m_pPrev;
+    }
+
+    pTask->m_pNext = NULL;
+    pTask->m_pPrev = NULL;
+    pTask->m_iSlot = -1;
+    ps->nTasks--;
+    m_nTasks--;
+}
+
+bool CTaskShares::Insert(PTASK_RECORD pTask)
+{
+    TASK_SHARE *ps = Find(pTask->m_iShare, true);
+
+    pTask->m_iSlot = TASK_SLOT_SHARE;
+    pTask->m_iVisitedMark = m_iVisitedMark;
+    pTask->m_pNext = NULL;
+    pTask->m_pPrev = ps->pTail;
+    if (ps->pTail)
+    {
+        ps->pTail->m_pNext = pTask;
+    }
+    else
+    {
+        ps->pHead = pTask;
+    }
+    ps->pTail = pTask;
+    ps->nTasks++;
+    m_nTasks++;
+
+    Activate(ps);
+    return true;
+}
+
+/*! \brief Take the next task in deficit round-robin order.
+ *
+ * The share at the head of the ring keeps running tasks while it has
+ * credit.  The caller must follow up with Charge() once the task has run.
+ *
+ * \param iQuantum  Credit given to a share each time around the ring.
+ * \return          Task or NULL if no tasks are waiting.
+ */
+
+PTASK_RECORD CTaskShares::RemoveNext(INT64 iQuantum)
+{
+    if (iQuantum <= 0)
+    {
+        iQuantum = 1;
+    }
+
+    int nPassed = 0;
+    while (m_pActive)
+    {
+        TASK_SHARE *ps = m_pActive;
+        if (NULL == ps->pHead)
+        {
+            // Its last task is still running (a nested RunTasks).
+            //
+            Deactivate(ps);
+        }
+        else if (ps->iDeficit <= 0)
+        {
+            if (m_nActive < ++nPassed)
+            {
+                // A whole lap went by without finding credit.  Rather than
+                // go around once per quantum, give every share the laps
+                // which would pass before the first of them could run.
+                //
+                TASK_SHARE *p = ps;
+                INT64 nLaps = (iQuantum - p->iDeficit)/iQuantum;
+                while ((p = p->pNext) != ps)
+                {
+                    INT64 n = (iQuantum - p->iDeficit)/iQuantum;
+                    if (n < nLaps)
+                    {
+                        nLaps = n;
+                    }
+                }
+
+                if (1 < nLaps)
+                {
+                    INT64 iCredit = (nLaps - 1) * iQuantum;
+                    do
+                    {
+                        p->iDeficit += iCredit;
+                        p = p->pNext;
+                    } while (p != ps);
+                }
+                nPassed = 0;
+            }
+            ps->iDeficit += iQuantum;
+            m_pActive = ps->pNext;
+        }
+        else
+        {
+            PTASK_RECORD pTask = ps->pHead;
+            Unlink(ps, pTask);
+            return pTask;
+        }
+    }
+    return NULL;
+}
+
+void CTaskShares::Charge(int iShare, INT64 iUsed)
+{
+    TASK_SHARE *ps = Find(iShare, false);
+    if (NULL == ps)
+    {
+        return;
+    }
+
+    if (ps->bActive)
+    {
+        ps->iDeficit -= iUsed;
+        if (NULL == ps->pHead)
+        {
+            Deactivate(ps);
+        }
+    }
+}
+
+void CTaskShares::Latency(int iShare, INT64 iLatency)
+{
+    TASK_SHARE *ps = Find(iShare, true);
+    if (iLatency < 0)
+    {
+        iLatency = 0;
+    }
+
+    // Exponentially-weighted average with a weight of 1/8.
+    //
+    if (0 == ps->nRun)
+    {
+        ps->iLatencyAverage = iLatency;
+    }
+    else
+    {
+        ps->iLatencyAverage += (iLatency - ps->iLatencyAverage)/8;
+    }
+    if (ps->iLatencyMaximum < iLatency)
+    {
+        ps->iLatencyMaximum = iLatency;
+    }
+    ps->nRun++;
+}
+
+bool CTaskShares::GetLatency(int iShare, INT64 *piAverage, INT64 *piMaximum, int *pnRun)
+{
+    TASK_SHARE *ps = Find(iShare, false);
+    if (  NULL == ps
+       || 0 == ps->nRun)
+    {
+        return false;
+    }
+    *piAverage = ps->iLatencyAverage;
+    *piMaximum = ps->iLatencyMaximum;
+    *pnRun = ps->nRun;
+    return true;
+}
+
+void CTaskShares::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
+{
+    TASK_SHARE *ps = m_pActive;
+    for (int i = 0; i < m_nActive; i++)
+    {
+        for (PTASK_RECORD p = ps->pHead; p; p = p->m_pNext)
+        {
+            if (  p->fpTask == fpTask
+               && p->arg_voidptr == arg_voidptr
+               && p->arg_Integer == arg_Integer)
+            {
+                p->fpTask = NULL;
+            }
+        }
+        ps = ps->pNext;
+    }
+}
+
+bool CTaskShares::RemoveTask(PTASK_RECORD pTask)
+{
+    if (TASK_SLOT_SHARE != pTask->m_iSlot)
+    {
+        return false;
+    }
+
+    TASK_SHARE *ps = Find(pTask->m_iShare, false);
+    if (NULL == ps)
+    {
+        return false;
+    }
+    Unlink(ps, pTask);
+    if (NULL == ps->pHead)
+    {
+        Deactivate(ps);
+    }
+    return true;
+}
+
+// Copy the ring so that shares may come and go during a traversal.  Share
+// records are never freed while the game is running.
+//
+int CTaskShares::Snapshot(TASK_SHARE ***paShares)
+{
+    *paShares = NULL;
+    if (0 == m_nActive)
+    {
+        return 0;
+    }
+
+    TASK_SHARE **aShares = NULL;
+    try
+    {
+        aShares = new TASK_SHARE *[m_nActive];
+    }
+    catch (...)
+    {
+        ; // Nothing.
+    }
+
+    if (!aShares)
+    {
+        return -1;
+    }
+
+    TASK_SHARE *ps = m_pActive;
+    int n = m_nActive;
+    for (int i = 0; i < n; i++)
+    {
+        aShares[i] = ps;
+        ps = ps->pNext;
+    }
+    *paShares = aShares;
+    return n;
+}
+
+// Like CTaskHeap::TraverseUnordered, this visits every task exactly once
+// even if tasks are removed along the way.  Tasks in a fair-share queue are
+// ready to run, so IU_UPDATE_TASK leaves them where they are.
+//
+int CTaskShares::TraverseUnordered(SCHLOOK *pfLook)
+{
+    TASK_SHARE **aShares;
+    int nShares = Snapshot(&aShares);
+    if (nShares <= 0)
+    {
+        return (0 == nShares);
+    }
+
+    m_iVisitedMark++;
+    if (m_iVisitedMark == 0)
+    {
+        for (int i = 0; i < nShares; i++)
+        {
+            for (PTASK_RECORD p = aShares[i]->pHead; p; p = p->m_pNext)
+            {
+                p->m_iVisitedMark = m_iVisitedMark;
+            }
+        }
+        m_iVisitedMark++;
+    }
+
+    for (int i = 0; i < nShares; i++)
+    {
+        PTASK_RECORD p = aShares[i]->pHead;
+        while (p)
+        {
+            m_pTraverseNext = p->m_pNext;
+            if (p->m_iVisitedMark != m_iVisitedMark)
+            {
+                p->m_iVisitedMark = m_iVisitedMark;
+
+                int cmd = pfLook(p);
+                switch (cmd)
+                {
+                case IU_REMOVE_TASK:
+                    if (RemoveTask(p))
+                    {
+                        delete p;
+                    }
+                    break;
+
+                case IU_DONE:
+                    m_pTraverseNext = NULL;
+                    delete [] aShares;
+                    return false;
+                }
+            }
+            p = m_pTraverseNext;
+        }
+    }
+    m_pTraverseNext = NULL;
+    delete [] aShares;
+    return true;
+}
+
+static SCHCMP *s_pfCompareIndirect;
+
+static int CompareIndirect(const void *pa, const void *pb)
+{
+    return s_pfCompareIndirect(*(PTASK_RECORD *)pa, *(PTASK_RECORD *)pb);
+}
+
+// Visits every task in pfCompare order.  The tasks must not be changed along
+// the way.
+//
+int CTaskShares::TraverseOrdered(SCHLOOK *pfLook, SCHCMP *pfCompare)
+{
+    if (0 == m_nTasks)
+    {
+        return true;
+    }
+
+    PTASK_RECORD *aTasks = NULL;
+    try
+    {
+        aTasks = new PTASK_RECORD[m_nTasks];
+    }
+    catch (...)
+    {
+        ; // Nothing.
+    }
+
+    if (!aTasks)
+    {
+        return false;
+    }
+
+    int n = 0;
+    TASK_SHARE *ps = m_pActive;
+    for (int i = 0; i < m_nActive; i++)
+    {
+        for (PTASK_RECORD p = ps->pHead; p && n < m_nTasks; p = p->m_pNext)
+        {
+            aTasks[n++] = p;
+        }
+        ps = ps->pNext;
+    }
+    s_pfCompareIndirect = pfCompare;
+    qsort(aTasks, n, sizeof(PTASK_RECORD), CompareIndirect);
+
+    int bContinue = true;
+    for (int i = 0; i < n; i++)
+    {
+        if (IU_DONE == pfLook(aTasks[i]))
+        {
+            bContinue = false;
+            break;
+        }
+    }
+    delete [] aTasks;
+    return bContinue;
+}
+
+void CTaskShares::Report(dbref executor)
+{
+    notify(executor, tprintf(T("Fair-share queues: %d tasks from %d owners."),
+        m_nTasks, m_nActive));
+
+    TASK_SHARE *ps = m_pActive;
+    for (int i = 0; i < m_nActive && i < 10; i++)
+    {
+        notify(executor, tprintf(T("  #%d: %d ready, credit %d usec."),
+            ps->iShare, ps->nTasks, (int)(ps->iDeficit/FACTOR_100NS_PER_MICROSECOND)));
+        ps = ps->pNext;
+    }
+}
+
+void CScheduler::Report(dbref executor)
+{
+    m_WhenHeap.Report(executor);
+    notify(executor, tprintf(T("Priority heap: %d tasks."), m_PriorityHeap.Count()));
+    m_Shares.Report(executor);
+}
+
+/*! \brief Report how long an owner's queue entries wait before running.
+ *
+ * \param iShare       Owner.
+ * \param pltdAverage  Recent average latency.
+ * \param pltdMaximum  Worst latency seen.
+ * \param pnRun        Number of entries measured.
+ * \return             false if nothing has been measured for the owner.
+ */
+
+bool CScheduler::ShareLatency(int iShare, CLinearTimeDelta *pltdAverage,
+                              CLinearTimeDelta *pltdMaximum, int *pnRun)
+{
+    INT64 iAverage, iMaximum;
+    if (!m_Shares.GetLatency(iShare, &iAverage, &iMaximum, pnRun))
+    {
+        return false;
+    }
+    pltdAverage->Set100ns(iAverage);
+    pltdMaximum->Set100ns(iMaximum);
+    return true;
+}
+
+void CScheduler::SetMinPriority(int arg_minPriority)
+{
+    m_minPriority = arg_minPriority;
+}
+
+void CScheduler::Shrink(void)
+{
+    m_WhenHeap.Shrink();
+    m_PriorityHeap.Shrink();
+}
+
+// ---------------------------------------------------------------------------
+// Scheduler microbenchmark.
+//
+// The same set of randomly-timed tasks is inserted into a CTaskHeap and a
+// CTaskWheel.  Every other task is then removed, and the rest are drained in
+// When order.  Neither structure belongs to the live scheduler.  The game
+// does not run while this does, so the task count is capped at a size that
+// finishes within a few milliseconds.
+//
+#define BENCHMARK_MAX_TASKS 10000
+
+static void BenchmarkReset(PTASK_RECORD *aTasks, int nTasks)
+{
+    for (int i = 0; i < nTasks; i++)
+    {
+        aTasks[i]->m_iHeapIndex = -1;
+        aTasks[i]->m_iSlot = -1;
+        aTasks[i]->m_pNext = NULL;
+        aTasks[i]->m_pPrev = NULL;
+    }
+}
+
+template <class T> static void BenchmarkQueue
+(
+    T &queue,
+    PTASK_RECORD *aTasks,
+    int nTasks,
+    INT64 aElapsed[3],
+    int *pnDisorder
+)
+{
+    BenchmarkReset(aTasks, nTasks);
+
+    CLinearTimeAbsolute ltaBegin, ltaEnd;
+    ltaBegin.GetUTC();
+    for (int i = 0; i < nTasks; i++)
+    {
+        queue.Insert(aTasks[i], CompareWhen);
+    }
+    ltaEnd.GetUTC();
+    aElapsed[0] = (ltaEnd - ltaBegin).Return100ns();
+
+    ltaBegin.GetUTC();
+    for (int i = 0; i < nTasks; i += 2)
+    {
+        queue.RemoveTask(aTasks[i], CompareWhen);
+    }
+    ltaEnd.GetUTC();
+    aElapsed[1] = (ltaEnd - ltaBegin).Return100ns();
+
+    *pnDisorder = 0;
+    PTASK_RECORD pPrevious = NULL;
+    ltaBegin.GetUTC();
+    PTASK_RECORD pTask;
+    while (NULL != (pTask = queue.RemoveTopmost(CompareWhen)))
+    {
+        if (  NULL != pPrevious
+           && CompareWhen(pPrevious, pTask) > 0)
+        {
+            (*pnDisorder)++;
+        }
+        pPrevious = pTask;
+    }
+    ltaEnd.GetUTC();
+    aElapsed[2] = (ltaEnd - ltaBegin).Return100ns();
+}
+
+static void BenchmarkReport(dbref player, const UTF8 *pName, int nTasks, INT64 aElapsed[3], int nDisorder)
+{
+    INT64 aPer[3];
+    aPer[0] = (100 * aElapsed[0]) / nTasks;
+    aPer[1] = (100 * aElapsed[1]) / ((nTasks + 1) / 2);
+    aPer[2] = (100 * aElapsed[2]) / (nTasks / 2 > 0 ? nTasks / 2 : 1);
+    notify(player, tprintf(T("%-10s %8d %8d %8d %s"), pName,
+        (int)aPer[0], (int)aPer[1], (int)aPer[2],
+        nDisorder ? T("OUT OF ORDER") : T("")));
+}
+
+/*! \brief Reports on the scheduler and optionally compares heap and wheel.
+ *
+ * \param player   Who is listening.
+ * \param pCount   Number of tasks to benchmark with or NULL.
+ * \return         None.
+ */
+
+void list_scheduler(dbref player, UTF8 *pCount)
+{
+    scheduler.Report(player);
+    if (  NULL == pCount
+       || !is_integer(pCount, NULL))
+    {
+        return;
+    }
+
+    int nTasks = mux_atol(pCount);
+    if (nTasks <= 0)
+    {
+        return;
+    }
+    else if (BENCHMARK_MAX_TASKS < nTasks)
+    {
+        nTasks = BENCHMARK_MAX_TASKS;
+    }
+
+    PTASK_RECORD *aTasks = (PTASK_RECORD *)MEMALLOC(nTasks * sizeof(PTASK_RECORD));
+    ISOUTOFMEMORY(aTasks);
+
+    // Spread the tasks over the next hour much as @wait would.
+    //
+    CLinearTimeAbsolute ltaNow;
+    ltaNow.GetUTC();
+    for (int i = 0; i < nTasks; i++)
+    {
+        PTASK_RECORD pTask = new TASK_RECORD;
+        CLinearTimeDelta ltd;
+        ltd.SetSeconds(RandomINT32(0, 3599));
+        ltd += CLinearTimeDelta(RandomINT32(0, (INT32)(FACTOR_100NS_PER_SECOND - 1)));
+        pTask->ltaWhen = ltaNow + ltd;
+        pTask->iPriority = PRIORITY_OBJECT;
+        pTask->m_Ticket = i;
+        pTask->fpTask = NULL;
+        pTask->arg_voidptr = NULL;
+        pTask->arg_Integer = 0;
+        aTasks[i] = pTask;
+    }
+
+    INT64 aElapsed[3];
+    int nDisorder;
+    notify(player, tprintf(T("Benchmark of %d tasks in nanoseconds per task:"), nTasks));
+    notify(player, T("              Insert   Cancel    Drain"));
+    {
+        CTaskHeap heap;
+        BenchmarkQueue(heap, aTasks, nTasks, aElapsed, &nDisorder);
+        BenchmarkReport(player, T("Heap"), nTasks, aElapsed, nDisorder);
+    }
+    {
+        CTaskWheel wheel;
+        BenchmarkQueue(wheel, aTasks, nTasks, aElapsed, &nDisorder);
+        BenchmarkReport(player, T("Wheel"), nTasks, aElapsed, nDisorder);
+    }
+
+    for (int i = 0; i < nTasks; i++)
+    {
+        delete aTasks[i];
+    }
+    MEMFREE(aTasks);
 }
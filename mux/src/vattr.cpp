@@ -75,6 +75,7 @@ ATTR *vattr_define_LEN(const UTF8 *pName, size_t nName, int number, int flags)
         vp->name = store_string(pName);
         vp->flags = flags;
         vp->number = number;
+        mudstate.bDirtyAttrNames = true;
 
         // This entry cannot already be in the hash table because we've checked it
         // above with vattr_find_LEN.
@@ -632,6 +633,11 @@ void do_dbclean(dbref executor, dbref caller, dbref enactor, int eval, int key)
     notify(executor, tprintf(T("Next Attribute number to allocate: %d"), mudstate.attr_next));
     notify(executor, T("Checking Integrity of the attribute data structures..."));
     dbclean_IntegrityChecking(executor);
+
+    // Attribute numbers changed everywhere, so the next checkpoint cannot
+    // be an incremental one.
+    //
+    mudstate.nIncrementalDumps = -1;
     notify(executor, T("@dbclean completed.."));
 }
 
@@ -654,6 +660,7 @@ void vattr_delete_LEN(UTF8 *pName, size_t nName)
             pht->Remove(iDir);
             MEMFREE(vp);
             vp = NULL;
+            mudstate.bDirtyAttrNames = true;
         }
         iDir = pht->FindNextKey(iDir, nHash);
     }
@@ -682,6 +689,7 @@ ATTR *vattr_rename_LEN(UTF8 *pOldName, size_t nOldName, UTF8 *pNewName, size_t n
             vp->name = store_string(pNewName);
             nHash = HASH_ProcessBuffer(0, pNewName, nNewName);
             pht->Insert(sizeof(int), nHash, &anum);
+            mudstate.bDirtyAttrNames = true;
             return (ATTR *)anum_table[anum];
         }
         iDir = pht->FindNextKey(iDir, nHash);
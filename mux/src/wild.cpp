@@ -21,441 +21,423 @@
 
 #include "mathutil.h"
 
-#define EQUAL(a,b) (mux_tolower_ascii(a) == mux_tolower_ascii(b))
-#define NOTEQUAL(a,b) (mux_tolower_ascii(a) != mux_tolower_ascii(b))
-
-// Argument return space and size.
-//
-static UTF8 **arglist;
-static int numargs;
-
-//
-// ---------------------------------------------------------------------------
-// quick_wild: do a wildcard match, without remembering the wild data.
-//
-// This routine will cause crashes if fed NULLs instead of strings.
+// Returns the length of the valid UTF-8 character at p, or 0.
 //
-bool quick_wild(const UTF8 *tstr, const UTF8 *dstr)
+static size_t wild_char_width(const UTF8 *p)
 {
-    if (mudstate.wild_invk_ctr >= mudconf.wild_invk_lim)
+    size_t t;
+    if (  '\0' == p[0]
+       || UTF8_CONTINUE <= (t = utf8_FirstByte[p[0]]))
     {
-        return false;
+        return 0;
     }
-    mudstate.wild_invk_ctr++;
 
-    while (*tstr != '*')
+    for (size_t j = 1; j < t; j++)
     {
-        switch (*tstr)
+        if (  '\0' == p[j]
+           || UTF8_CONTINUE != utf8_FirstByte[p[j]])
         {
-        case '?':
-
-            // Single character match.  Return false if at end of data.
-            //
-            if (!*dstr)
-            {
-                return false;
-            }
-            break;
-
-        case '\\':
-
-            // Escape character.  Move up, and force literal match of next
-            // character.
-            //
-            tstr++;
-
-            // FALL THROUGH
-
-        default:
-
-            // Literal character.  Check for a match. If matching end of data,
-            // return true.
-            //
-            if (NOTEQUAL(*dstr, *tstr))
-            {
-                return false;
-            }
-            if (!*dstr)
-            {
-                return true;
-            }
+            return 0;
         }
-        tstr++;
-        dstr++;
-    }
-
-    // Skip over '*'.
-    //
-    tstr++;
-
-    // Return true on trailing '*'.
-    //
-    if (!*tstr)
-    {
-        return true;
     }
+    return t;
+}
 
-    // Skip over wildcards.
-    //
-    while (  *tstr == '?'
-          || *tstr == '*')
+static void wild_capture(UTF8 **parg, const UTF8 *pName, const UTF8 *p, size_t n)
+{
+    if (0 < n)
     {
-        if (*tstr == '?')
+        if (LBUF_SIZE-1 < n)
         {
-            if (!*dstr)
-            {
-                return false;
-            }
-            dstr++;
+            n = LBUF_SIZE-1;
         }
-        tstr++;
+        *parg = alloc_lbuf(pName);
+        memcpy(*parg, p, n);
+        (*parg)[n] = '\0';
     }
+}
 
-    // Skip over a backslash in the pattern string if it is there.
-    //
-    if (*tstr == '\\')
+CWildcard::CWildcard()
+{
+    m_nArgs          = 0;
+    m_nTokens        = 0;
+    m_nTokensAlloc   = 0;
+    m_aTokens        = NULL;
+    m_nSegments      = 0;
+    m_nSegmentsAlloc = 0;
+    m_aSegments      = NULL;
+    m_bVariable      = false;
+}
+
+CWildcard::~CWildcard()
+{
+    if (m_aTokens)
     {
-        tstr++;
+        MEMFREE(m_aTokens);
+        m_aTokens = NULL;
     }
-
-    // Return true on trailing '*'.
-    //
-    if (!*tstr)
+    if (m_aSegments)
     {
-        return true;
+        MEMFREE(m_aSegments);
+        m_aSegments = NULL;
     }
+}
 
-    // Scan for possible matches.
-    //
-    while (*dstr)
+void CWildcard::AddToken(UTF8 chType, UTF8 ch, int iArg)
+{
+    WILD_TOKEN *pt = &m_aTokens[m_nTokens++];
+    pt->chType = chType;
+    pt->ch     = ch;
+    pt->iArg   = (iArg < m_nArgs) ? iArg : -1;
+
+    WILD_SEGMENT *ps = &m_aSegments[m_nSegments-1];
+    ps->nTokens++;
+    if (WILD_CHAR != chType)
     {
-        if (  EQUAL(*dstr, *tstr)
-           && quick_wild(tstr + 1, dstr + 1))
-        {
-            return true;
-        }
-        dstr++;
+        ps->nWidth++;
+    }
+    else if (1 < m_nSegments)
+    {
+        m_bVariable = true;
     }
-    return false;
+}
+
+void CWildcard::AddSegment(int iArg)
+{
+    WILD_SEGMENT *ps = &m_aSegments[m_nSegments++];
+    ps->iToken  = m_nTokens;
+    ps->nTokens = 0;
+    ps->iArg    = (iArg < m_nArgs) ? iArg : -1;
+    ps->nWidth  = 0;
+    ps->iStart  = 0;
+    ps->iEnd    = 0;
+    ps->iLimit  = 0;
 }
 
 // ---------------------------------------------------------------------------
-// wild1: INTERNAL: do a wildcard match, remembering the wild data.
-//
-// DO NOT CALL THIS FUNCTION DIRECTLY - DOING SO MAY RESULT IN SERVER CRASHES
-// AND IMPROPER ARGUMENT RETURN.
+// Compile: Break a pattern into literal pieces separated by runs of
+// wildcards which start with a '*'.
 //
-// Side Effect: this routine modifies the 'arglist' static global variable.
+// Wildcards are numbered from the left, and the first nArgs of them are
+// captured by Match().  The backtracking matcher this replaces made every '*'
+// in a run except the last match nothing, so those '?'s in the run before
+// the last '*' match the bytes just after the previous piece, and those
+// after it match the bytes just before the next piece.  A '?' outside a run
+// which is captured matches a whole UTF-8 character.  Every other '?'
+// matches a single byte.
 //
-static bool wild1(UTF8 *tstr, UTF8 *dstr, int arg)
+void CWildcard::Compile(const UTF8 *pPattern, int nArgs)
 {
-    if (mudstate.wild_invk_ctr >= mudconf.wild_invk_lim)
+    m_nArgs     = nArgs;
+    m_nTokens   = 0;
+    m_nSegments = 0;
+    m_bVariable = false;
+
+    // Every token and every piece after the first uses up at least one
+    // character of the pattern.
+    //
+    size_t n = strlen((const char *)pPattern);
+    if (m_nTokensAlloc < static_cast<int>(n))
     {
-        return false;
+        if (m_aTokens)
+        {
+            MEMFREE(m_aTokens);
+        }
+        m_nTokensAlloc = static_cast<int>(n);
+        m_aTokens = (WILD_TOKEN *)MEMALLOC(m_nTokensAlloc * sizeof(WILD_TOKEN));
+        ISOUTOFMEMORY(m_aTokens);
     }
-    mudstate.wild_invk_ctr++;
-
-    UTF8 *datapos;
-    int argpos, numextra;
-
-    while (*tstr != '*')
+    if (m_nSegmentsAlloc < static_cast<int>(n) + 1)
     {
-        switch (*tstr)
+        if (m_aSegments)
         {
-        case '?':
+            MEMFREE(m_aSegments);
+        }
+        m_nSegmentsAlloc = static_cast<int>(n) + 1;
+        m_aSegments = (WILD_SEGMENT *)MEMALLOC(m_nSegmentsAlloc * sizeof(WILD_SEGMENT));
+        ISOUTOFMEMORY(m_aSegments);
+    }
+    AddSegment(-1);
 
-            // Single character match.  Return false if at end of data.
-            //
-            size_t t;
-            if (  '\0' == dstr[0]
-               || UTF8_CONTINUE <= (t = utf8_FirstByte[*dstr]))
+    int iArg = 0;
+    const UTF8 *p = pPattern;
+    while ('\0' != *p)
+    {
+        if ('*' == *p)
+        {
+            int iStar  = -1;
+            int iQuery = iArg;
+            int nQuery = 0;
+            while (  '*' == *p
+                  || '?' == *p)
             {
-                return false;
+                if ('*' == *p)
+                {
+                    for (int i = 0; i < nQuery; i++)
+                    {
+                        AddToken(WILD_BYTE, '\0', iQuery + i);
+                    }
+                    iStar  = iArg++;
+                    iQuery = iArg;
+                    nQuery = 0;
+                }
+                else
+                {
+                    iArg++;
+                    nQuery++;
+                }
+                p++;
             }
 
-            size_t j;
-            for (j = 1; j < t; j++)
+            AddSegment(iStar);
+            for (int i = 0; i < nQuery; i++)
             {
-                if (  '\0' == dstr[j]
-                   || UTF8_CONTINUE != utf8_FirstByte[dstr[j]])
+                AddToken(WILD_BYTE, '\0', iQuery + i);
+            }
+        }
+        else if ('?' == *p)
+        {
+            AddToken((iArg < m_nArgs) ? WILD_CHAR : WILD_BYTE, '\0', iArg);
+            iArg++;
+            p++;
+        }
+        else
+        {
+            // A backslash forces a literal match of the next character.  A
+            // trailing backslash ends the pattern.
+            //
+            if ('\\' == *p)
+            {
+                p++;
+                if ('\0' == *p)
                 {
-                    return false;
+                    break;
                 }
             }
+            AddToken(WILD_LITERAL, mux_tolower_ascii(*p), -1);
+            p++;
+        }
+    }
+}
 
-            memcpy(arglist[arg], dstr, t);
-            arglist[arg][t] = '\0';
-            arg++;
-
-            // Jump to the fast routine if we can.
-            //
-            if (arg >= numargs)
+// Match a piece starting at iPos.
+//
+bool CWildcard::MatchSegment(const WILD_SEGMENT *ps, const UTF8 *pData,
+    size_t iPos, size_t *piEnd)
+{
+    const WILD_TOKEN *pt = m_aTokens + ps->iToken;
+    for (int i = 0; i < ps->nTokens; i++, pt++)
+    {
+        if (WILD_LITERAL == pt->chType)
+        {
+            if (mux_tolower_ascii(pData[iPos]) != pt->ch)
             {
-                return quick_wild(tstr + 1, dstr + t);
+                return false;
             }
-            dstr += t;
-            break;
-
-        case '\\':
-
-            // Escape character.  Move up, and force literal match of next
-            // character.
-            //
-            tstr++;
-
-            // FALL THROUGH
-
-        default:
-
-            // Literal character.  Check for a match. If matching end of data,
-            // return true.
-            //
-            if (NOTEQUAL(*dstr, *tstr))
+            iPos++;
+        }
+        else if (WILD_BYTE == pt->chType)
+        {
+            if ('\0' == pData[iPos])
             {
                 return false;
             }
-            if (!*dstr)
+            iPos++;
+        }
+        else
+        {
+            size_t t = wild_char_width(pData + iPos);
+            if (0 == t)
             {
-                return true;
+                return false;
             }
-            dstr++;
-            break;
+            iPos += t;
         }
-        tstr++;
     }
+    *piEnd = iPos;
+    return true;
+}
 
-    // If at end of pattern, slurp the rest, and leave.
-    //
-    if (!tstr[1])
+// Place every piece.  The first piece starts with the data, the last piece
+// ends with it, and each piece in between is placed at the earliest
+// position after the previous piece which still leaves room for the rest.
+// That is the same answer the backtracking matcher found.
+//
+bool CWildcard::Locate(const UTF8 *pData)
+{
+    size_t nData = strlen((const char *)pData);
+    int iLast = m_nSegments - 1;
+    WILD_SEGMENT *ps = m_aSegments;
+    ps->iStart = 0;
+    if (!MatchSegment(ps, pData, 0, &ps->iEnd))
+    {
+        return false;
+    }
+    else if (0 == iLast)
     {
-        mux_strncpy(arglist[arg], dstr, LBUF_SIZE-1);
-        return true;
+        return (nData == ps->iEnd);
     }
 
-    // Remember current position for filling in the '*' return.
-    //
-    datapos = dstr;
-    argpos = arg;
+    int i;
+    for (i = 0; i <= iLast; i++)
+    {
+        m_aSegments[i].iLimit = nData;
+    }
 
-    // Scan forward until we find a non-wildcard.
+    // When every piece has a fixed width, the earliest position a piece fits
+    // always leaves the most room for the rest.  A '?' which matches a whole
+    // character breaks that, so first find the latest position each piece
+    // can start, working back from the end of the data.
     //
-    do
+    if (m_bVariable)
     {
-        if (argpos < arg)
+        size_t iLimit = nData;
+        for (i = iLast; 1 <= i; i--)
         {
-            // Fill in arguments if someone put another '*' before a fixed
-            // string.
-            //
-            arglist[argpos][0] = '\0';
-            argpos++;
+            ps = m_aSegments + i;
+            ps->iLimit = iLimit;
 
-            // Jump to the fast routine if we can.
-            //
-            if (argpos >= numargs)
-            {
-                return quick_wild(tstr, dstr);
-            }
-
-            // Fill in any intervening '?'s
-            //
-            while (argpos < arg)
+            size_t iStart = iLimit + 1;
+            size_t iEnd;
+            do
             {
-                arglist[argpos][0] = *datapos;
-                arglist[argpos][1] = '\0';
-                datapos++;
-                argpos++;
-
-                // Jump to the fast routine if we can.
-                //
-                if (argpos >= numargs)
+                if (0 == iStart)
                 {
-                    return quick_wild(tstr, dstr);
+                    return false;
                 }
-            }
+                iStart--;
+            } while (  !MatchSegment(ps, pData, iStart, &iEnd)
+                    || iLimit < iEnd
+                    || (  i == iLast
+                       && nData != iEnd));
+            iLimit = iStart;
         }
+        m_aSegments[0].iLimit = iLimit;
 
-        // Skip over the '*' for now...
-        //
-        tstr++;
-        arg++;
-
-        // Skip over '?'s for now...
-        //
-        numextra = 0;
-        while (*tstr == '?')
+        if (iLimit < m_aSegments[0].iEnd)
         {
-            if (!*dstr)
-            {
-                return false;
-            }
-            tstr++;
-            dstr++;
-            arg++;
-            numextra++;
+            return false;
         }
-    } while (*tstr == '*');
-
-    // Skip over a backslash in the pattern string if it is there.
-    //
-    if (*tstr == '\\')
-    {
-        tstr++;
     }
 
-    // Check for possible matches.  This loop terminates either at end of data
-    // (resulting in failure), or at a successful match.
-    //
-    for (;;)
+    size_t iPos = m_aSegments[0].iEnd;
+    for (i = 1; i <= iLast; i++)
     {
-        // Scan forward until first character matches.
-        //
-        if (*tstr)
+        ps = m_aSegments + i;
+        if (  i == iLast
+           && !m_bVariable)
         {
-            while (NOTEQUAL(*dstr, *tstr))
+            if (  nData < ps->nWidth
+               || nData - ps->nWidth < iPos)
             {
-                if (!*dstr)
-                {
-                    return false;
-                }
-                dstr++;
+                return false;
             }
-        }
-        else
-        {
-            while (*dstr)
+            ps->iStart = nData - ps->nWidth;
+            if (!MatchSegment(ps, pData, ps->iStart, &ps->iEnd))
             {
-                dstr++;
+                return false;
             }
         }
-
-        // The first character matches, now.  Check if the rest does, using
-        // the fastest method, as usual.
-        //
-        if (  !*dstr
-           || ((arg < numargs) ? wild1(tstr + 1, dstr + 1, arg)
-                               : quick_wild(tstr + 1, dstr + 1)))
+        else
         {
-            // Found a match!  Fill in all remaining arguments. First do the
-            // '*'...
-            //
-            mux_strncpy(arglist[argpos], datapos, (dstr - datapos) - numextra);
-            datapos = dstr - numextra;
-            argpos++;
-
-            // Fill in any trailing '?'s that are left.
-            //
-            while (numextra)
+            ps->iStart = iPos;
+            while (  !MatchSegment(ps, pData, ps->iStart, &ps->iEnd)
+                  || ps->iLimit < ps->iEnd
+                  || (  i == iLast
+                     && nData != ps->iEnd))
             {
-                if (argpos >= numargs)
+                if (nData <= ps->iStart)
                 {
-                    return true;
+                    return false;
                 }
-                arglist[argpos][0] = *datapos;
-                arglist[argpos][1] = '\0';
-                datapos++;
-                argpos++;
-                numextra--;
+                ps->iStart++;
             }
-
-            // It's done!
-            //
-            return true;
-        }
-        else
-        {
-            dstr++;
         }
+        iPos = ps->iEnd;
     }
+    return true;
 }
 
 // ---------------------------------------------------------------------------
-// wild: do a wildcard match, remembering the wild data.
+// Match: do a wildcard match, without remembering the wild data.
 //
-// This routine will cause crashes if fed NULLs instead of strings.
+bool CWildcard::Match(const UTF8 *pData)
+{
+    return Locate(pData);
+}
+
+// ---------------------------------------------------------------------------
+// Match: do a wildcard match, remembering the wild data.
 //
-// Side Effect: this routine modifies the 'arglist' and 'numargs' static
-// global variables.
+// args[] must have room for the nArgs given to Compile().  Wildcards which
+// match nothing are left NULL, as are all of them if the match fails.
 //
-bool wild(UTF8 *tstr, UTF8 *dstr, UTF8 *args[], int nargs)
+bool CWildcard::Match(const UTF8 *pData, UTF8 *args[])
 {
-    mudstate.wild_invk_ctr = 0;
-
     int i;
-    UTF8 *scan;
-
-    // Initialize the return array.
-    //
-    for (i = 0; i < nargs; i++)
+    for (i = 0; i < m_nArgs; i++)
     {
         args[i] = NULL;
     }
 
-    // Do fast match.
-    //
-    while (  *tstr != '*'
-          && *tstr != '?')
+    if (!Locate(pData))
     {
-        if (*tstr == '\\')
-        {
-            tstr++;
-        }
-        if (NOTEQUAL(*dstr, *tstr))
-        {
-            return false;
-        }
-        if (!*dstr)
-        {
-            return true;
-        }
-        tstr++;
-        dstr++;
+        return false;
     }
 
-    // Allocate space for the return args.
-    //
-    i = 0;
-    scan = tstr;
-    while (  *scan
-          && i < nargs)
+    for (i = 0; i < m_nSegments; i++)
     {
-        switch (*scan)
+        WILD_SEGMENT *ps = m_aSegments + i;
+        if (0 <= ps->iArg)
         {
-        case '?':
-
-            args[i] = alloc_lbuf("wild.?");
-            i++;
-            break;
-
-        case '*':
+            wild_capture(&args[ps->iArg], T("wild.*"), pData + ps[-1].iEnd,
+                ps->iStart - ps[-1].iEnd);
+        }
 
-            args[i] = alloc_lbuf("wild.*");
-            i++;
+        size_t iPos = ps->iStart;
+        const WILD_TOKEN *pt = m_aTokens + ps->iToken;
+        for (int j = 0; j < ps->nTokens; j++, pt++)
+        {
+            size_t n = 1;
+            if (WILD_CHAR == pt->chType)
+            {
+                n = wild_char_width(pData + iPos);
+            }
+            if (0 <= pt->iArg)
+            {
+                wild_capture(&args[pt->iArg], T("wild.?"), pData + iPos, n);
+            }
+            iPos += n;
         }
-        scan++;
     }
+    return true;
+}
 
-    // Put stuff in globals for quick recursion.
-    //
-    arglist = args;
-    numargs = nargs;
+// One-shot matches reuse these so that their space is only allocated once.
+//
+static CWildcard wcQuick;
+static CWildcard wcArgs;
 
-    // Do the match.
-    //
-    bool value = nargs ? wild1(tstr, dstr, 0) : quick_wild(tstr, dstr);
+// ---------------------------------------------------------------------------
+// quick_wild: do a wildcard match, without remembering the wild data.
+//
+// This routine will cause crashes if fed NULLs instead of strings.
+//
+bool quick_wild(const UTF8 *tstr, const UTF8 *dstr)
+{
+    wcQuick.Compile(tstr);
+    return wcQuick.Match(dstr);
+}
 
-    // Clean out any fake match data left by wild1.
-    //
-    for (i = 0; i < nargs; i++)
-    {
-        if (  args[i] != NULL
-           && (  !*args[i]
-              || !value))
-        {
-            free_lbuf(args[i]);
-            args[i] = NULL;
-        }
-    }
-    return value;
+// ---------------------------------------------------------------------------
+// wild: do a wildcard match, remembering the wild data.
+//
+// This routine will cause crashes if fed NULLs instead of strings.
+//
+bool wild(UTF8 *tstr, UTF8 *dstr, UTF8 *args[], int nargs)
+{
+    wcArgs.Compile(tstr, nargs);
+    return wcArgs.Match(dstr, args);
 }
 
 // ---------------------------------------------------------------------------
@@ -495,6 +477,5 @@ bool wild_match(UTF8 *tstr, const UTF8 *dstr)
             return (strcmp((char *)dstr, (char *)tstr) > 0);
         }
     }
-    mudstate.wild_invk_ctr = 0;
     return quick_wild(tstr, dstr);
 }